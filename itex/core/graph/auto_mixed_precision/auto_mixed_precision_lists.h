@@ -171,6 +171,7 @@ class AutoMixedPrecisionLists {
       "_FusedBatchMatMulV2",
       "_ITEXForwardGRU",
       "_ITEXForwardAUGRU",
+      "_ITEXFusedBatchNormGradWithConv2DBackprop",
       "_ITEXFusedConv2D",
       "_ITEXFusedConv3D",
       "_ITEXFusedDepthwiseConv2dNative",
@@ -0,0 +1,295 @@
+/* Copyright (c) 2022 Intel Corporation
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "itex/core/graph/embedding_compression/embedding_compression.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "itex/core/graph/utils/op_types.h"
+#include "itex/core/graph/utils/utils.h"
+#include "itex/core/utils/attr_value_util.h"
+#include "itex/core/utils/embedding_compression.h"
+#include "itex/core/utils/plugin_tensor.h"
+#include "itex/core/utils/types.h"
+
+namespace itex {
+namespace graph {
+
+namespace {
+
+constexpr char kCompressedGather[] = "_ITEXCompressedGather";
+constexpr char kCompressedSegment[] = "_ITEXCompressedSparseSegmentReduction";
+
+// A lookup of rows of a 2-D fp32 Const table.
+struct Lookup {
+  string table;
+  DataType index_type = DT_INT32;
+  DataType segment_type = DT_INT32;
+  // "sum", "mean" or "sqrtn" for SparseSegment ops, empty for gathers.
+  string combiner;
+};
+
+// Compressed tables and their scales are named after the table.
+string CompressedName(const string& table) {
+  return table + "/itex_compressed";
+}
+string ScaleBiasName(const string& table) {
+  return CompressedName(table) + "/scale_bias";
+}
+
+bool IsTwoDimFloatConst(const NodeDef& node_def) {
+  if (!IsConstant(node_def)) return false;
+  DataType dtype;
+  if (!TryGetNodeAttr(node_def, "dtype", &dtype) || dtype != DT_FLOAT)
+    return false;
+  return node_def.attr().at("value").tensor().tensor_shape().dim_size() == 2;
+}
+
+// Only Const tables are compressed. A variable may be assigned in place by
+// another graph or a checkpoint restore, which a cached copy wouldn't see:
+// on CPU these are TF kernels, which don't tell the plugin when a variable
+// changes.
+bool GetTable(const NodeDef& table_def, Lookup* lookup) {
+  if (IsReadVariableOp(table_def)) {
+    ITEX_VLOG(1) << "EmbeddingCompression: variable table " << table_def.name()
+                 << " stays in fp32, freeze the graph to compress it";
+    return false;
+  }
+  if (!IsTwoDimFloatConst(table_def)) return false;
+  lookup->table = table_def.name();
+  return true;
+}
+
+bool IsZeroAxis(const NodeDef& node_def) {
+  if (!IsConstant(node_def)) return false;
+  Tensor axis;
+  if (!axis.FromProto(node_def.attr().at("value").tensor()) ||
+      axis.NumElements() != 1)
+    return false;
+  if (axis.dtype() == DT_INT32) return axis.flat<int32>()(0) == 0;
+  if (axis.dtype() == DT_INT64) return axis.flat<int64>()(0) == 0;
+  return false;
+}
+
+bool GetLookup(const utils::MutableNodeView& node_view, Lookup* lookup) {
+  const NodeDef& node_def = *(node_view.node());
+  const string& op = node_def.op();
+  int batch_dims = 0;
+  DataType dtype;
+
+  if (op == "GatherV2") {
+    if (!TryGetNodeAttr(node_def, "Tparams", &dtype) || dtype != DT_FLOAT)
+      return false;
+    if (TryGetNodeAttr(node_def, "batch_dims", &batch_dims) && batch_dims != 0)
+      return false;
+    if (node_view.NumRegularFanins() != 3 ||
+        !IsZeroAxis(*(node_view.GetRegularFanin(2).node_view()->node())))
+      return false;
+    if (!TryGetNodeAttr(node_def, "Tindices", &lookup->index_type))
+      return false;
+    return GetTable(*(node_view.GetRegularFanin(0).node_view()->node()),
+                    lookup);
+  }
+
+  if (op == "ResourceGather") {
+    ITEX_VLOG(1) << "EmbeddingCompression: variable table of "
+                 << node_def.name()
+                 << " stays in fp32, freeze the graph to compress it";
+    return false;
+  }
+
+  if (op == "SparseSegmentSum") {
+    lookup->combiner = "sum";
+  } else if (op == "SparseSegmentMean") {
+    lookup->combiner = "mean";
+  } else if (op == "SparseSegmentSqrtN") {
+    lookup->combiner = "sqrtn";
+  } else {
+    return false;
+  }
+  if (!TryGetNodeAttr(node_def, "T", &dtype) || dtype != DT_FLOAT)
+    return false;
+  if (!TryGetNodeAttr(node_def, "Tidx", &lookup->index_type)) return false;
+  // Older TF has int32 segment ids only.
+  TryGetNodeAttr(node_def, "Tsegmentids", &lookup->segment_type);
+  return GetTable(*(node_view.GetRegularFanin(0).node_view()->node()),
+                  lookup);
+}
+
+NodeDef MakeConst(const string& name, const string& device, Tensor* value) {
+  NodeDef const_node;
+  const_node.set_name(name);
+  const_node.set_op("Const");
+  const_node.set_device(device);
+  auto* attr = const_node.mutable_attr();
+  SetAttrValue(value->dtype(), &(*attr)["dtype"]);
+  value->AsProtoTensorContent((*attr)["value"].mutable_tensor());
+  return const_node;
+}
+
+// Adds the compressed Const table and its scales, unless the relative
+// error is above `tolerance`, in which case `compressed` is false.
+Status AddCompressedConst(utils::Mutation* mutation, const NodeDef& table,
+                          const string& device, DataType dtype,
+                          float tolerance, bool* compressed) {
+  const TensorProto& proto = table.attr().at("value").tensor();
+  Tensor value(proto.dtype(), proto.tensor_shape());
+  if (!value.FromProto(proto)) {
+    return errors::InvalidArgument("Can't parse the table ", table.name());
+  }
+  Tensor compressed_value, scale_bias;
+  TF_RETURN_IF_ERROR(
+      CompressEmbeddingTable(value, dtype, &compressed_value, &scale_bias));
+  const float error =
+      EmbeddingCompressionError(value, compressed_value, scale_bias);
+  *compressed = error <= tolerance;
+  if (!*compressed) {
+    ITEX_LOG(WARNING) << "EmbeddingCompression: " << table.name()
+                      << " stays in fp32, its relative error " << error
+                      << " is above " << tolerance;
+    return Status::OK();
+  }
+
+  // Keep the control inputs of the table, e.g. the frame of a while loop.
+  NodeDef compressed_table =
+      MakeConst(CompressedName(table.name()), device, &compressed_value);
+  NodeDef scale_bias_table =
+      MakeConst(ScaleBiasName(table.name()), device, &scale_bias);
+  for (const auto& input : table.input()) {
+    compressed_table.add_input(input);
+    scale_bias_table.add_input(input);
+  }
+
+  Status status;
+  mutation->AddNode(std::move(compressed_table), &status);
+  TF_RETURN_IF_ERROR(status);
+  mutation->AddNode(std::move(scale_bias_table), &status);
+  return status;
+}
+
+// Replaces the lookup in place by the compressed one, adding the compressed
+// table on its first lookup.
+Status RewriteLookup(EmbeddingCompressionContext* ctx, const string& node_name,
+                     const Lookup& lookup, DataType dtype, float tolerance) {
+  auto* node_view = ctx->graph_view.GetNode(node_name);
+  const NodeDef& node_def = *(node_view->node());
+  const string& device = node_def.device();
+  utils::Mutation* mutation = ctx->graph_view.GetMutationBuilder();
+
+  auto it = ctx->compressed_tables.find(lookup.table);
+  if (it != ctx->compressed_tables.end() && !it->second) return Status::OK();
+  if (it == ctx->compressed_tables.end()) {
+    bool compressed = false;
+    TF_RETURN_IF_ERROR(AddCompressedConst(
+        mutation, *(ctx->graph_view.GetNode(lookup.table)->node()), device,
+        dtype, tolerance, &compressed));
+    if (!compressed) {
+      ctx->compressed_tables[lookup.table] = false;
+      return Status::OK();
+    }
+  }
+
+  NodeDef compressed;
+  compressed.set_name(node_name);
+  compressed.set_device(device);
+  compressed.add_input(CompressedName(lookup.table));
+  compressed.add_input(node_def.input(1));
+  auto* attr = compressed.mutable_attr();
+  SetAttrValue(dtype, &(*attr)["Tparams"]);
+  if (lookup.combiner.empty()) {
+    compressed.set_op(kCompressedGather);
+    SetAttrValue(lookup.index_type, &(*attr)["Tindices"]);
+  } else {
+    compressed.set_op(kCompressedSegment);
+    compressed.add_input(node_def.input(2));
+    SetAttrValue(lookup.index_type, &(*attr)["Tidx"]);
+    SetAttrValue(lookup.segment_type, &(*attr)["Tsegmentids"]);
+    SetAttrValue(lookup.combiner, &(*attr)["combiner"]);
+  }
+  compressed.add_input(ScaleBiasName(lookup.table));
+  for (int i = node_view->NumRegularFanins(); i < node_def.input_size(); ++i) {
+    compressed.add_input(node_def.input(i));
+  }
+
+  Status status;
+  mutation->AddNode(std::move(compressed), &status);
+  TF_RETURN_IF_ERROR(status);
+  TF_RETURN_IF_ERROR(mutation->Apply());
+  ctx->compressed_tables[lookup.table] = true;
+  return Status::OK();
+}
+
+// Removes fp32 Const tables left without consumers.
+Status RemoveUnusedTables(EmbeddingCompressionContext* ctx) {
+  utils::Mutation* mutation = ctx->graph_view.GetMutationBuilder();
+  for (const auto& table : ctx->compressed_tables) {
+    if (!table.second || ctx->nodes_to_preserve.count(table.first) > 0)
+      continue;
+    auto* node_view = ctx->graph_view.GetNode(table.first);
+    if (node_view == nullptr || !IsConstant(*(node_view->node()))) continue;
+    if (node_view->NumRegularFanouts() == 0 &&
+        node_view->NumControlledFanouts() == 0) {
+      mutation->RemoveNode(node_view);
+    }
+  }
+  return mutation->Apply();
+}
+
+}  // namespace
+
+Status RunEmbeddingCompression(const char* device_name,
+                               const GrapplerItem& item,
+                               const GraphDef& graph_def,
+                               GraphDef* optimized_graph, DataType dtype,
+                               float tolerance) {
+  Status status;
+  GraphDef mutable_graph_def = graph_def;
+  EmbeddingCompressionContext ctx(item, &mutable_graph_def, &status);
+  TF_RETURN_IF_ERROR(status);
+
+  // Nodes are looked up by name, as rewriting one adds nodes to the graph.
+  std::vector<std::pair<string, Lookup>> lookups;
+  for (int i = 0; i < ctx.graph_view.NumNodes(); ++i) {
+    const auto* node_view = ctx.graph_view.GetNode(i);
+    if (!NodeIsOnDevice(device_name, node_view->node())) continue;
+    Lookup lookup;
+    if (GetLookup(*node_view, &lookup)) {
+      lookups.emplace_back(node_view->GetName(), std::move(lookup));
+    }
+  }
+
+  ITEX_VLOG(1) << "EmbeddingCompression: " << lookups.size()
+               << " lookups to " << DataTypeString(dtype);
+
+  for (const auto& lookup : lookups) {
+    Status s = RewriteLookup(&ctx, lookup.first, lookup.second, dtype,
+                             tolerance);
+    if (!s.ok()) {
+      // Drop what was added for this lookup, it stays in fp32.
+      ctx.graph_view.GetMutationBuilder()->Reset();
+      ITEX_VLOG(2) << "EmbeddingCompression: failed to rewrite "
+                   << lookup.first << ": " << s;
+    }
+  }
+  TF_RETURN_IF_ERROR(RemoveUnusedTables(&ctx));
+
+  *optimized_graph = std::move(mutable_graph_def);
+  return Status::OK();
+}
+
+}  // namespace graph
+}  // namespace itex
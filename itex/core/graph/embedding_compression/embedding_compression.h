@@ -0,0 +1,62 @@
+/* Copyright (c) 2022 Intel Corporation
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef ITEX_CORE_GRAPH_EMBEDDING_COMPRESSION_EMBEDDING_COMPRESSION_H_
+#define ITEX_CORE_GRAPH_EMBEDDING_COMPRESSION_EMBEDDING_COMPRESSION_H_
+
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "itex/core/graph/utils/graph_view.h"
+#include "itex/core/graph/utils/grappler_item.h"
+#include "itex/core/utils/node_def_util.h"
+#include "protos/graph.pb.h"
+
+namespace itex {
+namespace graph {
+
+struct EmbeddingCompressionContext {
+  explicit EmbeddingCompressionContext(const GrapplerItem& item,
+                                       GraphDef* g_def, Status* status)
+      : graph_view(g_def, status), nodes_to_preserve(item.NodesToPreserve()) {}
+
+  utils::MutableGraphView graph_view;
+  std::unordered_set<string> nodes_to_preserve;
+  // Whether each Const table is compressed. Tables whose error is above the
+  // tolerance stay in fp32.
+  std::unordered_map<string, bool> compressed_tables;
+};
+
+// Compression of fp32 embedding tables to bf16 or row-wise int8, on CPU.
+//
+// GatherV2 on axis 0 and SparseSegmentSum/Mean/SqrtN of a 2-D Const table
+// are rewritten to `_ITEXCompressedGather` and
+// `_ITEXCompressedSparseSegmentReduction`, which only dequantize the looked
+// up rows and still output fp32.
+//
+// The table is compressed here, and kept in fp32 if the relative error is
+// above `tolerance`. Variable tables aren't compressed, as nothing in the
+// graph tells when they're assigned.
+Status RunEmbeddingCompression(const char* device_name,
+                               const GrapplerItem& item,
+                               const GraphDef& graph_def,
+                               GraphDef* optimized_graph, DataType dtype,
+                               float tolerance);
+
+}  // namespace graph
+}  // namespace itex
+
+#endif  // ITEX_CORE_GRAPH_EMBEDDING_COMPRESSION_EMBEDDING_COMPRESSION_H_
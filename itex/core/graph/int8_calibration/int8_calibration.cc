@@ -0,0 +1,510 @@
+/* Copyright (c) 2022 Intel Corporation
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "itex/core/graph/int8_calibration/int8_calibration.h"
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "itex/core/graph/utils/op_types.h"
+#include "itex/core/graph/utils/utils.h"
+#include "itex/core/utils/attr_value_util.h"
+#include "itex/core/utils/calibration_stats.h"
+#include "itex/core/utils/hash.h"
+#include "itex/core/utils/onednn/onednn_post_op_util.h"
+#include "itex/core/utils/plugin_tensor.h"
+#include "itex/core/utils/strcat.h"
+#include "itex/core/utils/types.h"
+
+namespace itex {
+namespace graph {
+
+namespace {
+
+constexpr char kCollector[] = "_ITEXMinMaxCollector";
+
+// Ranges narrower than this are widened, so the scales stay finite.
+constexpr float kMinRange = 1e-4f;
+
+string InputKey(const Int8CalibrationContext& ctx, const string& node_name) {
+  return strings::StrCat(ctx.graph_scope, "/", node_name, ":input");
+}
+string OutputKey(const Int8CalibrationContext& ctx, const string& node_name) {
+  return strings::StrCat(ctx.graph_scope, "/", node_name, ":output");
+}
+
+bool IsCalibratedConv(const NodeDef& node_def) {
+  return node_def.op() == "_ITEXFusedConv2D" ||
+         node_def.op() == "_FusedConv2D";
+}
+
+bool IsCalibratedMatMul(const NodeDef& node_def) {
+  return node_def.op() == "_ITEXFusedMatMul" ||
+         node_def.op() == "_FusedMatMul";
+}
+
+// fp32 Conv2D/MatMul with const weight, fused with BiasAdd and at most one
+// activation the quantized kernels support.
+bool IsEligible(const utils::MutableNodeView& node_view) {
+  const NodeDef& node_def = *(node_view.node());
+  const bool is_conv = IsCalibratedConv(node_def);
+  if (!is_conv && !IsCalibratedMatMul(node_def)) return false;
+
+  DataType T;
+  if (!TryGetNodeAttr(node_def, "T", &T) || T != DT_FLOAT) return false;
+  if (node_view.NumRegularFanins() != 3) return false;
+
+  const NodeDef* weight = node_view.GetRegularFanin(1).node_view()->node();
+  if (!IsConstant(*weight)) return false;
+
+  std::vector<string> fused_ops;
+  if (!TryGetNodeAttr(node_def, "fused_ops", &fused_ops)) return false;
+  if (fused_ops.empty() || fused_ops.size() > 2 || fused_ops[0] != "BiasAdd")
+    return false;
+
+  if (is_conv) {
+    // The quantized Conv2D is NHWC only and fuses nothing but Relu.
+    string data_format, padding;
+    if (!TryGetNodeAttr(node_def, "data_format", &data_format) ||
+        data_format != "NHWC")
+      return false;
+    if (!TryGetNodeAttr(node_def, "padding", &padding) || padding == "EXPLICIT")
+      return false;
+    return fused_ops.size() == 1 || fused_ops[1] == "Relu";
+  }
+
+  bool transpose_a = false;
+  if (TryGetNodeAttr(node_def, "transpose_a", &transpose_a) && transpose_a)
+    return false;
+  if (fused_ops.size() == 2) {
+    PostOpUtil post_op_util;
+    if (!post_op_util.AddOps({fused_ops[1]}) || !post_op_util.HasActivation())
+      return false;
+  }
+  return true;
+}
+
+NodeDef MakeCollector(const string& name, const string& device,
+                      const string& input, const string& key) {
+  NodeDef collector;
+  collector.set_name(name);
+  collector.set_op(kCollector);
+  collector.set_device(device);
+  collector.add_input(input);
+  auto* attr = collector.mutable_attr();
+  SetAttrValue(DT_FLOAT, &(*attr)["T"]);
+  SetAttrValue(key, &(*attr)["key"]);
+  return collector;
+}
+
+NodeDef MakeConst(const string& name, const string& device, Tensor* value) {
+  NodeDef const_node;
+  const_node.set_name(name);
+  const_node.set_op("Const");
+  const_node.set_device(device);
+  auto* attr = const_node.mutable_attr();
+  SetAttrValue(value->dtype(), &(*attr)["dtype"]);
+  value->AsProtoTensorContent((*attr)["value"].mutable_tensor());
+  return const_node;
+}
+
+NodeDef MakeFloatConst(const string& name, const string& device,
+                       const std::vector<float>& values, bool is_scalar) {
+  Tensor value(DT_FLOAT,
+               is_scalar ? TensorShape()
+                         : TensorShape({static_cast<int64>(values.size())}));
+  auto flat = value.flat<float>();
+  for (size_t i = 0; i < values.size(); ++i) flat(i) = values[i];
+  return MakeConst(name, device, &value);
+}
+
+// Quantizes the weight to s8 with a symmetric range per output channel,
+// which is the last dimension, or the first one with `channel_first`.
+// Returns the int8 weight, and the ranges in `min_range` and `max_range`.
+Tensor QuantizeWeight(const Tensor& weight, bool channel_first,
+                      std::vector<float>* min_range,
+                      std::vector<float>* max_range) {
+  const int64 num_channels =
+      channel_first ? weight.dim_size(0) : weight.dim_size(weight.dims() - 1);
+  const int64 channel_size = weight.NumElements() / num_channels;
+  auto w = weight.flat<float>();
+  auto channel_of = [&](int64 i) {
+    return channel_first ? i / channel_size : i % num_channels;
+  };
+
+  std::vector<float> absmax(num_channels, 0.0f);
+  for (int64 i = 0; i < weight.NumElements(); ++i) {
+    float& m = absmax[channel_of(i)];
+    m = std::max(m, std::abs(w(i)));
+  }
+
+  Tensor qweight(DT_QINT8, weight.shape());
+  auto q = qweight.flat<qint8>();
+  for (int64 i = 0; i < weight.NumElements(); ++i) {
+    const float range = std::max(absmax[channel_of(i)], kMinRange);
+    const float scaled = std::round(w(i) * 127.0f / range);
+    q(i) = static_cast<int8>(std::min(127.0f, std::max(-127.0f, scaled)));
+  }
+
+  min_range->resize(num_channels);
+  max_range->resize(num_channels);
+  for (int64 c = 0; c < num_channels; ++c) {
+    (*max_range)[c] = std::max(absmax[c], kMinRange);
+    (*min_range)[c] = -(*max_range)[c];
+  }
+  return qweight;
+}
+
+// Inserts collectors on the input of an eligible node, and on the output of
+// Conv2D unless it's fetched, as the consumers can't be rewired then.
+// Nothing is done if the node already has them, as the graph may be optimized
+// more than once.
+Status InsertCollectors(Int8CalibrationContext* ctx, const string& node_name) {
+  auto* node_view = ctx->graph_view.GetNode(node_name);
+  const NodeDef* node_def = node_view->node();
+  const string& device = node_def->device();
+  if (node_view->GetRegularFanin(0).node_view()->node()->op() == kCollector) {
+    return Status::OK();
+  }
+
+  utils::Mutation* mutation = ctx->graph_view.GetMutationBuilder();
+  Status status;
+
+  const string input_collector = node_name + "/input_collector";
+  mutation->AddNode(MakeCollector(input_collector, device, node_def->input(0),
+                                  InputKey(*ctx, node_name)),
+                    &status);
+  TF_RETURN_IF_ERROR(status);
+  mutation->AddOrUpdateRegularFanin(node_view, 0, {input_collector, 0});
+
+  if (IsCalibratedConv(*node_def) &&
+      ctx->nodes_to_preserve.count(node_name) == 0) {
+    const string output_collector = node_name + "/output_collector";
+    mutation->AddNode(MakeCollector(output_collector, device, node_name,
+                                    OutputKey(*ctx, node_name)),
+                      &status);
+    TF_RETURN_IF_ERROR(status);
+    for (const auto& fanout : node_view->GetRegularFanout(0)) {
+      mutation->AddOrUpdateRegularFanin(fanout.node_view(), fanout.index(),
+                                        {output_collector, 0});
+    }
+  }
+
+  return mutation->Apply();
+}
+
+// Adds `QuantizeV2` of input 0 with its recorded range, unsigned if the
+// range has no negative values.
+Status AddQuantizeInput(utils::Mutation* mutation, const NodeDef& node_def,
+                        const CalibrationStats::Range& range,
+                        const string& quantize_name, bool* is_unsigned) {
+  const string& device = node_def.device();
+  *is_unsigned = range.min >= 0.0f;
+  const float max_abs =
+      std::max({std::abs(range.min), std::abs(range.max), kMinRange});
+  const float min_input = *is_unsigned ? 0.0f : -max_abs;
+  const float max_input =
+      *is_unsigned ? std::max(range.max, kMinRange) : max_abs;
+
+  Status status;
+  mutation->AddNode(MakeFloatConst(quantize_name + "/min", device, {min_input},
+                                   /*is_scalar=*/true),
+                    &status);
+  TF_RETURN_IF_ERROR(status);
+  mutation->AddNode(MakeFloatConst(quantize_name + "/max", device, {max_input},
+                                   /*is_scalar=*/true),
+                    &status);
+  TF_RETURN_IF_ERROR(status);
+
+  NodeDef quantize;
+  quantize.set_name(quantize_name);
+  quantize.set_op("QuantizeV2");
+  quantize.set_device(device);
+  quantize.add_input(node_def.input(0));
+  quantize.add_input(quantize_name + "/min");
+  quantize.add_input(quantize_name + "/max");
+  auto* attr = quantize.mutable_attr();
+  SetAttrValue(*is_unsigned ? DT_QUINT8 : DT_QINT8, &(*attr)["T"]);
+  SetAttrValue("SCALED", &(*attr)["mode"]);
+  SetAttrValue("HALF_TO_EVEN", &(*attr)["round_mode"]);
+  SetAttrValue(false, &(*attr)["narrow_range"]);
+  SetAttrValue(-1, &(*attr)["axis"]);
+  // The recorded range is used as is, it's already at least kMinRange.
+  SetAttrValue(0.0f, &(*attr)["ensure_minimum_range"]);
+  mutation->AddNode(std::move(quantize), &status);
+  return status;
+}
+
+// Adds the offline quantized weight and its per-channel ranges as Const
+// nodes named `prefix` + "/weight", "/min_weight" and "/max_weight".
+Status AddQuantizedWeight(utils::Mutation* mutation, const NodeDef& weight,
+                          const string& prefix, const string& device,
+                          bool channel_first) {
+  const TensorProto& proto = weight.attr().at("value").tensor();
+  Tensor value(proto.dtype(), proto.tensor_shape());
+  if (!value.FromProto(proto)) {
+    return errors::InvalidArgument("Can't parse the weight of ", prefix);
+  }
+  std::vector<float> min_range, max_range;
+  Tensor qweight =
+      QuantizeWeight(value, channel_first, &min_range, &max_range);
+
+  Status status;
+  mutation->AddNode(MakeConst(prefix + "/weight", device, &qweight), &status);
+  TF_RETURN_IF_ERROR(status);
+  mutation->AddNode(MakeFloatConst(prefix + "/min_weight", device, min_range,
+                                   /*is_scalar=*/false),
+                    &status);
+  TF_RETURN_IF_ERROR(status);
+  mutation->AddNode(MakeFloatConst(prefix + "/max_weight", device, max_range,
+                                   /*is_scalar=*/false),
+                    &status);
+  return status;
+}
+
+// MatMul + BiasAdd (+ activation) is replaced in place by
+// `_QuantizedFusedMatMulAndDequantize`, whose output is still fp32.
+Status QuantizeMatMul(Int8CalibrationContext* ctx, const string& node_name,
+                      const CalibrationStats::Range& input_range) {
+  auto* node_view = ctx->graph_view.GetNode(node_name);
+  const NodeDef& node_def = *(node_view->node());
+  const NodeDef& weight = *(node_view->GetRegularFanin(1).node_view()->node());
+  const NodeDef& bias = *(node_view->GetRegularFanin(2).node_view()->node());
+  const string& device = node_def.device();
+  bool transpose_b = false;
+  TryGetNodeAttr(node_def, "transpose_b", &transpose_b);
+
+  utils::Mutation* mutation = ctx->graph_view.GetMutationBuilder();
+  Status status;
+  const string quantize_name = node_name + "/quantize";
+  bool is_unsigned = false;
+  TF_RETURN_IF_ERROR(AddQuantizeInput(mutation, node_def, input_range,
+                                      quantize_name, &is_unsigned));
+  TF_RETURN_IF_ERROR(AddQuantizedWeight(mutation, weight, node_name, device,
+                                        /*channel_first=*/transpose_b));
+
+  NodeDef matmul;
+  matmul.set_name(node_name);
+  matmul.set_op("_QuantizedFusedMatMulAndDequantize");
+  matmul.set_device(device);
+  matmul.add_input(quantize_name);
+  matmul.add_input(node_name + "/weight");
+  matmul.add_input(node_def.input(2));
+  matmul.add_input(quantize_name + ":1");
+  matmul.add_input(quantize_name + ":2");
+  matmul.add_input(node_name + "/min_weight");
+  matmul.add_input(node_name + "/max_weight");
+  for (int i = node_view->NumRegularFanins(); i < node_def.input_size(); ++i) {
+    matmul.add_input(node_def.input(i));
+  }
+
+  auto* attr = matmul.mutable_attr();
+  SetAttrValue(is_unsigned ? DT_QUINT8 : DT_QINT8, &(*attr)["T1"]);
+  SetAttrValue(DT_QINT8, &(*attr)["T2"]);
+  SetAttrValue(1, &(*attr)["num_args"]);
+  SetAttrValue(DT_FLOAT, &(*attr)["Targs"]);
+  SetAttrValue(DT_FLOAT, &(*attr)["Toutput"]);
+  SetAttrValue(false, &(*attr)["transpose_a"]);
+  SetAttrValue(transpose_b, &(*attr)["transpose_b"]);
+  (*attr)["fused_ops"] = node_def.attr().at("fused_ops");
+  SetAttrValue(true, &(*attr)["is_filter_const"]);
+  SetAttrValue(IsConstant(bias), &(*attr)["is_bias_const"]);
+  if (HasNodeAttr(node_def, "leakyrelu_alpha")) {
+    (*attr)["leakyrelu_alpha"] = node_def.attr().at("leakyrelu_alpha");
+  }
+  SetAttrValue("SCALED", &(*attr)["input_quant_mode"]);
+
+  mutation->AddNode(std::move(matmul), &status);
+  TF_RETURN_IF_ERROR(status);
+  return mutation->Apply();
+}
+
+// Conv2D + BiasAdd (+ Relu) is replaced by the quantized Conv2D which
+// requantizes to the recorded output range, and a `Dequantize` that keeps
+// the original name, so consumers are unchanged.
+Status QuantizeConv(Int8CalibrationContext* ctx, const string& node_name,
+                    const CalibrationStats::Range& input_range,
+                    const CalibrationStats::Range& output_range) {
+  auto* node_view = ctx->graph_view.GetNode(node_name);
+  const NodeDef& node_def = *(node_view->node());
+  const NodeDef& weight = *(node_view->GetRegularFanin(1).node_view()->node());
+  const string& device = node_def.device();
+  std::vector<string> fused_ops;
+  TF_RETURN_IF_ERROR(GetNodeAttr(node_def, "fused_ops", &fused_ops));
+  const bool has_relu = fused_ops.size() == 2;
+
+  utils::Mutation* mutation = ctx->graph_view.GetMutationBuilder();
+  Status status;
+  const string quantize_name = node_name + "/quantize";
+  bool is_unsigned = false;
+  TF_RETURN_IF_ERROR(AddQuantizeInput(mutation, node_def, input_range,
+                                      quantize_name, &is_unsigned));
+  TF_RETURN_IF_ERROR(AddQuantizedWeight(mutation, weight, node_name, device,
+                                        /*channel_first=*/false));
+
+  // Relu output is requantized to u8 over [0, max], otherwise to s8 over a
+  // symmetric range.
+  const float max_abs = std::max(
+      {std::abs(output_range.min), std::abs(output_range.max), kMinRange});
+  const float max_output =
+      has_relu ? std::max(output_range.max, kMinRange) : max_abs;
+  const float min_output = has_relu ? 0.0f : -max_abs;
+  mutation->AddNode(MakeFloatConst(node_name + "/min_output", device,
+                                   {min_output}, /*is_scalar=*/true),
+                    &status);
+  TF_RETURN_IF_ERROR(status);
+  mutation->AddNode(MakeFloatConst(node_name + "/max_output", device,
+                                   {max_output}, /*is_scalar=*/true),
+                    &status);
+  TF_RETURN_IF_ERROR(status);
+
+  const DataType out_type = has_relu ? DT_QUINT8 : DT_QINT8;
+  const string conv_name = node_name + "/int8";
+  NodeDef conv;
+  conv.set_name(conv_name);
+  conv.set_op(has_relu ? "QuantizedConv2DWithBiasAndReluAndRequantize"
+                       : "QuantizedConv2DWithBiasAndRequantize");
+  conv.set_device(device);
+  conv.add_input(quantize_name);
+  conv.add_input(node_name + "/weight");
+  conv.add_input(node_def.input(2));
+  conv.add_input(quantize_name + ":1");
+  conv.add_input(quantize_name + ":2");
+  conv.add_input(node_name + "/min_weight");
+  conv.add_input(node_name + "/max_weight");
+  conv.add_input(node_name + "/min_output");
+  conv.add_input(node_name + "/max_output");
+  for (int i = node_view->NumRegularFanins(); i < node_def.input_size(); ++i) {
+    conv.add_input(node_def.input(i));
+  }
+
+  auto* attr = conv.mutable_attr();
+  SetAttrValue(is_unsigned ? DT_QUINT8 : DT_QINT8, &(*attr)["Tinput"]);
+  SetAttrValue(DT_QINT8, &(*attr)["Tfilter"]);
+  SetAttrValue(DT_FLOAT, &(*attr)["Tbias"]);
+  SetAttrValue(out_type, &(*attr)["out_type"]);
+  (*attr)["strides"] = node_def.attr().at("strides");
+  (*attr)["padding"] = node_def.attr().at("padding");
+  if (HasNodeAttr(node_def, "dilations")) {
+    (*attr)["dilations"] = node_def.attr().at("dilations");
+  }
+  mutation->AddNode(std::move(conv), &status);
+  TF_RETURN_IF_ERROR(status);
+
+  NodeDef dequantize;
+  dequantize.set_name(node_name);
+  dequantize.set_op("Dequantize");
+  dequantize.set_device(device);
+  dequantize.add_input(conv_name);
+  dequantize.add_input(conv_name + ":1");
+  dequantize.add_input(conv_name + ":2");
+  attr = dequantize.mutable_attr();
+  SetAttrValue(out_type, &(*attr)["T"]);
+  SetAttrValue("SCALED", &(*attr)["mode"]);
+  SetAttrValue(false, &(*attr)["narrow_range"]);
+  SetAttrValue(-1, &(*attr)["axis"]);
+  SetAttrValue(DT_FLOAT, &(*attr)["dtype"]);
+  mutation->AddNode(std::move(dequantize), &status);
+  TF_RETURN_IF_ERROR(status);
+  return mutation->Apply();
+}
+
+// Fingerprint of the names and weights of `nodes`, in any order. It's the
+// same when collecting and quantizing a graph, and differs between graphs
+// which only share node names.
+string GraphScope(const Int8CalibrationContext& ctx,
+                  const std::vector<string>& nodes) {
+  uint64 fingerprint = 0;
+  for (const string& node_name : nodes) {
+    const NodeDef* weight = ctx.graph_view.GetNode(node_name)
+                                ->GetRegularFanin(1)
+                                .node_view()
+                                ->node();
+    const uint64 node_fingerprint = Hash64Combine(
+        Hash64(node_name),
+        Hash64(weight->attr().at("value").tensor().SerializeAsString()));
+    fingerprint = Hash64CombineUnordered(fingerprint, node_fingerprint);
+  }
+  return strings::StrCat(strings::Hex(fingerprint, strings::kZeroPad16));
+}
+
+Status QuantizeNode(Int8CalibrationContext* ctx, const string& node_name) {
+  auto* stats = CalibrationStats::Global();
+  CalibrationStats::Range input_range;
+  if (!stats->Lookup(InputKey(*ctx, node_name), &input_range)) {
+    ITEX_VLOG(2) << "Int8Calibration: no input range of " << node_name;
+    return Status::OK();
+  }
+
+  if (IsCalibratedMatMul(*(ctx->graph_view.GetNode(node_name)->node()))) {
+    return QuantizeMatMul(ctx, node_name, input_range);
+  }
+
+  CalibrationStats::Range output_range;
+  if (!stats->Lookup(OutputKey(*ctx, node_name), &output_range)) {
+    ITEX_VLOG(2) << "Int8Calibration: no output range of " << node_name;
+    return Status::OK();
+  }
+  return QuantizeConv(ctx, node_name, input_range, output_range);
+}
+
+}  // namespace
+
+Status RunInt8Calibration(const char* device_name, const GrapplerItem& item,
+                          const GraphDef& graph_def, GraphDef* optimized_graph,
+                          bool collect) {
+  Status status;
+  GraphDef mutable_graph_def = graph_def;
+  Int8CalibrationContext ctx(item, &mutable_graph_def, &status);
+  TF_RETURN_IF_ERROR(status);
+
+  // Nodes are looked up by name, as rewriting one adds nodes to the graph.
+  std::vector<string> eligible_nodes;
+  for (int i = 0; i < ctx.graph_view.NumNodes(); ++i) {
+    const auto* node_view = ctx.graph_view.GetNode(i);
+    if (!NodeIsOnDevice(device_name, node_view->node())) continue;
+    if (IsEligible(*node_view)) eligible_nodes.push_back(node_view->GetName());
+  }
+
+  if (eligible_nodes.empty()) {
+    *optimized_graph = std::move(mutable_graph_def);
+    return Status::OK();
+  }
+  ctx.graph_scope = GraphScope(ctx, eligible_nodes);
+
+  ITEX_VLOG(1) << "Int8Calibration: " << (collect ? "collect" : "quantize")
+               << " on " << eligible_nodes.size() << " nodes of graph "
+               << ctx.graph_scope << ".";
+
+  for (const string& node_name : eligible_nodes) {
+    Status s = collect ? InsertCollectors(&ctx, node_name)
+                       : QuantizeNode(&ctx, node_name);
+    if (!s.ok()) {
+      // Drop what was added for this node, it stays in fp32.
+      ctx.graph_view.GetMutationBuilder()->Reset();
+      ITEX_VLOG(2) << "Int8Calibration: failed to rewrite " << node_name
+                   << ": " << s;
+    }
+  }
+
+  *optimized_graph = std::move(mutable_graph_def);
+  return Status::OK();
+}
+
+}  // namespace graph
+}  // namespace itex
@@ -0,0 +1,63 @@
+/* Copyright (c) 2022 Intel Corporation
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef ITEX_CORE_GRAPH_INT8_CALIBRATION_INT8_CALIBRATION_H_
+#define ITEX_CORE_GRAPH_INT8_CALIBRATION_INT8_CALIBRATION_H_
+
+#include <string>
+#include <unordered_set>
+
+#include "itex/core/graph/utils/graph_view.h"
+#include "itex/core/graph/utils/grappler_item.h"
+#include "itex/core/utils/node_def_util.h"
+#include "protos/graph.pb.h"
+
+namespace itex {
+namespace graph {
+
+struct Int8CalibrationContext {
+  explicit Int8CalibrationContext(const GrapplerItem& item, GraphDef* g_def,
+                                  Status* status)
+      : graph_view(g_def, status), nodes_to_preserve(item.NodesToPreserve()) {}
+
+  utils::MutableGraphView graph_view;
+  std::unordered_set<string> nodes_to_preserve;
+  // Prefix of the range keys of this graph, see RunInt8Calibration.
+  string graph_scope;
+};
+
+// INT8 calibration of fp32 Conv2D/MatMul fused with BiasAdd and a const
+// weight, on CPU.
+//
+// With `collect`, a `_ITEXMinMaxCollector` is inserted on the input of each
+// eligible node, and on the output of Conv2D which needs it to requantize.
+// Running the graph on representative data records the ranges in
+// CalibrationStats. Ranges are keyed by a fingerprint of the names and
+// weights of the eligible nodes, so graphs sharing node names don't mix up
+// their ranges.
+//
+// Without `collect`, nodes with recorded ranges are rewritten to INT8:
+// the input is quantized by `QuantizeV2` with the recorded range, the weight
+// is quantized offline to s8 with one scale per output channel, MatMul
+// becomes `_QuantizedFusedMatMulAndDequantize` and Conv2D becomes
+// `QuantizedConv2DWithBias[AndRelu]AndRequantize` followed by `Dequantize`.
+Status RunInt8Calibration(const char* device_name, const GrapplerItem& item,
+                          const GraphDef& graph_def, GraphDef* optimized_graph,
+                          bool collect);
+
+}  // namespace graph
+}  // namespace itex
+
+#endif  // ITEX_CORE_GRAPH_INT8_CALIBRATION_INT8_CALIBRATION_H_
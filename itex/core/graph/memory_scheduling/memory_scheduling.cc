@@ -0,0 +1,374 @@
+/* Copyright (c) 2022 Intel Corporation
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "itex/core/graph/memory_scheduling/memory_scheduling.h"
+
+#include <algorithm>
+#include <deque>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "itex/core/graph/utils/graph_properties.h"
+#include "itex/core/graph/utils/op_types.h"
+#include "itex/core/graph/utils/utils.h"
+#include "itex/core/utils/types.h"
+
+namespace itex {
+namespace graph {
+
+namespace {
+// Pruning tries each added control dependency with one executor simulation,
+// so it's skipped when `num_edges * num_nodes` is above this.
+constexpr int64_t kMaxPruneWork = int64_t{1} << 26;
+
+int64_t TensorBytes(const OpInfo_TensorProperties& prop) {
+  if (prop.shape().unknown_rank()) return 0;
+  int64_t num_elements = 1;
+  for (const auto& dim : prop.shape().dim()) {
+    if (dim.size() < 0) return 0;
+    num_elements *= dim.size();
+  }
+  return num_elements * DataTypeSize(prop.dtype());
+}
+
+int64_t OutputBytes(const MemorySchedulingContext* ctx, int node) {
+  int64_t bytes = 0;
+  for (int64_t b : ctx->output_bytes[node]) bytes += b;
+  return bytes;
+}
+
+// Fills the per node information of `ctx` from the sorted graph.
+void InitSchedulingInfo(MemorySchedulingContext* ctx,
+                        const GraphProperties& properties) {
+  const int num_nodes = ctx->graph_view.NumNodes();
+  ctx->preds.assign(num_nodes, {});
+  ctx->succs.assign(num_nodes, {});
+  ctx->output_bytes.assign(num_nodes, {});
+  ctx->num_consumers.assign(num_nodes, {});
+  ctx->inputs.assign(num_nodes, {});
+  ctx->is_inplace.assign(num_nodes, false);
+  ctx->keep_alive.assign(num_nodes, false);
+
+  for (int i = 0; i < num_nodes; ++i) {
+    const auto* node_view = ctx->graph_view.GetNode(i);
+    const NodeDef* node_def = node_view->node();
+
+    std::vector<OpInfo_TensorProperties> props;
+    // Feeds, constants and variables aren't activations.
+    if (!IsPersistent(*node_def) && !IsPlaceholder(*node_def) &&
+        !IsArg(*node_def)) {
+      properties.GetOutputProperties(node_def->name(), &props).IgnoreError();
+    }
+    const int num_outputs = std::max<int>(
+        props.size(), node_view->GetRegularFanouts().size());
+    ctx->output_bytes[i].assign(num_outputs, 0);
+    ctx->num_consumers[i].assign(num_outputs, 0);
+    for (int port = 0; port < props.size(); ++port) {
+      ctx->output_bytes[i][port] = TensorBytes(props[port]);
+    }
+
+    for (const auto& fanin : node_view->GetRegularFanins()) {
+      std::pair<int, int> tensor(fanin.node_index(), fanin.index());
+      if (std::find(ctx->inputs[i].begin(), ctx->inputs[i].end(), tensor) ==
+          ctx->inputs[i].end()) {
+        ctx->inputs[i].push_back(tensor);
+      }
+      ctx->preds[i].push_back(fanin.node_index());
+    }
+    for (const auto& fanin : node_view->GetControllingFanins()) {
+      ctx->preds[i].push_back(fanin.node_index());
+    }
+    std::sort(ctx->preds[i].begin(), ctx->preds[i].end());
+    ctx->preds[i].erase(std::unique(ctx->preds[i].begin(), ctx->preds[i].end()),
+                        ctx->preds[i].end());
+
+    bool is_inplace = false;
+    bool inplace_sum = false;
+    TryGetNodeAttr(*node_def, "is_inplace", &is_inplace);
+    TryGetNodeAttr(*node_def, "inplace_sum", &inplace_sum);
+    ctx->is_inplace[i] = is_inplace || inplace_sum;
+    ctx->keep_alive[i] = ctx->nodes_to_preserve.count(node_def->name()) > 0;
+  }
+
+  for (int i = 0; i < num_nodes; ++i) {
+    for (int pred : ctx->preds[i]) ctx->succs[pred].push_back(i);
+    for (const auto& tensor : ctx->inputs[i]) {
+      auto& consumers = ctx->num_consumers[tensor.first];
+      // Fanins to ports without inferred properties.
+      if (tensor.second >= consumers.size()) {
+        consumers.resize(tensor.second + 1, 0);
+        ctx->output_bytes[tensor.first].resize(tensor.second + 1, 0);
+      }
+      ++consumers[tensor.second];
+    }
+  }
+}
+
+// Net change of live bytes if `node` runs next, given the remaining consumers
+// of each tensor.
+int64_t MemoryDelta(const MemorySchedulingContext* ctx,
+                    const std::vector<std::vector<int>>& remaining, int node) {
+  int64_t delta = 0;
+  for (int port = 0; port < ctx->output_bytes[node].size(); ++port) {
+    if (ctx->num_consumers[node][port] > 0 || ctx->keep_alive[node]) {
+      delta += ctx->output_bytes[node][port];
+    }
+  }
+  for (const auto& tensor : ctx->inputs[node]) {
+    if (remaining[tensor.first][tensor.second] == 1 &&
+        !ctx->keep_alive[tensor.first]) {
+      delta -= ctx->output_bytes[tensor.first][tensor.second];
+    }
+  }
+  return delta;
+}
+
+}  // namespace
+
+int64_t EstimatePeakMemory(const MemorySchedulingContext* ctx,
+                           const std::vector<int>& order) {
+  std::vector<std::vector<int>> remaining = ctx->num_consumers;
+  int64_t live = 0;
+  int64_t peak = 0;
+
+  for (int node : order) {
+    const auto& bytes = ctx->output_bytes[node];
+    // An inplace output takes over its input buffer, so it isn't allocated.
+    int64_t allocated = OutputBytes(ctx, node);
+    if (ctx->is_inplace[node] && !bytes.empty()) allocated -= bytes[0];
+    peak = std::max(peak, live + allocated);
+
+    live += OutputBytes(ctx, node);
+    for (const auto& tensor : ctx->inputs[node]) {
+      if (--remaining[tensor.first][tensor.second] == 0 &&
+          !ctx->keep_alive[tensor.first]) {
+        live -= ctx->output_bytes[tensor.first][tensor.second];
+      }
+    }
+    if (!ctx->keep_alive[node]) {
+      for (int port = 0; port < bytes.size(); ++port) {
+        if (ctx->num_consumers[node][port] == 0) live -= bytes[port];
+      }
+    }
+  }
+
+  return peak;
+}
+
+std::vector<int> ExecutorOrder(
+    const MemorySchedulingContext* ctx,
+    const std::vector<std::vector<int>>& extra_succs) {
+  const int num_nodes = ctx->preds.size();
+  std::vector<int> in_degree(num_nodes);
+  for (int i = 0; i < num_nodes; ++i) in_degree[i] = ctx->preds[i].size();
+  for (const auto& succs : extra_succs) {
+    for (int succ : succs) ++in_degree[succ];
+  }
+
+  std::deque<int> ready;
+  for (int i = 0; i < num_nodes; ++i) {
+    if (in_degree[i] == 0) ready.push_back(i);
+  }
+
+  std::vector<int> order;
+  order.reserve(num_nodes);
+  while (!ready.empty()) {
+    const int node = ready.front();
+    ready.pop_front();
+    order.push_back(node);
+    for (int succ : ctx->succs[node]) {
+      if (--in_degree[succ] == 0) ready.push_back(succ);
+    }
+    for (int succ : extra_succs[node]) {
+      if (--in_degree[succ] == 0) ready.push_back(succ);
+    }
+  }
+
+  return order;
+}
+
+std::vector<int> MemoryAwareOrder(const MemorySchedulingContext* ctx) {
+  const int num_nodes = ctx->preds.size();
+  std::vector<std::vector<int>> remaining = ctx->num_consumers;
+  std::vector<int> in_degree(num_nodes);
+  for (int i = 0; i < num_nodes; ++i) in_degree[i] = ctx->preds[i].size();
+
+  // Nodes which allocate nothing never raise the peak, so they run as soon as
+  // they're ready. The others wait in `ready` to be picked by memory delta.
+  std::deque<int> free_ready;
+  std::vector<int> ready;
+  auto push_ready = [&](int node) {
+    if (OutputBytes(ctx, node) == 0) {
+      free_ready.push_back(node);
+    } else {
+      ready.push_back(node);
+    }
+  };
+  for (int i = 0; i < num_nodes; ++i) {
+    if (in_degree[i] == 0) push_ready(i);
+  }
+
+  std::vector<int> order;
+  order.reserve(num_nodes);
+  while (!free_ready.empty() || !ready.empty()) {
+    int node;
+    if (!free_ready.empty()) {
+      node = free_ready.front();
+      free_ready.pop_front();
+    } else {
+      int best = 0;
+      int64_t best_delta = MemoryDelta(ctx, remaining, ready[0]);
+      for (int i = 1; i < ready.size(); ++i) {
+        int64_t delta = MemoryDelta(ctx, remaining, ready[i]);
+        if (delta < best_delta ||
+            (delta == best_delta && ready[i] < ready[best])) {
+          best = i;
+          best_delta = delta;
+        }
+      }
+      node = ready[best];
+      ready[best] = ready.back();
+      ready.pop_back();
+    }
+
+    order.push_back(node);
+    for (const auto& tensor : ctx->inputs[node]) {
+      --remaining[tensor.first][tensor.second];
+    }
+    for (int succ : ctx->succs[node]) {
+      if (--in_degree[succ] == 0) push_ready(succ);
+    }
+  }
+
+  return order;
+}
+
+Status RunMemorySchedulingPass(const char* device_name,
+                               const GrapplerItem& item,
+                               const GraphDef& graph_def,
+                               GraphDef* optimized_graph) {
+  Status status;
+  GraphDef mutable_graph_def = graph_def;
+  MemorySchedulingContext ctx(item, &mutable_graph_def, &status);
+  TF_RETURN_IF_ERROR(status);
+  TF_RETURN_IF_ERROR(
+      ctx.graph_view.SortTopologically(/*ignore_cycles=*/false, {}));
+
+  const int num_nodes = ctx.graph_view.NumNodes();
+  for (int i = 0; i < num_nodes; ++i) {
+    // Control dependencies can't cross frames of v1 while loops.
+    if (IsControlFlow(*ctx.graph_view.GetNode(i)->node())) {
+      ITEX_VLOG(1) << "MemorySchedulingPass: Skip graph with control flow.";
+      *optimized_graph = graph_def;
+      return Status::OK();
+    }
+  }
+
+  GraphProperties properties(item);
+  Status s = properties.InferStatically(/*assume_valid_feeds=*/true,
+                                        /*aggressive_shape_inference=*/false,
+                                        /*include_input_tensor_values=*/false,
+                                        /*include_output_tensor_values=*/false);
+  if (!s.ok()) {
+    ITEX_VLOG(1) << "MemorySchedulingPass: Shape inference failed, " << s;
+    *optimized_graph = graph_def;
+    return Status::OK();
+  }
+  InitSchedulingInfo(&ctx, properties);
+
+  std::vector<std::vector<int>> extra_succs(num_nodes);
+  const std::vector<int> executor_order = ExecutorOrder(&ctx, extra_succs);
+  const int64_t peak_before = EstimatePeakMemory(&ctx, executor_order);
+  const std::vector<int> target_order = MemoryAwareOrder(&ctx);
+  const int64_t target_peak = EstimatePeakMemory(&ctx, target_order);
+  ITEX_VLOG(1) << "MemorySchedulingPass: Estimated peak memory " << peak_before
+               << " bytes, " << target_peak << " bytes in memory-aware order.";
+  if (target_peak >= peak_before) {
+    *optimized_graph = graph_def;
+    return Status::OK();
+  }
+
+  std::vector<int> executor_pos(num_nodes);
+  for (int i = 0; i < num_nodes; ++i) executor_pos[executor_order[i]] = i;
+
+  // Make each allocating node wait for the previous one in the target order,
+  // where the executor would run it earlier. Other nodes follow their inputs.
+  std::vector<std::pair<int, int>> edges;
+  int prev = -1;
+  for (int node : target_order) {
+    const NodeDef* node_def = ctx.graph_view.GetNode(node)->node();
+    if (OutputBytes(&ctx, node) == 0 ||
+        !NodeIsOnDevice(device_name, node_def)) {
+      continue;
+    }
+    if (prev >= 0 && executor_pos[node] < executor_pos[prev] &&
+        !ctx.preds[node].empty() && !ctx.keep_alive[node]) {
+      edges.emplace_back(prev, node);
+      extra_succs[prev].push_back(node);
+    }
+    prev = node;
+  }
+
+  int64_t peak_after =
+      EstimatePeakMemory(&ctx, ExecutorOrder(&ctx, extra_succs));
+  if (peak_after >= peak_before) {
+    ITEX_VLOG(1) << "MemorySchedulingPass: Control dependencies don't lower "
+                 << "the estimated peak memory.";
+    *optimized_graph = graph_def;
+    return Status::OK();
+  }
+
+  // Drop the control dependencies the peak doesn't need, latest first.
+  std::vector<bool> kept(edges.size(), true);
+  if (static_cast<int64_t>(edges.size()) * num_nodes <= kMaxPruneWork) {
+    for (int i = edges.size() - 1; i >= 0; --i) {
+      auto& succs = extra_succs[edges[i].first];
+      const int pos =
+          std::find(succs.begin(), succs.end(), edges[i].second) -
+          succs.begin();
+      succs.erase(succs.begin() + pos);
+      int64_t peak =
+          EstimatePeakMemory(&ctx, ExecutorOrder(&ctx, extra_succs));
+      if (peak <= peak_after) {
+        kept[i] = false;
+        peak_after = peak;
+      } else {
+        succs.insert(succs.begin() + pos, edges[i].second);
+      }
+    }
+  }
+
+  utils::Mutation* mutation = ctx.graph_view.GetMutationBuilder();
+  int num_edges = 0;
+  for (int i = 0; i < edges.size(); ++i) {
+    if (!kept[i]) continue;
+    const NodeDef* fanin = ctx.graph_view.GetNode(edges[i].first)->node();
+    mutation->AddControllingFanin(ctx.graph_view.GetNode(edges[i].second),
+                                  fanin->name());
+    ++num_edges;
+  }
+  TF_RETURN_IF_ERROR(mutation->Apply());
+
+  ITEX_LOG(INFO) << "MemorySchedulingPass: Estimated peak memory from "
+                 << peak_before << " to " << peak_after << " bytes with "
+                 << num_edges << " control dependencies.";
+
+  *optimized_graph = std::move(mutable_graph_def);
+  return Status::OK();
+}
+
+}  // namespace graph
+}  // namespace itex
@@ -0,0 +1,89 @@
+/* Copyright (c) 2022 Intel Corporation
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef ITEX_CORE_GRAPH_MEMORY_SCHEDULING_MEMORY_SCHEDULING_H_
+#define ITEX_CORE_GRAPH_MEMORY_SCHEDULING_MEMORY_SCHEDULING_H_
+
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "itex/core/graph/utils/graph_view.h"
+#include "itex/core/graph/utils/grappler_item.h"
+#include "itex/core/utils/node_def_util.h"
+#include "protos/graph.pb.h"
+
+namespace itex {
+namespace graph {
+
+struct MemorySchedulingContext {
+  explicit MemorySchedulingContext(const GrapplerItem& item, GraphDef* g_def,
+                                   Status* status)
+      : graph_view(g_def, status), nodes_to_preserve(item.NodesToPreserve()) {}
+
+  utils::MutableGraphView graph_view;
+  std::unordered_set<string> nodes_to_preserve;
+
+  // Per node, indexed like `graph_view` after the topological sort.
+  // Distinct data or control predecessors and successors.
+  std::vector<std::vector<int>> preds;
+  std::vector<std::vector<int>> succs;
+  // Inferred bytes of each output, 0 if unknown or persistent.
+  std::vector<std::vector<int64_t>> output_bytes;
+  // Distinct consumers of each output.
+  std::vector<std::vector<int>> num_consumers;
+  // Tensors read by each node, as (node, port) without duplicates.
+  std::vector<std::vector<std::pair<int, int>>> inputs;
+  // Whether output 0 reuses an input buffer, see MemoryOptPass.
+  std::vector<bool> is_inplace;
+  // Whether outputs are fetched and so alive to the end.
+  std::vector<bool> keep_alive;
+};
+
+// Estimated peak bytes of live activations when nodes run in `order`. A
+// tensor is allocated when its producer runs and freed after its last
+// consumer. Outputs of preserved nodes stay alive to the end.
+int64_t EstimatePeakMemory(const MemorySchedulingContext* ctx,
+                           const std::vector<int>& order);
+
+// Order in which nodes become ready when run one by one from a FIFO ready
+// queue, as an approximation of the TF executor. `extra_succs` holds the
+// added control dependencies.
+std::vector<int> ExecutorOrder(
+    const MemorySchedulingContext* ctx,
+    const std::vector<std::vector<int>>& extra_succs);
+
+// Topological order that greedily runs the ready node which grows the live
+// memory least, preferring the original order on ties.
+std::vector<int> MemoryAwareOrder(const MemorySchedulingContext* ctx);
+
+// Memory-aware scheduling of wide graphs.
+//
+// With many independent branches, the executor may start all of them before
+// finishing any, which keeps their large intermediates alive at once. This
+// pass uses statically inferred tensor sizes to compute a topological order
+// with a lower peak, and adds control dependencies only where they make the
+// executor follow it and lower the estimated peak. Graphs with v1 control
+// flow are left unchanged.
+Status RunMemorySchedulingPass(const char* device_name,
+                               const GrapplerItem& item,
+                               const GraphDef& graph_def,
+                               GraphDef* optimized_graph);
+
+}  // namespace graph
+}  // namespace itex
+
+#endif  // ITEX_CORE_GRAPH_MEMORY_SCHEDULING_MEMORY_SCHEDULING_H_
@@ -20,10 +20,16 @@ limitations under the License.
 #include <vector>
 
 #include "google/protobuf/text_format.h"
+#include "itex/core/graph/optimizer_config.h"
 #include "itex/core/graph/utils/graph_properties.h"
 #include "itex/core/graph/utils/op_types.h"
 #include "itex/core/graph/utils/utils.h"
 #include "itex/core/utils/attr_value_util.h"
+#include "itex/core/utils/common_shape_fns.h"
+#include "itex/core/utils/onednn/onednn_post_op_util.h"
+#include "itex/core/utils/onednn/onednn_util.h"
+#include "itex/core/utils/padding.h"
+#include "itex/core/utils/tensor_format.h"
 #include "itex/core/utils/types.h"
 
 namespace itex {
@@ -32,6 +38,36 @@ namespace graph {
 namespace {
 namespace protobuf = ::google::protobuf;
 
+// fp32 MatMul with const weight, fused with BiasAdd and at most one activation,
+// runs in INT8 with dynamic quantization if it's enabled. With layout
+// optimization on, MatMul is already rewritten by the oneDNN layout pass and
+// never reaches here.
+bool RewriteDynamicQuantizedMatMul(const utils::MutableNodeView& node_view) {
+  const NodeDef& node_def = *(node_view.node());
+  DataType T;
+  ITEX_CHECK_OK(GetNodeAttr(node_def, "T", &T));
+  if (T != DT_FLOAT) return false;
+
+  bool transpose_a = false;
+  if (TryGetNodeAttr(node_def, "transpose_a", &transpose_a) && transpose_a)
+    return false;
+
+  const NodeDef* weight = node_view.GetRegularFanin(1).node_view()->node();
+  if (!IsConstant(*weight)) return false;
+
+  std::vector<string> fused_ops;
+  ITEX_CHECK_OK(GetNodeAttr(node_def, "fused_ops", &fused_ops));
+  if (fused_ops.empty() || fused_ops.size() > 2 || fused_ops[0] != "BiasAdd")
+    return false;
+  if (fused_ops.size() == 2) {
+    PostOpUtil post_op_util;
+    if (!post_op_util.AddOps({fused_ops[1]}) || !post_op_util.HasActivation())
+      return false;
+  }
+
+  return GetOptimizerConfigFlags().enable_dynamic_int8;
+}
+
 const std::vector<NativeFormatInfo>* GetNativeFormatInfo() {
   static std::vector<NativeFormatInfo> rinfo{
       {"_FusedBatchMatMulV2", "_ITEXFusedBatchMatMulV2",
@@ -129,6 +165,12 @@ const std::vector<NativeFormatInfo>* GetNativeFormatInfo() {
       {"ResizeBilinear", "_ITEXResizeBilinear", CopyAttrsAll, RewriteResize},
       {"ResizeBilinearGrad", "_ITEXResizeBilinearGrad", CopyAttrsAll,
        RewriteResize},
+      {"ResourceScatterAdd", "_ITEXResourceScatterAdd", CopyAttrsAll,
+       AlwaysRewrite},
+      {"ResourceSparseApplyAdagrad", "_ITEXResourceSparseApplyAdagrad",
+       CopyAttrsAll, AlwaysRewrite},
+      {"ResourceSparseApplyAdagradV2", "_ITEXResourceSparseApplyAdagradV2",
+       CopyAttrsAll, AlwaysRewrite},
       {"Slice", "_ITEXSlice", CopyAttrsAll, AlwaysRewrite},
       {"Softmax", "_ITEXSoftmax", CopyAttrsAll, AlwaysRewrite},
       {"Swish", "_ITEXSwish", CopyAttrsAll, AlwaysRewrite},
@@ -150,6 +192,8 @@ const std::vector<NativeFormatInfo>* GetNativeFormatInfo() {
        RewriteFusedConv},
       {"_ITEXFusedConv3D", "_ITEXFusedConv3D", CopyAttrsAllCheckConstFilter,
        RewriteFusedConv},
+      {"_ITEXFusedMatMul", "_ITEXDynamicQuantizedMatMul",
+       CopyAttrsAllCheckConstFilter, RewriteDynamicQuantizedMatMul},
       {"_ITEXFusedMatMul", "_ITEXFusedMatMul", CopyAttrsAllCheckConstFilter,
        AlwaysRewrite},
       {"_ITEXGRUCell", "_ITEXGRUCell", CopyAttrsAllCheckConstFilter,
@@ -159,6 +203,8 @@ const std::vector<NativeFormatInfo>* GetNativeFormatInfo() {
       // Intel-TF ops. Usually these ops should always be rewritten.
       // This part is for compatibility of legacy Intel-TF models, it will be
       // removed in future.
+      {"_FusedMatMul", "_ITEXDynamicQuantizedMatMul",
+       CopyAttrsAllCheckConstFilter, RewriteDynamicQuantizedMatMul},
       {"_FusedMatMul", "_ITEXFusedMatMul", CopyAttrsAllCheckConstFilter,
        AlwaysRewrite},
       {"_MklFusedBatchMatMulV2", "_ITEXFusedBatchMatMulV2",
@@ -255,6 +301,252 @@ const std::vector<NativeFormatInfo>* GetNativeFormatInfo() {
        AlwaysRewrite}};
   return &rinfo;
 }
+
+constexpr char kConv2D[] = "_ITEXConv2D";
+constexpr char kConv2DWithReorderedFilter[] = "_ITEXConv2DWithReorderedFilter";
+constexpr char kConv2DBackpropInput[] = "_ITEXConv2DBackpropInput";
+constexpr char kConv2DBackpropInputWithReorderedFilter[] =
+    "_ITEXConv2DBackpropInputWithReorderedFilter";
+
+// Returns the forward Conv2D whose reordered filter can be passed to the
+// given Conv2DBackpropInput, or -1 if there is none. Both read the same
+// non-const filter with the same conv attributes, and the forward node is
+// ahead of the backward one in topological order, so there is no cycle.
+int FindConv2DWithSameFilter(const NativeFormatContext& ctx, int node_index) {
+  const auto* node_view = ctx.graph_view.GetNode(node_index);
+  const NodeDef* node_def = node_view->node();
+  if (node_def->op() != kConv2DBackpropInput) return -1;
+
+  const auto& filter = node_view->GetRegularFanin(1);
+  if (IsConstant(*filter.node_view()->node())) return -1;
+
+  for (const auto& fanout :
+       filter.node_view()->GetRegularFanout(filter.index())) {
+    if (fanout.index() != 1 || fanout.node_index() >= node_index) continue;
+    const NodeDef* conv_def = fanout.node_view()->node();
+    if (conv_def->op() != kConv2D &&
+        conv_def->op() != kConv2DWithReorderedFilter)
+      continue;
+    if (conv_def->device() != node_def->device()) continue;
+
+    bool is_filter_const = false;
+    if (TryGetNodeAttr(*conv_def, "is_filter_const", &is_filter_const) &&
+        is_filter_const)
+      continue;
+
+    bool is_same_attr = true;
+    for (const char* name : {"T", "strides", "padding", "explicit_paddings",
+                             "data_format", "dilations"}) {
+      const auto conv_attr = conv_def->attr().find(name);
+      const auto grad_attr = node_def->attr().find(name);
+      if ((conv_attr == conv_def->attr().end()) !=
+              (grad_attr == node_def->attr().end()) ||
+          (conv_attr != conv_def->attr().end() &&
+           !AreAttrValuesEqual(conv_attr->second, grad_attr->second))) {
+        is_same_attr = false;
+        break;
+      }
+    }
+    if (is_same_attr) return fanout.node_index();
+  }
+  return -1;
+}
+
+// Returns whether the backward data kernel can use the filter reordered by
+// the forward kernel of `conv_def`, the same check as the kernel does with
+// CanUseConvFilterLayout. Otherwise forwarding the filter only keeps an
+// extra copy of it alive. The input and filter shapes must be known.
+bool CanShareReorderedFilter(const NodeDef& conv_def,
+                             const GraphProperties& properties) {
+  std::vector<OpInfo_TensorProperties> props;
+  if (!properties.GetInputProperties(conv_def.name(), &props).ok() ||
+      props.size() < 2) {
+    return false;
+  }
+  std::vector<int64> input_shape, filter_shape;
+  for (auto shape : {std::make_pair(&props[0], &input_shape),
+                     std::make_pair(&props[1], &filter_shape)}) {
+    const TensorShapeProto& proto = shape.first->shape();
+    if (proto.unknown_rank() || proto.dim_size() != 4) return false;
+    for (const auto& dim : proto.dim()) {
+      if (dim.size() <= 0) return false;
+      shape.second->push_back(dim.size());
+    }
+  }
+
+  DataType dtype;
+  string data_format_str, padding_str;
+  std::vector<int32> strides, dilations;
+  std::vector<int64> explicit_paddings;
+  TensorFormat data_format;
+  Padding padding;
+  if (!TryGetNodeAttr(conv_def, "T", &dtype) ||
+      !TryGetNodeAttr(conv_def, "data_format", &data_format_str) ||
+      !FormatFromString(data_format_str, &data_format) ||
+      !TryGetNodeAttr(conv_def, "padding", &padding_str) ||
+      !GetPaddingFromString(padding_str, &padding).ok() ||
+      !TryGetNodeAttr(conv_def, "strides", &strides) || strides.size() != 4) {
+    return false;
+  }
+  if (!TryGetNodeAttr(conv_def, "dilations", &dilations)) {
+    dilations.assign(4, 1);
+  }
+  TryGetNodeAttr(conv_def, "explicit_paddings", &explicit_paddings);
+  if (dilations.size() != 4 ||
+      (padding == Padding::EXPLICIT && explicit_paddings.size() != 8)) {
+    return false;
+  }
+
+  dnnl::memory::data_type onednn_type;
+  if (dtype == DT_FLOAT) {
+    onednn_type = OneDnnType<float>();
+  } else if (dtype == DT_BFLOAT16) {
+    onednn_type = OneDnnType<Eigen::bfloat16>();
+  } else {
+    return false;
+  }
+
+  // Grouped convolutions are not paired.
+  const int64 channels = input_shape[GetTensorDimIndex(data_format, 'C')];
+  if (filter_shape[2] != channels) return false;
+
+  dnnl::memory::dims src_dims = {
+      input_shape[GetTensorDimIndex(data_format, 'N')], channels};
+  dnnl::memory::dims dst_dims = {src_dims[0], filter_shape[3]};
+  dnnl::memory::dims filter_dims = {filter_shape[3], filter_shape[2],
+                                    filter_shape[0], filter_shape[1]};
+  dnnl::memory::dims stride_dims, dilation_dims, pad_left, pad_right;
+  for (int i = 0; i < 2; ++i) {
+    const int dim = GetTensorDimIndex(data_format, i == 0 ? 'H' : 'W');
+    int64 output_size = 0, pad_before = 0, pad_after = 0;
+    if (padding == Padding::EXPLICIT) {
+      pad_before = explicit_paddings[2 * dim];
+      pad_after = explicit_paddings[2 * dim + 1];
+    }
+    if (!GetWindowedOutputSizeVerboseV2(input_shape[dim], filter_shape[i],
+                                        dilations[dim], strides[dim], padding,
+                                        &output_size, &pad_before, &pad_after)
+             .ok()) {
+      return false;
+    }
+    src_dims.push_back(input_shape[dim]);
+    dst_dims.push_back(output_size);
+    stride_dims.push_back(strides[dim]);
+    // OneDNN dilations start from 0.
+    dilation_dims.push_back(dilations[dim] - 1);
+    pad_left.push_back(pad_before);
+    pad_right.push_back(pad_after);
+  }
+
+  try {
+    static dnnl::engine cpu_engine(dnnl::engine::kind::cpu, 0);
+    using tag = dnnl::memory::format_tag;
+    dnnl::memory::desc src_md(src_dims, onednn_type, tag::nhwc);
+    dnnl::memory::desc dst_md(dst_dims, onednn_type, tag::nhwc);
+    dnnl::memory::desc filter_md(filter_dims, onednn_type, tag::hwio);
+    dnnl::memory::desc filter_md_any(filter_dims, onednn_type, tag::any);
+
+    dnnl::primitive_attr attr;
+    attr.set_scratchpad_mode(dnnl::scratchpad_mode::user);
+    if (dtype == DT_FLOAT) attr.set_fpmath_mode(GetFP32MathMode<CPUDevice>());
+
+    dnnl::convolution_forward::primitive_desc fwd_pd(
+        dnnl::convolution_forward::desc(
+            dnnl::prop_kind::forward, dnnl::algorithm::convolution_direct,
+            src_md, filter_md_any, dst_md, stride_dims, dilation_dims, pad_left,
+            pad_right),
+        attr, cpu_engine);
+    // The forward kernel doesn't reorder a filter which is already in the
+    // layout it wants.
+    if (fwd_pd.weights_desc() == filter_md) return false;
+
+    dnnl::convolution_backward_data::desc any_desc(
+        dnnl::algorithm::convolution_direct, src_md, filter_md_any, dst_md,
+        stride_dims, dilation_dims, pad_left, pad_right);
+    dnnl::convolution_backward_data::desc shared_desc(
+        dnnl::algorithm::convolution_direct, src_md, fwd_pd.weights_desc(),
+        dst_md, stride_dims, dilation_dims, pad_left, pad_right);
+    return CanUseConvFilterLayout(fwd_pd.weights_desc(), any_desc,
+                                  shared_desc, attr, cpu_engine, fwd_pd);
+  } catch (dnnl::error& e) {
+    ITEX_VLOG(2) << "NativeLayoutPass: can't check filter sharing of "
+                 << conv_def.name() << ": " << e.message;
+    return false;
+  }
+}
+
+// Lets Conv2DBackpropInput reuse the filter reordered by the forward Conv2D
+// of the same training step instead of reordering it again. Pairs are only
+// rewritten when the backward kernel can use the forwarded layout.
+Status ShareReorderedFilter(const GrapplerItem& item,
+                            NativeFormatContext* ctx) {
+  std::vector<std::pair<int, int>> candidates;
+  for (int node_index = 0; node_index < ctx->graph_view.NumNodes();
+       ++node_index) {
+    int conv_index = FindConv2DWithSameFilter(*ctx, node_index);
+    if (conv_index >= 0) candidates.emplace_back(conv_index, node_index);
+  }
+  if (candidates.empty()) return Status::OK();
+
+  GraphProperties properties(item);
+  Status s = properties.InferStatically(/*assume_valid_feeds=*/true,
+                                        /*aggressive_shape_inference=*/false,
+                                        /*include_input_tensor_values=*/false,
+                                        /*include_output_tensor_values=*/false);
+  if (!s.ok()) {
+    ITEX_VLOG(1) << "NativeLayoutPass: Shape inference failed, " << s;
+    return Status::OK();
+  }
+  std::vector<std::pair<int, int>> pairs;
+  for (const auto& candidate : candidates) {
+    const NodeDef* conv_def = ctx->graph_view.GetNode(candidate.first)->node();
+    if (CanShareReorderedFilter(*conv_def, properties)) {
+      pairs.push_back(candidate);
+    }
+  }
+  if (pairs.empty()) return Status::OK();
+
+  // Forward nodes are rewritten first, so the new fanins of backward nodes
+  // refer to outputs which exist.
+  utils::Mutation* mutation = ctx->graph_view.GetMutationBuilder();
+  Status status;
+  for (const auto& pair : pairs) {
+    const NodeDef* conv_def = ctx->graph_view.GetNode(pair.first)->node();
+    if (conv_def->op() == kConv2DWithReorderedFilter) continue;
+    NodeDef new_conv = *conv_def;
+    new_conv.set_op(kConv2DWithReorderedFilter);
+    mutation->AddNode(std::move(new_conv), &status);
+    TF_RETURN_IF_ERROR(status);
+  }
+  TF_RETURN_IF_ERROR(mutation->Apply());
+
+  for (const auto& pair : pairs) {
+    const auto* node_view = ctx->graph_view.GetNode(pair.second);
+    const NodeDef* node_def = node_view->node();
+    const string& conv_name = ctx->graph_view.GetNode(pair.first)->GetName();
+
+    NodeDef new_node;
+    new_node.set_name(node_def->name());
+    new_node.set_op(kConv2DBackpropInputWithReorderedFilter);
+    new_node.set_device(node_def->device());
+    for (int idx = 0; idx < node_view->NumRegularFanins(); idx++) {
+      new_node.add_input(node_def->input(idx));
+    }
+    new_node.add_input(strings::StrCat(conv_name, ":1"));
+    new_node.add_input(strings::StrCat(conv_name, ":2"));
+    for (int idx = 0; idx < node_view->NumControllingFanins(); idx++) {
+      new_node.add_input(node_def->input(node_view->NumRegularFanins() + idx));
+    }
+    *new_node.mutable_attr() = node_def->attr();
+
+    ITEX_VLOG(2) << "NativeLayoutPass: " << node_def->name()
+                 << " reuses the reordered filter of " << conv_name;
+    mutation->AddNode(std::move(new_node), &status);
+    TF_RETURN_IF_ERROR(status);
+  }
+  TF_RETURN_IF_ERROR(mutation->Apply());
+  return Status::OK();
+}
 }  // namespace
 
 const NativeFormatInfo* CheckForNodeNativeFormat(
@@ -372,6 +664,8 @@ Status RunNativeLayout(const char* device_name, const GrapplerItem& item,
     }
   }
 
+  TF_ABORT_IF_ERROR(ShareReorderedFilter(item, &ctx));
+
   *optimized_graph = std::move(multable_graph_def);
   return Status::OK();
 }
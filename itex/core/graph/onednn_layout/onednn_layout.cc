@@ -77,7 +77,6 @@ bool IsOneDnnLayoutPartialDependentOp(const string& op_name) {
       "_OneDnnFusedDequantizeWithReshape",
       "_OneDnnQuantizedReshape",
       "_OneDnnQuantizedTranspose",
-      "_OneDnnReshape",
       "_OneDnnShape",
       "_OneDnnToTf",
       "_OneDnnTranspose"};
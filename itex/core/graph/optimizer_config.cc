@@ -18,6 +18,8 @@ limitations under the License.
 #include <string>
 #include <utility>
 
+#include "absl/strings/ascii.h"
+#include "absl/strings/numbers.h"
 #include "itex/core/devices/xpu_device_util.h"
 #include "itex/core/utils/env_var.h"
 #include "itex/core/utils/hw_info.h"
@@ -47,6 +49,11 @@ void SetOptimizerConfigFlags(OptimizerConfigFlags* opt_config_flags) {
   bool auto_mixed_precision_flag;
   bool native_format_flag;
   bool layout_opt_flag;
+  bool dynamic_int8_flag;
+  bool memory_scheduling_flag;
+  std::string int8_calibration_mode;
+  std::string embedding_compression_type;
+  std::string embedding_compression_tolerance;
 
   auto cfg_ = itex::itex_get_config();
 #define USER_IS_ON(CFG) cfg_.graph_options().CFG() == itex::Toggle::ON
@@ -119,16 +126,76 @@ void SetOptimizerConfigFlags(OptimizerConfigFlags* opt_config_flags) {
                                            &auto_mixed_precision_flag));
   }
 
+  if (USER_IS_SET(dynamic_int8)) {
+    dynamic_int8_flag = false;
+    if (USER_IS_ON(dynamic_int8)) {
+      dynamic_int8_flag = true;
+    }
+  } else {
+    ITEX_CHECK_OK(itex::ReadBoolFromEnvVar(
+        "ITEX_DYNAMIC_INT8", enable_itex_dynamic_int8, &dynamic_int8_flag));
+  }
+
 #undef USER_IS_ON
 #undef USER_IS_OFF
 #undef USER_IS_SET
 
+  // "COLLECT" records activation ranges of Conv/MatMul nodes, "QUANTIZE"
+  // rewrites them to INT8 with the recorded ranges.
+  ITEX_CHECK_OK(itex::ReadStringFromEnvVar("ITEX_INT8_CALIBRATION", "",
+                                           &int8_calibration_mode));
+  int8_calibration_mode = absl::AsciiStrToUpper(int8_calibration_mode);
+  if (!int8_calibration_mode.empty() && int8_calibration_mode != "COLLECT" &&
+      int8_calibration_mode != "QUANTIZE") {
+    ITEX_LOG(WARNING) << "Unknown ITEX_INT8_CALIBRATION "
+                      << int8_calibration_mode
+                      << ", it should be COLLECT or QUANTIZE.";
+  }
+
+  // "BF16" or "INT8" compresses embedding tables of lookups on CPU.
+  ITEX_CHECK_OK(itex::ReadStringFromEnvVar("ITEX_EMBEDDING_COMPRESSION", "",
+                                           &embedding_compression_type));
+  embedding_compression_type =
+      absl::AsciiStrToUpper(embedding_compression_type);
+  if (!embedding_compression_type.empty() &&
+      embedding_compression_type != "BF16" &&
+      embedding_compression_type != "INT8") {
+    ITEX_LOG(WARNING) << "Unknown ITEX_EMBEDDING_COMPRESSION "
+                      << embedding_compression_type
+                      << ", it should be BF16 or INT8.";
+  }
+  ITEX_CHECK_OK(itex::ReadStringFromEnvVar(
+      "ITEX_EMBEDDING_COMPRESSION_TOLERANCE", "0.01",
+      &embedding_compression_tolerance));
+  float tolerance = 0.01f;
+  if (!absl::SimpleAtof(embedding_compression_tolerance, &tolerance) ||
+      tolerance < 0.0f) {
+    ITEX_LOG(WARNING) << "Invalid ITEX_EMBEDDING_COMPRESSION_TOLERANCE "
+                      << embedding_compression_tolerance << ", use 0.01.";
+    tolerance = 0.01f;
+  }
+
+  ITEX_CHECK_OK(itex::ReadBoolFromEnvVar("ITEX_MEMORY_SCHEDULING",
+                                         enable_itex_memory_scheduling,
+                                         &memory_scheduling_flag));
+
   // Set OptimizerConfigFlags.
   opt_config_flags->enable_onednn_graph = onednn_graph_flag;
   opt_config_flags->enable_remapper = remapper_flag;
   opt_config_flags->enable_auto_mixed_precision = auto_mixed_precision_flag;
   opt_config_flags->enable_native_format = native_format_flag;
   opt_config_flags->enable_layout_opt = layout_opt_flag;
+  opt_config_flags->enable_dynamic_int8 = dynamic_int8_flag;
+  opt_config_flags->enable_int8_calibration_collect =
+      int8_calibration_mode == "COLLECT";
+  opt_config_flags->enable_int8_calibration_quantize =
+      int8_calibration_mode == "QUANTIZE";
+  opt_config_flags->enable_embedding_compression_bf16 =
+      embedding_compression_type == "BF16";
+  opt_config_flags->enable_embedding_compression_int8 =
+      embedding_compression_type == "INT8";
+  opt_config_flags->embedding_compression_tolerance = tolerance;
+  opt_config_flags->enable_memory_scheduling = memory_scheduling_flag;
   opt_config_flags->remapper_run_pass = remapper_run_pass;
 }
 
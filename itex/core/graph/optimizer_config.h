@@ -24,6 +24,8 @@ constexpr static bool enable_itex_remapper = true;
 constexpr static bool enable_itex_auto_mixed_precision = false;
 constexpr static bool enable_itex_native_format = false;
 constexpr static bool enable_itex_layout_opt = true;
+constexpr static bool enable_itex_dynamic_int8 = false;
+constexpr static bool enable_itex_memory_scheduling = false;
 constexpr static int32_t remapper_run_pass = 2;
 
 typedef struct _OptimizerConfigFlags {
@@ -33,6 +35,16 @@ typedef struct _OptimizerConfigFlags {
   // TODO(itex): To integrate DOC & GraphOptions
   bool enable_native_format;
   bool enable_layout_opt;
+  bool enable_dynamic_int8;
+  // INT8 calibration, see ITEX_INT8_CALIBRATION.
+  bool enable_int8_calibration_collect;
+  bool enable_int8_calibration_quantize;
+  // Embedding table compression, see ITEX_EMBEDDING_COMPRESSION.
+  bool enable_embedding_compression_bf16;
+  bool enable_embedding_compression_int8;
+  float embedding_compression_tolerance;
+  // Memory-aware scheduling, see ITEX_MEMORY_SCHEDULING.
+  bool enable_memory_scheduling;
   int32_t remapper_run_pass;
 } OptimizerConfigFlags;
 
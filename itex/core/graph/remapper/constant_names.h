@@ -33,6 +33,7 @@ constexpr char kBinaryAdd[] = "BinaryAdd";
 constexpr char kCast[] = "Cast";
 constexpr char kConcatV2[] = "ConcatV2";
 constexpr char kConst[] = "Const";
+constexpr char kConv2D[] = "Conv2D";
 constexpr char kConv2DBackpropFilter[] = "Conv2DBackpropFilter";
 constexpr char kConv2DBackpropFilterWithBias[] = "Conv2DBackpropFilterWithBias";
 constexpr char kConv3DBackpropFilter[] = "Conv3DBackpropFilter";
@@ -40,12 +41,15 @@ constexpr char kConv3DBackpropFilterV2[] = "Conv3DBackpropFilterV2";
 constexpr char kConv3DBackpropFilterWithBias[] = "Conv3DBackpropFilterWithBias";
 constexpr char kConv3D[] = "Conv3D";
 constexpr char kDequantize[] = "Dequantize";
+constexpr char kExpandDims[] = "ExpandDims";
 constexpr char kFusedBatchNormV3[] = "FusedBatchNormV3";
 constexpr char kLeakyRelu[] = "LeakyRelu";
 constexpr char kMatMul[] = "MatMul";
 constexpr char kMean[] = "Mean";
 constexpr char kMul[] = "Mul";
+constexpr char kNeg[] = "Neg";
 constexpr char kFill[] = "Fill";
+constexpr char kPack[] = "Pack";
 constexpr char kPad[] = "Pad";
 constexpr char kQuantizeV2[] = "QuantizeV2";
 constexpr char kReadVariableOp[] = "ReadVariableOp";
@@ -56,6 +60,7 @@ constexpr char kResizeNearestNeighbor[] = "ResizeNearestNeighbor";
 constexpr char kResizeNearestNeighborGrad[] = "ResizeNearestNeighborGrad";
 constexpr char kRsqrt[] = "Rsqrt";
 constexpr char kSlice[] = "Slice";
+constexpr char kSoftmax[] = "Softmax";
 constexpr char kSub[] = "Sub";
 constexpr char kSigmoid[] = "Sigmoid";
 constexpr char kSplit[] = "Split";
@@ -63,17 +68,24 @@ constexpr char kSplitV[] = "SplitV";
 constexpr char kSqrt[] = "Sqrt";
 constexpr char kSquare[] = "Square";
 constexpr char kSquaredDifference[] = "SquaredDifference";
+constexpr char kSqueeze[] = "Squeeze";
+constexpr char kStridedSlice[] = "StridedSlice";
 constexpr char kSwish[] = "Swish";
 constexpr char kTanh[] = "Tanh";
 
 constexpr char kFusedBatchMatMulV2[] = "_FusedBatchMatMulV2";
 constexpr char kInstanceNorm[] = "InstanceNorm";
+constexpr char kITEXConv1D[] = "_ITEXConv1D";
 constexpr char kFusedInstanceNorm[] = "FusedInstanceNorm";
 constexpr char kITEXFusedMatMulWithSum[] = "_FusedMatMulWithSum";
 constexpr char kITEXFusedMatMul[] = "_ITEXFusedMatMul";
 constexpr char kLayerNorm[] = "LayerNorm";
+constexpr char kLocalAttention[] = "_ITEXLocalAttention";
 constexpr char kMklLayerNorm[] = "_MklLayerNorm";
 constexpr char kPadConv3d[] = "_ITEXConv3D";
+constexpr char kQuantizedLayerNorm[] = "_ITEXQuantizedLayerNorm";
+constexpr char kQuantizedSoftmax[] = "_ITEXQuantizedSoftmax";
+constexpr char kRotaryEmbedding[] = "_ITEXRotaryEmbedding";
 
 }  // namespace graph
 }  // namespace itex
@@ -0,0 +1,256 @@
+/* Copyright (c) 2022 Intel Corporation
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <string>
+#include <vector>
+
+#include "itex/core/graph/remapper/constant_names.h"
+#include "itex/core/graph/remapper/fusion.h"
+#include "itex/core/graph/remapper/remapper.h"
+#include "itex/core/graph/utils/op_types.h"
+#include "itex/core/graph/utils/pattern_utils.h"
+#include "itex/core/graph/utils/utils.h"
+
+/*
+Lower tf.nn.conv1d, which is implemented as 2-D convolution with H=1, to a
+native 1-D convolution.
+Before:                                         After:
+  input  axis    filter  axis(0)
+     \    /         \    /
+   ExpandDims     ExpandDims                      input  filter
+          \         /                                \    /
+            Conv2D                                 _ITEXConv1D
+              |
+           Squeeze
+*/
+namespace itex {
+namespace graph {
+
+namespace {
+
+// Returns the scalar value of an int32/int64 Const node.
+bool GetScalarConst(const NodeDef& node, int64* value) {
+  if (node.op() != kConst || !node.attr().count("value")) return false;
+  Tensor const_tensor;
+  if (!const_tensor.FromProto(node.attr().at("value").tensor())) return false;
+  if (const_tensor.NumElements() != 1) return false;
+  if (const_tensor.dtype() == DT_INT32) {
+    *value = const_tensor.flat<int32>()(0);
+  } else if (const_tensor.dtype() == DT_INT64) {
+    *value = const_tensor.flat<int64>()(0);
+  } else {
+    return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+class Conv1DFusionBase : public Fusion {
+ public:
+  Conv1DFusionBase() : Fusion() {}
+  ~Conv1DFusionBase() {}
+
+  MatchedProperties Check(RemapperContext* ctx,
+                          const int node_index) const override {
+    MatchedProperties ret;
+    auto& graph_view = ctx->graph_view;
+    auto* squeeze_node = graph_view.GetNode(node_index)->node();
+    // Only CPU kernel is available.
+    if (!NodeIsOnCpu(squeeze_node)) return ret;
+
+    ret = FillProperties(&graph_view, graph_view.GetNode(node_index), pattern_);
+    if (ret.Empty()) return ret;
+
+    auto* conv_node = ret.GetNode(&graph_view, "conv");
+    if (!HasDataType(conv_node, DT_FLOAT) &&
+        !HasDataType(conv_node, DT_BFLOAT16)) {
+      return ret.ToEmpty();
+    }
+
+    string data_format, padding;
+    std::vector<int32> strides, dilations = {1, 1, 1, 1};
+    if (!TryGetNodeAttr(*conv_node, "data_format", &data_format) ||
+        !TryGetNodeAttr(*conv_node, "padding", &padding) ||
+        !TryGetNodeAttr(*conv_node, "strides", &strides) ||
+        strides.size() != 4) {
+      return ret.ToEmpty();
+    }
+    TryGetNodeAttr(*conv_node, "dilations", &dilations);
+    if (padding != "SAME" && padding != "VALID") return ret.ToEmpty();
+
+    // H is the expanded dim, it must be 1 in both input and filter.
+    const bool is_nhwc = data_format == "NHWC";
+    if (!is_nhwc && data_format != "NCHW") return ret.ToEmpty();
+    const int h_index = is_nhwc ? 1 : 2;
+    const int c_index = is_nhwc ? 3 : 1;
+    const int64 expected_axis = is_nhwc ? -3 : -2;
+    if (strides[0] != 1 || strides[h_index] != 1 || strides[c_index] != 1 ||
+        dilations.size() != 4 || dilations[h_index] != 1) {
+      return ret.ToEmpty();
+    }
+
+    int64 input_axis;
+    if (!GetScalarConst(*ret.GetNode(&graph_view, "input_axis"),
+                        &input_axis)) {
+      return ret.ToEmpty();
+    }
+    // Input of tf.nn.conv1d is 3-D, so a positive axis is offset by 4.
+    if (input_axis >= 0) input_axis -= 4;
+    if (input_axis != expected_axis || !CheckFilter(&graph_view, ret)) {
+      return ret.ToEmpty();
+    }
+
+    std::vector<int32> squeeze_dims;
+    TryGetNodeAttr(*squeeze_node, "squeeze_dims", &squeeze_dims);
+    if (squeeze_dims.size() != 1 ||
+        (squeeze_dims[0] != h_index && squeeze_dims[0] != expected_axis)) {
+      return ret.ToEmpty();
+    }
+
+    return ret;
+  }
+
+  Status Update(RemapperContext* ctx,
+                const MatchedProperties& properties) const override {
+    auto& graph_view = ctx->graph_view;
+    auto* squeeze_node = properties.GetNode(&graph_view, "squeeze");
+    auto* conv_node = properties.GetNode(&graph_view, "conv");
+    auto* expand_input_node = properties.GetNode(&graph_view, "expand_input");
+    auto* filter_node = properties.GetNode(&graph_view, "filter");
+
+    string data_format;
+    std::vector<int32> strides, dilations = {1, 1, 1, 1};
+    TF_ABORT_IF_ERROR(GetNodeAttr(*conv_node, "data_format", &data_format));
+    TF_ABORT_IF_ERROR(GetNodeAttr(*conv_node, "strides", &strides));
+    TryGetNodeAttr(*conv_node, "dilations", &dilations);
+    const int w_index = data_format == "NHWC" ? 2 : 3;
+
+    NodeDef fused_node;
+    fused_node.set_op(kITEXConv1D);
+    fused_node.set_name(squeeze_node->name());
+    fused_node.set_device(squeeze_node->device());
+    fused_node.add_input(expand_input_node->input(0));
+    fused_node.add_input(FilterInput(&graph_view, properties));
+
+    auto* attr = fused_node.mutable_attr();
+    (*attr)["T"] = conv_node->attr().at("T");
+    (*attr)["padding"] = conv_node->attr().at("padding");
+    SetAttrValue(data_format == "NHWC" ? "NWC" : "NCW",
+                 &(*attr)["data_format"]);
+    SetAttrValue(static_cast<int64>(strides[w_index]), &(*attr)["stride"]);
+    SetAttrValue(static_cast<int64>(dilations[w_index]),
+                 &(*attr)["dilation"]);
+    SetAttrValue(IsConstant(*filter_node), &(*attr)["is_filter_const"]);
+
+    utils::Mutation* mutation = graph_view.GetMutationBuilder();
+    Status status;
+    mutation->AddNode(std::move(fused_node), &status);
+    TF_RETURN_IF_ERROR(status);
+    TF_RETURN_IF_ERROR(mutation->Apply());
+
+    ITEX_VLOG(2) << "Lower " << conv_node->op() << " to 1-D convolution: "
+                 << squeeze_node->name();
+    return Status::OK();
+  }
+
+ protected:
+  virtual bool CheckFilter(utils::MutableGraphView* graph_view,
+                           const MatchedProperties& properties) const = 0;
+  virtual string FilterInput(utils::MutableGraphView* graph_view,
+                             const MatchedProperties& properties) const = 0;
+
+  // Builds the pattern ending with Squeeze. `filter` is the 2nd input of
+  // Conv2D.
+  void InitPattern(utils::OpTypePattern&& filter) {
+    using utils::NodeStatus;
+    using utils::OpTypePattern;
+
+    OpTypePattern input = {kAny, "input", NodeStatus::kRemain};
+    OpTypePattern input_axis = {kConst, "input_axis", NodeStatus::kRemain};
+    OpTypePattern expand_input = {kExpandDims, "expand_input",
+                                  NodeStatus::kRemove};
+    OpTypePattern conv = {kConv2D, "conv", NodeStatus::kRemove};
+    OpTypePattern squeeze = {kSqueeze, "squeeze", NodeStatus::kReplace};
+
+    expand_input.AddInput(input).AddInput(input_axis);
+    conv.AddInput(expand_input).AddInput(filter);
+    squeeze.AddInput(conv);
+
+    pattern_ = InternalPattern(std::move(squeeze));
+  }
+};
+
+// Filter is expanded in graph, e.g. it's read from a variable.
+class Conv1DFusion : public Conv1DFusionBase {
+ public:
+  Conv1DFusion() : Conv1DFusionBase() {
+    using utils::NodeStatus;
+    using utils::OpTypePattern;
+
+    OpTypePattern filter = {kAny, "filter", NodeStatus::kRemain};
+    OpTypePattern filter_axis = {kConst, "filter_axis", NodeStatus::kRemain};
+    OpTypePattern expand_filter = {kExpandDims, "expand_filter",
+                                   NodeStatus::kRemove};
+    expand_filter.AddInput(filter).AddInput(filter_axis);
+    InitPattern(std::move(expand_filter));
+  }
+
+  std::string Name() override { return "expanddims-conv2d-squeeze"; }
+
+ protected:
+  bool CheckFilter(utils::MutableGraphView* graph_view,
+                   const MatchedProperties& properties) const override {
+    int64 filter_axis;
+    return GetScalarConst(*properties.GetNode(graph_view, "filter_axis"),
+                          &filter_axis) &&
+           filter_axis == 0;
+  }
+
+  string FilterInput(utils::MutableGraphView* graph_view,
+                     const MatchedProperties& properties) const override {
+    return properties.GetNode(graph_view, "expand_filter")->input(0);
+  }
+};
+
+// ExpandDims of a constant filter is already folded into [1, K, C_in, C_out],
+// which the 1-D kernel accepts as is.
+class Conv1DConstFilterFusion : public Conv1DFusionBase {
+ public:
+  Conv1DConstFilterFusion() : Conv1DFusionBase() {
+    InitPattern({kConst, "filter", utils::NodeStatus::kRemain});
+  }
+
+  std::string Name() override { return "expanddims-conv2d-squeeze-const"; }
+
+ protected:
+  bool CheckFilter(utils::MutableGraphView* graph_view,
+                   const MatchedProperties& properties) const override {
+    const NodeDef* filter_node = properties.GetNode(graph_view, "filter");
+    if (!filter_node->attr().count("value")) return false;
+    const auto& shape = filter_node->attr().at("value").tensor().tensor_shape();
+    return shape.dim_size() == 4 && shape.dim(0).size() == 1;
+  }
+
+  string FilterInput(utils::MutableGraphView* graph_view,
+                     const MatchedProperties& properties) const override {
+    return properties.GetNode(graph_view, "conv")->input(1);
+  }
+};
+
+REGISTER_FUSION(Conv1DFusion)
+REGISTER_FUSION(Conv1DConstFilterFusion)
+}  // namespace graph
+}  // namespace itex
@@ -0,0 +1,356 @@
+/* Copyright (c) 2022 Intel Corporation
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <algorithm>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "itex/core/graph/remapper/constant_names.h"
+#include "itex/core/graph/remapper/fusion.h"
+#include "itex/core/graph/remapper/remapper.h"
+#include "itex/core/graph/utils/op_types.h"
+#include "itex/core/graph/utils/pattern_utils.h"
+#include "itex/core/graph/utils/symbolic_shapes.h"
+#include "itex/core/graph/utils/utils.h"
+
+/*
+Longformer/BigBird-style models export sliding-window attention as dense
+attention with a constant additive mask, which is 0 for the allowed pairs and
+a large negative value elsewhere. If the mask is a band plus global rows and
+columns, the whole attention is replaced with the local attention kernel.
+Before:                                         After:
+  query   key
+     \    /
+  BatchMatMulV2(adj_y)
+        |
+  Mul(scale), optional                    query  key  value  global_mask
+        |                                     \    |    |    /
+      AddV2 -- mask(Const)                   _ITEXLocalAttention
+        |
+     Softmax  value
+         \    /
+      BatchMatMulV2
+*/
+namespace itex {
+namespace graph {
+
+namespace {
+
+// Masked scores must vanish after softmax.
+constexpr float kMaskedValue = -1e4f;
+
+// The local kernel is only used if a row attends to at most this fraction of
+// the sequence, otherwise the dense GEMMs are as fast. A block of the local
+// kernel also computes the scores of the keys between the bands of its rows,
+// so it breaks even around a quarter on CPU.
+constexpr int64 kMaxLocalRatio = 4;
+
+bool GetFloatValues(const Tensor& tensor, std::vector<float>* values) {
+  values->resize(tensor.NumElements());
+  if (tensor.dtype() == DT_FLOAT) {
+    auto flat = tensor.flat<float>();
+    for (int64 i = 0; i < flat.size(); ++i) (*values)[i] = flat(i);
+  } else if (tensor.dtype() == DT_BFLOAT16) {
+    auto flat = tensor.flat<Eigen::bfloat16>();
+    for (int64 i = 0; i < flat.size(); ++i) {
+      (*values)[i] = static_cast<float>(flat(i));
+    }
+  } else {
+    return false;
+  }
+  return true;
+}
+
+// Recovers the window size and the global tokens of a [seq_len, seq_len]
+// additive mask. Returns false if the mask isn't exactly a band plus global
+// rows and columns.
+bool DecomposeMask(const std::vector<float>& mask, int64 seq_len,
+                   int64* window_size, std::vector<bool>* is_global) {
+  auto allowed = [&](int64 i, int64 j) { return mask[i * seq_len + j] == 0; };
+  for (float value : mask) {
+    if (value != 0 && value > kMaskedValue) return false;
+  }
+
+  // A global token attends to and is attended by all the tokens.
+  is_global->assign(seq_len, false);
+  for (int64 i = 0; i < seq_len; ++i) {
+    bool is_row_allowed = true, is_col_allowed = true;
+    for (int64 j = 0; j < seq_len; ++j) {
+      is_row_allowed &= allowed(i, j);
+      is_col_allowed &= allowed(j, i);
+    }
+    if (is_row_allowed != is_col_allowed) return false;
+    (*is_global)[i] = is_row_allowed;
+  }
+
+  int64 window = 0;
+  for (int64 i = 0; i < seq_len; ++i) {
+    if ((*is_global)[i]) continue;
+    for (int64 j = 0; j < seq_len; ++j) {
+      if (!(*is_global)[j] && allowed(i, j)) {
+        window = std::max(window, std::abs(i - j));
+      }
+    }
+  }
+  for (int64 i = 0; i < seq_len; ++i) {
+    for (int64 j = 0; j < seq_len; ++j) {
+      const bool expected = (*is_global)[i] || (*is_global)[j] ||
+                            std::abs(i - j) <= window;
+      if (allowed(i, j) != expected) return false;
+    }
+  }
+  *window_size = window;
+  return true;
+}
+
+}  // namespace
+
+class LocalAttentionFusionBase : public Fusion {
+ public:
+  LocalAttentionFusionBase() : Fusion() {}
+  ~LocalAttentionFusionBase() {}
+
+  MatchedProperties Check(RemapperContext* ctx,
+                          const int node_index) const override {
+    MatchedProperties ret;
+    auto& graph_view = ctx->graph_view;
+    auto* output_node = graph_view.GetNode(node_index)->node();
+    // Only CPU kernel is available.
+    if (!NodeIsOnCpu(output_node)) return ret;
+    if (!HasDataType(output_node, DT_FLOAT) &&
+        !HasDataType(output_node, DT_BFLOAT16)) {
+      return ret;
+    }
+
+    ret = FillProperties(&graph_view, graph_view.GetNode(node_index), pattern_);
+    if (ret.Empty()) return ret;
+
+    auto* scores_node = ret.GetNode(&graph_view, "scores");
+    bool adj_x = false, adj_y = false;
+    TryGetNodeAttr(*scores_node, "adj_x", &adj_x);
+    TryGetNodeAttr(*scores_node, "adj_y", &adj_y);
+    if (adj_x || !adj_y) return ret.ToEmpty();
+    adj_x = adj_y = false;
+    TryGetNodeAttr(*output_node, "adj_x", &adj_x);
+    TryGetNodeAttr(*output_node, "adj_y", &adj_y);
+    if (adj_x || adj_y) return ret.ToEmpty();
+
+    float scale;
+    if (!GetScale(&graph_view, ret, &scale)) return ret.ToEmpty();
+
+    // Query, key and value must be [batch, heads, seq_len, head_size].
+    std::vector<OpInfo_TensorProperties> scores_inputs, output_inputs;
+    auto& graph_properties = ctx->GetGraphProperties();
+    Status scores_status = graph_properties.GetInputProperties(
+        scores_node->name(), &scores_inputs);
+    Status output_status = graph_properties.GetInputProperties(
+        output_node->name(), &output_inputs);
+    if (!scores_status.ok() || !output_status.ok() ||
+        scores_inputs.size() != 2 || output_inputs.size() != 2) {
+      return ret.ToEmpty();
+    }
+    const auto& query_shape = scores_inputs[0].shape();
+    if (Rank(query_shape) != 4 ||
+        !ShapesSymbolicallyEqual(query_shape, scores_inputs[1].shape()) ||
+        !ShapesSymbolicallyEqual(query_shape, output_inputs[1].shape())) {
+      return ret.ToEmpty();
+    }
+    const int64 seq_len = query_shape.dim(2).size();
+    if (seq_len <= 0) return ret.ToEmpty();
+
+    // The mask is [seq_len, seq_len] with optional leading 1s.
+    auto* mask_node = ret.GetNode(&graph_view, "mask");
+    Tensor mask;
+    if (!mask_node->attr().count("value") ||
+        !mask.FromProto(mask_node->attr().at("value").tensor()) ||
+        mask.dims() < 2 || mask.NumElements() != seq_len * seq_len ||
+        mask.dim_size(mask.dims() - 1) != seq_len ||
+        mask.dim_size(mask.dims() - 2) != seq_len) {
+      return ret.ToEmpty();
+    }
+    std::vector<float> mask_values;
+    int64 window_size;
+    std::vector<bool> is_global;
+    if (!GetFloatValues(mask, &mask_values) ||
+        !DecomposeMask(mask_values, seq_len, &window_size, &is_global)) {
+      return ret.ToEmpty();
+    }
+
+    int64 num_globals = 0;
+    for (bool g : is_global) num_globals += g;
+    if ((2 * window_size + 1 + num_globals) * kMaxLocalRatio > seq_len) {
+      return ret.ToEmpty();
+    }
+
+    return ret;
+  }
+
+  Status Update(RemapperContext* ctx,
+                const MatchedProperties& properties) const override {
+    auto& graph_view = ctx->graph_view;
+    auto* output_node = properties.GetNode(&graph_view, "output");
+    auto* scores_node = properties.GetNode(&graph_view, "scores");
+    auto* mask_node = properties.GetNode(&graph_view, "mask");
+
+    float scale;
+    GetScale(&graph_view, properties, &scale);
+    Tensor mask;
+    mask.FromProto(mask_node->attr().at("value").tensor());
+    const int64 seq_len = mask.dim_size(mask.dims() - 1);
+    std::vector<float> mask_values;
+    int64 window_size;
+    std::vector<bool> is_global;
+    GetFloatValues(mask, &mask_values);
+    DecomposeMask(mask_values, seq_len, &window_size, &is_global);
+
+    Tensor global_mask(DT_BOOL, TensorShape({seq_len}));
+    auto global_flat = global_mask.flat<bool>();
+    for (int64 i = 0; i < seq_len; ++i) global_flat(i) = is_global[i];
+
+    // Keep the control inputs of the mask, e.g. the frame of a while loop.
+    NodeDef global_mask_node;
+    global_mask_node.set_name(output_node->name() + "/global_mask");
+    global_mask_node.set_op(kConst);
+    global_mask_node.set_device(output_node->device());
+    for (const auto& input : mask_node->input()) {
+      global_mask_node.add_input(input);
+    }
+    AttrValue attr_type;
+    attr_type.set_type(DT_BOOL);
+    AttrValue attr_tensor;
+    global_mask.AsProtoTensorContent(attr_tensor.mutable_tensor());
+    global_mask_node.mutable_attr()->insert({"dtype", attr_type});
+    global_mask_node.mutable_attr()->insert({"value", attr_tensor});
+
+    NodeDef fused_node;
+    fused_node.set_op(kLocalAttention);
+    fused_node.set_name(output_node->name());
+    fused_node.set_device(output_node->device());
+    fused_node.add_input(scores_node->input(0));
+    fused_node.add_input(scores_node->input(1));
+    fused_node.add_input(output_node->input(1));
+    fused_node.add_input(global_mask_node.name());
+
+    auto* attr = fused_node.mutable_attr();
+    (*attr)["T"] = output_node->attr().at("T");
+    SetAttrValue(window_size, &(*attr)["window_size"]);
+    SetAttrValue(scale, &(*attr)["scale"]);
+
+    utils::Mutation* mutation = graph_view.GetMutationBuilder();
+    Status status;
+    mutation->AddNode(std::move(global_mask_node), &status);
+    TF_RETURN_IF_ERROR(status);
+    mutation->AddNode(std::move(fused_node), &status);
+    TF_RETURN_IF_ERROR(status);
+    TF_RETURN_IF_ERROR(mutation->Apply());
+
+    ITEX_VLOG(2) << "Replace masked dense attention with local attention: "
+                 << output_node->name() << ", window_size " << window_size;
+    return Status::OK();
+  }
+
+ protected:
+  // Gets the scale multiplied to the scores, 1 if there's no Mul.
+  virtual bool GetScale(utils::MutableGraphView* graph_view,
+                        const MatchedProperties& properties,
+                        float* scale) const = 0;
+
+  // Builds the pattern ending with the 2nd BatchMatMulV2. `scores` is the
+  // input of AddV2 computed from the 1st BatchMatMulV2.
+  void InitPattern(utils::OpTypePattern&& scores) {
+    using utils::NodeStatus;
+    using utils::OpTypePattern;
+
+    OpTypePattern mask = {kConst, "mask", NodeStatus::kRemain};
+    OpTypePattern masked = {kAddV2, "masked", NodeStatus::kRemove};
+    OpTypePattern softmax = {kSoftmax, "softmax", NodeStatus::kRemove};
+    OpTypePattern value = {kAny, "value", NodeStatus::kRemain};
+    OpTypePattern output = {kBatchMatMulV2, "output", NodeStatus::kReplace};
+
+    masked.AddInput(scores).AddInput(mask);
+    softmax.AddInput(masked);
+    output.AddInput(softmax).AddInput(value);
+
+    pattern_ = InternalPattern(std::move(output));
+  }
+
+  static utils::OpTypePattern ScoresPattern() {
+    using utils::NodeStatus;
+    using utils::OpTypePattern;
+
+    OpTypePattern query = {kAny, "query", NodeStatus::kRemain};
+    OpTypePattern key = {kAny, "key", NodeStatus::kRemain};
+    OpTypePattern scores = {kBatchMatMulV2, "scores", NodeStatus::kRemove};
+    scores.AddInput(query).AddInput(key);
+    return scores;
+  }
+};
+
+// Scores are scaled by a Mul with a scalar Const.
+class LocalAttentionFusion : public LocalAttentionFusionBase {
+ public:
+  LocalAttentionFusion() : LocalAttentionFusionBase() {
+    using utils::NodeStatus;
+    using utils::OpTypePattern;
+
+    OpTypePattern scale = {kConst, "scale", NodeStatus::kRemain};
+    OpTypePattern scaled = {kMul, "scaled", NodeStatus::kRemove};
+    scaled.AddInput(ScoresPattern()).AddInput(scale);
+    InitPattern(std::move(scaled));
+  }
+
+  std::string Name() override { return "masked-dense-attention-with-scale"; }
+
+ protected:
+  bool GetScale(utils::MutableGraphView* graph_view,
+                const MatchedProperties& properties,
+                float* scale) const override {
+    const NodeDef* scale_node = properties.GetNode(graph_view, "scale");
+    Tensor scale_tensor;
+    std::vector<float> values;
+    if (!scale_node->attr().count("value") ||
+        !scale_tensor.FromProto(scale_node->attr().at("value").tensor()) ||
+        scale_tensor.NumElements() != 1 ||
+        !GetFloatValues(scale_tensor, &values)) {
+      return false;
+    }
+    *scale = values[0];
+    return *scale != 0.f;
+  }
+};
+
+// Query is already scaled, e.g. before it's split into heads.
+class LocalAttentionWithoutScaleFusion : public LocalAttentionFusionBase {
+ public:
+  LocalAttentionWithoutScaleFusion() : LocalAttentionFusionBase() {
+    InitPattern(ScoresPattern());
+  }
+
+  std::string Name() override { return "masked-dense-attention"; }
+
+ protected:
+  bool GetScale(utils::MutableGraphView* graph_view,
+                const MatchedProperties& properties,
+                float* scale) const override {
+    *scale = 1.f;
+    return true;
+  }
+};
+
+REGISTER_FUSION(LocalAttentionFusion)
+REGISTER_FUSION(LocalAttentionWithoutScaleFusion)
+}  // namespace graph
+}  // namespace itex
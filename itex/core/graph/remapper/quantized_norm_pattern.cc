@@ -0,0 +1,201 @@
+/* Copyright (c) 2022 Intel Corporation
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <string>
+
+#include "itex/core/graph/remapper/constant_names.h"
+#include "itex/core/graph/remapper/fusion.h"
+#include "itex/core/graph/remapper/remapper.h"
+#include "itex/core/graph/utils/pattern_utils.h"
+#include "itex/core/graph/utils/utils.h"
+
+/*
+Absorb the surrounding Dequantize/QuantizeV2 into quantized Softmax/LayerNorm,
+so the int8 tensor doesn't need to be expanded to fp32 in the graph.
+Before:                                  After:
+    input  min  max                          input  min  max
+       \    |   /                               \    |   /
+       Dequantize                                \   |  /   min_y  max_y
+           |                                      \  |  |   /     /
+    Softmax/LayerNorm   min_y  max_y      _ITEXQuantizedSoftmax/LayerNorm
+              \          |     /
+                QuantizeV2
+*/
+namespace itex {
+namespace graph {
+
+class QuantizedNormFusionBase : public Fusion {
+ public:
+  QuantizedNormFusionBase() : Fusion() {}
+  ~QuantizedNormFusionBase() {}
+
+  MatchedProperties Check(RemapperContext* ctx,
+                          const int node_index) const override {
+    MatchedProperties ret;
+    auto& graph_view = ctx->graph_view;
+    auto* quantize_node = graph_view.GetNode(node_index)->node();
+    // Only CPU kernels are available.
+    if (!NodeIsOnCpu(quantize_node)) return ret;
+
+    ret = FillProperties(&graph_view, graph_view.GetNode(node_index), pattern_);
+    if (ret.Empty()) return ret;
+
+    auto* dequantize_node = ret.GetNode(&graph_view, "dequantize");
+    auto* norm_node = ret.GetNode(&graph_view, "norm");
+    bool is_ok = IsPerTensorScaled(*dequantize_node) &&
+                 IsPerTensorScaled(*quantize_node) &&
+                 HasDataType(norm_node, DT_FLOAT) &&
+                 HasDataType(dequantize_node, DT_FLOAT, "dtype") &&
+                 HasDataType(quantize_node, DT_FLOAT, "dtype") &&
+                 CheckNorm(*norm_node);
+    if (!is_ok) return ret.ToEmpty();
+
+    return ret;
+  }
+
+  Status Update(RemapperContext* ctx,
+                const MatchedProperties& properties) const override {
+    auto& graph_view = ctx->graph_view;
+    auto* dequantize_node = properties.GetNode(&graph_view, "dequantize");
+    auto* norm_node = properties.GetNode(&graph_view, "norm");
+    auto* quantize_node = properties.GetNode(&graph_view, "quantize");
+
+    NodeDef fused_node;
+    fused_node.set_op(FusedOp());
+    fused_node.set_name(quantize_node->name());
+    fused_node.set_device(quantize_node->device());
+    fused_node.add_input(dequantize_node->input(0));
+    AddNormInputs(*norm_node, &fused_node);
+    fused_node.add_input(dequantize_node->input(1));
+    fused_node.add_input(dequantize_node->input(2));
+    fused_node.add_input(quantize_node->input(1));
+    fused_node.add_input(quantize_node->input(2));
+
+    auto* attr = fused_node.mutable_attr();
+    (*attr)["T"] = dequantize_node->attr().at("T");
+    (*attr)["out_type"] = quantize_node->attr().at("T");
+    if (quantize_node->attr().count("ensure_minimum_range")) {
+      (*attr)["ensure_minimum_range"] =
+          quantize_node->attr().at("ensure_minimum_range");
+    }
+    AddNormAttrs(*norm_node, &fused_node);
+
+    utils::Mutation* mutation = graph_view.GetMutationBuilder();
+    Status status;
+    mutation->AddNode(std::move(fused_node), &status);
+    TF_RETURN_IF_ERROR(status);
+    TF_RETURN_IF_ERROR(mutation->Apply());
+
+    ITEX_VLOG(2) << "Fuse " << dequantize_node->op() << " with "
+                 << norm_node->op() << " and " << quantize_node->op() << ": "
+                 << norm_node->name();
+    return Status::OK();
+  }
+
+ protected:
+  virtual const char* FusedOp() const = 0;
+  virtual bool CheckNorm(const NodeDef& norm_node) const { return true; }
+  virtual void AddNormInputs(const NodeDef& norm_node,
+                             NodeDef* fused_node) const {}
+  virtual void AddNormAttrs(const NodeDef& norm_node,
+                            NodeDef* fused_node) const {}
+
+  void InitPattern(const char* norm_op, int norm_extra_inputs) {
+    using utils::NodeStatus;
+    using utils::OpTypePattern;
+
+    OpTypePattern input = {kAny, "input", NodeStatus::kRemain};
+    OpTypePattern min_input = {kAny, "min_input", NodeStatus::kRemain};
+    OpTypePattern max_input = {kAny, "max_input", NodeStatus::kRemain};
+    OpTypePattern dequantize = {kDequantize, "dequantize", NodeStatus::kRemove};
+    OpTypePattern norm = {norm_op, "norm", NodeStatus::kRemove};
+    OpTypePattern min_output = {kConst, "min_output", NodeStatus::kRemain};
+    OpTypePattern max_output = {kConst, "max_output", NodeStatus::kRemain};
+    OpTypePattern quantize = {kQuantizeV2, "quantize", NodeStatus::kReplace};
+
+    dequantize.AddInput(input).AddInput(min_input).AddInput(max_input);
+    norm.AddInput(dequantize);
+    if (norm_extra_inputs == 2) {
+      OpTypePattern scale = {kAny, "scale", NodeStatus::kRemain};
+      OpTypePattern offset = {kAny, "offset", NodeStatus::kRemain};
+      norm.AddInput(scale).AddInput(offset);
+    }
+    quantize.AddInput(norm).AddInput(min_output).AddInput(max_output);
+
+    pattern_ = InternalPattern(std::move(quantize));
+  }
+
+ private:
+  // The fused kernels use the full [-128, 127] range for qint8, so
+  // `narrow_range` ones are left unfused.
+  bool IsPerTensorScaled(const NodeDef& node) const {
+    string mode;
+    int axis = -1;
+    bool narrow_range = false;
+    TryGetNodeAttr(node, "axis", &axis);
+    TryGetNodeAttr(node, "narrow_range", &narrow_range);
+    return TryGetNodeAttr(node, "mode", &mode) && mode == "SCALED" &&
+           axis == -1 && !narrow_range;
+  }
+};
+
+class QuantizedSoftmaxFusion : public QuantizedNormFusionBase {
+ public:
+  QuantizedSoftmaxFusion() : QuantizedNormFusionBase() {
+    InitPattern(kSoftmax, 0);
+  }
+
+  std::string Name() override { return "dequantize-softmax-quantize"; }
+
+ protected:
+  const char* FusedOp() const override { return kQuantizedSoftmax; }
+};
+
+class QuantizedLayerNormFusion : public QuantizedNormFusionBase {
+ public:
+  QuantizedLayerNormFusion() : QuantizedNormFusionBase() {
+    InitPattern("LayerNorm|_MklLayerNorm", 2);
+  }
+
+  std::string Name() override { return "dequantize-layernorm-quantize"; }
+
+ protected:
+  const char* FusedOp() const override { return kQuantizedLayerNorm; }
+
+  bool CheckNorm(const NodeDef& norm_node) const override {
+    // `U` is the type of scale and offset, _MklLayerNorm uses `T` for them.
+    DataType scale_type = DT_FLOAT;
+    TryGetNodeAttr(norm_node, "U", &scale_type);
+    return scale_type == DT_FLOAT;
+  }
+
+  void AddNormInputs(const NodeDef& norm_node,
+                     NodeDef* fused_node) const override {
+    fused_node->add_input(norm_node.input(1));
+    fused_node->add_input(norm_node.input(2));
+  }
+
+  void AddNormAttrs(const NodeDef& norm_node,
+                    NodeDef* fused_node) const override {
+    if (norm_node.attr().count("epsilon")) {
+      (*fused_node->mutable_attr())["epsilon"] = norm_node.attr().at("epsilon");
+    }
+  }
+};
+
+REGISTER_FUSION(QuantizedSoftmaxFusion)
+REGISTER_FUSION(QuantizedLayerNormFusion)
+}  // namespace graph
+}  // namespace itex
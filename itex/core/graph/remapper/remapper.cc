@@ -35,6 +35,7 @@ limitations under the License.
 #include "itex/core/graph/utils/pattern_utils.h"
 #include "itex/core/graph/utils/symbolic_shapes.h"
 #include "itex/core/graph/utils/utils.h"
+#include "itex/core/utils/attr_value_util.h"
 #include "itex/core/utils/onednn/onednn_post_op_util.h"
 #include "itex/core/utils/op_kernel.h"
 
@@ -72,12 +73,16 @@ constexpr char kFusedConv3D[] = "_ITEXFusedConv3D";
 constexpr char kFusedMatMul[] = "_ITEXFusedMatMul";
 constexpr char kAddV2WithSoftmax[] = "_ITEXFusedAddV2WithSoftmax";
 constexpr char kFusedMatMulWithSum[] = "_FusedMatMulWithSum";
+constexpr char kFusedMatMulWithSumAndLayerNorm[] =
+    "_ITEXFusedMatMulWithSumAndLayerNorm";
 constexpr char kFusedMatMulGrad[] = "_FusedMatMulGrad";
 constexpr char kFusedBatchMatMul[] = "_FusedBatchMatMulV2";
 constexpr char kFusedDepthwiseConv2dNative[] =
     "_ITEXFusedDepthwiseConv2dNative";
 constexpr char kFusedBatchNormEx[] = "_FusedBatchNormEx";
 constexpr char kFusedBatchNormGradEx[] = "_FusedBatchNormExGrad";
+constexpr char kFusedBatchNormGradWithConv2DBackprop[] =
+    "_ITEXFusedBatchNormGradWithConv2DBackprop";
 constexpr char kPadWithConv2D[] = "_PadWithConv2D";
 constexpr char kPadWithFusedConv2D[] = "_PadWithFusedConv2D";
 constexpr char kPadWithConv3D[] = "_PadWithConv3D";
@@ -174,6 +179,18 @@ struct ConstWithCast {
   int cast = kMissingIndex;
 };
 
+// Reshape whose target shape is computed by Shape/StridedSlice/Pack. The chain
+// will be substituted with a Const target shape.
+struct ShapeChainWithReshape {
+  ShapeChainWithReshape() = default;
+
+  int reshape = kMissingIndex;
+  // Folded target shape, the only dynamic dim (if any) is -1.
+  std::vector<int64> shape;
+  // Chain nodes which are only used by the reshape.
+  std::set<int> dead_nodes;
+};
+
 // Contraction node followed by a BiasAdd.
 struct ContractionWithBiasAdd {
   ContractionWithBiasAdd() = default;
@@ -248,6 +265,18 @@ struct ContractionWithBiasAddAndAdd {
   int bias_port = kMissingIndex;
 };
 
+// MatMul node followed by a BiasAdd, a residual Add and a LayerNorm.
+struct ContractionWithBiasAddAndAddLayerNorm {
+  ContractionWithBiasAddAndAddLayerNorm() = default;
+
+  int contraction = kMissingIndex;
+  int bias_add = kMissingIndex;
+  int add = kMissingIndex;
+  int layer_norm = kMissingIndex;
+  int port_id = 0;
+  int bias_port = kMissingIndex;
+};
+
 // Contraction node followed by a BiasAdd, Add and Relu.
 struct ContractionWithBiasAndAddActivation {
   ContractionWithBiasAndAddActivation() = default;
@@ -300,6 +329,14 @@ struct FusedBatchNormGradEx {
   int fwd_fused_batch_norm = kMissingIndex;
 };
 
+// FusedBatchNormGrad with fused Relu, whose gradient only feeds the input and
+// filter backprop of the Conv2D producing the batch norm input.
+struct FusedBatchNormGradExWithConv2DBackprop {
+  FusedBatchNormGradEx fused_batch_norm_grad_ex;
+  int conv_backprop_input = kMissingIndex;
+  int conv_backprop_filter = kMissingIndex;
+};
+
 // Pad with `VALID` padding Conv2D/_ITEXFusedConv2D.
 // Only `Pad` is supported rather than PadV2/MirrorPad.
 struct PadWithContraction {
@@ -1013,6 +1050,49 @@ bool FindContractionWithBiasAddAndAdd(const RemapperContext& ctx,
   return true;
 }
 
+bool FindContractionWithBiasAddAndAddLayerNorm(
+    const RemapperContext& ctx, int node_index,
+    ContractionWithBiasAddAndAddLayerNorm* matched) {
+  ContractionWithBiasAddAndAdd base;
+  if (!FindContractionWithBiasAddAndAdd(ctx, node_index, &base)) return false;
+
+  const GraphDef* graph = ctx.graph_view.graph();
+  if (!IsMatMul(graph->node(base.contraction))) return false;
+
+  // The residual Add must feed the input of a LayerNorm, which is visited
+  // and fused from its sub-graph already in reverse-topological order.
+  const auto* add_node_view = ctx.graph_view.GetNode(node_index);
+  const utils::MutableNodeView* layer_norm_node_view = nullptr;
+  for (const auto& fanout : add_node_view->GetRegularFanout(0)) {
+    const auto* fanout_node_view = fanout.node_view();
+    if (fanout_node_view->node()->op() == kLayerNorm &&
+        fanout.index() == 0) {
+      layer_norm_node_view = fanout_node_view;
+      break;
+    }
+  }
+  if (layer_norm_node_view == nullptr ||
+      HasControlFaninOrFanout(*layer_norm_node_view))
+    return false;
+
+  const auto* layer_norm_node_def = layer_norm_node_view->node();
+  string data_format;
+  if (TryGetNodeAttr(*layer_norm_node_def, kDataFormat, &data_format) &&
+      data_format != "NHWC")
+    return false;
+  if (!HaveSameDataType(add_node_view->node(), layer_norm_node_def) ||
+      layer_norm_node_def->device() != add_node_view->node()->device())
+    return false;
+
+  matched->contraction = base.contraction;
+  matched->bias_add = base.bias_add;
+  matched->add = base.add;
+  matched->layer_norm = layer_norm_node_view->node_index();
+  matched->port_id = base.port_id;
+  matched->bias_port = base.bias_port;
+  return true;
+}
+
 bool FindContractionWithBiasAndActivation(
     const RemapperContext& ctx, int node_index,
     ContractionWithBiasAddAndActivation* matched) {
@@ -1415,6 +1495,89 @@ bool FindFusedBatchNormGradEx(const RemapperContext& ctx, int node_index,
   return false;
 }
 
+bool FindFusedBatchNormGradExWithConv2DBackprop(
+    const RemapperContext& ctx, int node_index,
+    FusedBatchNormGradExWithConv2DBackprop* matched) {
+  const auto* node_view = ctx.graph_view.GetNode(node_index);
+  const auto* node_def = node_view->node();
+  // Only CPU has the fused kernel.
+  if (!NodeIsOnCpu(node_def)) return false;
+  if (!(HasDataType(node_def, DT_FLOAT) || HasDataType(node_def, DT_BFLOAT16)))
+    return false;
+
+  FusedBatchNormGradEx base;
+  if (!FindFusedBatchNormGradEx(ctx, node_index, &base) ||
+      base.side_input_grad != kMissingIndex)
+    return false;
+
+  // The batch norm input must come from a Conv2D.
+  const auto* conv_node_view = node_view->GetRegularFanin(1).node_view();
+  const auto* conv_node_def = conv_node_view->node();
+  if (!IsConv2D(*conv_node_def)) return false;
+
+  // x_backprop must only feed the input and filter backprop of that Conv2D,
+  // which are visited already in reverse-topological order.
+  const auto& x_backprop_fanout = node_view->GetRegularFanout(0);
+  if (x_backprop_fanout.size() != 2) return false;
+  const utils::MutableNodeView* input_grad_node_view = nullptr;
+  const utils::MutableNodeView* filter_grad_node_view = nullptr;
+  for (const auto& fanout : x_backprop_fanout) {
+    const auto* fanout_node_view = fanout.node_view();
+    if (fanout.index() != 2 || HasControlFaninOrFanout(*fanout_node_view))
+      return false;
+    if (IsConv2DBackpropInput(*fanout_node_view->node())) {
+      input_grad_node_view = fanout_node_view;
+    } else if (IsConv2DBackpropFilter(*fanout_node_view->node())) {
+      filter_grad_node_view = fanout_node_view;
+    }
+  }
+  if (input_grad_node_view == nullptr || filter_grad_node_view == nullptr)
+    return false;
+
+  const auto is_same_fanin = [](const utils::MutableNodeView* a, int a_port,
+                                const utils::MutableNodeView* b, int b_port) {
+    const auto& a_fanin = a->GetRegularFanin(a_port);
+    const auto& b_fanin = b->GetRegularFanin(b_port);
+    return a_fanin.node_index() == b_fanin.node_index() &&
+           a_fanin.index() == b_fanin.index();
+  };
+  if (!is_same_fanin(input_grad_node_view, 1, conv_node_view, 1) ||
+      !is_same_fanin(filter_grad_node_view, 0, conv_node_view, 0))
+    return false;
+
+  string data_format;
+  if (!TryGetNodeAttr(*node_def, kDataFormat, &data_format) ||
+      !(data_format == "NHWC" || data_format == "NCHW"))
+    return false;
+  for (const auto* grad_node_view :
+       {input_grad_node_view, filter_grad_node_view}) {
+    const auto* grad_node_def = grad_node_view->node();
+    if (grad_node_def->device() != node_def->device() ||
+        !HaveSameDataType(node_def, grad_node_def))
+      return false;
+    string grad_data_format;
+    if (!TryGetNodeAttr(*grad_node_def, kDataFormat, &grad_data_format) ||
+        grad_data_format != data_format)
+      return false;
+    for (const char* name :
+         {"strides", "padding", "explicit_paddings", "dilations"}) {
+      const auto conv_attr = conv_node_def->attr().find(name);
+      const auto grad_attr = grad_node_def->attr().find(name);
+      if ((conv_attr == conv_node_def->attr().end()) !=
+          (grad_attr == grad_node_def->attr().end()))
+        return false;
+      if (conv_attr != conv_node_def->attr().end() &&
+          !AreAttrValuesEqual(conv_attr->second, grad_attr->second))
+        return false;
+    }
+  }
+
+  matched->fused_batch_norm_grad_ex = base;
+  matched->conv_backprop_input = input_grad_node_view->node_index();
+  matched->conv_backprop_filter = filter_grad_node_view->node_index();
+  return true;
+}
+
 bool FindPadWithContraction(const RemapperContext& ctx, int node_index,
                             PadWithContraction* matched,
                             bool check_device_compatible = true) {
@@ -2027,6 +2190,186 @@ bool FindConstWithCast(const RemapperContext& ctx, int node_index,
   return true;
 }
 
+namespace {
+
+// Reads all elements of an int32/int64 Const node.
+bool GetConstIntValues(const NodeDef& node, std::vector<int64>* values) {
+  if (!IsConstant(node) || !node.attr().count("value")) return false;
+  Tensor const_tensor;
+  if (!const_tensor.FromProto(node.attr().at("value").tensor())) return false;
+  values->clear();
+  if (const_tensor.dtype() == DT_INT32) {
+    for (int64 i = 0; i < const_tensor.NumElements(); ++i) {
+      values->push_back(const_tensor.flat<int32>()(i));
+    }
+  } else if (const_tensor.dtype() == DT_INT64) {
+    for (int64 i = 0; i < const_tensor.NumElements(); ++i) {
+      values->push_back(const_tensor.flat<int64>()(i));
+    }
+  } else {
+    return false;
+  }
+  return true;
+}
+
+// Gets the static shape of the tensor consumed by a Shape node. Unknown dims
+// are -1.
+bool GetShapeOpInputDims(const RemapperContext& ctx,
+                         const utils::MutableNodeView& shape_view,
+                         std::vector<int64>* dims) {
+  if (!IsShape(*shape_view.node()) || HasControlFanin(shape_view)) {
+    return false;
+  }
+  std::vector<OpInfo_TensorProperties> props;
+  if (!ctx.graph_properties
+           .GetInputProperties(shape_view.node()->name(), &props)
+           .ok() ||
+      props.size() != 1 || props[0].shape().unknown_rank()) {
+    return false;
+  }
+  dims->clear();
+  for (const auto& dim : props[0].shape().dim()) {
+    dims->push_back(dim.size() < 0 ? -1 : dim.size());
+  }
+  return true;
+}
+
+// Gets a scalar packed into the target shape. It's either a Const or a single
+// dim picked from a Shape by StridedSlice, e.g. `tf.shape(x)[0]`.
+bool GetShapeChainScalar(const RemapperContext& ctx,
+                         const utils::MutableNodeView& node_view, int64* value,
+                         std::set<int>* chain_nodes) {
+  const NodeDef* node_def = node_view.node();
+  std::vector<int64> values;
+  if (GetConstIntValues(*node_def, &values)) {
+    if (values.size() != 1) return false;
+    *value = values[0];
+    return true;
+  }
+
+  if (!IsStridedSlice(*node_def) || node_view.NumRegularFanins() != 4 ||
+      HasControlFanin(node_view)) {
+    return false;
+  }
+  int begin_mask = 0, ellipsis_mask = 0, new_axis_mask = 0;
+  int shrink_axis_mask = 0;
+  TryGetNodeAttr(*node_def, "begin_mask", &begin_mask);
+  TryGetNodeAttr(*node_def, "ellipsis_mask", &ellipsis_mask);
+  TryGetNodeAttr(*node_def, "new_axis_mask", &new_axis_mask);
+  TryGetNodeAttr(*node_def, "shrink_axis_mask", &shrink_axis_mask);
+  if (begin_mask != 0 || ellipsis_mask != 0 || new_axis_mask != 0 ||
+      shrink_axis_mask != 1) {
+    return false;
+  }
+
+  std::vector<int64> begin, strides;
+  if (!GetConstIntValues(*node_view.GetRegularFanin(1).node_view()->node(),
+                         &begin) ||
+      !GetConstIntValues(*node_view.GetRegularFanin(3).node_view()->node(),
+                         &strides) ||
+      begin.size() != 1 || strides.size() != 1 || strides[0] != 1) {
+    return false;
+  }
+
+  const auto* shape_view = node_view.GetRegularFanin(0).node_view();
+  std::vector<int64> dims;
+  if (!GetShapeOpInputDims(ctx, *shape_view, &dims)) return false;
+  const int64 rank = dims.size();
+  const int64 index = begin[0] < 0 ? begin[0] + rank : begin[0];
+  if (index < 0 || index >= rank) return false;
+
+  *value = dims[index];
+  chain_nodes->insert(shape_view->node_index());
+  chain_nodes->insert(node_view.node_index());
+  return true;
+}
+
+// Returns true if `node_view` can be removed once all nodes in `consumers`
+// are removed.
+bool IsOnlyUsedBy(const RemapperContext& ctx,
+                  const utils::MutableNodeView& node_view,
+                  const std::set<int>& consumers) {
+  if (HasControlFaninOrFanout(node_view) ||
+      IsInPreserveSet(ctx, node_view.node())) {
+    return false;
+  }
+  for (const auto& fanouts : node_view.GetRegularFanouts()) {
+    for (const auto& fanout : fanouts) {
+      if (!consumers.count(fanout.node_index())) return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+bool FindShapeChainWithReshape(const RemapperContext& ctx, int node_index,
+                               ShapeChainWithReshape* matched) {
+  const auto* node_view = ctx.graph_view.GetNode(node_index);
+  const auto* node_def = node_view->node();
+  if (!IsReshape(*node_def) || node_view->NumRegularFanins() != 2) {
+    return false;
+  }
+
+  const auto& shape_fanin = node_view->GetRegularFanin(1);
+  const auto* shape_src = shape_fanin.node_view();
+  const NodeDef* shape_src_def = shape_src->node();
+  if (shape_fanin.index() != 0 || IsConstant(*shape_src_def)) return false;
+
+  std::vector<int64> shape;
+  std::set<int> chain_nodes;
+  if (IsPack(*shape_src_def)) {
+    int axis = 0;
+    TryGetNodeAttr(*shape_src_def, "axis", &axis);
+    if (axis != 0 || HasControlFanin(*shape_src)) return false;
+    for (int i = 0; i < shape_src->NumRegularFanins(); ++i) {
+      const auto& fanin = shape_src->GetRegularFanin(i);
+      int64 value;
+      if (fanin.index() != 0 ||
+          !GetShapeChainScalar(ctx, *fanin.node_view(), &value,
+                               &chain_nodes)) {
+        return false;
+      }
+      shape.push_back(value);
+    }
+  } else if (!GetShapeOpInputDims(ctx, *shape_src, &shape)) {
+    return false;
+  }
+  chain_nodes.insert(shape_src->node_index());
+
+  // Usually only the batch dim is dynamic. It's left to Reshape by -1, which
+  // requires all other dims to be static and non-zero.
+  int num_dynamic_dims = 0;
+  int64 static_elements = 1;
+  for (int64 dim : shape) {
+    if (dim < 0) {
+      ++num_dynamic_dims;
+    } else {
+      static_elements *= dim;
+    }
+  }
+  if (num_dynamic_dims > 1 || (num_dynamic_dims == 1 && static_elements == 0))
+    return false;
+
+  if (ctx.graph_view.GetNode(node_def->name() + "/folded_shape") != nullptr)
+    return false;
+
+  // Graph is sorted topologically, so walking node indices backwards visits
+  // consumers of the chain first.
+  matched->dead_nodes.clear();
+  std::set<int> consumers = {node_index};
+  for (auto it = chain_nodes.rbegin(); it != chain_nodes.rend(); ++it) {
+    if (IsOnlyUsedBy(ctx, *ctx.graph_view.GetNode(*it), consumers)) {
+      consumers.insert(*it);
+      matched->dead_nodes.insert(*it);
+    }
+  }
+
+  matched->reshape = node_index;
+  matched->shape = std::move(shape);
+  return true;
+}
+
 // Find sequatial binary ops.
 bool FindFusedBinary(const RemapperContext& ctx, int node_index,
                      FusedBinary* matched) {
@@ -2401,6 +2744,78 @@ Status AddFusedContractionNode(RemapperContext* ctx,
   return Status::OK();
 }
 
+// MatMul + BiasAdd + Add + LayerNorm.
+Status AddFusedContractionNode(
+    RemapperContext* ctx, const ContractionWithBiasAddAndAddLayerNorm& matched,
+    std::vector<bool>* invalidated_nodes, std::vector<bool>* nodes_to_delete) {
+  const GraphDef* graph = ctx->graph_view.graph();
+  const NodeDef& contraction = graph->node(matched.contraction);
+  const NodeDef& bias_add = graph->node(matched.bias_add);
+  const NodeDef& add = graph->node(matched.add);
+  const NodeDef& layer_norm = graph->node(matched.layer_norm);
+
+  // The fused node replaces LayerNorm, so consumers of its outputs are kept.
+  NodeDef fused_node;
+  fused_node.set_name(layer_norm.name());
+  fused_node.set_op(kFusedMatMulWithSumAndLayerNorm);
+  fused_node.set_device(contraction.device());
+  fused_node.add_input(contraction.input(0));
+  fused_node.add_input(contraction.input(1));
+  fused_node.add_input(bias_add.input(matched.bias_port));
+  fused_node.add_input(add.input(1 - matched.port_id));
+  fused_node.add_input(layer_norm.input(1));
+  fused_node.add_input(layer_norm.input(2));
+
+  auto* attr = fused_node.mutable_attr();
+  auto& src_attr = contraction.attr();
+  (*attr)["T"] = src_attr.at("T");
+  (*attr)["transpose_a"] = src_attr.at("transpose_a");
+  (*attr)["transpose_b"] = src_attr.at("transpose_b");
+  SetAttrValue(DT_FLOAT, &(*attr)["U"]);
+  for (const char* name : {"epsilon", kIsTraining}) {
+    if (layer_norm.attr().count(name)) {
+      (*attr)[name] = layer_norm.attr().at(name);
+    }
+  }
+  const auto* filter_node_view = ctx->graph_view.GetNode(matched.contraction)
+                                     ->GetRegularFanin(1)
+                                     .node_view();
+  SetAttrValue(IsConstant(*filter_node_view->node()),
+               &(*attr)["is_filter_const"]);
+
+  utils::Mutation* mutation = ctx->graph_view.GetMutationBuilder();
+  Status status;
+  mutation->AddNode(std::move(fused_node), &status);
+  TF_ABORT_IF_ERROR(status);
+
+  // Other consumers of the pre-norm sum, e.g. LayerNormGrad in training, read
+  // it from the last output of the fused node.
+  const bool is_sum_used =
+      ctx->graph_view.GetNode(matched.add)->GetRegularFanout(0).size() > 1;
+  if (is_sum_used) {
+    NodeDef identity;
+    identity.set_name(add.name());
+    identity.set_op("Identity");
+    identity.set_device(add.device());
+    identity.add_input(strings::StrCat(layer_norm.name(), ":3"));
+    (*identity.mutable_attr())["T"] = add.attr().at("T");
+    mutation->AddNode(std::move(identity), &status);
+    TF_ABORT_IF_ERROR(status);
+  }
+  TF_ABORT_IF_ERROR(mutation->Apply());
+
+  (*invalidated_nodes)[matched.layer_norm] = true;
+  (*nodes_to_delete)[matched.contraction] = true;
+  (*nodes_to_delete)[matched.bias_add] = true;
+  if (is_sum_used) {
+    (*invalidated_nodes)[matched.add] = true;
+  } else {
+    (*nodes_to_delete)[matched.add] = true;
+  }
+
+  return Status::OK();
+}
+
 // Contractoin + BiasAdd + Activation.
 Status AddFusedContractionNode(
     RemapperContext* ctx, const ContractionWithBiasAddAndActivation& matched,
@@ -2698,6 +3113,91 @@ Status AddFusedBatchNormGradExNode(RemapperContext* ctx,
   return Status::OK();
 }
 
+// ReluGrad + FusedBatchNormGrad + Conv2DBackpropInput + Conv2DBackpropFilter.
+Status AddFusedBatchNormGradExWithConv2DBackpropNode(
+    RemapperContext* ctx, const FusedBatchNormGradExWithConv2DBackprop& matched,
+    std::vector<bool>* invalidated_nodes, std::vector<bool>* nodes_to_delete) {
+  const GraphDef* graph = ctx->graph_view.graph();
+  const FusedBatchNormGradEx& bn_grad_ex = matched.fused_batch_norm_grad_ex;
+  const NodeDef& fused_batch_norm_grad =
+      graph->node(bn_grad_ex.fused_batch_norm_grad);
+  const NodeDef& activation_grad = graph->node(bn_grad_ex.activation_grad);
+  const NodeDef& fwd_fused_batch_norm =
+      graph->node(bn_grad_ex.fwd_fused_batch_norm);
+  const NodeDef& conv_backprop_input = graph->node(matched.conv_backprop_input);
+  const NodeDef& conv_backprop_filter =
+      graph->node(matched.conv_backprop_filter);
+
+  ITEX_VLOG(2) << "Fuse FusedBatchNormGrad with " << activation_grad.op()
+               << " and Conv2D backprop: "
+               << " fused_batch_norm_grad=" << fused_batch_norm_grad.name()
+               << " activation=" << activation_grad.name()
+               << " input_backprop=" << conv_backprop_input.name()
+               << " filter_backprop=" << conv_backprop_filter.name();
+
+  NodeDef fused_op;
+  fused_op.set_op(kFusedBatchNormGradWithConv2DBackprop);
+  fused_op.set_name(fused_batch_norm_grad.name());
+  fused_op.set_device(fused_batch_norm_grad.device());
+
+  fused_op.add_input(activation_grad.input(0));        // 0: y_backprop
+  fused_op.add_input(fused_batch_norm_grad.input(1));  // 1: x
+  fused_op.add_input(fused_batch_norm_grad.input(2));  // 2: scale
+  fused_op.add_input(fused_batch_norm_grad.input(3));  // 3: reserve_space_1
+  fused_op.add_input(fused_batch_norm_grad.input(4));  // 4: reserve_space_2
+  fused_op.add_input(fused_batch_norm_grad.input(5));  // 5: reserve_space_3
+  fused_op.add_input(fwd_fused_batch_norm.input(2));   // 6: offset
+  fused_op.add_input(activation_grad.input(1));        // 7: y
+  fused_op.add_input(conv_backprop_filter.input(0));   // 8: conv_input
+  fused_op.add_input(conv_backprop_input.input(1));    // 9: filter
+  fused_op.add_input(conv_backprop_input.input(0));    // 10: input_sizes
+
+  CopyFusedBatchNormAttributes(fused_batch_norm_grad, &fused_op);
+
+  auto* attrs = fused_op.mutable_attr();
+  SetAttrValue(activation_grad.op(), &(*attrs)["activation_mode"]);
+  for (const char* name :
+       {"strides", "padding", "explicit_paddings", "dilations"}) {
+    if (conv_backprop_input.attr().count(name)) {
+      (*attrs)[name] = conv_backprop_input.attr().at(name);
+    }
+  }
+
+  // Consumers of the conv gradients read them from the fused node.
+  NodeDef input_grad_identity;
+  input_grad_identity.set_op("Identity");
+  input_grad_identity.set_name(conv_backprop_input.name());
+  input_grad_identity.set_device(conv_backprop_input.device());
+  input_grad_identity.add_input(
+      strings::StrCat(fused_batch_norm_grad.name(), ":5"));
+  (*input_grad_identity.mutable_attr())["T"] = attrs->at("T");
+
+  NodeDef filter_grad_identity;
+  filter_grad_identity.set_op("Identity");
+  filter_grad_identity.set_name(conv_backprop_filter.name());
+  filter_grad_identity.set_device(conv_backprop_filter.device());
+  filter_grad_identity.add_input(
+      strings::StrCat(fused_batch_norm_grad.name(), ":6"));
+  (*filter_grad_identity.mutable_attr())["T"] = attrs->at("T");
+
+  utils::Mutation* mutation = ctx->graph_view.GetMutationBuilder();
+  Status status;
+  mutation->AddNode(std::move(fused_op), &status);
+  TF_RETURN_IF_ERROR(status);
+  mutation->AddNode(std::move(input_grad_identity), &status);
+  TF_RETURN_IF_ERROR(status);
+  mutation->AddNode(std::move(filter_grad_identity), &status);
+  TF_RETURN_IF_ERROR(status);
+  TF_RETURN_IF_ERROR(mutation->Apply());
+
+  (*invalidated_nodes)[bn_grad_ex.fused_batch_norm_grad] = true;
+  (*invalidated_nodes)[matched.conv_backprop_input] = true;
+  (*invalidated_nodes)[matched.conv_backprop_filter] = true;
+  (*nodes_to_delete)[bn_grad_ex.activation_grad] = true;
+
+  return Status::OK();
+}
+
 // Pad + Contraction.
 Status AddPadWithContractionNode(RemapperContext* ctx,
                                  const PadWithContraction& matched,
@@ -3628,6 +4128,58 @@ Status AddConstWithCastNode(RemapperContext* ctx, const ConstWithCast& matched,
   return Status::OK();
 }
 
+// Add Const target shape of Reshape.
+Status AddShapeChainWithReshapeNode(RemapperContext* ctx,
+                                    const ShapeChainWithReshape& matched,
+                                    std::vector<bool>* invalidated_nodes,
+                                    std::vector<bool>* nodes_to_delete) {
+  auto* reshape_view = ctx->graph_view.GetNode(matched.reshape);
+  const NodeDef& reshape = *reshape_view->node();
+
+  DataType shape_dtype = DT_INT32;
+  TryGetNodeAttr(reshape, "Tshape", &shape_dtype);
+  const int64 rank = matched.shape.size();
+  Tensor shape_value(shape_dtype, TensorShape({rank}));
+  for (int64 i = 0; i < rank; ++i) {
+    if (shape_dtype == DT_INT32) {
+      shape_value.flat<int32>()(i) = static_cast<int32>(matched.shape[i]);
+    } else {
+      shape_value.flat<int64>()(i) = matched.shape[i];
+    }
+  }
+
+  NodeDef new_const_op;
+  new_const_op.set_op("Const");
+  new_const_op.set_name(reshape.name() + "/folded_shape");
+  new_const_op.set_device(reshape.device());
+  // Run in the frame of the Reshape data, e.g. the body of a while loop.
+  const NodeDef* data = reshape_view->GetRegularFanin(0).node_view()->node();
+  new_const_op.add_input(AsControlDependency(*data));
+
+  AttrValue attr_type;
+  attr_type.set_type(shape_dtype);
+  AttrValue attr_tensor;
+  TensorProto* t = attr_tensor.mutable_tensor();
+  shape_value.AsProtoTensorContent(t);
+  new_const_op.mutable_attr()->insert({"dtype", attr_type});
+  new_const_op.mutable_attr()->insert({"value", attr_tensor});
+
+  const string const_name = new_const_op.name();
+  utils::Mutation* mutation = ctx->graph_view.GetMutationBuilder();
+  Status status;
+  mutation->AddNode(std::move(new_const_op), &status);
+  TF_ABORT_IF_ERROR(status);
+  mutation->AddOrUpdateRegularFanin(reshape_view, 1, {const_name, 0});
+  TF_ABORT_IF_ERROR(mutation->Apply());
+
+  // Reshape itself is kept valid, other fusions may still use it.
+  for (int index : matched.dead_nodes) {
+    (*nodes_to_delete)[index] = true;
+  }
+  ITEX_VLOG(2) << "Fold target shape of " << reshape.name() << " into Const.";
+  return Status::OK();
+}
+
 // Add sequatial Binary ops fusion.
 Status AddFusedBinaryNode(RemapperContext* ctx, const FusedBinary& matched,
                           std::vector<bool>* invalidated_nodes,
@@ -3742,6 +4294,16 @@ Status RunRemapper(const char* device_name, const GrapplerItem& item,
       continue;
     }
 
+    // Fold Shape/StridedSlice/Pack target shape of Reshape into Const, so the
+    // small host ops won't run every step. No `continue` here, the Reshape
+    // is still a candidate of fusions below.
+    ShapeChainWithReshape shape_chain_with_reshape;
+    if (FindShapeChainWithReshape(ctx, i, &shape_chain_with_reshape)) {
+      TF_ABORT_IF_ERROR(AddShapeChainWithReshapeNode(
+          &ctx, shape_chain_with_reshape, &invalidated_nodes,
+          &nodes_to_delete));
+    }
+
     if (is_full) {
       // Remap Conv2D+BiasAdd+Add+Activation into the _ITEXFusedConv2D.
       ContractionWithBiasAndAddActivation contract_with_bias_and_add_activation;
@@ -3753,6 +4315,17 @@ Status RunRemapper(const char* device_name, const GrapplerItem& item,
         continue;
       }
 
+      // Remap MatMul+BiasAdd+Add+LayerNorm into the
+      // _ITEXFusedMatMulWithSumAndLayerNorm.
+      ContractionWithBiasAddAndAddLayerNorm contract_with_add_layer_norm;
+      if (FindContractionWithBiasAddAndAddLayerNorm(
+              ctx, i, &contract_with_add_layer_norm)) {
+        TF_ABORT_IF_ERROR(
+            AddFusedContractionNode(&ctx, contract_with_add_layer_norm,
+                                    &invalidated_nodes, &nodes_to_delete));
+        continue;
+      }
+
       // Remap Conv2D+BiasAdd+Add into the _ITEXFusedConv2D.
       ContractionWithBiasAddAndAdd contract_with_bias_and_add;
       if (FindContractionWithBiasAddAndAdd(ctx, i,
@@ -3829,6 +4402,17 @@ Status RunRemapper(const char* device_name, const GrapplerItem& item,
         continue;
       }
 
+      // Remap ReluGrad+FusedBatchNormGrad feeding the Conv2D backprop into
+      // the _ITEXFusedBatchNormGradWithConv2DBackprop.
+      FusedBatchNormGradExWithConv2DBackprop fused_batch_norm_grad_conv;
+      if (FindFusedBatchNormGradExWithConv2DBackprop(
+              ctx, i, &fused_batch_norm_grad_conv)) {
+        TF_ABORT_IF_ERROR(AddFusedBatchNormGradExWithConv2DBackpropNode(
+            &ctx, fused_batch_norm_grad_conv, &invalidated_nodes,
+            &nodes_to_delete));
+        continue;
+      }
+
       FusedBatchNormGradEx fused_batch_norm_grad_ex;
       if (FindFusedBatchNormGradEx(ctx, i, &fused_batch_norm_grad_ex)) {
         TF_ABORT_IF_ERROR(
@@ -0,0 +1,394 @@
+/* Copyright (c) 2022 Intel Corporation
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "itex/core/graph/remapper/constant_names.h"
+#include "itex/core/graph/remapper/fusion.h"
+#include "itex/core/graph/remapper/remapper.h"
+#include "itex/core/graph/utils/op_types.h"
+#include "itex/core/graph/utils/pattern_utils.h"
+#include "itex/core/graph/utils/symbolic_shapes.h"
+#include "itex/core/graph/utils/utils.h"
+
+/*
+Rotary position embedding y = x * cos + rotate(x) * sin, as exported by LLMs.
+rotate(x) is one of:
+  half-split:  concat(-x[..., h:], x[..., :h]) by StridedSlice or Split,
+  interleaved: reshape(stack([-x[..., 1::2], x[..., ::2]], -1), shape(x)).
+Before:                                          After:
+        x --------------+
+   /         \           \
+ slice/split  slice/split  |
+    |          |           |                     x   cos   sin
+   Neg         |           |                      \   |   /
+     \        /            |               _ITEXRotaryEmbedding
+   ConcatV2 or Pack+Reshape |
+        |                  |
+    Mul(sin)           Mul(cos)
+          \            /
+              AddV2
+*/
+namespace itex {
+namespace graph {
+
+namespace {
+
+enum class RotateKind { kSliceConcat, kSplitConcat, kSlicePackReshape };
+
+bool GetIntValues(const NodeDef& node, std::vector<int64>* values) {
+  if (node.op() != kConst || !node.attr().count("value")) return false;
+  Tensor tensor;
+  if (!tensor.FromProto(node.attr().at("value").tensor())) return false;
+  values->clear();
+  if (tensor.dtype() == DT_INT32) {
+    auto flat = tensor.flat<int32>();
+    for (int64 i = 0; i < flat.size(); ++i) values->push_back(flat(i));
+  } else if (tensor.dtype() == DT_INT64) {
+    auto flat = tensor.flat<int64>();
+    for (int64 i = 0; i < flat.size(); ++i) values->push_back(flat(i));
+  } else {
+    return false;
+  }
+  return true;
+}
+
+// Returns true if `axis` is the last dim of a tensor of rank `rank`.
+bool IsLastAxis(const NodeDef& node, int rank) {
+  std::vector<int64> axis;
+  return GetIntValues(node, &axis) && axis.size() == 1 &&
+         (axis[0] == -1 || axis[0] == rank - 1);
+}
+
+// Gets [begin, end) and stride of a StridedSlice which only slices the last
+// dim, of size `dim`, of a tensor of rank `rank`.
+bool GetLastDimSlice(const NodeDef& slice, const NodeDef& begin_node,
+                     const NodeDef& end_node, const NodeDef& strides_node,
+                     int rank, int64 dim, int64* begin, int64* end,
+                     int64* stride) {
+  std::vector<int64> begins, ends, strides;
+  if (!GetIntValues(begin_node, &begins) || !GetIntValues(end_node, &ends) ||
+      !GetIntValues(strides_node, &strides) || begins.size() != ends.size() ||
+      begins.size() != strides.size() || begins.empty()) {
+    return false;
+  }
+  int begin_mask = 0, end_mask = 0, ellipsis_mask = 0, new_axis_mask = 0,
+      shrink_axis_mask = 0;
+  TryGetNodeAttr(slice, "begin_mask", &begin_mask);
+  TryGetNodeAttr(slice, "end_mask", &end_mask);
+  TryGetNodeAttr(slice, "ellipsis_mask", &ellipsis_mask);
+  TryGetNodeAttr(slice, "new_axis_mask", &new_axis_mask);
+  TryGetNodeAttr(slice, "shrink_axis_mask", &shrink_axis_mask);
+  if (new_axis_mask != 0 || shrink_axis_mask != 0) return false;
+
+  // Either x[..., b:e:s] or x[:, ..., :, b:e:s].
+  const int n = begins.size();
+  if (ellipsis_mask != 1 || n != 2) {
+    if (ellipsis_mask != 0 || n != rank) return false;
+    for (int i = 0; i < n - 1; ++i) {
+      if (!((begin_mask >> i) & 1) && begins[i] != 0) return false;
+      if (!((end_mask >> i) & 1) || strides[i] != 1) return false;
+    }
+  }
+
+  const int k = n - 1;
+  *stride = strides[k];
+  if (*stride <= 0) return false;
+  *begin = ((begin_mask >> k) & 1) ? 0 : begins[k];
+  *end = ((end_mask >> k) & 1) ? dim : ends[k];
+  if (*begin < 0) *begin += dim;
+  if (*end < 0) *end += dim;
+  *end = std::min(*end, dim);
+  return *begin >= 0 && *begin < *end;
+}
+
+}  // namespace
+
+class RotaryEmbeddingFusion : public Fusion {
+ public:
+  RotaryEmbeddingFusion() : Fusion() {
+    // The commutative heuristic of the matcher can't order two Muls, or a Mul
+    // of two Reshapes, so all the orders are listed.
+    for (auto kind : {RotateKind::kSliceConcat, RotateKind::kSplitConcat,
+                      RotateKind::kSlicePackReshape}) {
+      for (bool is_cos_first : {true, false}) {
+        for (bool is_rotate_first : {true, false}) {
+          patterns_.emplace_back(
+              kind, InternalPattern(BuildPattern(kind, is_cos_first,
+                                                 is_rotate_first)));
+        }
+      }
+    }
+    pattern_ = InternalPattern(
+        BuildPattern(RotateKind::kSliceConcat, true, true));
+  }
+
+  ~RotaryEmbeddingFusion() {}
+
+  std::string Name() override { return "rotary-embedding"; }
+
+  MatchedProperties Check(RemapperContext* ctx,
+                          const int node_index) const override {
+    MatchedProperties ret;
+    auto& graph_view = ctx->graph_view;
+    auto* output_node = graph_view.GetNode(node_index)->node();
+    // Only CPU kernel is available.
+    if (!NodeIsOnCpu(output_node)) return ret;
+    if (!HasDataType(output_node, DT_FLOAT) &&
+        !HasDataType(output_node, DT_BFLOAT16)) {
+      return ret;
+    }
+
+    RotateKind kind = RotateKind::kSliceConcat;
+    for (const auto& pattern : patterns_) {
+      ret = FillProperties(&graph_view, graph_view.GetNode(node_index),
+                           pattern.second);
+      if (!ret.Empty()) {
+        kind = pattern.first;
+        break;
+      }
+    }
+    if (ret.Empty()) return ret;
+
+    string x, cos, sin;
+    if (!GetInputs(&graph_view, ret, &x, &cos, &sin)) return ret.ToEmpty();
+
+    // x must keep its shape, with an even and static last dim.
+    auto* mul_cos_node = ret.GetNode(&graph_view, "mul_cos");
+    const int x_port = ParseTensorName(mul_cos_node->input(0)) ==
+                               ParseTensorName(x)
+                           ? 0
+                           : 1;
+    std::vector<OpInfo_TensorProperties> mul_cos_inputs, mul_sin_inputs;
+    auto& graph_properties = ctx->GetGraphProperties();
+    auto output_properties = GetOutputProperties(ctx, node_index);
+    Status cos_status = graph_properties.GetInputProperties(
+        mul_cos_node->name(), &mul_cos_inputs);
+    Status sin_status = graph_properties.GetInputProperties(
+        ret.GetNode(&graph_view, "mul_sin")->name(), &mul_sin_inputs);
+    if (!cos_status.ok() || !sin_status.ok() || output_properties.empty() ||
+        mul_cos_inputs.size() != 2 || mul_sin_inputs.size() != 2) {
+      return ret.ToEmpty();
+    }
+    const auto& x_shape = mul_cos_inputs[x_port].shape();
+    const int rank = Rank(x_shape);
+    if (rank < 1 ||
+        !ShapesSymbolicallyEqual(x_shape, output_properties[0].shape())) {
+      return ret.ToEmpty();
+    }
+    const int64 dim = x_shape.dim(rank - 1).size();
+    if (dim <= 0 || dim % 2 != 0) return ret.ToEmpty();
+    for (const auto& input : {mul_cos_inputs[1 - x_port], mul_sin_inputs[0],
+                              mul_sin_inputs[1]}) {
+      if (Rank(input.shape()) < 0 || Rank(input.shape()) > rank) {
+        return ret.ToEmpty();
+      }
+    }
+
+    if (!CheckRotate(&graph_view, ret, kind, rank, dim)) return ret.ToEmpty();
+    if (kind == RotateKind::kSlicePackReshape) {
+      auto rotate_properties = GetOutputProperties(ctx, ret.map.at("rotate"));
+      if (rotate_properties.empty() ||
+          !ShapesSymbolicallyEqual(x_shape, rotate_properties[0].shape())) {
+        return ret.ToEmpty();
+      }
+    }
+    return ret;
+  }
+
+  Status Update(RemapperContext* ctx,
+                const MatchedProperties& properties) const override {
+    auto& graph_view = ctx->graph_view;
+    auto* output_node = properties.GetNode(&graph_view, "output");
+
+    string x, cos, sin;
+    GetInputs(&graph_view, properties, &x, &cos, &sin);
+
+    NodeDef fused_node;
+    fused_node.set_op(kRotaryEmbedding);
+    fused_node.set_name(output_node->name());
+    fused_node.set_device(output_node->device());
+    fused_node.add_input(x);
+    fused_node.add_input(cos);
+    fused_node.add_input(sin);
+
+    auto* attr = fused_node.mutable_attr();
+    (*attr)["T"] = output_node->attr().at("T");
+    SetAttrValue(properties.map.count("pack") != 0, &(*attr)["interleaved"]);
+
+    utils::Mutation* mutation = graph_view.GetMutationBuilder();
+    Status status;
+    mutation->AddNode(std::move(fused_node), &status);
+    TF_RETURN_IF_ERROR(status);
+    TF_RETURN_IF_ERROR(mutation->Apply());
+
+    ITEX_VLOG(2) << "Fuse rotary embedding: " << output_node->name();
+    return Status::OK();
+  }
+
+ private:
+  static utils::OpTypePattern SlicePattern(const string& label) {
+    using utils::NodeStatus;
+    using utils::OpTypePattern;
+
+    OpTypePattern slice = {kStridedSlice, label, NodeStatus::kRemove};
+    slice.AddInput({kAny, "x", NodeStatus::kRemain})
+        .AddInput({kConst, label + "_begin", NodeStatus::kRemain})
+        .AddInput({kConst, label + "_end", NodeStatus::kRemain})
+        .AddInput({kConst, label + "_strides", NodeStatus::kRemain});
+    return slice;
+  }
+
+  // Builds AddV2(Mul(x, cos), Mul(rotate(x), sin)) with the given input
+  // orders. x of Mul(x, cos) is matched by GetInputs.
+  static utils::OpTypePattern BuildPattern(RotateKind kind, bool is_cos_first,
+                                           bool is_rotate_first) {
+    using utils::NodeStatus;
+    using utils::OpTypePattern;
+
+    OpTypePattern neg = {kNeg, "neg", NodeStatus::kRemove};
+    OpTypePattern rotate;
+    if (kind == RotateKind::kSplitConcat) {
+      OpTypePattern split = {kSplit, "split", NodeStatus::kRemove};
+      split.AddInput({kConst, "split_dim", NodeStatus::kRemain})
+          .AddInput({kAny, "x", NodeStatus::kRemain});
+      neg.AddInput(split);
+      rotate = {kConcatV2, "rotate", NodeStatus::kRemove};
+      rotate.AddInput(neg)
+          .AddInput({kSplit, "split", NodeStatus::kRemove})
+          .AddInput({kConst, "axis", NodeStatus::kRemain});
+    } else if (kind == RotateKind::kSliceConcat) {
+      neg.AddInput(SlicePattern("x2"));
+      rotate = {kConcatV2, "rotate", NodeStatus::kRemove};
+      rotate.AddInput(neg)
+          .AddInput(SlicePattern("x1"))
+          .AddInput({kConst, "axis", NodeStatus::kRemain});
+    } else {
+      neg.AddInput(SlicePattern("x2"));
+      OpTypePattern pack = {kPack, "pack", NodeStatus::kRemove};
+      pack.AddInput(neg).AddInput(SlicePattern("x1"));
+      rotate = {kReshape, "rotate", NodeStatus::kRemove};
+      rotate.AddInput(pack).AddInput({kAny, "shape", NodeStatus::kRemain});
+    }
+
+    OpTypePattern mul_cos = {kMul, "mul_cos", NodeStatus::kRemove};
+    mul_cos.AddInput({kAny, "cos_lhs", NodeStatus::kRemain})
+        .AddInput({kAny, "cos_rhs", NodeStatus::kRemain});
+
+    OpTypePattern sin = {kAny, "sin", NodeStatus::kRemain};
+    OpTypePattern mul_sin = {kMul, "mul_sin", NodeStatus::kRemove};
+    if (is_rotate_first) {
+      mul_sin.AddInput(rotate).AddInput(sin);
+    } else {
+      mul_sin.AddInput(sin).AddInput(rotate);
+    }
+
+    OpTypePattern output = {kAddV2, "output", NodeStatus::kReplace};
+    if (is_cos_first) {
+      output.AddInput(mul_cos).AddInput(mul_sin);
+    } else {
+      output.AddInput(mul_sin).AddInput(mul_cos);
+    }
+    return output;
+  }
+
+  // Gets the tensors of x, cos and sin. Returns false if Mul(x, cos) doesn't
+  // multiply the rotated tensor.
+  static bool GetInputs(utils::MutableGraphView* graph_view,
+                        const MatchedProperties& properties, string* x,
+                        string* cos, string* sin) {
+    const NodeDef* x_consumer =
+        properties.map.count("split")
+            ? properties.GetNode(graph_view, "split")
+            : properties.GetNode(graph_view, "x1");
+    *x = x_consumer->input(x_consumer->op() == kSplit ? 1 : 0);
+
+    const NodeDef* mul_cos = properties.GetNode(graph_view, "mul_cos");
+    if (ParseTensorName(mul_cos->input(0)) == ParseTensorName(*x)) {
+      *cos = mul_cos->input(1);
+    } else if (ParseTensorName(mul_cos->input(1)) == ParseTensorName(*x)) {
+      *cos = mul_cos->input(0);
+    } else {
+      return false;
+    }
+
+    const NodeDef* mul_sin = properties.GetNode(graph_view, "mul_sin");
+    const string& rotate = properties.GetNode(graph_view, "rotate")->name();
+    *sin = NodePositionIfSameNode(mul_sin->input(0), rotate) == 0
+               ? mul_sin->input(1)
+               : mul_sin->input(0);
+    return true;
+  }
+
+  // Checks rotate(x) slices, negates and joins x along its last dim.
+  static bool CheckRotate(utils::MutableGraphView* graph_view,
+                          const MatchedProperties& properties, RotateKind kind,
+                          int rank, int64 dim) {
+    const NodeDef* neg = properties.GetNode(graph_view, "neg");
+    const NodeDef* rotate = properties.GetNode(graph_view, "rotate");
+    if (kind == RotateKind::kSplitConcat) {
+      const NodeDef* split = properties.GetNode(graph_view, "split");
+      int num_split = 0;
+      TryGetNodeAttr(*split, "num_split", &num_split);
+      return num_split == 2 &&
+             IsLastAxis(*properties.GetNode(graph_view, "split_dim"), rank) &&
+             IsLastAxis(*properties.GetNode(graph_view, "axis"), rank) &&
+             NodePositionIfSameNode(neg->input(0), split->name()) == 1 &&
+             NodePositionIfSameNode(rotate->input(1), split->name()) == 0;
+    }
+
+    // Both slices read the same tensor.
+    const NodeDef* x1 = properties.GetNode(graph_view, "x1");
+    const NodeDef* x2 = properties.GetNode(graph_view, "x2");
+    if (ParseTensorName(x1->input(0)) != ParseTensorName(x2->input(0))) {
+      return false;
+    }
+    int64 begin1, end1, stride1, begin2, end2, stride2;
+    auto get_slice = [&](const NodeDef* slice, const string& label,
+                         int64* begin, int64* end, int64* stride) {
+      return GetLastDimSlice(
+          *slice, *properties.GetNode(graph_view, (label + "_begin").c_str()),
+          *properties.GetNode(graph_view, (label + "_end").c_str()),
+          *properties.GetNode(graph_view, (label + "_strides").c_str()), rank,
+          dim, begin, end, stride);
+    };
+    if (!get_slice(x1, "x1", &begin1, &end1, &stride1) ||
+        !get_slice(x2, "x2", &begin2, &end2, &stride2)) {
+      return false;
+    }
+
+    if (kind == RotateKind::kSliceConcat) {
+      return IsLastAxis(*properties.GetNode(graph_view, "axis"), rank) &&
+             begin1 == 0 && end1 == dim / 2 && stride1 == 1 &&
+             begin2 == dim / 2 && end2 == dim && stride2 == 1;
+    }
+
+    // stack(..., axis=-1) is reshaped back to the shape of x.
+    const NodeDef* pack = properties.GetNode(graph_view, "pack");
+    int axis = 0;
+    TryGetNodeAttr(*pack, "axis", &axis);
+    return (axis == -1 || axis == rank) && begin1 == 0 && stride1 == 2 &&
+           end1 >= dim - 1 && begin2 == 1 && stride2 == 2 && end2 == dim;
+  }
+
+  std::vector<std::pair<RotateKind, InternalPattern>> patterns_;
+};
+
+REGISTER_FUSION(RotaryEmbeddingFusion)
+}  // namespace graph
+}  // namespace itex
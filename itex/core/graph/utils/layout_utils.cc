@@ -561,7 +561,10 @@ bool IsLayoutRewriteSupportedDataType(const NodeDef& node_def) {
   // without `T` if want to rewrite it.
   DataType T;
   AttrSlice attr_list(node_def);
-  if (!TryGetNodeAttr(attr_list, "T", &T)) {
+  // ResourceScatterAdd has `dtype` instead.
+  const char* type_attr =
+      node_def.op() == "ResourceScatterAdd" ? "dtype" : "T";
+  if (!TryGetNodeAttr(attr_list, type_attr, &T)) {
     return false;
   }
 
@@ -17,7 +17,10 @@ limitations under the License.
 
 #include "itex/core/devices/xpu_device_util.h"
 #include "itex/core/graph/auto_mixed_precision/auto_mixed_precision.h"
+#include "itex/core/graph/embedding_compression/embedding_compression.h"
+#include "itex/core/graph/int8_calibration/int8_calibration.h"
 #include "itex/core/graph/memory_opt_pass/memory_opt_pass.h"
+#include "itex/core/graph/memory_scheduling/memory_scheduling.h"
 #include "itex/core/graph/native_layout/native_layout.h"
 #include "itex/core/graph/onednn_graph/onednn_graph.h"
 #include "itex/core/graph/onednn_layout/onednn_layout.h"
@@ -108,7 +111,35 @@ void Optimizer_Optimize(void* optimizer, const TF_Buffer* graph_buf,
     }
   }
 
+  // INT8 calibration works on the fp32 fused Conv2D/MatMul, before they're
+  // rewritten by the layout passes.
+  if (device_name == DEVICE_CPU && (config.enable_int8_calibration_collect ||
+                                    config.enable_int8_calibration_quantize)) {
+    optimized_graph_def.Swap(&graph_def);
+    SET_STATUS_IF_ERROR(
+        tf_status,
+        RunInt8Calibration(device_name, item, graph_def, &optimized_graph_def,
+                           config.enable_int8_calibration_collect));
+  }
+
+  if (device_name == DEVICE_CPU && (config.enable_embedding_compression_bf16 ||
+                                    config.enable_embedding_compression_int8)) {
+    optimized_graph_def.Swap(&graph_def);
+    SET_STATUS_IF_ERROR(
+        tf_status,
+        RunEmbeddingCompression(
+            device_name, item, graph_def, &optimized_graph_def,
+            config.enable_embedding_compression_bf16 ? DT_BFLOAT16 : DT_INT8,
+            config.embedding_compression_tolerance));
+  }
+
   if (config.enable_layout_opt) {
+    // oneDNN layout rewrites MatMul before the Native Format pass, so dynamic
+    // INT8 MatMul is never used.
+    if (device_name == DEVICE_CPU && config.enable_dynamic_int8) {
+      ITEX_VLOG(1) << "Dynamic INT8 MatMul is skipped since layout "
+                   << "optimization is enabled.";
+    }
     optimized_graph_def.Swap(&graph_def);
     SET_STATUS_IF_ERROR(tf_status, RunOneDnnLayout(device_name, item, graph_def,
                                                    &optimized_graph_def));
@@ -127,6 +158,15 @@ void Optimizer_Optimize(void* optimizer, const TF_Buffer* graph_buf,
   SET_STATUS_IF_ERROR(tf_status, RunMemoryOptPass(device_name, item, graph_def,
                                                   &optimized_graph_def));
 
+  // Memory-aware scheduling runs last, so that it sees the final nodes and
+  // the inplace attributes set by MemoryOptPass.
+  if (config.enable_memory_scheduling) {
+    optimized_graph_def.Swap(&graph_def);
+    SET_STATUS_IF_ERROR(
+        tf_status, RunMemorySchedulingPass(device_name, item, graph_def,
+                                           &optimized_graph_def));
+  }
+
   if (ITEX_VLOG_IS_ON(4)) {
     DumpGraphDefToFile("itex_optimizer", optimized_graph_def, "./");
   }
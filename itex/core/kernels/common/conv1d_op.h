@@ -0,0 +1,416 @@
+/* Copyright (c) 2022 Intel Corporation
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef ITEX_CORE_KERNELS_COMMON_CONV1D_OP_H_
+#define ITEX_CORE_KERNELS_COMMON_CONV1D_OP_H_
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "itex/core/utils/errors.h"
+#include "itex/core/utils/mutex.h"
+#include "itex/core/utils/onednn/onednn_primitive_log.h"
+#include "itex/core/utils/onednn/onednn_util.h"
+#include "itex/core/utils/op_kernel.h"
+#include "itex/core/utils/op_requires.h"
+#include "itex/core/utils/padding.h"
+#include "itex/core/utils/plugin_tensor.h"
+#include "itex/core/utils/tensor_shape.h"
+#include "itex/core/utils/types.h"
+
+namespace itex {
+
+using dnnl::convolution_forward;
+using dnnl::memory;
+using dnnl::prop_kind;
+
+// Shared implementation of the 1-D convolution kernels. Filter is
+// [K, C_in, C_out], the layout tf.nn.conv1d takes before it expands it to
+// 2-D. The primitive is cached by its shapes when ITEX_CACHE_ONEDNN_OBJECT is
+// enabled, and the reordered filter is cached when it's constant.
+template <typename Device, typename T>
+class Conv1DOpBase : public OpKernel {
+ public:
+  explicit Conv1DOpBase(OpKernelConstruction* context) : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("dilation", &dilation_));
+    OP_REQUIRES(context, dilation_ > 0,
+                errors::InvalidArgument("Dilation should be larger than 0."));
+    if (context->HasAttr("is_filter_const")) {
+      OP_REQUIRES_OK(context,
+                     context->GetAttr("is_filter_const", &is_filter_const_));
+    }
+    enable_cache_ = IsOneDnnObjectCacheEnabled();
+    fp32_math_mode_ = GetFP32MathMode<Device>();
+  }
+
+ protected:
+  // Convolves `src_data` ([N, C_in, W] logically, laid out as `data_tag`)
+  // with `filter_tensor` and writes [N, C_out, OW] into `dst_data`.
+  void ExecuteConv1D(OpKernelContext* context, void* src_data,
+                     const memory::dims& src_dims, const memory::dims& dst_dims,
+                     memory::format_tag data_tag, const Tensor& filter_tensor,
+                     int64 stride, int64 pad_left, int64 pad_right,
+                     void* dst_data) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_compute_) {
+    try {
+      auto onednn_engine = CreateDnnlEngine<Device>(*context);
+      auto onednn_stream = CreateDnnlStream(*context, onednn_engine);
+
+      memory::dims filter_dims = {FilterDim(filter_tensor, 2),
+                                  FilterDim(filter_tensor, 1),
+                                  FilterDim(filter_tensor, 0)};
+      memory::dims primitive_key = src_dims;
+      primitive_key.insert(primitive_key.end(), dst_dims.begin(),
+                           dst_dims.end());
+      primitive_key.insert(primitive_key.end(),
+                           {filter_dims[2], stride, pad_left, pad_right});
+
+      if (!(enable_cache_ && is_init_ && primitive_key == primitive_key_)) {
+        ScopedPrimitiveCreation record(
+            this, "convolution",
+            is_init_ ? PrimitiveCreateReason::kShapeChange
+                     : PrimitiveCreateReason::kCold);
+        memory::desc src_md(src_dims, OneDnnType<T>(), data_tag);
+        memory::desc dst_md(dst_dims, OneDnnType<T>(), data_tag);
+        memory::desc filter_md_prefer(filter_dims, OneDnnType<T>(),
+                                      memory::format_tag::any);
+        filter_md_ =
+            memory::desc(filter_dims, OneDnnType<T>(), memory::format_tag::wio);
+
+        // OneDNN dilations start from 0.
+        convolution_forward::desc fwd_desc(
+            prop_kind::forward_inference, dnnl::algorithm::convolution_direct,
+            src_md, filter_md_prefer, dst_md, {stride}, {dilation_ - 1},
+            {pad_left}, {pad_right});
+        dnnl::primitive_attr attr;
+        attr.set_scratchpad_mode(dnnl::scratchpad_mode::user);
+        if (std::is_same<T, float>::value) {
+          attr.set_fpmath_mode(fp32_math_mode_);
+        }
+        fwd_pd_ =
+            convolution_forward::primitive_desc(fwd_desc, attr, onednn_engine);
+        fwd_primitive_ = convolution_forward(fwd_pd_);
+        record.SetPrimitiveDesc(fwd_pd_);
+
+        src_mem_ = CreateDnnlMemory(src_md, onednn_engine);
+        dst_mem_ = CreateDnnlMemory(fwd_pd_.dst_desc(), onednn_engine);
+        primitive_key_ = primitive_key;
+        is_init_ = true;
+      }
+
+      // Reorder the filter if the primitive prefers a blocked format.
+      void* filter_data = GetTensorBuffer<T>(&filter_tensor);
+      const memory::desc& filter_md_prefer = fwd_pd_.weights_desc();
+      Tensor tmp_weight;
+      if (filter_md_prefer != filter_md_) {
+        T* filter_cached_data = nullptr;
+        if (is_filter_const_) {
+          if (weight_cache_manager_.IsEmpty()) {
+            weight_cache_manager_.SetCache(context, filter_md_,
+                                           filter_md_prefer, filter_data,
+                                           onednn_engine);
+          }
+          filter_cached_data =
+              weight_cache_manager_.GetCache(context, filter_md_prefer);
+        }
+        if (filter_cached_data != nullptr) {
+          filter_data = filter_cached_data;
+        } else {
+          int64 reorder_filter_size = filter_md_prefer.get_size() / sizeof(T);
+          OP_REQUIRES_OK(context,
+                         context->allocate_temp(
+                             DataTypeToEnum<T>::v(),
+                             TensorShape({reorder_filter_size}), &tmp_weight));
+          auto filter_mem_input =
+              CreateDnnlMemory(filter_md_, onednn_engine, filter_data);
+          auto filter_mem = CreateDnnlMemory(
+              filter_md_prefer, onednn_engine, GetTensorBuffer<T>(&tmp_weight));
+          ReorderMemory(*context, &filter_mem_input, &filter_mem,
+                        onednn_engine);
+          filter_data = GetTensorBuffer<T>(&tmp_weight);
+        }
+      }
+      auto filter_mem =
+          CreateDnnlMemory(filter_md_prefer, onednn_engine, filter_data);
+
+      Tensor scratchpad_tensor;
+      int64 scratchpad_size = fwd_pd_.scratchpad_desc().get_size() / sizeof(T);
+      OP_REQUIRES_OK(context,
+                     context->allocate_temp(DataTypeToEnum<T>::v(),
+                                            TensorShape({scratchpad_size}),
+                                            &scratchpad_tensor));
+      auto scratchpad_mem =
+          dnnl::memory(fwd_pd_.scratchpad_desc(), onednn_engine,
+                       GetTensorBuffer<T>(&scratchpad_tensor));
+
+      src_mem_.set_data_handle(src_data);
+      dst_mem_.set_data_handle(dst_data);
+      std::unordered_map<int, memory> fwd_primitive_args = {
+          {DNNL_ARG_SRC, src_mem_},
+          {DNNL_ARG_WEIGHTS, filter_mem},
+          {DNNL_ARG_DST, dst_mem_},
+          {DNNL_ARG_SCRATCHPAD, scratchpad_mem}};
+      fwd_primitive_.execute(onednn_stream, fwd_primitive_args);
+    } catch (dnnl::error& e) {
+      string error_msg = "Status: " + std::to_string(e.status) +
+                         ", message: " + string(e.message) + ", in file " +
+                         string(__FILE__) + ":" + std::to_string(__LINE__);
+      OP_REQUIRES_OK(
+          context,
+          errors::Aborted("Operation received an exception:", error_msg));
+    }
+  }
+
+  // Returns dim `i` of [K, C_in, C_out]. A constant filter may also come as
+  // [1, K, C_in, C_out], once its ExpandDims is folded, with the same memory.
+  static int64 FilterDim(const Tensor& filter_tensor, int i) {
+    return filter_tensor.dim_size(filter_tensor.dims() - 3 + i);
+  }
+
+  Status CheckFilter(const Tensor& filter_tensor, int64 in_channels) {
+    if (filter_tensor.dims() != 3 &&
+        !(filter_tensor.dims() == 4 && filter_tensor.dim_size(0) == 1)) {
+      return errors::InvalidArgument("filter must be 3-dimensional: ",
+                                     filter_tensor.shape().DebugString());
+    }
+    if (filter_tensor.NumElements() == 0) {
+      return errors::InvalidArgument(
+          "filter must not have zero elements "
+          "(i.e. all dimensions must be non-zero)");
+    }
+    if (FilterDim(filter_tensor, 1) != in_channels) {
+      return errors::InvalidArgument(
+          "input and filter must have the same depth: ", in_channels, " vs ",
+          FilterDim(filter_tensor, 1));
+    }
+    return Status::OK();
+  }
+
+  int64 dilation_ = 1;
+  mutex mu_compute_;
+
+ private:
+  bool is_filter_const_ = false;
+  bool enable_cache_ = false;
+  bool is_init_ TF_GUARDED_BY(mu_compute_) = false;
+  dnnl::fpmath_mode fp32_math_mode_ = dnnl::fpmath_mode::strict;
+
+  memory::dims primitive_key_ TF_GUARDED_BY(mu_compute_);
+  memory::desc filter_md_ TF_GUARDED_BY(mu_compute_);
+  convolution_forward::primitive_desc fwd_pd_ TF_GUARDED_BY(mu_compute_);
+  dnnl::primitive fwd_primitive_ TF_GUARDED_BY(mu_compute_);
+  dnnl::memory src_mem_ TF_GUARDED_BY(mu_compute_);
+  dnnl::memory dst_mem_ TF_GUARDED_BY(mu_compute_);
+
+  WeightCacheManager<T> weight_cache_manager_;
+};
+
+// Lowered `ExpandDims -> Conv2D -> Squeeze`. Computing the convolution as
+// 1-D avoids the H=1 2-D primitive and the reshapes around it.
+template <typename Device, typename T>
+class Conv1DOp : public Conv1DOpBase<Device, T> {
+ public:
+  explicit Conv1DOp(OpKernelConstruction* context)
+      : Conv1DOpBase<Device, T>(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("stride", &stride_));
+    OP_REQUIRES(context, stride_ > 0,
+                errors::InvalidArgument("Stride should be larger than 0."));
+    OP_REQUIRES_OK(context, context->GetAttr("padding", &padding_));
+    string data_format;
+    OP_REQUIRES_OK(context, context->GetAttr("data_format", &data_format));
+    is_nwc_ = (data_format == "NWC");
+  }
+
+  void Compute(OpKernelContext* context) override {
+    mutex_lock lock(&this->mu_compute_);
+    const Tensor& src_tensor = context->input(kSrcIndex_);
+    const Tensor& filter_tensor = context->input(kFilterIndex_);
+    OP_REQUIRES(context, src_tensor.dims() == 3,
+                errors::InvalidArgument("input must be 3-dimensional: ",
+                                        src_tensor.shape().DebugString()));
+
+    const int64 batch = src_tensor.dim_size(0);
+    const int64 in_width = src_tensor.dim_size(is_nwc_ ? 1 : 2);
+    const int64 in_channels = src_tensor.dim_size(is_nwc_ ? 2 : 1);
+    OP_REQUIRES_OK(context, this->CheckFilter(filter_tensor, in_channels));
+
+    const int64 out_channels = this->FilterDim(filter_tensor, 2);
+    const int64 effective_kernel =
+        (this->FilterDim(filter_tensor, 0) - 1) * this->dilation_ + 1;
+    int64 out_width = 0, pad_left = 0, pad_right = 0;
+    if (padding_ == Padding::VALID) {
+      if (in_width >= effective_kernel) {
+        out_width = (in_width - effective_kernel) / stride_ + 1;
+      }
+    } else {
+      out_width = (in_width + stride_ - 1) / stride_;
+      int64 pad_total = std::max<int64>(
+          (out_width - 1) * stride_ + effective_kernel - in_width, 0);
+      pad_left = pad_total / 2;
+      pad_right = pad_total - pad_left;
+    }
+
+    TensorShape dst_shape =
+        is_nwc_ ? TensorShape({batch, out_width, out_channels})
+                : TensorShape({batch, out_channels, out_width});
+    Tensor* dst_tensor = nullptr;
+    OP_REQUIRES_OK(
+        context, context->allocate_output(kDstIndex_, dst_shape, &dst_tensor));
+    if (dst_shape.num_elements() == 0) return;
+
+    this->ExecuteConv1D(
+        context, GetTensorBuffer<T>(&src_tensor),
+        {batch, in_channels, in_width}, {batch, out_channels, out_width},
+        is_nwc_ ? memory::format_tag::nwc : memory::format_tag::ncw,
+        filter_tensor, stride_, pad_left, pad_right,
+        GetTensorBuffer<T>(dst_tensor));
+  }
+
+ private:
+  const int kSrcIndex_ = 0, kFilterIndex_ = 1, kDstIndex_ = 0;
+  int64 stride_ = 1;
+  Padding padding_;
+  bool is_nwc_ = true;
+};
+
+// Stateful causal convolution for streaming inference. The kernel keeps a
+// ring buffer with the last (K - 1) * dilation input frames of each batch, so
+// a call only convolves the new frames: the history and the new frames are
+// laid out into one window and convolved with VALID padding, producing one
+// output per new frame. `reset` clears the history, e.g. at the start of a
+// new stream. The history lives in host memory, so only CPU is supported.
+template <typename Device, typename T>
+class CausalConv1DOp : public Conv1DOpBase<Device, T> {
+ public:
+  explicit CausalConv1DOp(OpKernelConstruction* context)
+      : Conv1DOpBase<Device, T>(context) {}
+
+  void Compute(OpKernelContext* context) override {
+    mutex_lock lock(&this->mu_compute_);
+    const Tensor& src_tensor = context->input(kSrcIndex_);
+    const Tensor& filter_tensor = context->input(kFilterIndex_);
+    const Tensor& reset_tensor = context->input(kResetIndex_);
+    OP_REQUIRES(context, src_tensor.dims() == 3,
+                errors::InvalidArgument("input must be 3-dimensional: ",
+                                        src_tensor.shape().DebugString()));
+    OP_REQUIRES(context, TensorShapeUtils::IsScalar(reset_tensor.shape()),
+                errors::InvalidArgument("reset must be a scalar: ",
+                                        reset_tensor.shape().DebugString()));
+
+    const int64 batch = src_tensor.dim_size(0);
+    const int64 frames = src_tensor.dim_size(1);
+    const int64 in_channels = src_tensor.dim_size(2);
+    OP_REQUIRES_OK(context, this->CheckFilter(filter_tensor, in_channels));
+    const int64 out_channels = this->FilterDim(filter_tensor, 2);
+    const int64 history_len =
+        (this->FilterDim(filter_tensor, 0) - 1) * this->dilation_;
+
+    Tensor* dst_tensor = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(
+                                kDstIndex_,
+                                TensorShape({batch, frames, out_channels}),
+                                &dst_tensor));
+    if (dst_tensor->NumElements() == 0) return;
+
+    // (Re)start the stream with zero history, which is equivalent to the
+    // left padding of an offline causal convolution.
+    if (!history_.IsInitialized() || history_batch_ != batch ||
+        history_len_ != history_len || history_channels_ != in_channels ||
+        reset_tensor.scalar<bool>()()) {
+      Tensor* history_tensor = nullptr;
+      OP_REQUIRES_OK(context,
+                     context->allocate_persistent(
+                         DataTypeToEnum<T>::v(),
+                         TensorShape({batch, history_len, in_channels}),
+                         &history_, &history_tensor));
+      std::fill_n(history_tensor->flat<T>().data(),
+                  history_tensor->NumElements(), T(0));
+      history_batch_ = batch;
+      history_len_ = history_len;
+      history_channels_ = in_channels;
+      history_head_ = 0;
+    }
+
+    const T* src_data = src_tensor.flat<T>().data();
+    if (history_len == 0) {
+      this->ExecuteConv1D(context, const_cast<T*>(src_data),
+                          {batch, in_channels, frames},
+                          {batch, out_channels, frames},
+                          memory::format_tag::nwc, filter_tensor, 1, 0, 0,
+                          GetTensorBuffer<T>(dst_tensor));
+      return;
+    }
+
+    // Build the window [N, history_len + frames, C_in] in NWC.
+    const int64 window_len = history_len + frames;
+    Tensor window_tensor;
+    OP_REQUIRES_OK(context,
+                   context->allocate_temp(
+                       DataTypeToEnum<T>::v(),
+                       TensorShape({batch, window_len, in_channels}),
+                       &window_tensor));
+    T* window = window_tensor.flat<T>().data();
+    T* history = history_.AccessTensor(context)->flat<T>().data();
+    const int64 frame_bytes = in_channels * sizeof(T);
+    for (int64 n = 0; n < batch; ++n) {
+      const T* ring = history + n * history_len * in_channels;
+      T* dst = window + n * window_len * in_channels;
+      // Oldest frame is at the head of the ring.
+      const int64 tail_frames = history_len - history_head_;
+      std::memcpy(dst, ring + history_head_ * in_channels,
+                  tail_frames * frame_bytes);
+      std::memcpy(dst + tail_frames * in_channels, ring,
+                  history_head_ * frame_bytes);
+      std::memcpy(dst + history_len * in_channels,
+                  src_data + n * frames * in_channels, frames * frame_bytes);
+    }
+
+    this->ExecuteConv1D(context, window, {batch, in_channels, window_len},
+                        {batch, out_channels, frames}, memory::format_tag::nwc,
+                        filter_tensor, 1, 0, 0, GetTensorBuffer<T>(dst_tensor));
+
+    // Push the new frames into the ring, only the last `history_len` frames
+    // are kept.
+    const int64 pushed = std::min(frames, history_len);
+    for (int64 n = 0; n < batch; ++n) {
+      T* ring = history + n * history_len * in_channels;
+      const T* newest =
+          window + (n * window_len + window_len - pushed) * in_channels;
+      for (int64 i = 0; i < pushed; ++i) {
+        const int64 slot = (history_head_ + i) % history_len;
+        std::memcpy(ring + slot * in_channels, newest + i * in_channels,
+                    frame_bytes);
+      }
+    }
+    history_head_ = (history_head_ + pushed) % history_len;
+  }
+
+ private:
+  const int kSrcIndex_ = 0, kFilterIndex_ = 1, kResetIndex_ = 2;
+  const int kDstIndex_ = 0;
+
+  PersistentTensor history_;
+  int64 history_batch_ = 0;
+  int64 history_len_ = 0;
+  int64 history_channels_ = 0;
+  // Ring slot of the oldest frame.
+  int64 history_head_ = 0;
+};
+
+}  // namespace itex
+
+#endif  // ITEX_CORE_KERNELS_COMMON_CONV1D_OP_H_
@@ -16,7 +16,10 @@ limitations under the License.
 #ifndef ITEX_CORE_KERNELS_COMMON_CONV_GRAD_OPS_H_
 #define ITEX_CORE_KERNELS_COMMON_CONV_GRAD_OPS_H_
 
+#include <atomic>
+#include <cstring>
 #include <limits>
+#include <map>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -24,7 +27,9 @@ limitations under the License.
 #include "itex/core/devices/xpu_device_util.h"
 #include "itex/core/kernels/common/conv_ops.h"
 #include "itex/core/utils/errors.h"
+#include "itex/core/utils/mutex.h"
 #include "itex/core/utils/onednn/onednn_layout_util.h"
+#include "itex/core/utils/onednn/onednn_primitive_log.h"
 #include "itex/core/utils/onednn/onednn_util.h"
 #include "itex/core/utils/op_kernel.h"
 #include "itex/core/utils/op_requires.h"
@@ -465,8 +470,10 @@ class ConvBackpropFilterOp
   }
 };
 
+// With `reuse_filter`, the kernel has 2 more inputs: the filter reordered by
+// the forward kernel and its memory descriptor, see ConvWithReorderedFilterOp.
 template <typename Device, typename T, bool is_depthwise = false,
-          bool pad_enabled = false>
+          bool pad_enabled = false, bool reuse_filter = false>
 class ConvBackpropInputOp
     : public ConvBackpropCommonOp<Device, T, is_depthwise> {
  public:
@@ -481,6 +488,7 @@ class ConvBackpropInputOp
 
   void Compute(OpKernelContext* context) override {
     const int kInputSizesIdx = 0, kFilterIdx = 1, kOutBackpropIdx = 2;
+    const int kReorderedFilterIdx = 3, kReorderedFilterDescIdx = 4;
     const int kOutputIdx = 0;
     try {
       auto onednn_engine = CreateDnnlEngine<Device>(*context);
@@ -607,9 +615,59 @@ class ConvBackpropInputOp
         attr.set_fpmath_mode(this->fp32_math_mode_);
       }
 
-      ConvFwdPd fwd_pd = ConvFwdPd(fwd_desc, attr, onednn_engine);
-      ConvBwdInputPd bwd_input_pd =
-          ConvBwdInputPd(bwd_input_desc, attr, onednn_engine, fwd_pd);
+      ConvBwdInputPd bwd_input_pd;
+      bool is_filter_shared = false;
+      {
+        ScopedPrimitiveCreation record(
+            this, "convolution_backward_data",
+            is_created_.exchange(true) ? PrimitiveCreateReason::kShapeChange
+                                       : PrimitiveCreateReason::kCold);
+        ConvFwdPd fwd_pd = ConvFwdPd(fwd_desc, attr, onednn_engine);
+
+        // Use the filter reordered by forward kernel if the primitive, or the
+        // same implementation of it, takes that layout. The answer only
+        // depends on the shapes, so it's computed once per shape.
+        if (reuse_filter) {
+          const Tensor& desc_tensor = context->input(kReorderedFilterDescIdx);
+          memory::desc shared_filter_md;
+          if (desc_tensor.NumElements() == sizeof(shared_filter_md.data)) {
+            std::memcpy(&shared_filter_md.data,
+                        desc_tensor.flat<uint8>().data(),
+                        sizeof(shared_filter_md.data));
+          }
+          if (shared_filter_md.dims() == fwd_filter_dims) {
+            ConvBwdInputDesc shared_desc = ConvBwdInputDesc(
+                dnnl::algorithm::convolution_direct, diff_src_md_opt,
+                shared_filter_md, diff_dst_md_opt, stride_dims, dilation_dims,
+                pad_left_dims, pad_right_dims);
+            memory::dims key = fwd_src_dims;
+            key.insert(key.end(), fwd_filter_dims.begin(),
+                       fwd_filter_dims.end());
+            {
+              mutex_lock lock(&sharing_mu_);
+              auto it = filter_sharing_.find(key);
+              if (it == filter_sharing_.end()) {
+                it = filter_sharing_
+                         .emplace(key, CanUseConvFilterLayout(
+                                           shared_filter_md, bwd_input_desc,
+                                           shared_desc, attr, onednn_engine,
+                                           fwd_pd))
+                         .first;
+              }
+              is_filter_shared = it->second;
+            }
+            if (is_filter_shared) {
+              bwd_input_pd =
+                  ConvBwdInputPd(shared_desc, attr, onednn_engine, fwd_pd);
+            }
+          }
+        }
+        if (!is_filter_shared) {
+          bwd_input_pd =
+              ConvBwdInputPd(bwd_input_desc, attr, onednn_engine, fwd_pd);
+        }
+        record.SetPrimitiveDesc(bwd_input_pd);
+      }
 
       Tensor scratchpad_tensor;
       int64 scratchpad_size =
@@ -663,7 +721,13 @@ class ConvBackpropInputOp
                                          static_cast<void*>(filter_data));
       bool is_filter_reordered = (bwd_input_pd.weights_desc() != filter_md);
 
-      if (is_filter_reordered) {
+      if (is_filter_shared) {
+        const Tensor& shared_filter_tensor =
+            context->input(kReorderedFilterIdx);
+        filter_mem = CreateDnnlMemory(
+            bwd_input_pd.weights_desc(), onednn_engine,
+            GetTensorBuffer<T>(&shared_filter_tensor));
+      } else if (is_filter_reordered) {
         // TODO(itex): add supports for costant filter
         bool is_filter_cached = false;
         if (!is_filter_cached) {
@@ -708,6 +772,12 @@ class ConvBackpropInputOp
           errors::Aborted("Operation received an exception:", error_msg));
     }
   }
+
+ private:
+  std::atomic<bool> is_created_{false};
+  // Whether the forwarded filter is used, by source and filter dims.
+  mutex sharing_mu_;
+  std::map<memory::dims, bool> filter_sharing_ TF_GUARDED_BY(sharing_mu_);
 };
 
 }  // namespace itex
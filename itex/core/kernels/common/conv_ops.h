@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef ITEX_CORE_KERNELS_COMMON_CONV_OPS_H_
 #define ITEX_CORE_KERNELS_COMMON_CONV_OPS_H_
 
+#include <cstring>
 #include <limits>
 #include <string>
 #include <unordered_map>
@@ -26,6 +27,7 @@ limitations under the License.
 #include "itex/core/utils/errors.h"
 #include "itex/core/utils/onednn/onednn_layout_util.h"
 #include "itex/core/utils/onednn/onednn_post_op_util.h"
+#include "itex/core/utils/onednn/onednn_primitive_log.h"
 #include "itex/core/utils/onednn/onednn_util.h"
 #include "itex/core/utils/op_kernel.h"
 #include "itex/core/utils/op_requires.h"
@@ -672,8 +674,7 @@ class ConvOpBase : public OpKernel {
       OP_REQUIRES_OK(context, context->GetAttr("inplace_sum", &inplace_sum_));
     }
 
-    ITEX_CHECK_OK(
-        ReadBoolFromEnvVar("ITEX_CACHE_ONEDNN_OBJECT", false, &enable_cache_));
+    enable_cache_ = IsOneDnnObjectCacheEnabled();
     fp32_math_mode_ = GetFP32MathMode<Device>();
   }
 
@@ -690,12 +691,24 @@ class ConvOpBase : public OpKernel {
       return;
     }
 
+    // `filter_mem_` points to the weight cache, which may be evicted since
+    // the last run. Init() fills it again.
+    if (is_filter_reordered_ && is_filter_const_ &&
+        weight_cache_manager_.IsEmpty()) {
+      Init(context, /*is_weight_evicted=*/true);
+      return;
+    }
+
     src_mem_opt_.set_data_handle(context->tensor_data(kSrcIndex_));
 
     if (is_filter_reordered_) {
       if (!is_filter_const_) {
+        Tfilter* filter_data_handle = nullptr;
+        OP_REQUIRES_OK(context,
+                       AllocateReorderedFilter(context, fwd_pd_.weights_desc(),
+                                               true, &filter_data_handle));
         filter_mem_input_.set_data_handle(context->tensor_data(kFilterIndex_));
-        filter_mem_.set_data_handle(GetTensorBuffer<Tfilter>(&tmp_weight_));
+        filter_mem_.set_data_handle(filter_data_handle);
         weight_reorder_.execute(onednn_stream_, weight_reorder_args_);
       }
     } else {
@@ -739,7 +752,9 @@ class ConvOpBase : public OpKernel {
     }
   }
 
-  void Init(OpKernelContext* context) {
+  // `is_weight_evicted` is set when the cached objects are recreated only to
+  // fill the evicted weight cache again.
+  void Init(OpKernelContext* context, bool is_weight_evicted = false) {
     try {
       fwd_primitives_args_.clear();
 
@@ -870,7 +885,15 @@ class ConvOpBase : public OpKernel {
       if (std::is_same<Tinput, float>::value) {
         post_ops_attr.set_fpmath_mode(fp32_math_mode_);
       }
-      fwd_pd_ = ConvFwdPd(fwd_desc, post_ops_attr, onednn_engine_);
+      {
+        ScopedPrimitiveCreation record(
+            this, "convolution",
+            is_weight_evicted ? PrimitiveCreateReason::kEviction
+            : is_init_        ? PrimitiveCreateReason::kShapeChange
+                              : PrimitiveCreateReason::kCold);
+        fwd_pd_ = ConvFwdPd(fwd_desc, post_ops_attr, onednn_engine_);
+        record.SetPrimitiveDesc(fwd_pd_);
+      }
 
       // keep tensor out of if block to avoid of being deallocated
       is_format_reordered_ = data_layout != tag_opt;
@@ -954,19 +977,16 @@ class ConvOpBase : public OpKernel {
           }
           filter_cached_data =
               weight_cache_manager_.GetCache(context, filter_md_prefer);
-          if (filter_cached_data != nullptr) {
-            filter_mem_ = CreateDnnlMemory(filter_md_prefer, onednn_engine_,
-                                           filter_cached_data);
-          }
+        }
+        if (filter_cached_data != nullptr) {
+          filter_mem_ = CreateDnnlMemory(filter_md_prefer, onednn_engine_,
+                                         filter_cached_data);
         } else {
-          // allocate temporay tensor for reordering filter
-          int64_t reorder_filter_data_size =
-              fwd_pd_.weights_desc().get_size() / sizeof(Tfilter);
-          OP_REQUIRES_OK(context, context->allocate_temp(
-                                      DataTypeToEnum<Tfilter>::v(),
-                                      TensorShape({reorder_filter_data_size}),
-                                      &tmp_weight_));
-          void* filter_data_handle = GetTensorBuffer<Tfilter>(&tmp_weight_);
+          // Not const, or the cache was evicted.
+          Tfilter* filter_data_handle = nullptr;
+          OP_REQUIRES_OK(context,
+                         AllocateReorderedFilter(context, filter_md_prefer,
+                                                 false, &filter_data_handle));
           filter_mem_ = CreateDnnlMemory(filter_md_prefer, onednn_engine_,
                                          filter_data_handle);
           weight_reorder_args_.clear();
@@ -1074,6 +1094,21 @@ class ConvOpBase : public OpKernel {
   // ExtendInt8PostOps is only used in Int8 ops.
   virtual void ExtendInt8PostOps(OpKernelContext* context) {}
 
+  // Returns the buffer which non-const filter is reordered into. By default
+  // it's a temporary tensor allocated in Init and reused by cached runs.
+  virtual Status AllocateReorderedFilter(OpKernelContext* context,
+                                         const memory::desc& filter_md,
+                                         bool is_cached, Tfilter** data) {
+    if (!is_cached) {
+      int64_t reorder_filter_data_size = filter_md.get_size() / sizeof(Tfilter);
+      TF_RETURN_IF_ERROR(context->allocate_temp(
+          DataTypeToEnum<Tfilter>::v(), TensorShape({reorder_filter_data_size}),
+          &tmp_weight_));
+    }
+    *data = static_cast<Tfilter*>(GetTensorBuffer<Tfilter>(&tmp_weight_));
+    return Status::OK();
+  }
+
   virtual void AllocateOutputTensor(
       OpKernelContext* context,
       const dnnl::convolution_forward::primitive_desc& conv_pd,
@@ -1189,5 +1224,59 @@ class FusedConvOp : public ConvOpBase<Device, Tinput, Tfilter, Tbias, Toutput,
   TF_DISALLOW_COPY_AND_ASSIGN(FusedConvOp);
 };
 
+// Conv which also outputs its reordered non-const filter and the memory
+// descriptor of it, so the backward data kernel of the same filter can skip
+// reordering it again. Both outputs are empty if the filter isn't reordered.
+template <typename Device, typename T>
+class ConvWithReorderedFilterOp : public ConvOpBase<Device, T, T, T, T, T> {
+ public:
+  explicit ConvWithReorderedFilterOp(OpKernelConstruction* context)
+      : ConvOpBase<Device, T, T, T, T, T>(context) {}
+
+  void Compute(OpKernelContext* context) override {
+    mutex_lock lock(&mu_);
+    is_filter_output_ = false;
+    ConvOpBase<Device, T, T, T, T, T>::Compute(context);
+    if (!context->status().ok() || is_filter_output_) return;
+
+    Tensor* unused = nullptr;
+    OP_REQUIRES_OK(context,
+                   context->allocate_output(kReorderedFilterIndex_,
+                                            TensorShape({0}), &unused));
+    OP_REQUIRES_OK(context,
+                   context->allocate_output(kReorderedFilterDescIndex_,
+                                            TensorShape({0}), &unused));
+  }
+
+ protected:
+  Status AllocateReorderedFilter(OpKernelContext* context,
+                                 const memory::desc& filter_md, bool is_cached,
+                                 T** data) override {
+    Tensor* filter_tensor = nullptr;
+    TF_RETURN_IF_ERROR(context->allocate_output(
+        kReorderedFilterIndex_,
+        TensorShape({static_cast<int64>(filter_md.get_size() / sizeof(T))}),
+        &filter_tensor));
+    Tensor* desc_tensor = nullptr;
+    TF_RETURN_IF_ERROR(context->allocate_output(
+        kReorderedFilterDescIndex_,
+        TensorShape({static_cast<int64>(sizeof(filter_md.data))}),
+        &desc_tensor));
+    std::memcpy(desc_tensor->flat<uint8>().data(), &filter_md.data,
+                sizeof(filter_md.data));
+
+    *data = static_cast<T*>(GetTensorBuffer<T>(filter_tensor));
+    is_filter_output_ = true;
+    return Status::OK();
+  }
+
+ private:
+  const int kReorderedFilterIndex_ = 1, kReorderedFilterDescIndex_ = 2;
+  bool is_filter_output_ = false;
+  mutex mu_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ConvWithReorderedFilterOp);
+};
+
 }  // namespace itex
 #endif  // ITEX_CORE_KERNELS_COMMON_CONV_OPS_H_
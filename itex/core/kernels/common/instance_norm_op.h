@@ -16,12 +16,16 @@ limitations under the License.
 #ifndef ITEX_CORE_KERNELS_COMMON_INSTANCE_NORM_OP_H_
 #define ITEX_CORE_KERNELS_COMMON_INSTANCE_NORM_OP_H_
 
+#include <algorithm>
+#include <cmath>
 #include <memory>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
 #include "itex/core/utils/errors.h"
+#include "itex/core/utils/mutex.h"
+#include "itex/core/utils/onednn/onednn_primitive_log.h"
 #include "itex/core/utils/onednn/onednn_util.h"
 #include "itex/core/utils/op_kernel.h"
 #include "itex/core/utils/op_requires.h"
@@ -32,6 +36,152 @@ limitations under the License.
 
 namespace itex {
 
+// Native InstanceNorm for channels-last (NHWC/NDHWC) input on CPU. The input
+// is viewed as [batch, spatial, channels] and split into chunks of rows, so
+// even batch 1 volumes are spread over all threads. Pass 1 accumulates
+// per-chunk sum and sum of squares of each channel, pass 2 normalizes with
+// the folded scale/shift and applies the optional Relu/LeakyRelu. Channel is
+// the innermost dimension, so both inner loops are contiguous and vectorized
+// by the compiler, and no layout conversion is needed.
+class InstanceNormChannelsLast {
+ public:
+  InstanceNormChannelsLast(int64 batch, int64 spatial, int64 channels)
+      : batch_(batch), spatial_(spatial), channels_(channels) {
+    // Keep a chunk around 16K elements: big enough to amortize the partial
+    // sums, small enough to keep float accumulation accurate.
+    rows_per_chunk_ = std::max<int64>(1, kChunkElements / channels_);
+    num_chunks_ = (spatial_ + rows_per_chunk_ - 1) / rows_per_chunk_;
+  }
+
+  // Number of float elements needed by `workspace` in Compute().
+  int64 WorkspaceSize() const {
+    return batch_ * (num_chunks_ + 1) * 2 * channels_;
+  }
+
+  template <typename T, typename U>
+  void Compute(const Eigen::ThreadPoolDevice& d, const T* src, const U* scale,
+               const U* shift, float epsilon, bool fuse_activation,
+               float alpha, float* workspace, T* dst) const {
+    const int64 C = channels_;
+    const int64 num_tasks = batch_ * num_chunks_;
+    float* partials = workspace;
+    float* coeffs = workspace + num_tasks * 2 * C;
+    const double chunk_cost = static_cast<double>(rows_per_chunk_ * C);
+
+    // Pass 1: per-chunk sums. Values are shifted by the first element of the
+    // instance to avoid cancellation when computing variance.
+    d.parallelFor(
+        num_tasks,
+        Eigen::TensorOpCost(chunk_cost * sizeof(T), 0, chunk_cost * 4),
+        [&](Eigen::Index first, Eigen::Index last) {
+          for (Eigen::Index task = first; task < last; ++task) {
+            const int64 n = task / num_chunks_;
+            const int64 row_begin = (task % num_chunks_) * rows_per_chunk_;
+            const int64 row_end =
+                std::min(spatial_, row_begin + rows_per_chunk_);
+            const T* pivot = src + n * spatial_ * C;
+            float* sum = partials + task * 2 * C;
+            float* sum_sq = sum + C;
+            std::fill(sum, sum + 2 * C, 0.0f);
+            for (int64 row = row_begin; row < row_end; ++row) {
+              const T* x = pivot + row * C;
+              for (int64 c = 0; c < C; ++c) {
+                float v = static_cast<float>(x[c]) -
+                          static_cast<float>(pivot[c]);
+                sum[c] += v;
+                sum_sq[c] += v * v;
+              }
+            }
+          }
+        });
+
+    // Reduce the chunks and fold mean/variance with scale and shift into
+    // y = x * coeff_scale + coeff_shift.
+    d.parallelFor(
+        batch_, Eigen::TensorOpCost(0, 0, static_cast<double>(num_chunks_ * C)),
+        [&](Eigen::Index first, Eigen::Index last) {
+          for (Eigen::Index n = first; n < last; ++n) {
+            const T* pivot = src + n * spatial_ * C;
+            float* coeff_scale = coeffs + n * 2 * C;
+            float* coeff_shift = coeff_scale + C;
+            for (int64 c = 0; c < C; ++c) {
+              double sum = 0, sum_sq = 0;
+              for (int64 k = 0; k < num_chunks_; ++k) {
+                const float* part = partials + (n * num_chunks_ + k) * 2 * C;
+                sum += part[c];
+                sum_sq += part[C + c];
+              }
+              double shifted_mean = sum / spatial_;
+              double var = std::max(
+                  sum_sq / spatial_ - shifted_mean * shifted_mean, 0.0);
+              double mean = shifted_mean + static_cast<float>(pivot[c]);
+              double inv_std = 1.0 / std::sqrt(var + epsilon);
+              double s = static_cast<double>(scale[c]) * inv_std;
+              coeff_scale[c] = static_cast<float>(s);
+              coeff_shift[c] =
+                  static_cast<float>(static_cast<double>(shift[c]) - mean * s);
+            }
+          }
+        });
+
+    // Pass 2: normalize. `dst` may alias `src`.
+    d.parallelFor(
+        num_tasks,
+        Eigen::TensorOpCost(chunk_cost * sizeof(T), chunk_cost * sizeof(T),
+                            chunk_cost * 3),
+        [&](Eigen::Index first, Eigen::Index last) {
+          for (Eigen::Index task = first; task < last; ++task) {
+            const int64 n = task / num_chunks_;
+            const int64 row_begin = (task % num_chunks_) * rows_per_chunk_;
+            const int64 row_end =
+                std::min(spatial_, row_begin + rows_per_chunk_);
+            const float* coeff_scale = coeffs + n * 2 * C;
+            const float* coeff_shift = coeff_scale + C;
+            for (int64 row = row_begin; row < row_end; ++row) {
+              const int64 offset = (n * spatial_ + row) * C;
+              const T* x = src + offset;
+              T* y = dst + offset;
+              if (fuse_activation) {
+                for (int64 c = 0; c < C; ++c) {
+                  float v = static_cast<float>(x[c]) * coeff_scale[c] +
+                            coeff_shift[c];
+                  y[c] = static_cast<T>(v > 0.0f ? v : v * alpha);
+                }
+              } else {
+                for (int64 c = 0; c < C; ++c) {
+                  y[c] = static_cast<T>(static_cast<float>(x[c]) *
+                                            coeff_scale[c] +
+                                        coeff_shift[c]);
+                }
+              }
+            }
+          }
+        });
+  }
+
+ private:
+  static constexpr int64 kChunkElements = 16384;
+
+  int64 batch_;
+  int64 spatial_;
+  int64 channels_;
+  int64 rows_per_chunk_;
+  int64 num_chunks_;
+};
+
+// Returns true if InstanceNormChannelsLast can handle the input directly.
+// `scale` and `shift` may be broadcastable tensors like [1, 1, 1, C], but they
+// must hold exactly one element per channel.
+template <typename Device>
+bool CanUseInstanceNormChannelsLast(TensorFormat tensor_format,
+                                    const TensorShape& src_shape,
+                                    const Tensor& scale, const Tensor& shift) {
+  if (!std::is_same<Device, CPUDevice>::value) return false;
+  if (tensor_format != FORMAT_NHWC) return false;
+  const int64 channels = src_shape.dim_size(src_shape.dims() - 1);
+  return scale.NumElements() == channels && shift.NumElements() == channels;
+}
+
 template <typename Device, typename T, typename U, bool fuse_activation = false>
 class InstanceNormOp : public OpKernel {
  public:
@@ -67,46 +217,64 @@ class InstanceNormOp : public OpKernel {
                                   "only support Relu and LeakyRelu"));
       }
     }
+
+    enable_cache_ = IsOneDnnObjectCacheEnabled();
   }
 
   void Compute(OpKernelContext* context) override {
+    const size_t kSrcIndex = 0;    // index of src input tensor
+    const size_t kScaleIndex = 1;  // index of scale tensor
+    const size_t kShiftIndex = 2;  // index of shift tensor
+    const Tensor& src_tensor = context->input(kSrcIndex);
+    const Tensor& scale_tensor = context->input(kScaleIndex);
+    const Tensor& shift_tensor = context->input(kShiftIndex);
+
+    TensorShape src_tf_shape = src_tensor.shape();
+    const int ndims = src_tf_shape.dims();
+
+    OP_REQUIRES(context, ndims == 4 || ndims == 5,
+                errors::InvalidArgument(
+                    "input must be 4-dimensional or 5-dimensional",
+                    src_tensor.shape().DebugString()));
+
+    // Handle the special case: input with 0 element and 0 layer size.
+    Tensor* dst_tensor = nullptr;
+    if (src_tf_shape.num_elements() == 0) {
+      OP_REQUIRES_OK(context, context->forward_input_or_allocate_output(
+                                  {0}, 0, src_tf_shape, &dst_tensor));
+      ITEX_DCHECK(dst_tensor);
+      return;
+    } else {
+      OP_REQUIRES_OK(context, context->forward_input_or_allocate_output(
+                                  {0}, 0, src_tensor.shape(), &dst_tensor));
+    }
+
+    const int batch_size = src_tensor.shape().dim_size(0);
+    const int64_t elems_per_batch =
+        src_tensor.shape().num_elements() / batch_size;
+
+    if (CanUseInstanceNormChannelsLast<Device>(tensor_format_, src_tf_shape,
+                                               scale_tensor, shift_tensor)) {
+      const int64 channels = src_tf_shape.dim_size(ndims - 1);
+      InstanceNormChannelsLast instance_norm(
+          batch_size, elems_per_batch / channels, channels);
+      Tensor workspace_tensor;
+      OP_REQUIRES_OK(context, context->allocate_temp(
+                                  DT_FLOAT,
+                                  TensorShape({instance_norm.WorkspaceSize()}),
+                                  &workspace_tensor));
+      instance_norm.Compute<T, U>(
+          context->eigen_cpu_device(), src_tensor.flat<T>().data(),
+          scale_tensor.flat<U>().data(), shift_tensor.flat<U>().data(),
+          epsilon_, fuse_activation, leakyrelu_alpha_,
+          workspace_tensor.flat<float>().data(), dst_tensor->flat<T>().data());
+      return;
+    }
+
     try {
       auto onednn_engine = CreateDnnlEngine<Device>(*context);
       auto onednn_stream = CreateDnnlStream(*context, onednn_engine);
 
-      const size_t kSrcIndex = 0;    // index of src input tensor
-      const size_t kScaleIndex = 1;  // index of scale tensor
-      const size_t kShiftIndex = 2;  // index of shift tensor
-      const Tensor& src_tensor = context->input(kSrcIndex);
-      const Tensor& scale_tensor = context->input(kScaleIndex);
-      const Tensor& shift_tensor = context->input(kShiftIndex);
-
-      TensorShape src_tf_shape = src_tensor.shape();
-      const int ndims = src_tf_shape.dims();
-
-      OP_REQUIRES(context, ndims == 4 || ndims == 5,
-                  errors::InvalidArgument(
-                      "input must be 4-dimensional or 5-dimensional",
-                      src_tensor.shape().DebugString()));
-
-      const int batch_size = src_tensor.shape().dim_size(0);
-      const int64_t elems_per_batch =
-          src_tensor.shape().num_elements() / batch_size;
-
-      // Handle the special case: input with 0 element and 0 layer size.
-      Tensor* dst_tensor = nullptr;
-      TensorShape workspace_tf_shape;
-      if (src_tf_shape.num_elements() == 0) {
-        workspace_tf_shape.AddDim(0);
-        OP_REQUIRES_OK(context, context->forward_input_or_allocate_output(
-                                    {0}, 0, src_tf_shape, &dst_tensor));
-        ITEX_DCHECK(dst_tensor);
-        return;
-      } else {
-        OP_REQUIRES_OK(context, context->forward_input_or_allocate_output(
-                                    {0}, 0, src_tensor.shape(), &dst_tensor));
-      }
-
       int num_elements_scale = scale_tensor.dim_size(0);
       int num_elements_shift = shift_tensor.dim_size(0);
       if (scale_tensor.dims() > 1 && shift_tensor.dims() > 1) {
@@ -144,32 +312,46 @@ class InstanceNormOp : public OpKernel {
       auto shift_md =
           dnnl::memory::desc({static_cast<int64>(num_elements_shift)},
                              OneDnnType<U>(), dnnl::memory::format_tag::a);
-      // Create fwd primitive.
-      auto propagation = dnnl::prop_kind::forward_inference;
-      auto flags = dnnl::normalization_flags::use_scale |
-                   dnnl::normalization_flags::use_shift;
 
-      dnnl::batch_normalization_forward::desc bn_fwd_desc(propagation, src_md,
-                                                          epsilon_, flags);
-
-      dnnl::primitive_attr attr;
-      attr.set_scratchpad_mode(dnnl::scratchpad_mode::user);
+      // The primitive only depends on the per-instance shape, so it is shared
+      // by all batches and reused across steps when caching is enabled. Only
+      // the lookup is guarded, execution runs on a local handle.
       dnnl::batch_normalization_forward::primitive_desc bn_fwd_pd;
-
-      if (fuse_activation) {
-        dnnl::post_ops post_ops;
-        post_ops.append_eltwise(1.0, dnnl::algorithm::eltwise_relu,
-                                leakyrelu_alpha_, 0.0);
-        attr.set_post_ops(post_ops);
-        bn_fwd_pd = dnnl::batch_normalization_forward::primitive_desc(
-            bn_fwd_desc, attr, onednn_engine);
-      } else {
-        bn_fwd_pd = dnnl::batch_normalization_forward::primitive_desc(
-            bn_fwd_desc, attr, onednn_engine);
+      dnnl::batch_normalization_forward bn_fwd_primitive;
+      {
+        mutex_lock lock(&mu_compute_);
+        if (!(enable_cache_ && is_init_ && src_dims == cached_src_dims_)) {
+          ScopedPrimitiveCreation record(
+              this, "batch_normalization",
+              is_init_ ? PrimitiveCreateReason::kShapeChange
+                       : PrimitiveCreateReason::kCold);
+          // Create fwd primitive.
+          auto propagation = dnnl::prop_kind::forward_inference;
+          auto flags = dnnl::normalization_flags::use_scale |
+                       dnnl::normalization_flags::use_shift;
+
+          dnnl::batch_normalization_forward::desc bn_fwd_desc(
+              propagation, src_md, epsilon_, flags);
+
+          dnnl::primitive_attr attr;
+          attr.set_scratchpad_mode(dnnl::scratchpad_mode::user);
+          if (fuse_activation) {
+            dnnl::post_ops post_ops;
+            post_ops.append_eltwise(1.0, dnnl::algorithm::eltwise_relu,
+                                    leakyrelu_alpha_, 0.0);
+            attr.set_post_ops(post_ops);
+          }
+          bn_fwd_pd_ = dnnl::batch_normalization_forward::primitive_desc(
+              bn_fwd_desc, attr, onednn_engine);
+          bn_fwd_primitive_ = dnnl::batch_normalization_forward(bn_fwd_pd_);
+          record.SetPrimitiveDesc(bn_fwd_pd_);
+          cached_src_dims_ = src_dims;
+          is_init_ = true;
+        }
+        bn_fwd_pd = bn_fwd_pd_;
+        bn_fwd_primitive = bn_fwd_primitive_;
       }
 
-      dnnl::batch_normalization_forward bn_fwd_primitive(bn_fwd_pd);
-
       void* scale_data = GetTensorBuffer<U>(&scale_tensor);
       void* shift_data = GetTensorBuffer<U>(&shift_tensor);
 
@@ -224,9 +406,18 @@ class InstanceNormOp : public OpKernel {
 
  private:
   float epsilon_;
-  float leakyrelu_alpha_;
+  float leakyrelu_alpha_ = 0.0f;
   TensorFormat tensor_format_;
   string data_format;
+
+  bool enable_cache_ = false;
+  bool is_init_ = false;
+  mutex mu_compute_;
+  dnnl::memory::dims cached_src_dims_ TF_GUARDED_BY(mu_compute_);
+  dnnl::batch_normalization_forward::primitive_desc bn_fwd_pd_
+      TF_GUARDED_BY(mu_compute_);
+  dnnl::batch_normalization_forward bn_fwd_primitive_
+      TF_GUARDED_BY(mu_compute_);
 };
 
 }  // namespace itex
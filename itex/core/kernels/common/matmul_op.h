@@ -17,6 +17,7 @@ limitations under the License.
 #define ITEX_CORE_KERNELS_COMMON_MATMUL_OP_H_
 
 #include <algorithm>
+#include <atomic>
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -26,7 +27,9 @@ limitations under the License.
 #include "itex/core/kernels/common/fill_functor.h"
 #include "itex/core/utils/bcast.h"
 #include "itex/core/utils/errors.h"
+#include "itex/core/utils/onednn/onednn_async_compiler.h"
 #include "itex/core/utils/onednn/onednn_post_op_util.h"
+#include "itex/core/utils/onednn/onednn_primitive_log.h"
 #include "itex/core/utils/onednn/onednn_util.h"
 #include "itex/core/utils/op_kernel.h"
 #include "itex/core/utils/op_requires.h"
@@ -242,212 +245,265 @@ class MatMulOp : public OpKernel {
       fp32_math_mode_ = dnnl::fpmath_mode::bf16;
     }
 
-    ITEX_CHECK_OK(
-        ReadBoolFromEnvVar("ITEX_CACHE_ONEDNN_OBJECT", false, &enable_cache_));
+    enable_cache_ = IsOneDnnObjectCacheEnabled();
+    // Compiled plans are swapped in through the cache.
+    async_compile_ = enable_cache_ && AsyncPrimitiveCompiler::IsEnabled();
   }
 
-  void InitOrSetMemory(OpKernelContext* context) {
-    if (!(enable_cache_ && is_init_ && context->is_input_same(0, input_dims_) &&
-          context->is_input_same(1, weights_dims_))) {
-      Init(context);
-      return;
-    }
-
-    if (is_input_zero_) {
-      functor::SetZeroFunctor<Device, Tout> f;
-      OP_REQUIRES_OK(context, context->allocate_output(kDstIndex_, dst_shape_,
-                                                       &dst_tensor_));
-      f(context->eigen_device<Device>(), dst_tensor_->flat<Tout>());
-      return;
-    }
+  // Everything derived from the input signature. A plan is immutable once
+  // created, so concurrent Compute() calls on the same node share it and only
+  // bind their own memories and temporaries.
+  struct MatMulPlan {
+    std::vector<int64> input_dims, weights_dims;
+    TensorShape dst_shape;
+    bool is_input_zero = false;
+    bool is_weight_reorder = false;
+    memory::desc src_md, weights_md, dst_md, bias_md, add_md, fuse_add_md;
+    dnnl::matmul::primitive_desc matmul_pd;
+    dnnl::matmul matmul_primitive;
+  };
+
+  // Inputs which plan creation reads. They are copied out of the context, so
+  // a plan can be created off the compute thread.
+  struct PlanArgs {
+    TensorShape src_shape, weights_shape, add_shape;
+    float mul_value = 1.0f;
+  };
+
+  ~MatMulOp() override {
+    // Pending compiles refer to this kernel.
+    mutex_lock lock(&mu_compute_);
+    while (num_pending_compiles_ > 0) compile_done_.wait(&lock);
+  }
 
-    src_mem_.set_data_handle(context->tensor_data(kSrcIndex_));
-    if (is_weight_reorder_) {
-      if (!is_filter_const_) {
-        weights_mem_input_.set_data_handle(context->tensor_data(kWeightIndex_));
-        weights_mem_.set_data_handle(GetTensorBuffer<T>(&tmp_weight_));
-        ReorderMemory(*context, &weights_mem_input_, &weights_mem_,
-                      dnnl_engine_);
+  void Compute(OpKernelContext* context) override {
+    bool is_init = false;
+    std::shared_ptr<const MatMulPlan> plan = LookupPlan(context, &is_init);
+    if (plan == nullptr) {
+      PlanArgs args;
+      GetPlanArgs(context, &args);
+      if (!context->status().ok()) return;
+      const dnnl::engine& dnnl_engine = CreateDnnlEngine<Device>(*context);
+
+      std::shared_ptr<MatMulPlan> new_plan;
+      if (is_init && async_compile_ && IsGenericPlanSupported(args)) {
+        // Don't block on compiling a new shape, run this call through the
+        // generic primitive until the compiled plan is swapped in.
+        ScheduleCompile(dnnl_engine, args);
+        OP_REQUIRES_OK(context, GetGenericPlan(dnnl_engine, args, &new_plan));
+        plan = std::move(new_plan);
+      } else {
+        OP_REQUIRES_OK(context,
+                       CreatePlan(dnnl_engine, args,
+                                  is_init ? PrimitiveCreateReason::kShapeChange
+                                          : PrimitiveCreateReason::kCold,
+                                  nullptr, &new_plan));
+        plan = new_plan;
+        InsertPlan(std::move(new_plan));
       }
-    } else {
-      weights_mem_.set_data_handle(context->tensor_data(kWeightIndex_));
     }
+    Execute(context, *plan);
+  }
 
-    if (post_op_util_.HasBias()) {
-      bias_mem_.set_data_handle(context->tensor_data(kBiasIndex_));
+  // Returns the cached plan if it matches current inputs, otherwise nullptr.
+  // `is_init` tells whether any plan was created before.
+  std::shared_ptr<const MatMulPlan> LookupPlan(OpKernelContext* context,
+                                               bool* is_init)
+      TF_LOCKS_EXCLUDED(mu_compute_) {
+    std::shared_ptr<const MatMulPlan> plan;
+    {
+      mutex_lock lock(&mu_compute_);
+      *is_init = is_init_;
+      plan = plan_;
     }
-
-    if (post_op_util_.HasAdd() || post_op_util_.HasBinary()) {
-      add_tensor_ = &context->input(kAddIndex_);
+    if (plan != nullptr && context->is_input_same(0, plan->input_dims) &&
+        context->is_input_same(1, plan->weights_dims)) {
+      return plan;
     }
+    return nullptr;
+  }
 
-    if (post_op_util_.HasAdd()) {
-      int is_forward_success = kUnsuccess_;
-      // Try to do in-place.
-      // TODO(itex): Remove this workaround when inplace works.
-      if (inplace_sum_) {
-        context->set_output(kDstIndex_, *add_tensor_);
-        dst_tensor_ = context->mutable_output(kDstIndex_);
-        is_forward_success = kAddIndex_;
-      } else {
-        OP_REQUIRES_OK(context, context->forward_input_or_allocate_output(
-                                    {kAddIndex_}, kDstIndex_, dst_shape_,
-                                    &dst_tensor_, &is_forward_success));
-      }
-      // Reorder is needed, forward is failed but dst has been allocated;
-      if (is_forward_success == kUnsuccess_) {
-        // In-place do not success, need reorder.
-        fuse_add_src_mem_.set_data_handle(GetTensorBuffer<Tpost>(add_tensor_));
-        fuse_add_dst_mem_.set_data_handle(GetTensorBuffer<Tout>(dst_tensor_));
-        ReorderMemory(*context, &fuse_add_src_mem_, &fuse_add_dst_mem_,
-                      dnnl_engine_);
-      }
+  void InsertPlan(std::shared_ptr<const MatMulPlan> plan)
+      TF_LOCKS_EXCLUDED(mu_compute_) {
+    mutex_lock lock(&mu_compute_);
+    is_init_ = true;
+    if (enable_cache_) plan_ = std::move(plan);
+  }
 
-    } else {
-      OP_REQUIRES_OK(context, context->allocate_output(kDstIndex_, dst_shape_,
-                                                       &dst_tensor_));
+  void GetPlanArgs(OpKernelContext* context, PlanArgs* args) {
+    args->src_shape = context->input(kSrcIndex_).shape();
+    args->weights_shape = context->input(kWeightIndex_).shape();
+
+    // Handle Mul fusion.
+    if (post_op_util_.HasOutputScales()) {
+      const Tensor& scale_tensor = context->input(kMulIndex_);
+      OP_REQUIRES(context, scale_tensor.NumElements() == 1,
+                  errors::InvalidArgument("Mul Tensor must be a scalar"));
+
+#ifndef INTEL_CPU_ONLY
+      if (IsMulCacheEmpty()) {
+        // Cache weight
+        const T* mul_device_data = scale_tensor.flat<T>().data();
+        CacheMul(context, mul_device_data);
+      }
+      T* mul_host_data = GetCachedMul(context);
+      args->mul_value = static_cast<float>(mul_host_data[0]);
+#else
+      args->mul_value =
+          static_cast<float>(scale_tensor.flat<Tpost>().data()[0]);
+#endif  // INTEL_CPU_ONLY
     }
     if (post_op_util_.HasBinary()) {
-      // BatchMatMul + Add needs to set add input md in node execution.
-      add_mem_.set_data_handle(GetTensorBuffer<Tpost>(add_tensor_));
+      args->add_shape = context->input(kAddIndex_).shape();
     }
-    dst_mem_.set_data_handle(GetTensorBuffer<Tout>(dst_tensor_));
   }
 
-  void Init(OpKernelContext* context) {
-    const Tensor& src_tensor = context->input(0);
-    const Tensor& weights_tensor = context->input(1);
-    fwd_primitive_args_.clear();
-    auto input_shape = src_tensor.shape();
-    input_dims_.clear();
-    for (int i = 0; i < input_shape.dims(); ++i) {
-      input_dims_.push_back(input_shape.dim_size(i));
+  // Creates the plan of `args`. With `generic`, the primitive of that generic
+  // plan is reused instead of creating one, see GetGenericPlan. It doesn't
+  // touch any mutable state of the kernel, so it may run on the compile pool.
+  Status CreatePlan(const dnnl::engine& dnnl_engine, const PlanArgs& args,
+                    PrimitiveCreateReason reason, const MatMulPlan* generic,
+                    std::shared_ptr<MatMulPlan>* plan_ptr) {
+    const TensorShape& src_shape = args.src_shape;
+    const TensorShape& weights_shape = args.weights_shape;
+    auto plan = std::make_shared<MatMulPlan>();
+    for (int i = 0; i < src_shape.dims(); ++i) {
+      plan->input_dims.push_back(src_shape.dim_size(i));
     }
-    auto weights_tensor_shape = weights_tensor.shape();
-    weights_dims_.clear();
-    for (int i = 0; i < weights_tensor_shape.dims(); ++i) {
-      weights_dims_.push_back(weights_tensor_shape.dim_size(i));
+    for (int i = 0; i < weights_shape.dims(); ++i) {
+      plan->weights_dims.push_back(weights_shape.dim_size(i));
     }
 
-    OP_REQUIRES(context, src_tensor.dims() >= 2,
-                errors::InvalidArgument("In[0] ndims must be >= 2: ",
-                                        src_tensor.dims()));
+    if (src_shape.dims() < 2) {
+      return errors::InvalidArgument("In[0] ndims must be >= 2: ",
+                                     src_shape.dims());
+    }
 
     if (!allow_bcast) {
       // Using V1, so check to make sure lhs and rhs dimensions are correct and
       // no broadcasting is needed.
-      OP_REQUIRES(
-          context, src_tensor.dims() == weights_tensor.dims(),
-          errors::InvalidArgument("lhs and rhs has different ndims: ",
-                                  src_tensor.shape().DebugString(), " vs. ",
-                                  weights_tensor.shape().DebugString()));
-      const int ndims = src_tensor.dims();
-      OP_REQUIRES(
-          context, ndims >= 2,
-          errors::InvalidArgument("lhs and rhs ndims must be >= 2: ", ndims));
+      if (src_shape.dims() != weights_shape.dims()) {
+        return errors::InvalidArgument(
+            "lhs and rhs has different ndims: ", src_shape.DebugString(),
+            " vs. ", weights_shape.DebugString());
+      }
+      const int ndims = src_shape.dims();
+      if (ndims < 2) {
+        return errors::InvalidArgument("lhs and rhs ndims must be >= 2: ",
+                                       ndims);
+      }
       for (int i = 0; i < ndims - 2; ++i) {
-        OP_REQUIRES(
-            context, src_tensor.dim_size(i) == weights_tensor.dim_size(i),
-            errors::InvalidArgument(
-                "lhs.dim(", i, ") and rhs.dim(", i,
-                ") must be the same: ", src_tensor.shape().DebugString(),
-                " vs ", weights_tensor.shape().DebugString()));
+        if (src_shape.dim_size(i) != weights_shape.dim_size(i)) {
+          return errors::InvalidArgument(
+              "lhs.dim(", i, ") and rhs.dim(", i,
+              ") must be the same: ", src_shape.DebugString(), " vs ",
+              weights_shape.DebugString());
+        }
       }
     }
 
-    MatMulBCast bcast(src_tensor.shape().dim_sizes(),
-                      weights_tensor.shape().dim_sizes());
-    OP_REQUIRES(context, bcast.IsValid(),
-                errors::InvalidArgument(
-                    "In[0] and In[1] must have compatible batch dimensions: ",
-                    src_tensor.shape().DebugString(), " vs. ",
-                    weights_tensor.shape().DebugString()));
+    MatMulBCast bcast(src_shape.dim_sizes(), weights_shape.dim_sizes());
+    if (!bcast.IsValid()) {
+      return errors::InvalidArgument(
+          "In[0] and In[1] must have compatible batch dimensions: ",
+          src_shape.DebugString(), " vs. ", weights_shape.DebugString());
+    }
 
     // dst(bs, m,n) = \sigma{src(bs, m,k) * weights(bs, k, n)} + bias(bs, m,n)
     // Get the actual m & n to set dst_shape, and MatMulBCast will calculate the
     // shape of batches for us
-    const int kSrcDims = src_tensor.dims();
-    const auto m = adj_x_ ? src_tensor.dim_size(kSrcDims - 1)
-                          : src_tensor.dim_size(kSrcDims - 2);
-    const auto k = adj_x_ ? src_tensor.dim_size(kSrcDims - 2)
-                          : src_tensor.dim_size(kSrcDims - 1);
-    const int kWeightsDims = weights_tensor.dims();
-    const auto k_weights = adj_y_ ? weights_tensor.dim_size(kWeightsDims - 1)
-                                  : weights_tensor.dim_size(kWeightsDims - 2);
-    const auto n = adj_y_ ? weights_tensor.dim_size(kWeightsDims - 2)
-                          : weights_tensor.dim_size(kWeightsDims - 1);
-    OP_REQUIRES(context, k == k_weights,
-                errors::InvalidArgument(
-                    "Matrix size-incompatible: In[0]: ",
-                    src_tensor.shape().DebugString(),
-                    ", In[1]: ", weights_tensor.shape().DebugString()));
+    const int kSrcDims = src_shape.dims();
+    const auto m = adj_x_ ? src_shape.dim_size(kSrcDims - 1)
+                          : src_shape.dim_size(kSrcDims - 2);
+    const auto k = adj_x_ ? src_shape.dim_size(kSrcDims - 2)
+                          : src_shape.dim_size(kSrcDims - 1);
+    const int kWeightsDims = weights_shape.dims();
+    const auto k_weights = adj_y_ ? weights_shape.dim_size(kWeightsDims - 1)
+                                  : weights_shape.dim_size(kWeightsDims - 2);
+    const auto n = adj_y_ ? weights_shape.dim_size(kWeightsDims - 2)
+                          : weights_shape.dim_size(kWeightsDims - 1);
+    if (k != k_weights) {
+      return errors::InvalidArgument(
+          "Matrix size-incompatible: In[0]: ", src_shape.DebugString(),
+          ", In[1]: ", weights_shape.DebugString());
+    }
 
-    dst_shape_ = bcast.output_batch_shape();
-    dst_shape_.AddDim(m);
-    dst_shape_.AddDim(n);
+    plan->dst_shape = bcast.output_batch_shape();
+    plan->dst_shape.AddDim(m);
+    plan->dst_shape.AddDim(n);
     // The maximum number of dimensions for a tensor in DNNL is 6 on GPU.
-    OP_REQUIRES(
-        context, dst_shape_.dims() <= 6,
-        errors::InvalidArgument(
-            "Rank of output tensor must be <= 6, but is ", dst_shape_.dims(),
-            ". Current implementation supports up to rank 6 tensors."));
-
-    if (dst_shape_.num_elements() == 0) {
-      is_input_zero_ = true;
-      functor::SetZeroFunctor<Device, Tout> f;
-      OP_REQUIRES_OK(context, context->allocate_output(kDstIndex_, dst_shape_,
-                                                       &dst_tensor_));
-      f(context->eigen_device<Device>(), dst_tensor_->flat<Tout>());
-      is_init_ = true;
-      return;
+    if (plan->dst_shape.dims() > 6) {
+      return errors::InvalidArgument(
+          "Rank of output tensor must be <= 6, but is ", plan->dst_shape.dims(),
+          ". Current implementation supports up to rank 6 tensors.");
     }
 
     // Direct return if either input has 0 elements, but take care of fused ops
     // because they will change default value.
-    if (!post_op_util_.HasBias() && !post_op_util_.HasAdd() &&
-        (src_tensor.NumElements() == 0 || weights_tensor.NumElements() == 0)) {
-      is_input_zero_ = true;
-      functor::SetZeroFunctor<Device, Tout> f;
-      OP_REQUIRES_OK(context, context->allocate_output(kDstIndex_, dst_shape_,
-                                                       &dst_tensor_));
-      f(context->eigen_device<Device>(), dst_tensor_->flat<Tout>());
-      is_init_ = true;
-      return;
+    const bool has_zero_input =
+        src_shape.num_elements() == 0 || weights_shape.num_elements() == 0;
+    if (plan->dst_shape.num_elements() == 0 ||
+        (!post_op_util_.HasBias() && !post_op_util_.HasAdd() &&
+         has_zero_input)) {
+      plan->is_input_zero = true;
+      *plan_ptr = std::move(plan);
+      return Status::OK();
     }
 
     try {
+      // Post ops are completed by runtime inputs below, work on a copy so the
+      // kernel itself stays read-only.
+      PostOpUtil post_op_util = post_op_util_;
+
       // Compute parameters for DNNL matmul primitive.
       auto params = MatMulBaseUtil::CreateMatMulParams(
-          src_tensor.shape(), weights_tensor.shape(), dst_shape_, adj_x_,
-          adj_y_);
-      auto src_md =
+          src_shape, weights_shape, plan->dst_shape, adj_x_, adj_y_);
+      plan->src_md =
           memory::desc(params->a_dims, OneDnnType<T>(), params->a_strides);
-      auto weights_md =
+      plan->weights_md =
           memory::desc(params->b_dims, OneDnnType<T>(), params->b_strides);
+      plan->dst_md =
+          memory::desc(params->c_dims, OneDnnType<Tout>(), params->c_strides);
+      plan->fuse_add_md =
+          memory::desc(params->c_dims, OneDnnType<Tpost>(), params->c_strides);
+      if (post_op_util.HasBias()) {
+        // bias use same dims as dst
+        plan->bias_md = memory::desc(params->bias_dims, OneDnnType<Tpost>(),
+                                     params->bias_strides);
+      }
+
+      if (generic != nullptr) {
+        plan->matmul_pd = generic->matmul_pd;
+        plan->matmul_primitive = generic->matmul_primitive;
+        *plan_ptr = std::move(plan);
+        return Status::OK();
+      }
+
       // Let oneDNN choose weight format if:
       //   1. Weight is const and can be cached
       //   2. Kernel is on CPU and weight is not tranposed
+      // The generic plan keeps the plain weight, it's used by many shapes.
       bool is_any =
-          is_filter_const_ ||
-          (Eigen::internal::is_same<Device, CPUDevice>::value && !adj_y_);
+          reason != PrimitiveCreateReason::kGeneric &&
+          (is_filter_const_ ||
+           (Eigen::internal::is_same<Device, CPUDevice>::value && !adj_y_));
       auto weights_md_prefer =
           is_any ? memory::desc(params->b_dims, OneDnnType<T>(),
                                 memory::format_tag::any)
-                 : weights_md;
-      auto dst_md =
-          memory::desc(params->c_dims, OneDnnType<Tout>(), params->c_strides);
+                 : plan->weights_md;
+      // The generic primitive takes any M, which is given at execution.
+      memory::desc src_md = plan->src_md, dst_md = plan->dst_md;
+      if (reason == PrimitiveCreateReason::kGeneric) {
+        src_md = memory::desc({DNNL_RUNTIME_DIM_VAL, k}, OneDnnType<T>(),
+                              {k, 1});
+        dst_md = memory::desc({DNNL_RUNTIME_DIM_VAL, n}, OneDnnType<Tout>(),
+                              {n, 1});
+      }
 
       std::shared_ptr<dnnl::matmul::desc> matmul_desc_;
-      if (post_op_util_.HasBias()) {
-        // bias use same dims as dst
-        auto bias_md = memory::desc(params->bias_dims, OneDnnType<Tpost>(),
-                                    params->bias_strides);
-        matmul_desc_.reset(
-            new dnnl::matmul::desc(src_md, weights_md_prefer, bias_md, dst_md));
-        // create bias memory
-        const Tensor& bias_tensor = context->input(kBiasIndex_);
-        bias_mem_ = CreateDnnlMemory(bias_md, dnnl_engine_,
-                                     GetTensorBuffer<Tpost>(&bias_tensor));
+      if (post_op_util.HasBias()) {
+        matmul_desc_.reset(new dnnl::matmul::desc(
+            src_md, weights_md_prefer, plan->bias_md, dst_md));
       } else {
         matmul_desc_.reset(
             new dnnl::matmul::desc(src_md, weights_md_prefer, dst_md));
@@ -458,101 +514,167 @@ class MatMulOp : public OpKernel {
       if (std::is_same<T, float>::value) {
         post_ops_attr.set_fpmath_mode(fp32_math_mode_);
       }
-      std::shared_ptr<dnnl::matmul::primitive_desc> matmul_pd_ =
-          std::make_shared<dnnl::matmul::primitive_desc>(*matmul_desc_,
-                                                         dnnl_engine_);
+
+      if (post_op_util.HasOutputScales()) {
+        std::vector<float> scales = {args.mul_value};
+        post_op_util.SetOutputScale(scales);
+      }
+      if (post_op_util.HasBinary()) {
+        // BatchMatMul + Add needs to set add input md in node execution.
+        // Figure out the extended md for primitive execution
+        const TensorShape& tf_shape = args.add_shape;
+
+        ITEX_CHECK(tf_shape.dims() >= 3)
+            << "Add input of FusedBatchMatMul must have 3 dims at least";
+
+        auto add_dims = TFShapeToOneDnnDims(tf_shape);
+        auto add_strides = CalculateTFStrides(add_dims);
+        plan->add_md = memory::desc(add_dims, OneDnnType<Tpost>(), add_strides);
+
+        post_op_util.SetBinaryInput(plan->add_md);
+      }
+      // Set post ops attr after handling all fusions.
+      post_op_util.SetPostOpAttr(&post_ops_attr);
+      {
+        ScopedPrimitiveCreation primitive_record(this, "matmul", reason);
+        plan->matmul_pd = dnnl::matmul::primitive_desc(
+            *matmul_desc_, post_ops_attr, dnnl_engine);
+        plan->matmul_primitive = dnnl::matmul(plan->matmul_pd);
+        primitive_record.SetPrimitiveDesc(plan->matmul_pd);
+      }
+      plan->is_weight_reorder =
+          (plan->weights_md != plan->matmul_pd.weights_desc());
+      *plan_ptr = std::move(plan);
+    } catch (dnnl::error& e) {
+      string error_msg = "Status: " + std::to_string(e.status) +
+                         ", message: " + string(e.message) + ", in file " +
+                         string(__FILE__) + ":" + std::to_string(__LINE__);
+      return errors::Aborted("Operation received an exception:", error_msg);
+    }
+    return Status::OK();
+  }
+
+  // The generic primitive takes 2D non-transposed inputs with M given at
+  // execution. Binary post op isn't supported, its md is fixed in the
+  // primitive.
+  bool IsGenericPlanSupported(const PlanArgs& args) const {
+    return std::is_same<Device, CPUDevice>::value && !adj_x_ &&
+           args.src_shape.dims() == 2 && args.weights_shape.dims() == 2 &&
+           args.src_shape.num_elements() > 0 &&
+           args.weights_shape.num_elements() > 0 && !post_op_util_.HasBinary();
+  }
+
+  // Returns a plan of `args` running the generic primitive, which is created
+  // once per weight shape.
+  Status GetGenericPlan(const dnnl::engine& dnnl_engine, const PlanArgs& args,
+                        std::shared_ptr<MatMulPlan>* plan_ptr)
+      TF_LOCKS_EXCLUDED(mu_compute_) {
+    std::shared_ptr<const MatMulPlan> generic;
+    {
+      mutex_lock lock(&mu_compute_);
+      generic = generic_plan_;
+    }
+    if (generic == nullptr ||
+        TensorShape(generic->weights_dims) != args.weights_shape) {
+      std::shared_ptr<MatMulPlan> new_generic;
+      TF_RETURN_IF_ERROR(CreatePlan(dnnl_engine, args,
+                                    PrimitiveCreateReason::kGeneric, nullptr,
+                                    &new_generic));
+      generic = new_generic;
+      mutex_lock lock(&mu_compute_);
+      generic_plan_ = std::move(new_generic);
+    }
+    return CreatePlan(dnnl_engine, args, PrimitiveCreateReason::kGeneric,
+                      generic.get(), plan_ptr);
+  }
+
+  // Creates the plan of `args` on the compile pool and swaps it in, unless
+  // another one is pending. Calls in between run the generic plan.
+  void ScheduleCompile(const dnnl::engine& dnnl_engine, const PlanArgs& args)
+      TF_LOCKS_EXCLUDED(mu_compute_) {
+    {
+      mutex_lock lock(&mu_compute_);
+      if (num_pending_compiles_ > 0) return;
+      ++num_pending_compiles_;
+    }
+    AsyncPrimitiveCompiler::Global()->Schedule([this, dnnl_engine, args]() {
+      std::shared_ptr<MatMulPlan> plan;
+      Status status =
+          CreatePlan(dnnl_engine, args, PrimitiveCreateReason::kShapeChange,
+                     nullptr, &plan);
+      if (!status.ok()) {
+        ITEX_LOG(WARNING) << "Async compile of " << name()
+                          << " failed: " << status;
+      }
+      mutex_lock lock(&mu_compute_);
+      if (status.ok()) plan_ = std::move(plan);
+      --num_pending_compiles_;
+      compile_done_.notify_all();
+    });
+  }
+
+  // Binds current inputs and outputs to the plan and runs it. Nothing in the
+  // kernel is written here, except the thread-safe weight cache.
+  void Execute(OpKernelContext* context, const MatMulPlan& plan) {
+    Tensor* dst_tensor = nullptr;
+    if (plan.is_input_zero) {
+      functor::SetZeroFunctor<Device, Tout> f;
+      OP_REQUIRES_OK(context, context->allocate_output(
+                                  kDstIndex_, plan.dst_shape, &dst_tensor));
+      f(context->eigen_device<Device>(), dst_tensor->flat<Tout>());
+      return;
+    }
+
+    try {
+      auto dnnl_engine = CreateDnnlEngine<Device>(*context);
+      // onednn_stream has thread safety issue, need create a new one in
+      // every compute.
+      auto dnnl_stream = CreateDnnlStream(*context, dnnl_engine);
+      const Tensor& src_tensor = context->input(kSrcIndex_);
+      const Tensor& weights_tensor = context->input(kWeightIndex_);
+      const Tensor* add_tensor = nullptr;
       if (post_op_util_.HasAdd() || post_op_util_.HasBinary()) {
-        add_tensor_ = &context->input(kAddIndex_);
+        add_tensor = &context->input(kAddIndex_);
       }
 
       // Handle Add fusion and decide output tensor buffer.
       if (post_op_util_.HasAdd()) {
-        // const Tensor& add_tensor = context->input(kAddIndex_);
         int is_forward_success = kUnsuccess_;
 
         // Try to do in-place.
         // TODO(itex): Remove this workaround when inplace works.
         if (inplace_sum_) {
-          context->set_output(kDstIndex_, *add_tensor_);
-          dst_tensor_ = context->mutable_output(kDstIndex_);
+          context->set_output(kDstIndex_, *add_tensor);
+          dst_tensor = context->mutable_output(kDstIndex_);
           is_forward_success = kAddIndex_;
         } else {
           OP_REQUIRES_OK(context, context->forward_input_or_allocate_output(
-                                      {kAddIndex_}, kDstIndex_, dst_shape_,
-                                      &dst_tensor_, &is_forward_success));
+                                      {kAddIndex_}, kDstIndex_, plan.dst_shape,
+                                      &dst_tensor, &is_forward_success));
         }
         // Reorder is needed, forward is failed but dst has been allocated;
         if (is_forward_success == kUnsuccess_) {
           // In-place do not success, need reorder.
-          fuse_add_src_mem_ = CreateDnnlMemory(
-              memory::desc(params->c_dims, OneDnnType<Tpost>(),
-                           params->c_strides),
-              dnnl_engine_, GetTensorBuffer<Tpost>(add_tensor_));
-          fuse_add_dst_mem_ =
-              CreateDnnlMemory(matmul_pd_->dst_desc(), dnnl_engine_,
-                               GetTensorBuffer<Tout>(dst_tensor_));
-          ReorderMemory(*context, &fuse_add_src_mem_, &fuse_add_dst_mem_,
-                        dnnl_engine_);
+          memory fuse_add_src_mem =
+              CreateDnnlMemory(plan.fuse_add_md, dnnl_engine,
+                               GetTensorBuffer<Tpost>(add_tensor));
+          memory fuse_add_dst_mem =
+              CreateDnnlMemory(plan.dst_md, dnnl_engine,
+                               GetTensorBuffer<Tout>(dst_tensor));
+          ReorderMemory(*context, &fuse_add_src_mem, &fuse_add_dst_mem,
+                        dnnl_engine);
         }
       } else {
-        OP_REQUIRES_OK(context, context->allocate_output(kDstIndex_, dst_shape_,
-                                                         &dst_tensor_));
-      }
-
-      // Handle Mul fusion.
-      if (post_op_util_.HasOutputScales()) {
-        const Tensor& scale_tensor = context->input(kMulIndex_);
-        OP_REQUIRES(context, scale_tensor.NumElements() == 1,
-                    errors::InvalidArgument("Mul Tensor must be a scalar"));
-
-#ifndef INTEL_CPU_ONLY
-        if (IsMulCacheEmpty()) {
-          // Cache weight
-          const T* mul_device_data = scale_tensor.flat<T>().data();
-          CacheMul(context, mul_device_data);
-        }
-        T* mul_host_data = GetCachedMul(context);
-        float mul_value = static_cast<float>(mul_host_data[0]);
-#else
-        float mul_value =
-            static_cast<float>(scale_tensor.flat<Tpost>().data()[0]);
-#endif  // INTEL_CPU_ONLY
-        std::vector<float> scales = {mul_value};
-
-        post_op_util_.SetOutputScale(scales);
+        OP_REQUIRES_OK(context, context->allocate_output(
+                                    kDstIndex_, plan.dst_shape, &dst_tensor));
       }
-      if (this->post_op_util_.HasBinary()) {
-        // BatchMatMul + Add needs to set add input md in node execution.
-        // const Tensor& add_tensor = context->input(kAddIndex_);
-
-        // Figure out the extended md for primitive execution
-        TensorShape tf_shape = add_tensor_->shape();
-
-        ITEX_CHECK(tf_shape.dims() >= 3)
-            << "Add input of FusedBatchMatMul must have 3 dims at least";
-
-        auto add_dims = TFShapeToOneDnnDims(tf_shape);
-        auto add_strides = CalculateTFStrides(add_dims);
-        auto add_md = memory::desc(add_dims, OneDnnType<Tpost>(), add_strides);
-
-        this->post_op_util_.SetBinaryInput(add_md);
-        add_mem_ = CreateDnnlMemory(add_md, dnnl_engine_,
-                                    GetTensorBuffer<Tpost>(add_tensor_));
-
-        fwd_primitive_args_.emplace(
-            DNNL_ARG_ATTR_MULTIPLE_POST_OP(0) | DNNL_ARG_SRC_1, add_mem_);
-      }
-      // Set post ops attr after handling all fusions.
-      post_op_util_.SetPostOpAttr(&post_ops_attr);
-      matmul_pd_.reset(new dnnl::matmul::primitive_desc(
-          *matmul_desc_, post_ops_attr, dnnl_engine_));
 
       // Do weight cache only if Reorder is needed and weight is const.
-      weights_mem_input_ = CreateDnnlMemory(
-          weights_md, dnnl_engine_, GetTensorBuffer<T>(&weights_tensor));
-      weights_md_prefer = matmul_pd_->weights_desc();
-      is_weight_reorder_ = (weights_md != weights_md_prefer);
-      if (is_weight_reorder_) {
+      memory weights_mem = CreateDnnlMemory(
+          plan.weights_md, dnnl_engine, GetTensorBuffer<T>(&weights_tensor));
+      Tensor tmp_weight;
+      if (plan.is_weight_reorder) {
+        memory::desc weights_md_prefer = plan.matmul_pd.weights_desc();
         T* weight_cached_data = nullptr;
 
         // Check weight cache
@@ -560,56 +682,63 @@ class MatMulOp : public OpKernel {
           if (weight_cache_manager_.IsEmpty()) {
             // Cache weight in first time executing this node.
             weight_cache_manager_.SetCache(
-                context, weights_md, weights_md_prefer,
-                GetTensorBuffer<T>(&weights_tensor), dnnl_engine_);
+                context, plan.weights_md, weights_md_prefer,
+                GetTensorBuffer<T>(&weights_tensor), dnnl_engine);
           }
           weight_cached_data =
-              this->weight_cache_manager_.GetCache(context, weights_md_prefer);
+              weight_cache_manager_.GetCache(context, weights_md_prefer);
         }
 
         if (weight_cached_data != nullptr) {
-          weights_mem_ = CreateDnnlMemory(weights_md_prefer, dnnl_engine_,
-                                          weight_cached_data);
+          weights_mem = CreateDnnlMemory(weights_md_prefer, dnnl_engine,
+                                         weight_cached_data);
         } else {
           // Reorder if cache is failed since pd has already used any format.
           int64_t reorder_size = weights_md_prefer.get_size() / sizeof(T);
           OP_REQUIRES_OK(context,
                          context->allocate_temp(DataTypeToEnum<T>::v(),
                                                 TensorShape({reorder_size}),
-                                                &tmp_weight_));
-          void* data_handle = GetTensorBuffer<T>(&tmp_weight_);
-          weights_mem_ =
-              CreateDnnlMemory(weights_md_prefer, dnnl_engine_, data_handle);
-          ReorderMemory(*context, &weights_mem_input_, &weights_mem_,
-                        dnnl_engine_);
+                                                &tmp_weight));
+          memory weights_mem_input = weights_mem;
+          weights_mem = CreateDnnlMemory(weights_md_prefer, dnnl_engine,
+                                         GetTensorBuffer<T>(&tmp_weight));
+          ReorderMemory(*context, &weights_mem_input, &weights_mem,
+                        dnnl_engine);
         }
-      } else {
-        weights_mem_ = weights_mem_input_;
       }
+
+      Tensor scratchpad_tensor;
       int64 scratchpad_size =
-          matmul_pd_->scratchpad_desc().get_size() / sizeof(T);
+          plan.matmul_pd.scratchpad_desc().get_size() / sizeof(T);
       OP_REQUIRES_OK(context,
                      context->allocate_temp(DataTypeToEnum<T>::v(),
                                             TensorShape({scratchpad_size}),
-                                            &scratchpad_tensor_));
-      scratchpad_mem_ =
-          dnnl::memory(matmul_pd_->scratchpad_desc(), dnnl_engine_,
-                       GetTensorBuffer<T>(&scratchpad_tensor_));
-
-      matmul_primitive_ = dnnl::matmul(*matmul_pd_);
-      src_mem_ = CreateDnnlMemory(src_md, dnnl_engine_,
-                                  GetTensorBuffer<T>(&src_tensor));
-      dst_mem_ = CreateDnnlMemory(dst_md, dnnl_engine_,
-                                  GetTensorBuffer<Tout>(dst_tensor_));
-      fwd_primitive_args_.emplace(DNNL_ARG_SRC, src_mem_);
-      fwd_primitive_args_.emplace(DNNL_ARG_WEIGHTS, weights_mem_);
-      fwd_primitive_args_.emplace(DNNL_ARG_DST, dst_mem_);
-      fwd_primitive_args_.emplace(DNNL_ARG_SCRATCHPAD, scratchpad_mem_);
-
+                                            &scratchpad_tensor));
+
+      std::unordered_map<int, memory> fwd_primitive_args = {
+          {DNNL_ARG_SRC, CreateDnnlMemory(plan.src_md, dnnl_engine,
+                                          GetTensorBuffer<T>(&src_tensor))},
+          {DNNL_ARG_WEIGHTS, weights_mem},
+          {DNNL_ARG_DST, CreateDnnlMemory(plan.dst_md, dnnl_engine,
+                                          GetTensorBuffer<Tout>(dst_tensor))},
+          {DNNL_ARG_SCRATCHPAD,
+           dnnl::memory(plan.matmul_pd.scratchpad_desc(), dnnl_engine,
+                        GetTensorBuffer<T>(&scratchpad_tensor))}};
       if (post_op_util_.HasBias()) {
-        fwd_primitive_args_.emplace(DNNL_ARG_BIAS, bias_mem_);
+        const Tensor& bias_tensor = context->input(kBiasIndex_);
+        fwd_primitive_args.emplace(
+            DNNL_ARG_BIAS,
+            CreateDnnlMemory(plan.bias_md, dnnl_engine,
+                             GetTensorBuffer<Tpost>(&bias_tensor)));
       }
-      is_init_ = true;
+      if (post_op_util_.HasBinary()) {
+        fwd_primitive_args.emplace(
+            DNNL_ARG_ATTR_MULTIPLE_POST_OP(0) | DNNL_ARG_SRC_1,
+            CreateDnnlMemory(plan.add_md, dnnl_engine,
+                             GetTensorBuffer<Tpost>(add_tensor)));
+      }
+
+      plan.matmul_primitive.execute(dnnl_stream, fwd_primitive_args);
     } catch (dnnl::error& e) {
       string error_msg = "Status: " + std::to_string(e.status) +
                          ", message: " + string(e.message) + ", in file " +
@@ -619,26 +748,9 @@ class MatMulOp : public OpKernel {
           errors::Aborted("Operation received an exception:", error_msg));
     }
   }
-
-  void Compute(OpKernelContext* context) override {
-    mutex_lock lock(&mu_compute_);
-    dst_tensor_ = nullptr;
-    dnnl_engine_ = CreateDnnlEngine<Device>(*context);
-    // onednn_stream has thread safety issue, need create a new one in
-    // every compute.
-    dnnl_stream_ = CreateDnnlStream(*context, dnnl_engine_);
-    InitOrSetMemory(context);
-
-    // Skip primitive execution if the calculation is meaningless.
-    if (is_input_zero_) return;
-
-    matmul_primitive_.execute(dnnl_stream_, fwd_primitive_args_);
-  }
-
   // TODO(itex): Wrap all cache related code to a module, reuse this module
-  inline bool IsMulCacheEmpty() TF_LOCKS_EXCLUDED(mul_cache_mu_) {
-    tf_shared_lock lock(&mul_cache_mu_);
-    return (!mul_cached_tensor_.IsInitialized());
+  inline bool IsMulCacheEmpty() const {
+    return mul_cached_data_.load(std::memory_order_acquire) == nullptr;
   }
 
   void AllocatePersistentTensor(OpKernelContext* context, Tensor** mul_tensor) {
@@ -673,13 +785,12 @@ class MatMulOp : public OpKernel {
     auto event =
         dpcpp_stream->memcpy(mul_host_data, mul_device_data, 1 * sizeof(T));
     event.wait();
+    mul_cached_data_.store(mul_host_data, std::memory_order_release);
   }
 
-  T* GetCachedMul(OpKernelContext* context) TF_LOCKS_EXCLUDED(mul_cache_mu_) {
-    tf_shared_lock lock(&mul_cache_mu_);
-    const Tensor& mul_cached_data = *mul_cached_tensor_.AccessTensor(context);
-
-    return static_cast<T*>(const_cast<T*>(mul_cached_data.flat<T>().data()));
+  // Lock free, the value never changes once cached.
+  T* GetCachedMul(OpKernelContext* context) {
+    return mul_cached_data_.load(std::memory_order_acquire);
   }
 #endif  // INTEL_CPU_ONLY
 
@@ -688,10 +799,8 @@ class MatMulOp : public OpKernel {
   bool adj_y_ = false;
   bool inplace_sum_ = false;
   bool is_filter_const_ = false;
-  bool is_weight_reorder_ = false;
   bool enable_cache_ = false;
-  bool is_init_ = false;
-  bool is_input_zero_ = false;
+  bool async_compile_ = false;
   const int kSrcIndex_ = 0, kDstIndex_ = 0, kWeightIndex_ = 1, kBiasIndex_ = 2,
             kAddIndex_ = 3, kMulIndex_ = 2, kUnsuccess_ = -1;
 
@@ -703,19 +812,17 @@ class MatMulOp : public OpKernel {
 
  private:
   mutex mul_cache_mu_, mu_compute_;
-  std::unordered_map<int, memory> fwd_primitive_args_;
-  memory src_mem_, weights_mem_, weights_mem_input_, dst_mem_, bias_mem_,
-      add_mem_, fuse_add_src_mem_, fuse_add_dst_mem_, scratchpad_mem_;
-  dnnl::matmul matmul_primitive_;
-  Tensor* dst_tensor_;
-  const Tensor* add_tensor_;
-  Tensor tmp_weight_, scratchpad_tensor_;
-  std::vector<int64> input_dims_, weights_dims_;
-  TensorShape dst_shape_;
+  // Only guards lookup and insert of the plan, never the execution.
+  std::shared_ptr<const MatMulPlan> plan_ TF_GUARDED_BY(mu_compute_);
+  bool is_init_ TF_GUARDED_BY(mu_compute_) = false;
+  // Shape-agnostic plan run while a new shape compiles, see GetGenericPlan.
+  std::shared_ptr<const MatMulPlan> generic_plan_ TF_GUARDED_BY(mu_compute_);
+  int num_pending_compiles_ TF_GUARDED_BY(mu_compute_) = 0;
+  condition_variable compile_done_;
   PersistentTensor mul_cached_tensor_ TF_GUARDED_BY(mul_cache_mu_);
+  // Host data of `mul_cached_tensor_`, published once the copy is done.
+  std::atomic<T*> mul_cached_data_{nullptr};
   dnnl::fpmath_mode fp32_math_mode_ = dnnl::fpmath_mode::strict;
-  dnnl::stream dnnl_stream_;
-  dnnl::engine dnnl_engine_;
 };
 
 template <typename Device, typename T, typename Tgrad>
@@ -744,8 +851,7 @@ class FusedMatMulGradOp : public OpKernel {
       fp32_math_mode_ = dnnl::fpmath_mode::bf16;
     }
 
-    ITEX_CHECK_OK(
-        ReadBoolFromEnvVar("ITEX_CACHE_ONEDNN_OBJECT", false, &enable_cache_));
+    enable_cache_ = IsOneDnnObjectCacheEnabled();
   }
 
   void InitOrSetMemory(OpKernelContext* context) {
@@ -916,5 +1022,368 @@ class FusedMatMulGradOp : public OpKernel {
   dnnl::fpmath_mode fp32_math_mode_ = dnnl::fpmath_mode::strict;
 };
 
+// MatMul + BiasAdd + residual Add + LayerNorm. Bias and residual Add are
+// post-ops of the GEMM, and the output rows are processed tile by tile on CPU:
+// once a row tile of the pre-norm sum is written, it is normalized while it is
+// still in cache instead of re-reading the whole activation afterwards.
+template <typename Device, typename T>
+class FusedMatMulWithSumAndLayerNormOp : public OpKernel {
+ public:
+  explicit FusedMatMulWithSumAndLayerNormOp(OpKernelConstruction* context)
+      : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("transpose_a", &adj_x_));
+    OP_REQUIRES_OK(context, context->GetAttr("transpose_b", &adj_y_));
+    OP_REQUIRES_OK(context,
+                   context->GetAttr("is_filter_const", &is_filter_const_));
+    OP_REQUIRES_OK(context, context->GetAttr("epsilon", &epsilon_));
+    fp32_math_mode_ = GetFP32MathMode<Device>();
+    enable_cache_ = IsOneDnnObjectCacheEnabled();
+  }
+
+  // Primitives of a full row tile and of the tail tile, immutable once
+  // created like MatMulOp::MatMulPlan.
+  struct Plan {
+    std::vector<int64> input_dims, weights_dims;
+    int64 m = 0, k = 0, n = 0, tile_m = 0;
+    bool is_weight_reorder = false;
+    memory::desc weights_md;
+    dnnl::matmul::primitive_desc matmul_pd, tail_matmul_pd;
+    dnnl::matmul matmul_primitive, tail_matmul_primitive;
+    dnnl::layer_normalization_forward::primitive_desc ln_pd, tail_ln_pd;
+    dnnl::layer_normalization_forward ln_primitive, tail_ln_primitive;
+  };
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& src_tensor = context->input(kSrcIndex_);
+    const Tensor& weights_tensor = context->input(kWeightIndex_);
+    OP_REQUIRES(context, src_tensor.dims() == 2 && weights_tensor.dims() == 2,
+                errors::InvalidArgument("In[0] and In[1] must be 2-D: ",
+                                        src_tensor.shape().DebugString(),
+                                        " vs. ",
+                                        weights_tensor.shape().DebugString()));
+
+    std::shared_ptr<const Plan> plan;
+    bool is_init = false;
+    {
+      mutex_lock lock(&mu_compute_);
+      is_init = is_init_;
+      plan = plan_;
+    }
+    if (plan == nullptr || !context->is_input_same(0, plan->input_dims) ||
+        !context->is_input_same(1, plan->weights_dims)) {
+      std::shared_ptr<Plan> new_plan;
+      CreatePlan(context,
+                 is_init ? PrimitiveCreateReason::kShapeChange
+                         : PrimitiveCreateReason::kCold,
+                 &new_plan);
+      if (!context->status().ok()) return;
+      plan = new_plan;
+      mutex_lock lock(&mu_compute_);
+      is_init_ = true;
+      if (enable_cache_) plan_ = std::move(new_plan);
+    }
+    Execute(context, *plan);
+  }
+
+ private:
+  void CreatePlan(OpKernelContext* context, PrimitiveCreateReason reason,
+                  std::shared_ptr<Plan>* plan_ptr) {
+    const Tensor& src_tensor = context->input(kSrcIndex_);
+    const Tensor& weights_tensor = context->input(kWeightIndex_);
+    auto plan = std::make_shared<Plan>();
+    plan->input_dims = {src_tensor.dim_size(0), src_tensor.dim_size(1)};
+    plan->weights_dims = {weights_tensor.dim_size(0),
+                          weights_tensor.dim_size(1)};
+    plan->m = src_tensor.dim_size(adj_x_ ? 1 : 0);
+    plan->k = src_tensor.dim_size(adj_x_ ? 0 : 1);
+    plan->n = weights_tensor.dim_size(adj_y_ ? 0 : 1);
+    OP_REQUIRES(context,
+                plan->k == weights_tensor.dim_size(adj_y_ ? 1 : 0),
+                errors::InvalidArgument(
+                    "Matrix size-incompatible: In[0]: ",
+                    src_tensor.shape().DebugString(),
+                    ", In[1]: ", weights_tensor.shape().DebugString()));
+    if (plan->m == 0 || plan->n == 0) {
+      *plan_ptr = std::move(plan);
+      return;
+    }
+
+    // A tile of the pre-norm sum should stay in cache until LayerNorm reads
+    // it, about the L2 share of the tile. Keep enough rows per tile for the
+    // GEMM to use all cores. GPU has no such benefit, the whole output is one
+    // tile there.
+    plan->tile_m = plan->m;
+    if (std::is_same<Device, CPUDevice>::value) {
+      const int64 kTileBytes = 1 << 20;
+      const int64 kMinTileRows = 64;
+      const int64 tile_rows = kTileBytes / (plan->n * sizeof(T));
+      plan->tile_m = std::min(plan->m, std::max(kMinTileRows, tile_rows));
+    }
+
+    try {
+      auto dnnl_engine = CreateDnnlEngine<Device>(*context);
+      plan->weights_md = memory::desc(
+          {plan->k, plan->n}, OneDnnType<T>(),
+          adj_y_ ? memory::format_tag::ba : memory::format_tag::ab);
+      bool is_any = is_filter_const_ ||
+                    (std::is_same<Device, CPUDevice>::value && !adj_y_);
+      memory::desc weights_md_prefer =
+          is_any ? memory::desc({plan->k, plan->n}, OneDnnType<T>(),
+                                memory::format_tag::any)
+                 : plan->weights_md;
+
+      CreateTilePrimitives(*plan, plan->tile_m, weights_md_prefer,
+                           dnnl_engine, reason, &plan->matmul_pd,
+                           &plan->matmul_primitive, &plan->ln_pd,
+                           &plan->ln_primitive);
+      // The tail tile must read the same reordered weight as full tiles.
+      const int64 tail_m = plan->m % plan->tile_m;
+      if (tail_m != 0) {
+        CreateTilePrimitives(*plan, tail_m, plan->matmul_pd.weights_desc(),
+                             dnnl_engine, reason, &plan->tail_matmul_pd,
+                             &plan->tail_matmul_primitive, &plan->tail_ln_pd,
+                             &plan->tail_ln_primitive);
+      }
+      plan->is_weight_reorder =
+          (plan->weights_md != plan->matmul_pd.weights_desc());
+      *plan_ptr = std::move(plan);
+    } catch (dnnl::error& e) {
+      string error_msg = "Status: " + std::to_string(e.status) +
+                         ", message: " + string(e.message) + ", in file " +
+                         string(__FILE__) + ":" + std::to_string(__LINE__);
+      OP_REQUIRES_OK(
+          context,
+          errors::Aborted("Operation received an exception:", error_msg));
+    }
+  }
+
+  void CreateTilePrimitives(
+      const Plan& plan, int64 rows, const memory::desc& weights_md,
+      const dnnl::engine& dnnl_engine, PrimitiveCreateReason reason,
+      dnnl::matmul::primitive_desc* matmul_pd, dnnl::matmul* matmul_primitive,
+      dnnl::layer_normalization_forward::primitive_desc* ln_pd,
+      dnnl::layer_normalization_forward* ln_primitive) {
+    // Rows of a tile are a slice of the source, `transpose_a` only changes
+    // the strides.
+    memory::desc src_md =
+        adj_x_ ? memory::desc({rows, plan.k}, OneDnnType<T>(), {1, plan.m})
+               : memory::desc({rows, plan.k}, OneDnnType<T>(), {plan.k, 1});
+    memory::desc dst_md({rows, plan.n}, OneDnnType<T>(),
+                        memory::format_tag::ab);
+    memory::desc bias_md({1, plan.n}, OneDnnType<T>(), memory::format_tag::ab);
+    dnnl::matmul::desc matmul_desc(src_md, weights_md, bias_md, dst_md);
+
+    dnnl::primitive_attr matmul_attr;
+    matmul_attr.set_scratchpad_mode(dnnl::scratchpad_mode::user);
+    if (std::is_same<T, float>::value) {
+      matmul_attr.set_fpmath_mode(fp32_math_mode_);
+    }
+    dnnl::post_ops post_ops;
+    post_ops.append_binary(dnnl::algorithm::binary_add, dst_md);
+    matmul_attr.set_post_ops(post_ops);
+
+    // Mean and variance are always computed, they are tiny compared with
+    // the GEMM, and LayerNormGrad needs them in training.
+    dnnl::layer_normalization_forward::desc ln_desc(
+        dnnl::prop_kind::forward_training, dst_md, epsilon_,
+        dnnl::normalization_flags::use_scale |
+            dnnl::normalization_flags::use_shift);
+    dnnl::primitive_attr ln_attr;
+    ln_attr.set_scratchpad_mode(dnnl::scratchpad_mode::user);
+
+    ScopedPrimitiveCreation primitive_record(this, "matmul_layernorm",
+                                             reason);
+    *matmul_pd =
+        dnnl::matmul::primitive_desc(matmul_desc, matmul_attr, dnnl_engine);
+    *matmul_primitive = dnnl::matmul(*matmul_pd);
+    *ln_pd = dnnl::layer_normalization_forward::primitive_desc(
+        ln_desc, ln_attr, dnnl_engine);
+    *ln_primitive = dnnl::layer_normalization_forward(*ln_pd);
+    primitive_record.SetPrimitiveDesc(*matmul_pd);
+  }
+
+  void Execute(OpKernelContext* context, const Plan& plan) {
+    const Tensor& src_tensor = context->input(kSrcIndex_);
+    const Tensor& weights_tensor = context->input(kWeightIndex_);
+    const Tensor& bias_tensor = context->input(kBiasIndex_);
+    const Tensor& add_tensor = context->input(kAddIndex_);
+    const Tensor& scale_tensor = context->input(kScaleIndex_);
+    const Tensor& shift_tensor = context->input(kShiftIndex_);
+
+    const TensorShape dst_shape({plan.m, plan.n});
+    OP_REQUIRES(context, add_tensor.shape() == dst_shape,
+                errors::InvalidArgument(
+                    "Add input must have the MatMul output shape ",
+                    dst_shape.DebugString(), ", but got ",
+                    add_tensor.shape().DebugString()));
+    OP_REQUIRES(context,
+                bias_tensor.NumElements() == plan.n &&
+                    scale_tensor.NumElements() == plan.n &&
+                    shift_tensor.NumElements() == plan.n,
+                errors::InvalidArgument(
+                    "bias, scale and offset must have ", plan.n,
+                    " elements, the last dim of MatMul output"));
+
+    Tensor *dst_tensor = nullptr, *sum_tensor = nullptr,
+           *mean_tensor = nullptr, *variance_tensor = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(kDstIndex_, dst_shape,
+                                                     &dst_tensor));
+    OP_REQUIRES_OK(context, context->allocate_output(
+                                kMeanIndex_, TensorShape({plan.m}),
+                                &mean_tensor));
+    OP_REQUIRES_OK(context, context->allocate_output(
+                                kVarianceIndex_, TensorShape({plan.m}),
+                                &variance_tensor));
+    OP_REQUIRES_OK(context, context->allocate_output(kSumIndex_, dst_shape,
+                                                     &sum_tensor));
+    if (plan.m == 0 || plan.n == 0) return;
+
+    try {
+      auto dnnl_engine = CreateDnnlEngine<Device>(*context);
+      auto dnnl_stream = CreateDnnlStream(*context, dnnl_engine);
+
+      memory weights_mem = CreateDnnlMemory(
+          plan.weights_md, dnnl_engine, GetTensorBuffer<T>(&weights_tensor));
+      Tensor tmp_weight;
+      if (plan.is_weight_reorder) {
+        memory::desc weights_md_prefer = plan.matmul_pd.weights_desc();
+        T* weight_cached_data = nullptr;
+        if (is_filter_const_) {
+          if (weight_cache_manager_.IsEmpty()) {
+            weight_cache_manager_.SetCache(
+                context, plan.weights_md, weights_md_prefer,
+                GetTensorBuffer<T>(&weights_tensor), dnnl_engine);
+          }
+          weight_cached_data =
+              weight_cache_manager_.GetCache(context, weights_md_prefer);
+        }
+        if (weight_cached_data != nullptr) {
+          weights_mem = CreateDnnlMemory(weights_md_prefer, dnnl_engine,
+                                         weight_cached_data);
+        } else {
+          int64_t reorder_size = weights_md_prefer.get_size() / sizeof(T);
+          OP_REQUIRES_OK(context,
+                         context->allocate_temp(DataTypeToEnum<T>::v(),
+                                                TensorShape({reorder_size}),
+                                                &tmp_weight));
+          memory weights_mem_input = weights_mem;
+          weights_mem = CreateDnnlMemory(weights_md_prefer, dnnl_engine,
+                                         GetTensorBuffer<T>(&tmp_weight));
+          ReorderMemory(*context, &weights_mem_input, &weights_mem,
+                        dnnl_engine);
+        }
+      }
+
+      // One scratchpad is reused by all tiles, the stream runs them in order.
+      const bool has_tail = plan.m % plan.tile_m != 0;
+      size_t scratchpad_size =
+          std::max(plan.matmul_pd.scratchpad_desc().get_size(),
+                   plan.ln_pd.scratchpad_desc().get_size());
+      if (has_tail) {
+        scratchpad_size = std::max(
+            {scratchpad_size, plan.tail_matmul_pd.scratchpad_desc().get_size(),
+             plan.tail_ln_pd.scratchpad_desc().get_size()});
+      }
+      Tensor scratchpad_tensor;
+      OP_REQUIRES_OK(context, context->allocate_temp(
+                                  DataTypeToEnum<uint8>::v(),
+                                  TensorShape({static_cast<int64>(
+                                      scratchpad_size)}),
+                                  &scratchpad_tensor));
+
+      const T* src_data =
+          static_cast<T*>(GetTensorBuffer<T>(&src_tensor));
+      const T* add_data = static_cast<T*>(GetTensorBuffer<T>(&add_tensor));
+      T* sum_data = static_cast<T*>(GetTensorBuffer<T>(sum_tensor));
+      T* dst_data = static_cast<T*>(GetTensorBuffer<T>(dst_tensor));
+      float* mean_data =
+          static_cast<float*>(GetTensorBuffer<float>(mean_tensor));
+      float* variance_data =
+          static_cast<float*>(GetTensorBuffer<float>(variance_tensor));
+      memory bias_mem =
+          CreateDnnlMemory(plan.matmul_pd.bias_desc(), dnnl_engine,
+                           GetTensorBuffer<T>(&bias_tensor));
+      memory::desc scale_shift_md({plan.n}, OneDnnType<float>(),
+                                  memory::format_tag::a);
+      memory scale_mem =
+          CreateDnnlMemory(scale_shift_md, dnnl_engine,
+                           GetTensorBuffer<float>(&scale_tensor));
+      memory shift_mem =
+          CreateDnnlMemory(scale_shift_md, dnnl_engine,
+                           GetTensorBuffer<float>(&shift_tensor));
+
+      const int64 src_row_stride = adj_x_ ? 1 : plan.k;
+      for (int64 row = 0; row < plan.m; row += plan.tile_m) {
+        const bool is_tail = row + plan.tile_m > plan.m;
+        const auto& matmul_pd = is_tail ? plan.tail_matmul_pd : plan.matmul_pd;
+        const auto& ln_pd = is_tail ? plan.tail_ln_pd : plan.ln_pd;
+        const int64 offset = row * plan.n;
+
+        memory sum_mem = CreateDnnlMemory(matmul_pd.dst_desc(), dnnl_engine,
+                                          sum_data + offset);
+        std::unordered_map<int, memory> matmul_args = {
+            {DNNL_ARG_SRC,
+             CreateDnnlMemory(matmul_pd.src_desc(), dnnl_engine,
+                              const_cast<T*>(src_data) +
+                                  row * src_row_stride)},
+            {DNNL_ARG_WEIGHTS, weights_mem},
+            {DNNL_ARG_BIAS, bias_mem},
+            {DNNL_ARG_DST, sum_mem},
+            {DNNL_ARG_ATTR_MULTIPLE_POST_OP(0) | DNNL_ARG_SRC_1,
+             CreateDnnlMemory(matmul_pd.dst_desc(), dnnl_engine,
+                              const_cast<T*>(add_data) + offset)},
+            {DNNL_ARG_SCRATCHPAD,
+             dnnl::memory(matmul_pd.scratchpad_desc(), dnnl_engine,
+                          GetTensorBuffer<uint8>(&scratchpad_tensor))}};
+        (is_tail ? plan.tail_matmul_primitive : plan.matmul_primitive)
+            .execute(dnnl_stream, matmul_args);
+
+        std::unordered_map<int, memory> ln_args = {
+            {DNNL_ARG_SRC, sum_mem},
+            {DNNL_ARG_DST, CreateDnnlMemory(ln_pd.dst_desc(), dnnl_engine,
+                                            dst_data + offset)},
+            {DNNL_ARG_SCALE, scale_mem},
+            {DNNL_ARG_SHIFT, shift_mem},
+            {DNNL_ARG_MEAN, CreateDnnlMemory(ln_pd.mean_desc(), dnnl_engine,
+                                             mean_data + row)},
+            {DNNL_ARG_VARIANCE,
+             CreateDnnlMemory(ln_pd.variance_desc(), dnnl_engine,
+                              variance_data + row)},
+            {DNNL_ARG_SCRATCHPAD,
+             dnnl::memory(ln_pd.scratchpad_desc(), dnnl_engine,
+                          GetTensorBuffer<uint8>(&scratchpad_tensor))}};
+        (is_tail ? plan.tail_ln_primitive : plan.ln_primitive)
+            .execute(dnnl_stream, ln_args);
+      }
+    } catch (dnnl::error& e) {
+      string error_msg = "Status: " + std::to_string(e.status) +
+                         ", message: " + string(e.message) + ", in file " +
+                         string(__FILE__) + ":" + std::to_string(__LINE__);
+      OP_REQUIRES_OK(
+          context,
+          errors::Aborted("Operation received an exception:", error_msg));
+    }
+  }
+
+  const int kSrcIndex_ = 0, kWeightIndex_ = 1, kBiasIndex_ = 2,
+            kAddIndex_ = 3, kScaleIndex_ = 4, kShiftIndex_ = 5;
+  const int kDstIndex_ = 0, kMeanIndex_ = 1, kVarianceIndex_ = 2,
+            kSumIndex_ = 3;
+
+  bool adj_x_ = false;
+  bool adj_y_ = false;
+  bool is_filter_const_ = false;
+  bool enable_cache_ = false;
+  float epsilon_;
+  dnnl::fpmath_mode fp32_math_mode_ = dnnl::fpmath_mode::strict;
+
+  WeightCacheManager<T> weight_cache_manager_;
+
+  mutex mu_compute_;
+  // Only guards lookup and insert of the plan, never the execution.
+  std::shared_ptr<const Plan> plan_ TF_GUARDED_BY(mu_compute_);
+  bool is_init_ TF_GUARDED_BY(mu_compute_) = false;
+};
+
 }  // namespace itex
 #endif  // ITEX_CORE_KERNELS_COMMON_MATMUL_OP_H_
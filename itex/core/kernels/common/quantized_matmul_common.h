@@ -52,8 +52,7 @@ class LegacyQuantizedMatMulOpBase : public OpKernel {
                    context->GetAttr("transpose_a", &this->transpose_a_));
     OP_REQUIRES_OK(context,
                    context->GetAttr("transpose_b", &this->transpose_b_));
-    ITEX_CHECK_OK(
-        ReadBoolFromEnvVar("ITEX_CACHE_ONEDNN_OBJECT", false, &enable_cache_));
+    enable_cache_ = IsOneDnnObjectCacheEnabled();
   }
   void Compute(OpKernelContext* context) override {
     mutex_lock lock(&mu_compute_);
@@ -84,7 +83,12 @@ class LegacyQuantizedMatMulOpBase : public OpKernel {
   }
 
   void InitOrSetMemory(OpKernelContext* context) {
-    if (enable_cache_ && is_init_ && context->is_input_same(0, input_dims_)) {
+    // `weight_mem_` points to the weight cache, which may be evicted since the
+    // last run. Init() fills it again.
+    const bool is_weight_evicted = is_weight_reorder_ && is_weight_const_ &&
+                                   this->weight_cache_manager.IsEmpty();
+    if (enable_cache_ && is_init_ && !is_weight_evicted &&
+        context->is_input_same(0, input_dims_)) {
       ITEX_VLOG(3) << "Hit ITEX native MatMul INT8 object cache";
       src_mem_.set_data_handle(context->tensor_data(kInputIndex_Src));
 
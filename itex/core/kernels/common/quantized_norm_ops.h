@@ -0,0 +1,275 @@
+/* Copyright (c) 2022 Intel Corporation
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef ITEX_CORE_KERNELS_COMMON_QUANTIZED_NORM_OPS_H_
+#define ITEX_CORE_KERNELS_COMMON_QUANTIZED_NORM_OPS_H_
+
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "itex/core/utils/errors.h"
+#include "itex/core/utils/onednn/onednn_util.h"
+#include "itex/core/utils/op_kernel.h"
+#include "itex/core/utils/op_requires.h"
+#include "itex/core/utils/plugin_tensor.h"
+#include "itex/core/utils/quantization_util.h"
+#include "itex/core/utils/register_types.h"
+#include "itex/core/utils/types.h"
+
+namespace itex {
+
+// Base class of the quantized normalization ops, which replace
+// "Dequantize -> Norm -> QuantizeV2" subgraph. Both input and output use
+// per-tensor "SCALED" quantization. The fp32 normalization result never leaves
+// the kernel: the input is dequantized by a scaled reorder, normalized, and
+// quantized directly into the output tensor.
+//
+// Inputs:  x(T1), [norm specific inputs], min_x, max_x, min_y, max_y
+// Outputs: y(T2), y_min, y_max
+template <typename Device, typename T1, typename T2>
+class QuantizedNormBaseOp : public OpKernel {
+ public:
+  explicit QuantizedNormBaseOp(OpKernelConstruction* context)
+      : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("ensure_minimum_range",
+                                             &ensure_minimum_range_));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& src_tensor = context->input(kSrcIndex_);
+    const int range_index = context->num_inputs() - 4;
+    float min_src = context->input(range_index).template flat<float>()(0);
+    float max_src = context->input(range_index + 1).template flat<float>()(0);
+    float min_dst = context->input(range_index + 2).template flat<float>()(0);
+    float max_dst = context->input(range_index + 3).template flat<float>()(0);
+    OP_REQUIRES(context, max_dst >= min_dst,
+                errors::InvalidArgument(
+                    "max_output must be larger than min_output."));
+
+    // Same range adjustment with QuantizeV2, to keep numerics of the replaced
+    // subgraph.
+    min_dst = std::min(0.0f, min_dst);
+    const float epsilon =
+        std::max(1.0f, std::max(fabsf(min_dst), fabsf(max_dst))) *
+        ensure_minimum_range_;
+    max_dst = std::max(0.0f, std::max(max_dst, min_dst + epsilon));
+
+    float src_scale, dst_scale;
+    int32 zero_point;
+    GetScaleAndZeropointAndAlignMinMax<T1>(&min_src, &max_src,
+                                           QuantizeMode::SCALED,
+                                           QuantDequantFlag::Dequantize, 1,
+                                           &src_scale, &zero_point);
+    GetScaleAndZeropointAndAlignMinMax<T2>(&min_dst, &max_dst,
+                                           QuantizeMode::SCALED,
+                                           QuantDequantFlag::Quantize, 1,
+                                           &dst_scale, &zero_point);
+
+    Tensor* dst_tensor = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(
+                                kDstIndex_, src_tensor.shape(), &dst_tensor));
+    Tensor* dst_min_tensor = nullptr;
+    Tensor* dst_max_tensor = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(1, TensorShape({}),
+                                                     &dst_min_tensor));
+    OP_REQUIRES_OK(context, context->allocate_output(2, TensorShape({}),
+                                                     &dst_max_tensor));
+    dst_min_tensor->flat<float>()(0) = min_dst;
+    dst_max_tensor->flat<float>()(0) = max_dst;
+
+    if (src_tensor.NumElements() == 0) return;
+
+    try {
+      auto onednn_engine = CreateDnnlEngine<Device>(*context);
+      auto onednn_stream = CreateDnnlStream(*context, onednn_engine);
+
+      dnnl::memory::dims src_dims = TFShapeToOneDnnDims(src_tensor.shape());
+      auto src_md = CreatePlainMemDescWithFormatTag<T1>(src_dims);
+      auto fp32_md = CreatePlainMemDescWithFormatTag<float>(src_dims);
+      auto dst_md = CreatePlainMemDescWithFormatTag<T2>(src_dims);
+
+      // Dequantize input to a fp32 temporary buffer.
+      Tensor fp32_tensor;
+      OP_REQUIRES_OK(context,
+                     context->allocate_temp(DT_FLOAT, src_tensor.shape(),
+                                            &fp32_tensor));
+      auto src_mem = CreateDnnlMemory(src_md, onednn_engine,
+                                      GetTensorBuffer<T1>(&src_tensor));
+      auto fp32_mem = CreateDnnlMemory(fp32_md, onednn_engine,
+                                       GetTensorBuffer<float>(&fp32_tensor));
+      dnnl::primitive_attr dequantize_attr;
+      dequantize_attr.set_output_scales(0, {src_scale});
+      auto dequantize_pd = dnnl::reorder::primitive_desc(
+          onednn_engine, src_md, onednn_engine, fp32_md, dequantize_attr);
+      dnnl::reorder(dequantize_pd)
+          .execute(onednn_stream,
+                   {{DNNL_ARG_SRC, src_mem}, {DNNL_ARG_DST, fp32_mem}});
+
+      auto dst_mem = CreateDnnlMemory(dst_md, onednn_engine,
+                                      GetTensorBuffer<T2>(dst_tensor));
+      ComputeNorm(context, onednn_engine, onednn_stream, fp32_mem, dst_mem,
+                  dst_scale);
+    } catch (dnnl::error& e) {
+      string error_msg = "Status: " + std::to_string(e.status) +
+                         ", message: " + string(e.message) + ", in file " +
+                         string(__FILE__) + ":" + std::to_string(__LINE__);
+      OP_REQUIRES_OK(
+          context,
+          errors::Aborted("Operation received an exception:", error_msg));
+    }
+  }
+
+ protected:
+  // Normalizes fp32 `src_mem` and writes `dst_mem` quantized with `dst_scale`.
+  virtual void ComputeNorm(OpKernelContext* context,
+                           const dnnl::engine& onednn_engine,
+                           const dnnl::stream& onednn_stream,
+                           const dnnl::memory& src_mem,
+                           const dnnl::memory& dst_mem, float dst_scale) = 0;
+
+  void AllocateScratchpad(OpKernelContext* context,
+                          const dnnl::memory::desc& scratchpad_md,
+                          const dnnl::engine& onednn_engine,
+                          Tensor* scratchpad_tensor,
+                          dnnl::memory* scratchpad_mem) {
+    int64 scratchpad_size = scratchpad_md.get_size() / sizeof(float) + 1;
+    OP_REQUIRES_OK(context, context->allocate_temp(
+                                DT_FLOAT, TensorShape({scratchpad_size}),
+                                scratchpad_tensor));
+    *scratchpad_mem = dnnl::memory(scratchpad_md, onednn_engine,
+                                   GetTensorBuffer<float>(scratchpad_tensor));
+  }
+
+  const int kSrcIndex_ = 0, kDstIndex_ = 0;
+
+ private:
+  float ensure_minimum_range_;
+};
+
+// _ITEXQuantizedSoftmax: softmax along the last dimension. oneDNN softmax_v2
+// reads fp32 source and writes int8 destination with output scale directly.
+template <typename Device, typename T1, typename T2>
+class QuantizedSoftmaxOp : public QuantizedNormBaseOp<Device, T1, T2> {
+ public:
+  explicit QuantizedSoftmaxOp(OpKernelConstruction* context)
+      : QuantizedNormBaseOp<Device, T1, T2>(context) {}
+
+ protected:
+  void ComputeNorm(OpKernelContext* context, const dnnl::engine& onednn_engine,
+                   const dnnl::stream& onednn_stream,
+                   const dnnl::memory& src_mem, const dnnl::memory& dst_mem,
+                   float dst_scale) override {
+    const int axis = src_mem.get_desc().data.ndims - 1;
+    dnnl::primitive_attr attr;
+    attr.set_scratchpad_mode(dnnl::scratchpad_mode::user);
+    attr.set_output_scales(0, {dst_scale});
+    auto fwd_desc = dnnl::softmax_v2_forward::desc(
+        dnnl::prop_kind::forward_inference, dnnl::algorithm::softmax_accurate,
+        src_mem.get_desc(), dst_mem.get_desc(), axis);
+    auto fwd_pd =
+        dnnl::softmax_v2_forward::primitive_desc(fwd_desc, attr, onednn_engine);
+
+    Tensor scratchpad_tensor;
+    dnnl::memory scratchpad_mem;
+    this->AllocateScratchpad(context, fwd_pd.scratchpad_desc(), onednn_engine,
+                             &scratchpad_tensor, &scratchpad_mem);
+
+    dnnl::softmax_v2_forward(fwd_pd).execute(
+        onednn_stream, {{DNNL_ARG_SRC, src_mem},
+                        {DNNL_ARG_DST, dst_mem},
+                        {DNNL_ARG_SCRATCHPAD, scratchpad_mem}});
+  }
+};
+
+// _ITEXQuantizedLayerNorm: layer normalization along the last dimension with
+// fp32 scale and offset. oneDNN layer normalization has no int8 destination,
+// so it runs in place on the dequantized buffer, which is then quantized into
+// the output by a scaled reorder.
+template <typename Device, typename T1, typename T2>
+class QuantizedLayerNormOp : public QuantizedNormBaseOp<Device, T1, T2> {
+ public:
+  explicit QuantizedLayerNormOp(OpKernelConstruction* context)
+      : QuantizedNormBaseOp<Device, T1, T2>(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("epsilon", &epsilon_));
+  }
+
+ protected:
+  void ComputeNorm(OpKernelContext* context, const dnnl::engine& onednn_engine,
+                   const dnnl::stream& onednn_stream,
+                   const dnnl::memory& src_mem, const dnnl::memory& dst_mem,
+                   float dst_scale) override {
+    const Tensor& src_tensor = context->input(this->kSrcIndex_);
+    const Tensor& scale_tensor = context->input(kScaleIndex_);
+    const Tensor& shift_tensor = context->input(kShiftIndex_);
+    const int64 depth = src_tensor.dim_size(src_tensor.dims() - 1);
+    OP_REQUIRES(context,
+                scale_tensor.NumElements() == depth &&
+                    shift_tensor.NumElements() == depth,
+                errors::InvalidArgument(
+                    "scale and offset must have the same size as the last "
+                    "dimension of x: ",
+                    scale_tensor.shape().DebugString(), " vs ",
+                    src_tensor.shape().DebugString()));
+
+    auto flags = dnnl::normalization_flags::use_scale |
+                 dnnl::normalization_flags::use_shift;
+    dnnl::layer_normalization_forward::desc fwd_desc(
+        dnnl::prop_kind::forward_inference, src_mem.get_desc(), epsilon_,
+        flags);
+    dnnl::primitive_attr attr;
+    attr.set_scratchpad_mode(dnnl::scratchpad_mode::user);
+    dnnl::layer_normalization_forward::primitive_desc fwd_pd(fwd_desc, attr,
+                                                             onednn_engine);
+
+    auto scale_shift_md = dnnl::memory::desc({depth}, OneDnnType<float>(),
+                                             dnnl::memory::format_tag::a);
+    auto scale_mem = CreateDnnlMemory(scale_shift_md, onednn_engine,
+                                      GetTensorBuffer<float>(&scale_tensor));
+    auto shift_mem = CreateDnnlMemory(scale_shift_md, onednn_engine,
+                                      GetTensorBuffer<float>(&shift_tensor));
+
+    Tensor scratchpad_tensor;
+    dnnl::memory scratchpad_mem;
+    this->AllocateScratchpad(context, fwd_pd.scratchpad_desc(), onednn_engine,
+                             &scratchpad_tensor, &scratchpad_mem);
+
+    // In-place normalization on the fp32 buffer.
+    dnnl::layer_normalization_forward(fwd_pd).execute(
+        onednn_stream, {{DNNL_ARG_SRC, src_mem},
+                        {DNNL_ARG_DST, src_mem},
+                        {DNNL_ARG_SCALE, scale_mem},
+                        {DNNL_ARG_SHIFT, shift_mem},
+                        {DNNL_ARG_SCRATCHPAD, scratchpad_mem}});
+
+    dnnl::primitive_attr quantize_attr;
+    quantize_attr.set_output_scales(0, {dst_scale});
+    auto quantize_pd = dnnl::reorder::primitive_desc(
+        onednn_engine, src_mem.get_desc(), onednn_engine, dst_mem.get_desc(),
+        quantize_attr);
+    dnnl::reorder(quantize_pd)
+        .execute(onednn_stream,
+                 {{DNNL_ARG_SRC, src_mem}, {DNNL_ARG_DST, dst_mem}});
+  }
+
+ private:
+  const int kScaleIndex_ = 1, kShiftIndex_ = 2;
+  float epsilon_;
+};
+
+}  // namespace itex
+
+#endif  // ITEX_CORE_KERNELS_COMMON_QUANTIZED_NORM_OPS_H_
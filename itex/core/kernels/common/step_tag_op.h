@@ -0,0 +1,46 @@
+/* Copyright (c) 2022 Intel Corporation
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef ITEX_CORE_KERNELS_COMMON_STEP_TAG_OP_H_
+#define ITEX_CORE_KERNELS_COMMON_STEP_TAG_OP_H_
+
+#include "itex/core/utils/op_kernel.h"
+#include "itex/core/utils/op_requires.h"
+#include "itex/core/utils/plugin_tensor.h"
+#include "itex/core/utils/step_cancellation.h"
+#include "itex/core/utils/tensor_shape.h"
+
+namespace itex {
+
+// Forwards `x` and binds the running step to `tag`, so that the step can be
+// cancelled by its tag. Fails if the tag is already cancelled.
+class StepTagOp : public OpKernel {
+ public:
+  explicit StepTagOp(OpKernelConstruction* context) : OpKernel(context) {}
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& tag = context->input(1);
+    OP_REQUIRES(context, TensorShapeUtils::IsScalar(tag.shape()),
+                errors::InvalidArgument("tag must be a scalar, got shape ",
+                                        tag.shape().DebugString()));
+    OP_REQUIRES_OK(context, StepCancellation::Global()->TagStep(
+                                context->step_id(), tag.scalar<int64>()()));
+    context->set_output(0, context->input(0));
+  }
+};
+
+}  // namespace itex
+
+#endif  // ITEX_CORE_KERNELS_COMMON_STEP_TAG_OP_H_
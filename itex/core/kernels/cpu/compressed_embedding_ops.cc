@@ -0,0 +1,216 @@
+/* Copyright (c) 2022 Intel Corporation
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "itex/core/utils/embedding_compression.h"
+#include "itex/core/utils/errors.h"
+#include "itex/core/utils/op_kernel.h"
+#include "itex/core/utils/op_requires.h"
+#include "itex/core/utils/plugin_tensor.h"
+#include "itex/core/utils/register_types.h"
+#include "itex/core/utils/tensor_shape.h"
+#include "itex/core/utils/types.h"
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+
+namespace itex {
+
+namespace {
+
+// Checks the compressed table is 2-D and `scale_bias` matches it.
+Status ValidateCompressedTable(const Tensor& table, const Tensor& scale_bias) {
+  if (table.dims() != 2) {
+    return errors::InvalidArgument("The table must be 2-D, got ",
+                                   table.shape().DebugString());
+  }
+  if (table.dtype() == DT_INT8 &&
+      scale_bias.shape() != TensorShape({table.dim_size(0), 2})) {
+    return errors::InvalidArgument("scale_bias must be [", table.dim_size(0),
+                                   ", 2], got ",
+                                   scale_bias.shape().DebugString());
+  }
+  return Status::OK();
+}
+
+}  // namespace
+
+// Gathers rows of a compressed [num_rows, dim] table, dequantized to fp32.
+template <typename Device, typename T, typename Tindices>
+class CompressedGatherOp : public OpKernel {
+ public:
+  explicit CompressedGatherOp(OpKernelConstruction* context)
+      : OpKernel(context) {}
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& params = context->input(0);
+    const Tensor& indices = context->input(1);
+    const Tensor& scale_bias = context->input(2);
+    OP_REQUIRES_OK(context, ValidateCompressedTable(params, scale_bias));
+
+    const int64 num_rows = params.dim_size(0);
+    const int64 dim = params.dim_size(1);
+    TensorShape output_shape = indices.shape();
+    output_shape.AddDim(dim);
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context,
+                   context->allocate_output(0, output_shape, &output));
+    if (output->NumElements() == 0) return;
+
+    auto ids = indices.flat<Tindices>();
+    for (int64 i = 0; i < ids.size(); ++i) {
+      OP_REQUIRES(context, ids(i) >= 0 && ids(i) < num_rows,
+                  errors::InvalidArgument("indices[", i, "] = ", ids(i),
+                                          " is not in [0, ", num_rows, ")"));
+    }
+
+    const T* table = params.flat<T>().data();
+    const float* params_scale_bias = scale_bias.flat<float>().data();
+    float* dst = output->flat<float>().data();
+    const Eigen::ThreadPoolDevice& d = context->eigen_cpu_device();
+    d.parallelFor(ids.size(),
+                  Eigen::TensorOpCost(dim * sizeof(T), dim * sizeof(float),
+                                      2 * dim),
+                  [&](Eigen::Index first, Eigen::Index last) {
+                    std::fill(dst + first * dim, dst + last * dim, 0.0f);
+                    for (Eigen::Index i = first; i < last; ++i) {
+                      AccumulateEmbeddingRow(table, params_scale_bias, ids(i),
+                                             dim, 1.0f, dst + i * dim);
+                    }
+                  });
+  }
+};
+
+// SparseSegmentSum/Mean/SqrtN over a compressed table: output row s combines
+// the rows data[indices[j]] with segment_ids[j] == s in fp32.
+template <typename Device, typename T, typename Tidx, typename Tsegmentids>
+class CompressedSparseSegmentReductionOp : public OpKernel {
+ public:
+  explicit CompressedSparseSegmentReductionOp(OpKernelConstruction* context)
+      : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("combiner", &combiner_));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& data = context->input(0);
+    const Tensor& indices = context->input(1);
+    const Tensor& segment_ids = context->input(2);
+    const Tensor& scale_bias = context->input(3);
+    OP_REQUIRES_OK(context, ValidateCompressedTable(data, scale_bias));
+    OP_REQUIRES(context,
+                indices.dims() == 1 && segment_ids.shape() == indices.shape(),
+                errors::InvalidArgument(
+                    "indices and segment_ids must be 1-D of the same size, "
+                    "got ",
+                    indices.shape().DebugString(), " and ",
+                    segment_ids.shape().DebugString()));
+
+    const int64 num_rows = data.dim_size(0);
+    const int64 dim = data.dim_size(1);
+    const int64 num_indices = indices.NumElements();
+    auto ids = indices.flat<Tidx>();
+    auto segments = segment_ids.flat<Tsegmentids>();
+    const int64 num_segments =
+        num_indices > 0 ? static_cast<int64>(segments(num_indices - 1)) + 1
+                        : 0;
+
+    // Runs of the same segment id, [begin, end) of each run.
+    std::vector<int64> run_begins;
+    for (int64 i = 0; i < num_indices; ++i) {
+      OP_REQUIRES(context, ids(i) >= 0 && ids(i) < num_rows,
+                  errors::InvalidArgument("indices[", i, "] = ", ids(i),
+                                          " is not in [0, ", num_rows, ")"));
+      OP_REQUIRES(
+          context,
+          segments(i) >= 0 && (i == 0 || segments(i) >= segments(i - 1)),
+          errors::InvalidArgument("segment ids are not increasing"));
+      if (i == 0 || segments(i) != segments(i - 1)) run_begins.push_back(i);
+    }
+    run_begins.push_back(num_indices);
+
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(
+                                0, TensorShape({num_segments, dim}), &output));
+    if (output->NumElements() == 0) return;
+
+    const T* table = data.flat<T>().data();
+    const float* params_scale_bias = scale_bias.flat<float>().data();
+    float* dst = output->flat<float>().data();
+    // Segments without any index are 0.
+    std::fill(dst, dst + output->NumElements(), 0.0f);
+
+    const int64 num_runs = run_begins.size() - 1;
+    const double run_cost =
+        static_cast<double>(num_indices) / num_runs * dim * 2;
+    const Eigen::ThreadPoolDevice& d = context->eigen_cpu_device();
+    d.parallelFor(
+        num_runs, Eigen::TensorOpCost(0, dim * sizeof(float), run_cost),
+        [&](Eigen::Index first, Eigen::Index last) {
+          for (Eigen::Index run = first; run < last; ++run) {
+            const int64 begin = run_begins[run];
+            const int64 end = run_begins[run + 1];
+            const int64 count = end - begin;
+            float weight = 1.0f;
+            if (combiner_ == "mean") {
+              weight = 1.0f / count;
+            } else if (combiner_ == "sqrtn") {
+              weight = 1.0f / std::sqrt(static_cast<float>(count));
+            }
+            float* acc = dst + static_cast<int64>(segments(begin)) * dim;
+            for (int64 j = begin; j < end; ++j) {
+              AccumulateEmbeddingRow(table, params_scale_bias, ids(j), dim,
+                                     weight, acc);
+            }
+          }
+        });
+  }
+
+ private:
+  std::string combiner_;
+};
+
+#define REGISTER_CPU_COMPRESSED_GATHER(T, Tindices)                    \
+  REGISTER_KERNEL_BUILDER(Name("_ITEXCompressedGather")                \
+                              .Device(DEVICE_CPU)                      \
+                              .TypeConstraint<T>("Tparams")            \
+                              .TypeConstraint<Tindices>("Tindices"),   \
+                          CompressedGatherOp<CPUDevice, T, Tindices>);
+
+#define REGISTER_CPU_COMPRESSED_SEGMENT(T, Tidx, Tsegmentids)          \
+  REGISTER_KERNEL_BUILDER(                                             \
+      Name("_ITEXCompressedSparseSegmentReduction")                    \
+          .Device(DEVICE_CPU)                                          \
+          .TypeConstraint<T>("Tparams")                                \
+          .TypeConstraint<Tidx>("Tidx")                                \
+          .TypeConstraint<Tsegmentids>("Tsegmentids"),                 \
+      CompressedSparseSegmentReductionOp<CPUDevice, T, Tidx, Tsegmentids>);
+
+#define REGISTER_CPU_COMPRESSED_EMBEDDING(T)              \
+  REGISTER_CPU_COMPRESSED_GATHER(T, int32)                \
+  REGISTER_CPU_COMPRESSED_GATHER(T, int64)                \
+  REGISTER_CPU_COMPRESSED_SEGMENT(T, int32, int32)        \
+  REGISTER_CPU_COMPRESSED_SEGMENT(T, int32, int64)        \
+  REGISTER_CPU_COMPRESSED_SEGMENT(T, int64, int32)        \
+  REGISTER_CPU_COMPRESSED_SEGMENT(T, int64, int64)
+
+REGISTER_CPU_COMPRESSED_EMBEDDING(Eigen::bfloat16);
+REGISTER_CPU_COMPRESSED_EMBEDDING(int8);
+#undef REGISTER_CPU_COMPRESSED_EMBEDDING
+#undef REGISTER_CPU_COMPRESSED_SEGMENT
+#undef REGISTER_CPU_COMPRESSED_GATHER
+
+}  // namespace itex
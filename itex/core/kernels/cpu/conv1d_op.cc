@@ -0,0 +1,33 @@
+/* Copyright (c) 2021-2022 Intel Corporation
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "itex/core/kernels/common/conv1d_op.h"
+
+#include "itex/core/utils/register_types.h"
+
+namespace itex {
+
+#define REGISTER_CPU_CONV1D(T)                                            \
+  REGISTER_KERNEL_BUILDER(                                                \
+      Name("_ITEXConv1D").Device(DEVICE_CPU).TypeConstraint<T>("T"),      \
+      Conv1DOp<CPUDevice, T>);                                            \
+  REGISTER_KERNEL_BUILDER(                                                \
+      Name("ItexCausalConv1D").Device(DEVICE_CPU).TypeConstraint<T>("T"), \
+      CausalConv1DOp<CPUDevice, T>);
+
+TF_CALL_CPU_NUMBER_TYPES(REGISTER_CPU_CONV1D);
+#undef REGISTER_CPU_CONV1D
+
+}  // namespace itex
@@ -24,6 +24,12 @@ namespace itex {
                               .HostMemory("input_sizes")                   \
                               .TypeConstraint<T>("T"),                     \
                           ConvBackpropInputOp<CPUDevice, T>)               \
+  REGISTER_KERNEL_BUILDER(                                                 \
+      Name("_ITEXConv2DBackpropInputWithReorderedFilter")                  \
+          .Device(DEVICE_CPU)                                              \
+          .HostMemory("input_sizes")                                       \
+          .TypeConstraint<T>("T"),                                         \
+      ConvBackpropInputOp<CPUDevice, T, false, false, true>);              \
   REGISTER_KERNEL_BUILDER(Name("_ITEXConv3DBackpropInput")                 \
                               .Device(DEVICE_CPU)                          \
                               .TypeConstraint<T>("T"),                     \
@@ -23,6 +23,10 @@ namespace itex {
   REGISTER_KERNEL_BUILDER(                                                     \
       Name("_ITEXConv2D").Device(DEVICE_CPU).TypeConstraint<T>("T"),           \
       ConvOpBase<CPUDevice, T, T, T, T, T>);                                   \
+  REGISTER_KERNEL_BUILDER(Name("_ITEXConv2DWithReorderedFilter")               \
+                              .Device(DEVICE_CPU)                              \
+                              .TypeConstraint<T>("T"),                         \
+                          ConvWithReorderedFilterOp<CPUDevice, T>);            \
   REGISTER_KERNEL_BUILDER(                                                     \
       Name("_ITEXFusedConv2D").Device(DEVICE_CPU).TypeConstraint<T>("T"),      \
       FusedConvOp<CPUDevice, T, T, T, T, T>);                                  \
@@ -0,0 +1,458 @@
+/* Copyright (c) 2022 Intel Corporation
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "itex/core/utils/cache_governor.h"
+#include "itex/core/utils/errors.h"
+#include "itex/core/utils/onednn/onednn_post_op_util.h"
+#include "itex/core/utils/onednn/onednn_primitive_log.h"
+#include "itex/core/utils/onednn/onednn_util.h"
+#include "itex/core/utils/op_kernel.h"
+#include "itex/core/utils/op_requires.h"
+#include "itex/core/utils/plugin_tensor.h"
+#include "itex/core/utils/register_types.h"
+#include "itex/core/utils/tensor_shape.h"
+#include "itex/core/utils/types.h"
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+
+namespace itex {
+
+using dnnl::memory;
+
+// fp32 MatMul computed in INT8 without calibration, rewritten from
+// `_ITEXFusedMatMul` with a const weight when dynamic INT8 is enabled.
+//
+// The weight is quantized once to s8 with one symmetric scale per output
+// channel. The activation scale is computed on every call from its min/max:
+// non-negative activations, e.g. after Relu, use u8 and the others use
+// symmetric s8. The s8/u8 matmul then dequantizes with runtime per-channel
+// output scales, so the primitive doesn't depend on the data, and the fp32
+// bias and activation run as post ops on the dequantized result.
+template <typename Device>
+class DynamicQuantizedMatMulOp : public OpKernel {
+ public:
+  explicit DynamicQuantizedMatMulOp(OpKernelConstruction* context)
+      : OpKernel(context) {
+    bool transpose_a = false;
+    OP_REQUIRES_OK(context, context->GetAttr("transpose_a", &transpose_a));
+    OP_REQUIRES(context, !transpose_a,
+                errors::InvalidArgument(
+                    "Dynamic quantized MatMul doesn't support transpose_a."));
+    OP_REQUIRES_OK(context, context->GetAttr("transpose_b", &transpose_b_));
+    OP_REQUIRES_OK(context,
+                   context->GetAttr("is_filter_const", &is_filter_const_));
+
+    std::vector<string> fused_ops;
+    OP_REQUIRES_OK(context, context->GetAttr("fused_ops", &fused_ops));
+    // Bias is added after the output scales, as a binary post op, so it
+    // stays in fp32 instead of being quantized with the accumulator.
+    std::vector<string> post_ops;
+    for (const string& op : fused_ops) {
+      if (op == "BiasAdd") {
+        OP_REQUIRES(context, post_ops.empty(),
+                    errors::InvalidArgument(
+                        "BiasAdd must be the first fusion of MatMul."));
+        has_bias_ = true;
+        post_ops.push_back("BinaryAdd");
+      } else {
+        post_ops.push_back(op);
+      }
+    }
+    OP_REQUIRES(context, post_op_util_.AddOps(post_ops) &&
+                             !post_op_util_.HasAdd() &&
+                             post_op_util_.HasBinary() == has_bias_,
+                errors::InvalidArgument(
+                    "Found unsupported fusion in dynamic quantized MatMul."));
+    if (post_op_util_.HasLeakyRelu()) {
+      float alpha;
+      OP_REQUIRES_OK(context, context->GetAttr("leakyrelu_alpha", &alpha));
+      post_op_util_.SetLeakyReluAlpha(alpha);
+    }
+
+    enable_cache_ = IsOneDnnObjectCacheEnabled();
+  }
+
+  ~DynamicQuantizedMatMulOp() override {
+    mutex_lock lock(&weight_mu_);
+    if (weight_entry_ != nullptr) {
+      CacheGovernor::Global()->Unregister(weight_entry_);
+    }
+  }
+
+  struct CachedWeights {
+    const Tensor* qweights;
+    const Tensor* scales;
+  };
+
+  // Primitive for one source shape and type. Immutable once created, so
+  // concurrent calls share it.
+  struct Plan {
+    int64 m = 0, k = 0, n = 0;
+    bool is_src_unsigned = false;
+    memory::desc src_md, weights_md, dst_md, bias_md, scales_md;
+    dnnl::matmul::primitive_desc matmul_pd;
+    dnnl::matmul matmul_primitive;
+  };
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& src_tensor = context->input(kSrcIndex_);
+    const Tensor& weights_tensor = context->input(kWeightIndex_);
+    OP_REQUIRES(context, src_tensor.dims() >= 2,
+                errors::InvalidArgument("In[0] ndims must be >= 2: ",
+                                        src_tensor.dims()));
+    OP_REQUIRES(context, weights_tensor.dims() == 2,
+                errors::InvalidArgument("In[1] must be a matrix: ",
+                                        weights_tensor.shape().DebugString()));
+
+    // Leading dims of the source are flattened into M.
+    const int64 k = src_tensor.dim_size(src_tensor.dims() - 1);
+    const int64 k_weights = weights_tensor.dim_size(transpose_b_ ? 1 : 0);
+    const int64 n = weights_tensor.dim_size(transpose_b_ ? 0 : 1);
+    OP_REQUIRES(context, k == k_weights,
+                errors::InvalidArgument(
+                    "Matrix size-incompatible: In[0]: ",
+                    src_tensor.shape().DebugString(),
+                    ", In[1]: ", weights_tensor.shape().DebugString()));
+    if (has_bias_) {
+      const Tensor& bias_tensor = context->input(kBiasIndex_);
+      OP_REQUIRES(context, bias_tensor.NumElements() == n,
+                  errors::InvalidArgument(
+                      "Bias must have ", n, " elements, got shape ",
+                      bias_tensor.shape().DebugString()));
+    }
+
+    TensorShape dst_shape = src_tensor.shape();
+    dst_shape.set_dim(dst_shape.dims() - 1, n);
+    Tensor* dst_tensor = nullptr;
+    OP_REQUIRES_OK(
+        context, context->allocate_output(kDstIndex_, dst_shape, &dst_tensor));
+    if (dst_tensor->NumElements() == 0) return;
+    const int64 m = dst_tensor->NumElements() / n;
+
+    const Eigen::ThreadPoolDevice& d = context->eigen_cpu_device();
+
+    // Per-channel weight scales and the quantized weight.
+    const Tensor* qweights = nullptr;
+    const Tensor* weight_scales = nullptr;
+    Tensor tmp_qweights, tmp_weight_scales;
+    if (is_filter_const_) {
+      GetCachedWeights(context, weights_tensor, &qweights, &weight_scales);
+      if (!context->status().ok()) return;
+    } else {
+      OP_REQUIRES_OK(context,
+                     context->allocate_temp(DT_INT8, weights_tensor.shape(),
+                                            &tmp_qweights));
+      OP_REQUIRES_OK(context, context->allocate_temp(
+                                  DT_FLOAT, TensorShape({n}),
+                                  &tmp_weight_scales));
+      QuantizeWeights(d, weights_tensor, &tmp_qweights, &tmp_weight_scales);
+      qweights = &tmp_qweights;
+      weight_scales = &tmp_weight_scales;
+    }
+
+    // Activation range of this call.
+    auto src = src_tensor.flat<float>();
+    Eigen::Tensor<float, 0, Eigen::RowMajor> src_min, src_max;
+    src_min.device(d) = src.minimum();
+    src_max.device(d) = src.maximum();
+    const bool is_src_unsigned = src_min() >= 0.0f;
+    const float src_range =
+        std::max(std::abs(src_min()), std::abs(src_max()));
+    const float src_scale =
+        src_range > 0.0f ? (is_src_unsigned ? 255.0f : 127.0f) / src_range
+                         : 1.0f;
+
+    Tensor qsrc_tensor;
+    OP_REQUIRES_OK(context, context->allocate_temp(
+                                is_src_unsigned ? DT_UINT8 : DT_INT8,
+                                src_tensor.shape(), &qsrc_tensor));
+    if (is_src_unsigned) {
+      qsrc_tensor.flat<uint8>().device(d) =
+          (src * src_scale).round().cwiseMin(255.0f).template cast<uint8>();
+    } else {
+      qsrc_tensor.flat<int8>().device(d) = (src * src_scale)
+                                               .round()
+                                               .cwiseMax(-127.0f)
+                                               .cwiseMin(127.0f)
+                                               .template cast<int8>();
+    }
+
+    // Dequantization scale of each output channel.
+    Tensor output_scales;
+    OP_REQUIRES_OK(context, context->allocate_temp(
+                                DT_FLOAT, TensorShape({n}), &output_scales));
+    auto w_scales = weight_scales->flat<float>();
+    auto o_scales = output_scales.flat<float>();
+    for (int64 i = 0; i < n; ++i) {
+      o_scales(i) = 1.0f / (src_scale * w_scales(i));
+    }
+
+    bool is_init = false;
+    std::shared_ptr<const Plan> plan =
+        LookupPlan(m, k, n, is_src_unsigned, &is_init);
+    if (plan == nullptr) {
+      std::shared_ptr<Plan> new_plan;
+      CreatePlan(context, m, k, n, is_src_unsigned,
+                 is_init ? PrimitiveCreateReason::kShapeChange
+                         : PrimitiveCreateReason::kCold,
+                 &new_plan);
+      if (!context->status().ok()) return;
+      plan = new_plan;
+      InsertPlan(std::move(new_plan));
+    }
+
+    try {
+      auto dnnl_engine = CreateDnnlEngine<Device>(*context);
+      auto dnnl_stream = CreateDnnlStream(*context, dnnl_engine);
+
+      Tensor scratchpad_tensor;
+      int64 scratchpad_size = plan->matmul_pd.scratchpad_desc().get_size();
+      OP_REQUIRES_OK(context,
+                     context->allocate_temp(DT_UINT8,
+                                            TensorShape({scratchpad_size}),
+                                            &scratchpad_tensor));
+
+      std::unordered_map<int, memory> args = {
+          {DNNL_ARG_SRC,
+           CreateDnnlMemory(plan->src_md, dnnl_engine,
+                            is_src_unsigned
+                                ? GetTensorBuffer<uint8>(&qsrc_tensor)
+                                : GetTensorBuffer<int8>(&qsrc_tensor))},
+          {DNNL_ARG_WEIGHTS, CreateDnnlMemory(plan->weights_md, dnnl_engine,
+                                              GetTensorBuffer<int8>(qweights))},
+          {DNNL_ARG_DST, CreateDnnlMemory(plan->dst_md, dnnl_engine,
+                                          GetTensorBuffer<float>(dst_tensor))},
+          {DNNL_ARG_ATTR_OUTPUT_SCALES,
+           CreateDnnlMemory(plan->scales_md, dnnl_engine,
+                            GetTensorBuffer<float>(&output_scales))},
+          {DNNL_ARG_SCRATCHPAD,
+           CreateDnnlMemory(plan->matmul_pd.scratchpad_desc(), dnnl_engine,
+                            GetTensorBuffer<uint8>(&scratchpad_tensor))}};
+      if (has_bias_) {
+        const Tensor& bias_tensor = context->input(kBiasIndex_);
+        args.emplace(DNNL_ARG_ATTR_MULTIPLE_POST_OP(0) | DNNL_ARG_SRC_1,
+                     CreateDnnlMemory(plan->bias_md, dnnl_engine,
+                                      GetTensorBuffer<float>(&bias_tensor)));
+      }
+      plan->matmul_primitive.execute(dnnl_stream, args);
+    } catch (dnnl::error& e) {
+      string error_msg = "Status: " + std::to_string(e.status) +
+                         ", message: " + string(e.message) + ", in file " +
+                         string(__FILE__) + ":" + std::to_string(__LINE__);
+      OP_REQUIRES_OK(
+          context,
+          errors::Aborted("Operation received an exception:", error_msg));
+    }
+  }
+
+ private:
+  // Quantizes `weights` to s8 with a symmetric scale per output channel.
+  void QuantizeWeights(const Eigen::ThreadPoolDevice& d, const Tensor& weights,
+                       Tensor* qweights, Tensor* scales) {
+    auto w = weights.matrix<float>();
+    const int reduce_dim = transpose_b_ ? 1 : 0;
+    const int64 k = weights.dim_size(reduce_dim);
+    const int64 n = weights.dim_size(1 - reduce_dim);
+
+    auto s = scales->flat<float>();
+    s.device(d) = w.abs().maximum(Eigen::array<int, 1>{reduce_dim});
+    for (int64 i = 0; i < n; ++i) {
+      s(i) = s(i) > 0.0f ? 127.0f / s(i) : 1.0f;
+    }
+
+    Eigen::array<Eigen::Index, 2> scale_dims{1, n};
+    Eigen::array<Eigen::Index, 2> bcast{k, 1};
+    if (transpose_b_) {
+      scale_dims = {n, 1};
+      bcast = {1, k};
+    }
+    qweights->matrix<int8>().device(d) =
+        (w * s.reshape(scale_dims).broadcast(bcast))
+            .round()
+            .template cast<int8>();
+  }
+
+  // The quantized weight is filled once and never changes, so it's read
+  // through an atomic pointer and `weight_mu_` is only taken to fill it.
+  void GetCachedWeights(OpKernelContext* context, const Tensor& weights,
+                        const Tensor** qweights, const Tensor** scales)
+      TF_LOCKS_EXCLUDED(weight_mu_) {
+    const CachedWeights* cached =
+        published_weights_.load(std::memory_order_acquire);
+    if (cached == nullptr) {
+      cached = FillCachedWeights(context, weights);
+      if (cached == nullptr) return;
+    }
+    *qweights = cached->qweights;
+    *scales = cached->scales;
+  }
+
+  const CachedWeights* FillCachedWeights(OpKernelContext* context,
+                                         const Tensor& weights)
+      TF_LOCKS_EXCLUDED(weight_mu_) {
+    mutex_lock lock(&weight_mu_);
+    if (cached_weights_ == nullptr) {
+      const int64 n = weights.dim_size(transpose_b_ ? 0 : 1);
+      Tensor* qweights_ptr = nullptr;
+      Tensor* scales_ptr = nullptr;
+      OP_REQUIRES_OK_PTR(context, context->allocate_persistent(
+                                      DT_INT8, weights.shape(),
+                                      &qweights_cache_, &qweights_ptr));
+      OP_REQUIRES_OK_PTR(context, context->allocate_persistent(
+                                      DT_FLOAT, TensorShape({n}),
+                                      &scales_cache_, &scales_ptr));
+      QuantizeWeights(context->eigen_cpu_device(), weights, qweights_ptr,
+                      scales_ptr);
+      weight_entry_ = CacheGovernor::Global()->Register(
+          CacheCategory::kWeight,
+          qweights_ptr->TotalBytes() + scales_ptr->TotalBytes(), nullptr);
+      cached_weights_.reset(new CachedWeights{qweights_ptr, scales_ptr});
+      published_weights_.store(cached_weights_.get(),
+                               std::memory_order_release);
+    }
+    return cached_weights_.get();
+  }
+
+  // Returns the cached plan of this shape and source type, otherwise nullptr.
+  // `is_init` tells whether any plan was created before.
+  std::shared_ptr<const Plan> LookupPlan(int64 m, int64 k, int64 n,
+                                         bool is_src_unsigned, bool* is_init)
+      TF_LOCKS_EXCLUDED(mu_compute_) {
+    mutex_lock lock(&mu_compute_);
+    *is_init = is_init_;
+    for (const auto& plan : plans_) {
+      if (plan->m == m && plan->k == k && plan->n == n &&
+          plan->is_src_unsigned == is_src_unsigned) {
+        return plan;
+      }
+    }
+    return nullptr;
+  }
+
+  // Batch size and activation sign may alternate between calls, so a few
+  // plans are kept and the oldest one is dropped once the limit is reached.
+  void InsertPlan(std::shared_ptr<const Plan> plan)
+      TF_LOCKS_EXCLUDED(mu_compute_) {
+    mutex_lock lock(&mu_compute_);
+    is_init_ = true;
+    if (!enable_cache_) return;
+    for (const auto& cached : plans_) {
+      // Another call created the same plan meanwhile.
+      if (cached->m == plan->m && cached->k == plan->k &&
+          cached->n == plan->n &&
+          cached->is_src_unsigned == plan->is_src_unsigned) {
+        return;
+      }
+    }
+    if (plans_.size() >= kMaxPlans_) plans_.erase(plans_.begin());
+    plans_.push_back(std::move(plan));
+  }
+
+  void CreatePlan(OpKernelContext* context, int64 m, int64 k, int64 n,
+                  bool is_src_unsigned, PrimitiveCreateReason reason,
+                  std::shared_ptr<Plan>* plan_ptr) {
+    auto plan = std::make_shared<Plan>();
+    plan->m = m;
+    plan->k = k;
+    plan->n = n;
+    plan->is_src_unsigned = is_src_unsigned;
+
+    try {
+      auto dnnl_engine = CreateDnnlEngine<Device>(*context);
+      // Per call inputs complete the post ops, work on a copy so the kernel
+      // stays read-only.
+      PostOpUtil post_op_util = post_op_util_;
+
+      plan->src_md = memory::desc(
+          {m, k},
+          is_src_unsigned ? memory::data_type::u8 : memory::data_type::s8,
+          memory::format_tag::ab);
+      plan->weights_md =
+          memory::desc({k, n}, memory::data_type::s8,
+                       transpose_b_ ? memory::format_tag::ba
+                                    : memory::format_tag::ab);
+      plan->dst_md =
+          memory::desc({m, n}, memory::data_type::f32, memory::format_tag::ab);
+      plan->scales_md =
+          memory::desc({n}, memory::data_type::f32, memory::format_tag::a);
+
+      dnnl::primitive_attr attr;
+      attr.set_scratchpad_mode(dnnl::scratchpad_mode::user);
+      // Dim 1 of dst, i.e. one scale per output channel.
+      attr.set_output_scales(2, {DNNL_RUNTIME_F32_VAL});
+      if (has_bias_) {
+        plan->bias_md = memory::desc({1, n}, memory::data_type::f32,
+                                     memory::format_tag::ab);
+        post_op_util.SetBinaryInput(plan->bias_md);
+      }
+      post_op_util.SetPostOpAttr(&attr);
+
+      dnnl::matmul::desc matmul_desc(plan->src_md, plan->weights_md,
+                                     plan->dst_md);
+      {
+        ScopedPrimitiveCreation primitive_record(this, "matmul", reason);
+        plan->matmul_pd =
+            dnnl::matmul::primitive_desc(matmul_desc, attr, dnnl_engine);
+        plan->matmul_primitive = dnnl::matmul(plan->matmul_pd);
+        primitive_record.SetPrimitiveDesc(plan->matmul_pd);
+      }
+      *plan_ptr = std::move(plan);
+    } catch (dnnl::error& e) {
+      string error_msg = "Status: " + std::to_string(e.status) +
+                         ", message: " + string(e.message) + ", in file " +
+                         string(__FILE__) + ":" + std::to_string(__LINE__);
+      OP_REQUIRES_OK(
+          context,
+          errors::Aborted("Operation received an exception:", error_msg));
+    }
+  }
+
+  bool transpose_b_ = false;
+  bool is_filter_const_ = false;
+  bool has_bias_ = false;
+  bool enable_cache_ = false;
+  const int kSrcIndex_ = 0, kDstIndex_ = 0, kWeightIndex_ = 1,
+            kBiasIndex_ = 2;
+  const size_t kMaxPlans_ = 8;
+
+  PostOpUtil post_op_util_;
+
+  mutex weight_mu_, mu_compute_;
+  PersistentTensor qweights_cache_ TF_GUARDED_BY(weight_mu_);
+  PersistentTensor scales_cache_ TF_GUARDED_BY(weight_mu_);
+  CacheGovernor::Entry* weight_entry_ TF_GUARDED_BY(weight_mu_) = nullptr;
+  std::unique_ptr<const CachedWeights> cached_weights_
+      TF_GUARDED_BY(weight_mu_);
+  // Points to `cached_weights_` once the weight is quantized.
+  std::atomic<const CachedWeights*> published_weights_{nullptr};
+  // Only guards lookup and insert of plans, never the execution.
+  std::vector<std::shared_ptr<const Plan>> plans_ TF_GUARDED_BY(mu_compute_);
+  bool is_init_ TF_GUARDED_BY(mu_compute_) = false;
+};
+
+REGISTER_KERNEL_BUILDER(Name("_ITEXDynamicQuantizedMatMul")
+                            .Device(DEVICE_CPU)
+                            .TypeConstraint<float>("T"),
+                        DynamicQuantizedMatMulOp<CPUDevice>);
+
+}  // namespace itex
@@ -0,0 +1,326 @@
+/* Copyright (c) 2022 Intel Corporation
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "itex/core/kernels/common/conv_grad_ops.h"
+#include "itex/core/kernels/common/fused_batch_norm_op.h"
+#include "itex/core/utils/errors.h"
+#include "itex/core/utils/onednn/onednn_util.h"
+#include "itex/core/utils/op_kernel.h"
+#include "itex/core/utils/op_requires.h"
+#include "itex/core/utils/register_types.h"
+#include "itex/core/utils/types.h"
+
+namespace itex {
+typedef Eigen::ThreadPoolDevice CPUDevice;
+
+// Backward of Conv2D + FusedBatchNorm + Relu in one kernel. The ReLU mask and
+// the BN reductions are a single oneDNN batch norm backward pass writing the
+// conv output gradient, which then feeds both conv backward primitives. They
+// share one forward hint, one scratchpad and, for NCHW, one NHWC copy of the
+// gradient instead of each kernel reordering it on its own.
+template <typename Device, typename T, typename U>
+class FusedBatchNormGradWithConv2DBackpropOp
+    : public FusedBatchNormGradOp<Device, T, U, true, true> {
+ public:
+  explicit FusedBatchNormGradWithConv2DBackpropOp(
+      OpKernelConstruction* context)
+      : FusedBatchNormGradOp<Device, T, U, true, true>(context) {
+    string data_format_string;
+    OP_REQUIRES_OK(context,
+                   context->GetAttr("data_format", &data_format_string));
+    OP_REQUIRES(context, FormatFromString(data_format_string, &data_format_),
+                errors::InvalidArgument("Invalid data format"));
+    OP_REQUIRES_OK(context, context->GetAttr("strides", &strides_));
+    OP_REQUIRES_OK(context, context->GetAttr("dilations", &dilations_));
+    OP_REQUIRES(context, strides_.size() == 4 && dilations_.size() == 4,
+                errors::InvalidArgument("Sliding window strides and dilations "
+                                        "fields must specify 4 dimensions"));
+    OP_REQUIRES(context,
+                GetTensorDim(strides_, data_format_, 'N') == 1 &&
+                    GetTensorDim(strides_, data_format_, 'C') == 1 &&
+                    GetTensorDim(dilations_, data_format_, 'N') == 1 &&
+                    GetTensorDim(dilations_, data_format_, 'C') == 1,
+                errors::InvalidArgument(
+                    "Current implementation does not yet support strides or "
+                    "dilations in the batch and depth dimensions."));
+    OP_REQUIRES_OK(context, context->GetAttr("padding", &padding_));
+    if (context->HasAttr("explicit_paddings")) {
+      OP_REQUIRES_OK(
+          context, context->GetAttr("explicit_paddings", &explicit_paddings_));
+    }
+    OP_REQUIRES_OK(context, CheckValidPadding(padding_, explicit_paddings_, 4,
+                                              data_format_));
+    fp32_math_mode_ = GetFP32MathMode<Device>();
+  }
+
+  void Compute(OpKernelContext* context) override {
+    // ReluGrad + FusedBatchNormGrad, writing the conv output gradient to
+    // output 0.
+    FusedBatchNormGradOp<Device, T, U, true, true>::Compute(context);
+    if (!context->status().ok()) return;
+
+    const int kConvInputIdx = 8, kFilterIdx = 9, kInputSizesIdx = 10;
+    const int kDiffDstIdx = 0, kDiffSrcIdx = 5, kDiffFilterIdx = 6;
+    try {
+      auto onednn_engine = CreateDnnlEngine<Device>(*context);
+      auto onednn_stream = CreateDnnlStream(*context, onednn_engine);
+
+      const Tensor& src_tensor = context->input(kConvInputIdx);
+      const Tensor& filter_tensor = context->input(kFilterIdx);
+      const Tensor& diff_dst_tensor = *context->mutable_output(kDiffDstIdx);
+
+      const TensorShape src_shape =
+          GetTensorShape(context->input(kInputSizesIdx));
+      const TensorShape& filter_shape = filter_tensor.shape();
+      OP_REQUIRES(context, src_shape == src_tensor.shape(),
+                  errors::InvalidArgument(
+                      "input_sizes ", src_shape.DebugString(),
+                      " don't match conv_input ",
+                      src_tensor.shape().DebugString()));
+
+      Tensor* diff_src_tensor = nullptr;
+      Tensor* diff_filter_tensor = nullptr;
+      OP_REQUIRES_OK(context, context->allocate_output(kDiffSrcIdx, src_shape,
+                                                       &diff_src_tensor));
+      OP_REQUIRES_OK(context,
+                     context->allocate_output(kDiffFilterIdx, filter_shape,
+                                              &diff_filter_tensor));
+
+      // Corner cases: output with 0 elements and 0 batch size.
+      if (src_shape.num_elements() == 0 || filter_shape.num_elements() == 0 ||
+          diff_dst_tensor.NumElements() == 0) {
+        std::fill_n(diff_src_tensor->flat<T>().data(),
+                    diff_src_tensor->NumElements(), static_cast<T>(0));
+        std::fill_n(diff_filter_tensor->flat<T>().data(),
+                    diff_filter_tensor->NumElements(), static_cast<T>(0));
+        return;
+      }
+
+      memory::dims src_dims, filter_dims, diff_dst_dims;
+      memory::dims pad_left_dims, pad_right_dims, dilation_dims, stride_dims;
+      memory::dims dst_dims_tf, dst_dims_onednn;
+      OneDnnConvUtil conv_util(context, data_format_, strides_, dilations_,
+                               padding_, explicit_paddings_,
+                               /*is_conv2d*/ true, /*is_depthwise*/ false);
+      conv_util.InitFwdDimensions(src_shape, filter_shape, &src_dims,
+                                  &filter_dims, &stride_dims, &dilation_dims,
+                                  &dst_dims_tf, &dst_dims_onednn,
+                                  &pad_left_dims, &pad_right_dims);
+      conv_util.GetInputDimension(diff_dst_tensor.shape(), &diff_dst_dims);
+      if (!context->status().ok()) return;
+      // OneDNN dilations start from 0.
+      for (int i = 0; i < dilation_dims.size(); ++i) {
+        --dilation_dims[i];
+      }
+
+      memory::format_tag data_layout = OneDnnTensorFormatToTag(
+          TFDataFormatToOneDnnDataFormat(data_format_, true));
+      auto src_md = memory::desc(src_dims, OneDnnType<T>(), data_layout);
+      auto diff_dst_md =
+          memory::desc(diff_dst_dims, OneDnnType<T>(), data_layout);
+      auto filter_md = memory::desc(filter_dims, OneDnnType<T>(),
+                                    memory::format_tag::hwio);
+      auto filter_md_prefer =
+          memory::desc(filter_dims, OneDnnType<T>(), memory::format_tag::any);
+
+      // the convolution primitive is optimized for NHWC
+      const auto format_tag_opt = memory::format_tag::nhwc;
+      auto src_md_opt = memory::desc(src_dims, OneDnnType<T>(), format_tag_opt);
+      auto diff_dst_md_opt =
+          memory::desc(diff_dst_dims, OneDnnType<T>(), format_tag_opt);
+
+      ConvFwdDesc fwd_desc = ConvFwdDesc(
+          prop_kind::forward, dnnl::algorithm::convolution_direct, src_md_opt,
+          filter_md_prefer, diff_dst_md_opt, stride_dims, dilation_dims,
+          pad_left_dims, pad_right_dims);
+      ConvBwdInputDesc bwd_input_desc = ConvBwdInputDesc(
+          dnnl::algorithm::convolution_direct, src_md_opt, filter_md_prefer,
+          diff_dst_md_opt, stride_dims, dilation_dims, pad_left_dims,
+          pad_right_dims);
+      ConvBwdFilterDesc bwd_filter_desc = ConvBwdFilterDesc(
+          dnnl::algorithm::convolution_direct, src_md_opt, filter_md_prefer,
+          diff_dst_md_opt, stride_dims, dilation_dims, pad_left_dims,
+          pad_right_dims);
+
+      dnnl::primitive_attr attr;
+      attr.set_scratchpad_mode(dnnl::scratchpad_mode::user);
+      if (std::is_same<T, float>::value) {
+        attr.set_fpmath_mode(fp32_math_mode_);
+      }
+      ConvFwdPd fwd_pd = ConvFwdPd(fwd_desc, attr, onednn_engine);
+      ConvBwdInputPd bwd_input_pd =
+          ConvBwdInputPd(bwd_input_desc, attr, onednn_engine, fwd_pd);
+      ConvBwdFilterPd bwd_filter_pd =
+          ConvBwdFilterPd(bwd_filter_desc, attr, onednn_engine, fwd_pd);
+
+      // Both primitives run in order on the same stream, so they can share
+      // the scratchpad.
+      Tensor scratchpad_tensor;
+      int64 scratchpad_size =
+          std::max(bwd_input_pd.scratchpad_desc().get_size(),
+                   bwd_filter_pd.scratchpad_desc().get_size()) /
+          sizeof(T);
+      OP_REQUIRES_OK(context,
+                     context->allocate_temp(DataTypeToEnum<T>::v(),
+                                            TensorShape({scratchpad_size}),
+                                            &scratchpad_tensor));
+      auto input_scratchpad_mem =
+          dnnl::memory(bwd_input_pd.scratchpad_desc(), onednn_engine,
+                       GetTensorBuffer<T>(&scratchpad_tensor));
+      auto filter_scratchpad_mem =
+          dnnl::memory(bwd_filter_pd.scratchpad_desc(), onednn_engine,
+                       GetTensorBuffer<T>(&scratchpad_tensor));
+
+      auto src_mem = CreateDnnlMemory(src_md, onednn_engine,
+                                      GetTensorBuffer<T>(&src_tensor));
+      auto diff_dst_mem = CreateDnnlMemory(
+          diff_dst_md, onednn_engine, GetTensorBuffer<T>(&diff_dst_tensor));
+      auto diff_src_mem = CreateDnnlMemory(src_md, onednn_engine,
+                                           GetTensorBuffer<T>(diff_src_tensor));
+
+      // reorder src/diff_dst to NHWC if needed, diff_dst only once for both
+      // primitives.
+      memory src_mem_opt = src_mem, diff_dst_mem_opt = diff_dst_mem,
+             diff_src_mem_opt = diff_src_mem;
+      // keep tensor out of if block to avoid of being deallocated
+      Tensor src_tensor_opt, diff_dst_tensor_opt, diff_src_tensor_opt;
+      if (data_layout != format_tag_opt) {
+        OP_REQUIRES_OK(context, context->allocate_temp(DataTypeToEnum<T>::v(),
+                                                       src_shape,
+                                                       &src_tensor_opt));
+        src_mem_opt = CreateDnnlMemory(src_md_opt, onednn_engine,
+                                       GetTensorBuffer<T>(&src_tensor_opt));
+        ReorderMemory(*context, &src_mem, &src_mem_opt, onednn_engine);
+
+        OP_REQUIRES_OK(
+            context, context->allocate_temp(DataTypeToEnum<T>::v(),
+                                            diff_dst_tensor.shape(),
+                                            &diff_dst_tensor_opt));
+        diff_dst_mem_opt =
+            CreateDnnlMemory(diff_dst_md_opt, onednn_engine,
+                             GetTensorBuffer<T>(&diff_dst_tensor_opt));
+        ReorderMemory(*context, &diff_dst_mem, &diff_dst_mem_opt,
+                      onednn_engine);
+
+        OP_REQUIRES_OK(context, context->allocate_temp(DataTypeToEnum<T>::v(),
+                                                       src_shape,
+                                                       &diff_src_tensor_opt));
+        diff_src_mem_opt =
+            CreateDnnlMemory(src_md_opt, onednn_engine,
+                             GetTensorBuffer<T>(&diff_src_tensor_opt));
+      }
+
+      // Check filter reorder
+      Tensor tmp_weight;
+      auto filter_mem = CreateDnnlMemory(filter_md, onednn_engine,
+                                         GetTensorBuffer<T>(&filter_tensor));
+      memory filter_mem_reordered = filter_mem;
+      if (bwd_input_pd.weights_desc() != filter_md) {
+        int64 reorder_filter_data_size =
+            bwd_input_pd.weights_desc().get_size() / sizeof(T);
+        OP_REQUIRES_OK(context, context->allocate_temp(
+                                    DataTypeToEnum<T>::v(),
+                                    TensorShape({reorder_filter_data_size}),
+                                    &tmp_weight));
+        filter_mem_reordered =
+            CreateDnnlMemory(bwd_input_pd.weights_desc(), onednn_engine,
+                             GetTensorBuffer<T>(&tmp_weight));
+        ReorderMemory(*context, &filter_mem, &filter_mem_reordered,
+                      onednn_engine);
+      }
+
+      // Check diff filter reorder
+      Tensor tmp_diff_weight;
+      auto diff_filter_mem =
+          CreateDnnlMemory(filter_md, onednn_engine,
+                           GetTensorBuffer<T>(diff_filter_tensor));
+      memory diff_filter_mem_reordered = diff_filter_mem;
+      bool is_diff_filter_reordered =
+          (bwd_filter_pd.diff_weights_desc() != filter_md);
+      if (is_diff_filter_reordered) {
+        int64 reorder_diff_filter_data_size =
+            bwd_filter_pd.diff_weights_desc().get_size() / sizeof(T);
+        OP_REQUIRES_OK(
+            context,
+            context->allocate_temp(DataTypeToEnum<T>::v(),
+                                   TensorShape({reorder_diff_filter_data_size}),
+                                   &tmp_diff_weight));
+        diff_filter_mem_reordered =
+            CreateDnnlMemory(bwd_filter_pd.diff_weights_desc(), onednn_engine,
+                             GetTensorBuffer<T>(&tmp_diff_weight));
+      }
+
+      std::unordered_map<int, memory> bwd_input_primitive_args = {
+          {DNNL_ARG_WEIGHTS, filter_mem_reordered},
+          {DNNL_ARG_DIFF_DST, diff_dst_mem_opt},
+          {DNNL_ARG_DIFF_SRC, diff_src_mem_opt},
+          {DNNL_ARG_SCRATCHPAD, input_scratchpad_mem}};
+      primitive bwd_input_primitive = ConvBwdInputPrimitive(bwd_input_pd);
+      bwd_input_primitive.execute(onednn_stream, bwd_input_primitive_args);
+
+      std::unordered_map<int, memory> bwd_filter_primitive_args = {
+          {DNNL_ARG_SRC, src_mem_opt},
+          {DNNL_ARG_DIFF_DST, diff_dst_mem_opt},
+          {DNNL_ARG_DIFF_WEIGHTS, diff_filter_mem_reordered},
+          {DNNL_ARG_SCRATCHPAD, filter_scratchpad_mem}};
+      primitive bwd_filter_primitive = ConvBwdFilterPrimitive(bwd_filter_pd);
+      bwd_filter_primitive.execute(onednn_stream, bwd_filter_primitive_args);
+
+      // reorder back if needed
+      if (data_layout != format_tag_opt) {
+        ReorderMemory(*context, &diff_src_mem_opt, &diff_src_mem,
+                      onednn_engine);
+      }
+      if (is_diff_filter_reordered) {
+        ReorderMemory(*context, &diff_filter_mem_reordered, &diff_filter_mem,
+                      onednn_engine);
+      }
+    } catch (dnnl::error& e) {
+      string error_msg = "Status: " + std::to_string(e.status) +
+                         ", message: " + string(e.message) + ", in file " +
+                         string(__FILE__) + ":" + std::to_string(__LINE__);
+      OP_REQUIRES_OK(
+          context,
+          errors::Aborted("Operation received an exception:", error_msg));
+    }
+  }
+
+ private:
+  TensorFormat data_format_;
+  std::vector<int32> strides_;
+  std::vector<int32> dilations_;
+  Padding padding_;
+  std::vector<int64_t> explicit_paddings_;
+  dnnl::fpmath_mode fp32_math_mode_ = dnnl::fpmath_mode::strict;
+};
+
+#define REGISTER_KERNEL(T)                                           \
+  REGISTER_KERNEL_BUILDER(                                           \
+      Name("_ITEXFusedBatchNormGradWithConv2DBackprop")              \
+          .Device(DEVICE_CPU)                                        \
+          .TypeConstraint<T>("T")                                    \
+          .TypeConstraint<float>("U"),                               \
+      FusedBatchNormGradWithConv2DBackpropOp<CPUDevice, T, float>)
+
+REGISTER_KERNEL(float);
+REGISTER_KERNEL(Eigen::bfloat16);
+#undef REGISTER_KERNEL
+
+}  // namespace itex
@@ -0,0 +1,283 @@
+/* Copyright (c) 2022 Intel Corporation
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <vector>
+
+#include "itex/core/utils/errors.h"
+#include "itex/core/utils/op_kernel.h"
+#include "itex/core/utils/op_requires.h"
+#include "itex/core/utils/plugin_tensor.h"
+#include "itex/core/utils/register_types.h"
+#include "itex/core/utils/tensor_shape.h"
+#include "itex/core/utils/types.h"
+#include "third_party/eigen3/Eigen/Core"
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+
+namespace itex {
+
+// Sliding-window attention with global tokens over [batch, heads, seq_len,
+// head_size] query/key/value, as used by Longformer/BigBird-style models.
+// Token i attends to token j if |i - j| <= window_size or if either of them
+// is global, so the work is proportional to seq_len * (2 * window_size +
+// num_global) instead of seq_len^2, and no [seq_len, seq_len] score or mask
+// is materialized.
+//
+// Work is split into (batch, head, query block) tasks. The rows of a block
+// share most of their band, so the block computes its scores against the
+// keys in [first_row - window_size, last_row + window_size] and the global
+// keys as one small GEMM, masks the pairs out of each row's band, and
+// multiplies the probabilities with the values as a second GEMM. Global rows
+// attend to the whole sequence.
+template <typename Device, typename T>
+class LocalAttentionOp : public OpKernel {
+ public:
+  explicit LocalAttentionOp(OpKernelConstruction* context)
+      : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("window_size", &window_size_));
+    OP_REQUIRES_OK(context, context->GetAttr("scale", &scale_));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& query = context->input(0);
+    const Tensor& key = context->input(1);
+    const Tensor& value = context->input(2);
+    const Tensor& global_mask = context->input(3);
+    OP_REQUIRES(context, query.dims() == 4,
+                errors::InvalidArgument(
+                    "query must be 4-D [batch, heads, seq_len, head_size], "
+                    "got ",
+                    query.shape().DebugString()));
+    OP_REQUIRES(context,
+                key.shape() == query.shape() && value.shape() == query.shape(),
+                errors::InvalidArgument(
+                    "key and value must have the shape of query ",
+                    query.shape().DebugString(), ", got ",
+                    key.shape().DebugString(), " and ",
+                    value.shape().DebugString()));
+
+    const int64 batch = query.dim_size(0);
+    const int64 heads = query.dim_size(1);
+    const int64 seq_len = query.dim_size(2);
+    const int64 head_size = query.dim_size(3);
+    const bool is_valid_mask =
+        (global_mask.dims() == 1 && global_mask.dim_size(0) == seq_len) ||
+        (global_mask.dims() == 2 &&
+         (global_mask.dim_size(0) == batch || global_mask.dim_size(0) == 1) &&
+         global_mask.dim_size(1) == seq_len);
+    OP_REQUIRES(context, is_valid_mask,
+                errors::InvalidArgument(
+                    "global_mask must be [seq_len] or [batch, seq_len] with "
+                    "seq_len ",
+                    seq_len, ", got ", global_mask.shape().DebugString()));
+
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context,
+                   context->allocate_output(0, query.shape(), &output));
+    if (output->NumElements() == 0) return;
+
+    // Global tokens of each batch, in ascending order.
+    const bool is_mask_broadcast =
+        global_mask.dims() == 1 || global_mask.dim_size(0) == 1;
+    auto mask = global_mask.flat<bool>();
+    std::vector<std::vector<int64>> globals(is_mask_broadcast ? 1 : batch);
+    std::vector<uint8> is_global(globals.size() * seq_len);
+    int64 max_globals = 0;
+    for (size_t b = 0; b < globals.size(); ++b) {
+      for (int64 j = 0; j < seq_len; ++j) {
+        if (mask(b * seq_len + j)) {
+          globals[b].push_back(j);
+          is_global[b * seq_len + j] = true;
+        }
+      }
+      max_globals = std::max(max_globals,
+                             static_cast<int64>(globals[b].size()));
+    }
+
+    const float scale =
+        scale_ != 0.f ? scale_ : 1.f / std::sqrt(static_cast<float>(head_size));
+    const int64 window = std::min(window_size_, seq_len);
+    const int64 kRowsPerBlock = 32;
+    const int64 num_blocks = (seq_len + kRowsPerBlock - 1) / kRowsPerBlock;
+    const int64 num_tasks = batch * heads * num_blocks;
+    // The local rows of a block attend to the union of their bands and the
+    // global keys. A block has about max_globals * kRowsPerBlock / seq_len
+    // global rows, each of them attends to seq_len keys.
+    const double keys_per_row =
+        std::min(seq_len, kRowsPerBlock + 2 * window + max_globals) +
+        max_globals;
+    const double task_cost = kRowsPerBlock * keys_per_row * head_size * 4;
+
+    const T* q = query.flat<T>().data();
+    const T* k = key.flat<T>().data();
+    const T* v = value.flat<T>().data();
+    T* dst = output->flat<T>().data();
+    const Eigen::ThreadPoolDevice& d = context->eigen_cpu_device();
+    d.parallelFor(
+        num_tasks, Eigen::TensorOpCost(0, 0, task_cost),
+        [&](Eigen::Index first, Eigen::Index last) {
+          BlockBuffers buffers(kRowsPerBlock, seq_len, head_size);
+          std::vector<int64> local_rows, global_rows;
+          std::vector<int64> band_keys, all_keys(seq_len);
+          for (int64 j = 0; j < seq_len; ++j) all_keys[j] = j;
+          for (Eigen::Index task = first; task < last; ++task) {
+            const int64 block = task % num_blocks;
+            const int64 bh = task / num_blocks;
+            const int64 b = bh / heads;
+            const int64 mask_b = is_mask_broadcast ? 0 : b;
+            const uint8* is_global_b = is_global.data() + mask_b * seq_len;
+            const int64 offset = bh * seq_len * head_size;
+            Head head = {q + offset, k + offset, v + offset, dst + offset};
+
+            const int64 row_begin = block * kRowsPerBlock;
+            const int64 row_end = std::min(seq_len, row_begin + kRowsPerBlock);
+            local_rows.clear();
+            global_rows.clear();
+            for (int64 row = row_begin; row < row_end; ++row) {
+              (is_global_b[row] ? global_rows : local_rows).push_back(row);
+            }
+
+            // Local rows attend to the union of their bands and the global
+            // keys out of it, keys out of a row's own band are masked.
+            if (!local_rows.empty()) {
+              const int64 band_begin =
+                  std::max<int64>(0, local_rows.front() - window);
+              const int64 band_end =
+                  std::min(seq_len, local_rows.back() + window + 1);
+              band_keys.clear();
+              for (int64 j = band_begin; j < band_end; ++j) {
+                band_keys.push_back(j);
+              }
+              for (int64 j : globals[mask_b]) {
+                if (j < band_begin || j >= band_end) band_keys.push_back(j);
+              }
+              Attend(head, local_rows, band_keys, scale, head_size,
+                     [&](int64 row, int64 key) {
+                       return std::abs(row - key) <= window ||
+                              is_global_b[key];
+                     },
+                     &buffers);
+            }
+            // Global rows attend to the whole sequence.
+            if (!global_rows.empty()) {
+              Attend(head, global_rows, all_keys, scale, head_size,
+                     [](int64, int64) { return true; }, &buffers);
+            }
+          }
+        });
+  }
+
+ private:
+  using Matrix =
+      Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+  using MatrixMap = Eigen::Map<Matrix>;
+
+  struct Head {
+    const T* query;
+    const T* key;
+    const T* value;
+    T* output;
+  };
+
+  // Per-thread fp32 copies of the rows of a block and of the keys and values
+  // they attend to.
+  struct BlockBuffers {
+    BlockBuffers(int64 max_rows, int64 max_keys, int64 head_size)
+        : query(max_rows * head_size),
+          key(max_keys * head_size),
+          value(max_keys * head_size),
+          scores(max_rows * max_keys),
+          output(max_rows * head_size) {}
+
+    std::vector<float> query, key, value, scores, output;
+  };
+
+  // Attention of `rows` over `keys` as two GEMMs, the scores of pairs for
+  // which `is_allowed(row, key)` is false are masked before softmax.
+  template <typename IsAllowed>
+  static void Attend(const Head& head, const std::vector<int64>& rows,
+                     const std::vector<int64>& keys, float scale,
+                     int64 head_size, IsAllowed is_allowed,
+                     BlockBuffers* buffers) {
+    const int64 num_rows = rows.size();
+    const int64 num_keys = keys.size();
+    for (int64 r = 0; r < num_rows; ++r) {
+      const T* src = head.query + rows[r] * head_size;
+      float* q_row = buffers->query.data() + r * head_size;
+      for (int64 i = 0; i < head_size; ++i) {
+        q_row[i] = static_cast<float>(src[i]) * scale;
+      }
+    }
+    for (int64 n = 0; n < num_keys; ++n) {
+      const T* k_src = head.key + keys[n] * head_size;
+      const T* v_src = head.value + keys[n] * head_size;
+      float* k_row = buffers->key.data() + n * head_size;
+      float* v_row = buffers->value.data() + n * head_size;
+      for (int64 i = 0; i < head_size; ++i) {
+        k_row[i] = static_cast<float>(k_src[i]);
+        v_row[i] = static_cast<float>(v_src[i]);
+      }
+    }
+
+    MatrixMap q_mat(buffers->query.data(), num_rows, head_size);
+    MatrixMap k_mat(buffers->key.data(), num_keys, head_size);
+    MatrixMap v_mat(buffers->value.data(), num_keys, head_size);
+    MatrixMap scores(buffers->scores.data(), num_rows, num_keys);
+    MatrixMap out_mat(buffers->output.data(), num_rows, head_size);
+    scores.noalias() = q_mat * k_mat.transpose();
+
+    for (int64 r = 0; r < num_rows; ++r) {
+      float* score_row = scores.row(r).data();
+      float max_score = -std::numeric_limits<float>::infinity();
+      for (int64 n = 0; n < num_keys; ++n) {
+        if (!is_allowed(rows[r], keys[n])) {
+          score_row[n] = -std::numeric_limits<float>::infinity();
+        }
+        max_score = std::max(max_score, score_row[n]);
+      }
+      // A row always attends to itself, so `max_score` is finite.
+      float sum = 0.f;
+      for (int64 n = 0; n < num_keys; ++n) {
+        score_row[n] = std::exp(score_row[n] - max_score);
+        sum += score_row[n];
+      }
+      const float inv_sum = 1.f / sum;
+      for (int64 n = 0; n < num_keys; ++n) score_row[n] *= inv_sum;
+    }
+    out_mat.noalias() = scores * v_mat;
+
+    for (int64 r = 0; r < num_rows; ++r) {
+      T* dst = head.output + rows[r] * head_size;
+      const float* out_row = buffers->output.data() + r * head_size;
+      for (int64 i = 0; i < head_size; ++i) dst[i] = static_cast<T>(out_row[i]);
+    }
+  }
+
+  int64 window_size_;
+  float scale_;
+};
+
+#define REGISTER_CPU_LOCAL_ATTENTION(T)                                      \
+  REGISTER_KERNEL_BUILDER(                                                   \
+      Name("_ITEXLocalAttention").Device(DEVICE_CPU).TypeConstraint<T>("T"), \
+      LocalAttentionOp<CPUDevice, T>);
+
+TF_CALL_CPU_NUMBER_TYPES(REGISTER_CPU_LOCAL_ATTENTION);
+#undef REGISTER_CPU_LOCAL_ATTENTION
+
+}  // namespace itex
@@ -40,6 +40,15 @@ namespace itex {
 TF_CALL_CPU_NUMBER_TYPES(REGISTER_MATMUL_CPU);
 #undef REGISTER_MATMUL_CPU
 
+#define REGISTER_MATMUL_LAYERNORM_CPU(TYPE)                                 \
+  REGISTER_KERNEL_BUILDER(Name("_ITEXFusedMatMulWithSumAndLayerNorm")       \
+                              .Device(DEVICE_CPU)                           \
+                              .TypeConstraint<TYPE>("T")                    \
+                              .TypeConstraint<float>("U"),                  \
+                          FusedMatMulWithSumAndLayerNormOp<CPUDevice, TYPE>);
+TF_CALL_CPU_NUMBER_TYPES(REGISTER_MATMUL_LAYERNORM_CPU);
+#undef REGISTER_MATMUL_LAYERNORM_CPU
+
 #define REGISTER_BF32MATMUL_CPU(TYPE)                               \
   REGISTER_KERNEL_BUILDER(Name("_ITEXAccMatMul")                    \
                               .Device(DEVICE_CPU)                   \
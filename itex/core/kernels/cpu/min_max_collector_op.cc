@@ -0,0 +1,59 @@
+/* Copyright (c) 2022 Intel Corporation
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <string>
+
+#include "itex/core/utils/calibration_stats.h"
+#include "itex/core/utils/op_kernel.h"
+#include "itex/core/utils/op_requires.h"
+#include "itex/core/utils/plugin_tensor.h"
+#include "itex/core/utils/types.h"
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+
+namespace itex {
+
+// Inserted by INT8 calibration in collect mode. Forwards its input and widens
+// the range recorded for `key` with the min/max of this run.
+template <typename Device>
+class MinMaxCollectorOp : public OpKernel {
+ public:
+  explicit MinMaxCollectorOp(OpKernelConstruction* context)
+      : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("key", &key_));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& input = context->input(0);
+    context->set_output(0, input);
+    if (input.NumElements() == 0) return;
+
+    auto x = input.flat<float>();
+    Eigen::Tensor<float, 0, Eigen::RowMajor> x_min, x_max;
+    const Device& d = context->eigen_device<Device>();
+    x_min.device(d) = x.minimum();
+    x_max.device(d) = x.maximum();
+    CalibrationStats::Global()->Update(key_, x_min(), x_max());
+  }
+
+ private:
+  std::string key_;
+};
+
+REGISTER_KERNEL_BUILDER(Name("_ITEXMinMaxCollector")
+                            .Device(DEVICE_CPU)
+                            .TypeConstraint<float>("T"),
+                        MinMaxCollectorOp<CPUDevice>);
+
+}  // namespace itex
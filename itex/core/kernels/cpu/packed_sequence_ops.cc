@@ -0,0 +1,391 @@
+/* Copyright (c) 2022 Intel Corporation
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include "itex/core/utils/errors.h"
+#include "itex/core/utils/op_kernel.h"
+#include "itex/core/utils/op_requires.h"
+#include "itex/core/utils/plugin_tensor.h"
+#include "itex/core/utils/register_types.h"
+#include "itex/core/utils/tensor_shape.h"
+#include "itex/core/utils/types.h"
+#include "third_party/eigen3/Eigen/Core"
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+
+namespace itex {
+
+// Packed sequences keep only the valid tokens of a padded [batch, max_len,
+// ...] batch, back to back, as [total_tokens, ...]. `cu_seqlens` of shape
+// [batch + 1] holds the cumulative lengths, so sequence b owns tokens
+// [cu_seqlens[b], cu_seqlens[b + 1]). Token-wise ops such as MatMul,
+// LayerNorm and activations run on the packed tensor as is and skip the
+// padding; only attention needs the sequence boundaries.
+
+namespace {
+
+// Checks `cu_seqlens` is a non-decreasing [batch + 1] vector starting at 0
+// and ending at `total_tokens`.
+Status ValidateCuSeqlens(const Tensor& cu_seqlens, int64 total_tokens) {
+  if (!TensorShapeUtils::IsVector(cu_seqlens.shape()) ||
+      cu_seqlens.NumElements() < 1) {
+    return errors::InvalidArgument(
+        "cu_seqlens must be a non-empty vector, got shape ",
+        cu_seqlens.shape().DebugString());
+  }
+  auto cu = cu_seqlens.flat<int32>();
+  if (cu(0) != 0 || cu(cu.size() - 1) != total_tokens) {
+    return errors::InvalidArgument("cu_seqlens must start at 0 and end at ",
+                                   total_tokens, ", got ", cu(0), " and ",
+                                   cu(cu.size() - 1));
+  }
+  for (int64 b = 1; b < cu.size(); ++b) {
+    if (cu(b) < cu(b - 1)) {
+      return errors::InvalidArgument(
+          "cu_seqlens must be non-decreasing, got ", cu(b - 1), " then ",
+          cu(b), " at index ", b);
+    }
+  }
+  return Status::OK();
+}
+
+}  // namespace
+
+template <typename Device, typename T>
+class PackSequencesOp : public OpKernel {
+ public:
+  explicit PackSequencesOp(OpKernelConstruction* context)
+      : OpKernel(context) {}
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& padded = context->input(0);
+    const Tensor& lengths = context->input(1);
+    OP_REQUIRES(context, padded.dims() >= 2,
+                errors::InvalidArgument(
+                    "padded must be at least 2-D [batch, max_len, ...], got ",
+                    padded.shape().DebugString()));
+    const int64 batch = padded.dim_size(0);
+    const int64 max_len = padded.dim_size(1);
+    OP_REQUIRES(
+        context,
+        TensorShapeUtils::IsVector(lengths.shape()) &&
+            lengths.NumElements() == batch,
+        errors::InvalidArgument("lengths must be a vector of ", batch,
+                                " elements, got shape ",
+                                lengths.shape().DebugString()));
+
+    Tensor* cu_seqlens = nullptr;
+    OP_REQUIRES_OK(context,
+                   context->allocate_output(1, TensorShape({batch + 1}),
+                                            &cu_seqlens));
+    auto len = lengths.flat<int32>();
+    auto cu = cu_seqlens->flat<int32>();
+    cu(0) = 0;
+    for (int64 b = 0; b < batch; ++b) {
+      OP_REQUIRES(context, len(b) >= 0 && len(b) <= max_len,
+                  errors::InvalidArgument("lengths[", b, "] = ", len(b),
+                                          " is out of range [0, ", max_len,
+                                          "]"));
+      cu(b + 1) = cu(b) + len(b);
+    }
+
+    TensorShape packed_shape = padded.shape();
+    packed_shape.RemoveDim(0);
+    packed_shape.set_dim(0, cu(batch));
+    Tensor* packed = nullptr;
+    OP_REQUIRES_OK(context,
+                   context->allocate_output(0, packed_shape, &packed));
+    if (packed->NumElements() == 0) return;
+
+    // Each sequence is one contiguous copy of its valid tokens.
+    const int64 token_size = padded.NumElements() / (batch * max_len);
+    const T* src = padded.flat<T>().data();
+    T* dst = packed->flat<T>().data();
+    const Eigen::ThreadPoolDevice& d = context->eigen_cpu_device();
+    d.parallelFor(batch,
+                  Eigen::TensorOpCost(max_len * token_size * sizeof(T),
+                                      max_len * token_size * sizeof(T), 0),
+                  [&](Eigen::Index first, Eigen::Index last) {
+                    for (Eigen::Index b = first; b < last; ++b) {
+                      std::memcpy(dst + cu(b) * token_size,
+                                  src + b * max_len * token_size,
+                                  len(b) * token_size * sizeof(T));
+                    }
+                  });
+  }
+};
+
+template <typename Device, typename T>
+class UnpackSequencesOp : public OpKernel {
+ public:
+  explicit UnpackSequencesOp(OpKernelConstruction* context)
+      : OpKernel(context) {}
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& packed = context->input(0);
+    const Tensor& cu_seqlens = context->input(1);
+    const Tensor& max_seq_len = context->input(2);
+    OP_REQUIRES(context, packed.dims() >= 1,
+                errors::InvalidArgument(
+                    "packed must be at least 1-D [total_tokens, ...], got ",
+                    packed.shape().DebugString()));
+    OP_REQUIRES(context, TensorShapeUtils::IsScalar(max_seq_len.shape()),
+                errors::InvalidArgument("max_seq_len must be a scalar, got ",
+                                        max_seq_len.shape().DebugString()));
+    OP_REQUIRES_OK(context, ValidateCuSeqlens(cu_seqlens, packed.dim_size(0)));
+
+    auto cu = cu_seqlens.flat<int32>();
+    const int64 batch = cu.size() - 1;
+    const int64 max_len = max_seq_len.scalar<int32>()();
+    OP_REQUIRES(context, max_len >= 0,
+                errors::InvalidArgument("max_seq_len must be non-negative, ",
+                                        "got ", max_len));
+    for (int64 b = 0; b < batch; ++b) {
+      OP_REQUIRES(context, cu(b + 1) - cu(b) <= max_len,
+                  errors::InvalidArgument("Sequence ", b, " has ",
+                                          cu(b + 1) - cu(b),
+                                          " tokens, more than max_seq_len ",
+                                          max_len));
+    }
+
+    TensorShape padded_shape = packed.shape();
+    padded_shape.set_dim(0, max_len);
+    padded_shape.InsertDim(0, batch);
+    Tensor* padded = nullptr;
+    OP_REQUIRES_OK(context,
+                   context->allocate_output(0, padded_shape, &padded));
+    if (padded->NumElements() == 0) return;
+
+    const int64 token_size = padded->NumElements() / (batch * max_len);
+    const T* src = packed.flat<T>().data();
+    T* dst = padded->flat<T>().data();
+    const Eigen::ThreadPoolDevice& d = context->eigen_cpu_device();
+    d.parallelFor(batch,
+                  Eigen::TensorOpCost(max_len * token_size * sizeof(T),
+                                      max_len * token_size * sizeof(T), 0),
+                  [&](Eigen::Index first, Eigen::Index last) {
+                    for (Eigen::Index b = first; b < last; ++b) {
+                      const int64 valid = (cu(b + 1) - cu(b)) * token_size;
+                      T* row = dst + b * max_len * token_size;
+                      std::memcpy(row, src + cu(b) * token_size,
+                                  valid * sizeof(T));
+                      std::fill(row + valid, row + max_len * token_size,
+                                T(0));
+                    }
+                  });
+  }
+};
+
+// Attention over packed [total_tokens, heads, head_size] query/key/value.
+// Each token only attends to the tokens of its own sequence, so no mask or
+// padding is materialized and the work is proportional to the sum of the
+// squared sequence lengths instead of batch * max_len^2.
+//
+// Work is split into (query block, head) tasks. A task copies its rows and
+// the keys and values of its sequence as fp32, computes the scores as one
+// small GEMM, a float softmax, and multiplies the probabilities with the
+// values as a second GEMM. With `causal`, the keys after the last row of the
+// block are skipped and the ones after each row are masked.
+template <typename Device, typename T>
+class VarlenAttentionOp : public OpKernel {
+ public:
+  explicit VarlenAttentionOp(OpKernelConstruction* context)
+      : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("scale", &scale_));
+    OP_REQUIRES_OK(context, context->GetAttr("causal", &causal_));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& query = context->input(0);
+    const Tensor& key = context->input(1);
+    const Tensor& value = context->input(2);
+    const Tensor& cu_seqlens = context->input(3);
+    OP_REQUIRES(context, query.dims() == 3,
+                errors::InvalidArgument(
+                    "query must be 3-D [total_tokens, heads, head_size], "
+                    "got ",
+                    query.shape().DebugString()));
+    OP_REQUIRES(context,
+                key.shape() == query.shape() && value.shape() == query.shape(),
+                errors::InvalidArgument(
+                    "key and value must have the shape of query ",
+                    query.shape().DebugString(), ", got ",
+                    key.shape().DebugString(), " and ",
+                    value.shape().DebugString()));
+    OP_REQUIRES_OK(context, ValidateCuSeqlens(cu_seqlens, query.dim_size(0)));
+
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context,
+                   context->allocate_output(0, query.shape(), &output));
+    if (output->NumElements() == 0) return;
+
+    const int64 heads = query.dim_size(1);
+    const int64 head_size = query.dim_size(2);
+    const float scale =
+        scale_ != 0.f ? scale_ : 1.f / std::sqrt(static_cast<float>(head_size));
+
+    // Blocks of query rows, (sequence, first row), so that long sequences
+    // are spread over threads.
+    const int64 kRowsPerBlock = 128;
+    auto cu = cu_seqlens.flat<int32>();
+    std::vector<std::pair<int64, int64>> blocks;
+    int64 max_len = 0;
+    double work = 0;
+    for (int64 b = 0; b + 1 < cu.size(); ++b) {
+      const int64 len = cu(b + 1) - cu(b);
+      max_len = std::max(max_len, len);
+      work += static_cast<double>(len) * len;
+      for (int64 row = cu(b); row < cu(b + 1); row += kRowsPerBlock) {
+        blocks.emplace_back(b, row);
+      }
+    }
+    if (blocks.empty()) return;
+
+    Head head = {query.flat<T>().data(), key.flat<T>().data(),
+                 value.flat<T>().data(), output->flat<T>().data(),
+                 heads * head_size, head_size};
+    const int64 num_tasks = blocks.size() * heads;
+    const double task_cost =
+        work / blocks.size() * head_size * 4 + max_len * head_size * 2;
+    const Eigen::ThreadPoolDevice& d = context->eigen_cpu_device();
+    d.parallelFor(
+        num_tasks, Eigen::TensorOpCost(0, 0, task_cost),
+        [&](Eigen::Index first, Eigen::Index last) {
+          BlockBuffers buffers(kRowsPerBlock, max_len, head_size);
+          for (Eigen::Index task = first; task < last; ++task) {
+            const int64 b = blocks[task / heads].first;
+            const int64 row_begin = blocks[task / heads].second;
+            const int64 h = task % heads;
+            const int64 row_end =
+                std::min<int64>(cu(b + 1), row_begin + kRowsPerBlock);
+            const int64 key_end = causal_ ? row_end : cu(b + 1);
+            Attend(head, h, row_begin, row_end, cu(b), key_end, scale,
+                   causal_, &buffers);
+          }
+        });
+  }
+
+ private:
+  using Matrix =
+      Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+  using MatrixMap = Eigen::Map<Matrix>;
+
+  struct Head {
+    const T* query;
+    const T* key;
+    const T* value;
+    T* output;
+    // Elements between two tokens and of one head.
+    int64 stride;
+    int64 head_size;
+  };
+
+  // Per-thread fp32 copies of the rows of a block and of the keys and values
+  // of its sequence.
+  struct BlockBuffers {
+    BlockBuffers(int64 max_rows, int64 max_keys, int64 head_size)
+        : query(max_rows * head_size),
+          key(max_keys * head_size),
+          value(max_keys * head_size),
+          scores(max_rows * max_keys),
+          output(max_rows * head_size) {}
+
+    std::vector<float> query, key, value, scores, output;
+  };
+
+  // Attention of rows [row_begin, row_end) over keys [key_begin, key_end) of
+  // head `h` as two GEMMs.
+  static void Attend(const Head& head, int64 h, int64 row_begin,
+                     int64 row_end, int64 key_begin, int64 key_end,
+                     float scale, bool causal, BlockBuffers* buffers) {
+    const int64 head_size = head.head_size;
+    const int64 num_rows = row_end - row_begin;
+    const int64 num_keys = key_end - key_begin;
+    for (int64 r = 0; r < num_rows; ++r) {
+      const T* src = head.query + (row_begin + r) * head.stride + h * head_size;
+      float* q_row = buffers->query.data() + r * head_size;
+      for (int64 i = 0; i < head_size; ++i) {
+        q_row[i] = static_cast<float>(src[i]) * scale;
+      }
+    }
+    for (int64 n = 0; n < num_keys; ++n) {
+      const int64 offset = (key_begin + n) * head.stride + h * head_size;
+      float* k_row = buffers->key.data() + n * head_size;
+      float* v_row = buffers->value.data() + n * head_size;
+      for (int64 i = 0; i < head_size; ++i) {
+        k_row[i] = static_cast<float>(head.key[offset + i]);
+        v_row[i] = static_cast<float>(head.value[offset + i]);
+      }
+    }
+
+    MatrixMap q_mat(buffers->query.data(), num_rows, head_size);
+    MatrixMap k_mat(buffers->key.data(), num_keys, head_size);
+    MatrixMap v_mat(buffers->value.data(), num_keys, head_size);
+    MatrixMap scores(buffers->scores.data(), num_rows, num_keys);
+    MatrixMap out_mat(buffers->output.data(), num_rows, head_size);
+    scores.noalias() = q_mat * k_mat.transpose();
+
+    for (int64 r = 0; r < num_rows; ++r) {
+      float* score_row = scores.row(r).data();
+      // With `causal`, row r only attends to the keys up to itself.
+      const int64 valid_keys =
+          causal ? row_begin + r - key_begin + 1 : num_keys;
+      // Vectorized by Eigen, exp is as costly as the GEMMs otherwise.
+      Eigen::Map<Eigen::ArrayXf> probs(score_row, valid_keys);
+      probs = (probs - probs.maxCoeff()).exp();
+      probs *= 1.f / probs.sum();
+      std::fill(score_row + valid_keys, score_row + num_keys, 0.f);
+    }
+    out_mat.noalias() = scores * v_mat;
+
+    for (int64 r = 0; r < num_rows; ++r) {
+      T* dst = head.output + (row_begin + r) * head.stride + h * head_size;
+      const float* out_row = buffers->output.data() + r * head_size;
+      for (int64 i = 0; i < head_size; ++i) dst[i] = static_cast<T>(out_row[i]);
+    }
+  }
+
+  float scale_;
+  bool causal_;
+};
+
+#define REGISTER_CPU_PACK_SEQUENCES(T)                                     \
+  REGISTER_KERNEL_BUILDER(                                                 \
+      Name("ItexPackSequences").Device(DEVICE_CPU).TypeConstraint<T>("T"), \
+      PackSequencesOp<CPUDevice, T>);                                      \
+  REGISTER_KERNEL_BUILDER(Name("ItexUnpackSequences")                      \
+                              .Device(DEVICE_CPU)                          \
+                              .TypeConstraint<T>("T"),                     \
+                          UnpackSequencesOp<CPUDevice, T>);
+
+TF_CALL_CPU_NUMBER_TYPES(REGISTER_CPU_PACK_SEQUENCES);
+TF_CALL_half(REGISTER_CPU_PACK_SEQUENCES);
+TF_CALL_int32(REGISTER_CPU_PACK_SEQUENCES);
+TF_CALL_int64(REGISTER_CPU_PACK_SEQUENCES);
+#undef REGISTER_CPU_PACK_SEQUENCES
+
+#define REGISTER_CPU_VARLEN_ATTENTION(T)                                     \
+  REGISTER_KERNEL_BUILDER(                                                   \
+      Name("ItexVarlenAttention").Device(DEVICE_CPU).TypeConstraint<T>("T"), \
+      VarlenAttentionOp<CPUDevice, T>);
+
+TF_CALL_CPU_NUMBER_TYPES(REGISTER_CPU_VARLEN_ATTENTION);
+#undef REGISTER_CPU_VARLEN_ATTENTION
+
+}  // namespace itex
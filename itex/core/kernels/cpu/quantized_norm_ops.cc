@@ -0,0 +1,40 @@
+/* Copyright (c) 2022 Intel Corporation
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "itex/core/kernels/common/quantized_norm_ops.h"
+
+namespace itex {
+
+#define REGISTER_KERNEL(src_type, dst_type)                 \
+  REGISTER_KERNEL_BUILDER(                                  \
+      Name("_ITEXQuantizedSoftmax")                         \
+          .Device(DEVICE_CPU)                               \
+          .TypeConstraint<src_type>("T")                    \
+          .TypeConstraint<dst_type>("out_type"),            \
+      QuantizedSoftmaxOp<CPUDevice, src_type, dst_type>);   \
+  REGISTER_KERNEL_BUILDER(                                  \
+      Name("_ITEXQuantizedLayerNorm")                       \
+          .Device(DEVICE_CPU)                               \
+          .TypeConstraint<src_type>("T")                    \
+          .TypeConstraint<dst_type>("out_type"),            \
+      QuantizedLayerNormOp<CPUDevice, src_type, dst_type>);
+
+REGISTER_KERNEL(qint8, qint8);
+REGISTER_KERNEL(qint8, quint8);
+REGISTER_KERNEL(quint8, qint8);
+REGISTER_KERNEL(quint8, quint8);
+#undef REGISTER_KERNEL
+
+}  // namespace itex
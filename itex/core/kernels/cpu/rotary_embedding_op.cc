@@ -0,0 +1,179 @@
+/* Copyright (c) 2022 Intel Corporation
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <vector>
+
+#include "itex/core/utils/errors.h"
+#include "itex/core/utils/op_kernel.h"
+#include "itex/core/utils/op_requires.h"
+#include "itex/core/utils/plugin_tensor.h"
+#include "itex/core/utils/register_types.h"
+#include "itex/core/utils/tensor_shape.h"
+#include "itex/core/utils/types.h"
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+
+namespace itex {
+
+namespace {
+
+// Strides to read a table broadcast to `shape`, 0 for the broadcast dims.
+Status GetBroadcastStrides(const TensorShape& shape, const Tensor& table,
+                           const char* name, std::vector<int64>* strides) {
+  const int rank = shape.dims();
+  const int offset = rank - table.dims();
+  if (offset < 0) {
+    return errors::InvalidArgument(name, " must not have more dims than x ",
+                                   shape.DebugString(), ", got ",
+                                   table.shape().DebugString());
+  }
+  strides->assign(rank, 0);
+  int64 stride = 1;
+  for (int i = table.dims() - 1; i >= 0; --i) {
+    const int64 dim = table.dim_size(i);
+    if (dim != 1 && dim != shape.dim_size(i + offset)) {
+      return errors::InvalidArgument(name, " ", table.shape().DebugString(),
+                                     " can't be broadcast to x ",
+                                     shape.DebugString());
+    }
+    if (dim != 1) (*strides)[i + offset] = stride;
+    stride *= dim;
+  }
+  return Status::OK();
+}
+
+}  // namespace
+
+// Rotary position embedding:
+//   y = x * cos + rotate(x) * sin
+// where rotate(x) pairs the channels of the last dim. With `interleaved`, the
+// pairs are (x[2i], x[2i+1]) and rotate gives (-x[2i+1], x[2i]), otherwise
+// the pairs are the two halves and rotate(x) = concat(-x[h:], x[:h]). cos and
+// sin are broadcast to x, e.g. [seq_len, head_size] tables.
+//
+// Each pair is read and written once, so the output reuses the buffer of x
+// when possible. The rows of cos and sin are converted to float once per run
+// of rows sharing the same table row.
+template <typename Device, typename T>
+class RotaryEmbeddingOp : public OpKernel {
+ public:
+  explicit RotaryEmbeddingOp(OpKernelConstruction* context)
+      : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("interleaved", &interleaved_));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& x = context->input(0);
+    const Tensor& cos = context->input(1);
+    const Tensor& sin = context->input(2);
+    OP_REQUIRES(context, x.dims() >= 1,
+                errors::InvalidArgument("x must be at least 1-D, got ",
+                                        x.shape().DebugString()));
+    const int rank = x.dims();
+    const int64 dim = x.dim_size(rank - 1);
+    OP_REQUIRES(context, dim % 2 == 0,
+                errors::InvalidArgument("The last dim of x must be even, got ",
+                                        x.shape().DebugString()));
+    std::vector<int64> cos_strides, sin_strides;
+    OP_REQUIRES_OK(context,
+                   GetBroadcastStrides(x.shape(), cos, "cos", &cos_strides));
+    OP_REQUIRES_OK(context,
+                   GetBroadcastStrides(x.shape(), sin, "sin", &sin_strides));
+
+    Tensor* y = nullptr;
+    OP_REQUIRES_OK(context, context->forward_input_or_allocate_output(
+                                {0}, 0, x.shape(), &y));
+    if (y->NumElements() == 0) return;
+
+    const int64 rows = x.NumElements() / dim;
+    const T* src = x.flat<T>().data();
+    const T* cos_data = cos.flat<T>().data();
+    const T* sin_data = sin.flat<T>().data();
+    T* dst = y->flat<T>().data();
+    const int64 half = dim / 2;
+    const bool interleaved = interleaved_;
+
+    // Offset of the table row used by x row `row`.
+    auto table_offset = [&](int64 row, const std::vector<int64>& strides) {
+      int64 offset = 0;
+      for (int i = rank - 2; i >= 0; --i) {
+        const int64 size = x.dim_size(i);
+        offset += (row % size) * strides[i];
+        row /= size;
+      }
+      return offset;
+    };
+
+    const Eigen::ThreadPoolDevice& d = context->eigen_cpu_device();
+    const Eigen::TensorOpCost cost(3 * dim * sizeof(T), dim * sizeof(T),
+                                   4 * dim);
+    d.parallelFor(
+        rows, cost,
+        [&](Eigen::Index first, Eigen::Index last) {
+          std::vector<float> c(dim), s(dim);
+          int64 last_cos = -1, last_sin = -1;
+          for (Eigen::Index row = first; row < last; ++row) {
+            const int64 cos_offset = table_offset(row, cos_strides);
+            const int64 sin_offset = table_offset(row, sin_strides);
+            if (cos_offset != last_cos) {
+              for (int64 i = 0; i < dim; ++i) {
+                c[i] = static_cast<float>(
+                    cos_data[cos_offset + i * cos_strides[rank - 1]]);
+              }
+              last_cos = cos_offset;
+            }
+            if (sin_offset != last_sin) {
+              for (int64 i = 0; i < dim; ++i) {
+                s[i] = static_cast<float>(
+                    sin_data[sin_offset + i * sin_strides[rank - 1]]);
+              }
+              last_sin = sin_offset;
+            }
+
+            const T* x_row = src + row * dim;
+            T* y_row = dst + row * dim;
+            if (interleaved) {
+              for (int64 i = 0; i < dim; i += 2) {
+                const float x0 = static_cast<float>(x_row[i]);
+                const float x1 = static_cast<float>(x_row[i + 1]);
+                y_row[i] = static_cast<T>(x0 * c[i] - x1 * s[i]);
+                y_row[i + 1] = static_cast<T>(x1 * c[i + 1] + x0 * s[i + 1]);
+              }
+            } else {
+              for (int64 i = 0; i < half; ++i) {
+                const float x0 = static_cast<float>(x_row[i]);
+                const float x1 = static_cast<float>(x_row[i + half]);
+                y_row[i] = static_cast<T>(x0 * c[i] - x1 * s[i]);
+                y_row[i + half] =
+                    static_cast<T>(x1 * c[i + half] + x0 * s[i + half]);
+              }
+            }
+          }
+        });
+  }
+
+ private:
+  bool interleaved_;
+};
+
+#define REGISTER_CPU_ROTARY_EMBEDDING(T)                  \
+  REGISTER_KERNEL_BUILDER(Name("_ITEXRotaryEmbedding")    \
+                              .Device(DEVICE_CPU)         \
+                              .TypeConstraint<T>("T"),    \
+                          RotaryEmbeddingOp<CPUDevice, T>);
+
+TF_CALL_CPU_NUMBER_TYPES(REGISTER_CPU_ROTARY_EMBEDDING);
+#undef REGISTER_CPU_ROTARY_EMBEDDING
+
+}  // namespace itex
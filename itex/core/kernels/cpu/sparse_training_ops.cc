@@ -0,0 +1,437 @@
+/* Copyright (c) 2022 Intel Corporation
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+#include "itex/core/kernels/gpu/training_op_helpers.h"
+#include "itex/core/utils/errors.h"
+#include "itex/core/utils/op_kernel.h"
+#include "itex/core/utils/op_requires.h"
+#include "itex/core/utils/plugin_tensor.h"
+#include "itex/core/utils/prefetch.h"
+#include "itex/core/utils/register_types.h"
+#include "itex/core/utils/tensor_shape.h"
+#include "itex/core/utils/types.h"
+#include "third_party/eigen3/unsupported/Eigen/CXX11/Tensor"
+
+namespace itex {
+
+namespace {
+
+// Distinct rows of sparse updates: the updates at positions
+// [offsets[k], offsets[k + 1]) of `positions` all go to `rows[k]`.
+struct UniqueRows {
+  std::vector<int64> rows;
+  std::vector<int64> offsets;
+  std::vector<int64> positions;
+};
+
+// Groups the positions of `indices` by row, so each row is updated by one
+// thread, without locking. The positions of a row stay in input order.
+template <typename Tindex>
+Status GroupByRow(const Tensor& indices, int64 num_rows, UniqueRows* unique) {
+  auto ids = indices.flat<Tindex>();
+  const int64 n = ids.size();
+  std::vector<std::pair<int64, int64>> sorted(n);
+  for (int64 i = 0; i < n; ++i) {
+    const int64 row = static_cast<int64>(ids(i));
+    if (row < 0 || row >= num_rows) {
+      return errors::InvalidArgument("indices[", i, "] = ", row,
+                                     " is not in [0, ", num_rows, ")");
+    }
+    sorted[i] = {row, i};
+  }
+  std::sort(sorted.begin(), sorted.end());
+
+  unique->rows.clear();
+  unique->offsets.clear();
+  unique->positions.resize(n);
+  for (int64 i = 0; i < n; ++i) {
+    if (i == 0 || sorted[i].first != sorted[i - 1].first) {
+      unique->rows.push_back(sorted[i].first);
+      unique->offsets.push_back(i);
+    }
+    unique->positions[i] = sorted[i].second;
+  }
+  unique->offsets.push_back(n);
+  return Status::OK();
+}
+
+// Runs `update(k)` on each distinct row `unique.rows[k]` in parallel. The
+// rows of `params` and the first update used by the next row are prefetched
+// while the current one is updated.
+template <typename T, typename Update>
+void ForEachUniqueRow(OpKernelContext* ctx, const UniqueRows& unique,
+                      const T* updates, int64 inner_dim,
+                      const std::vector<const T*>& params,
+                      const Update& update) {
+  const int64 num_unique = unique.rows.size();
+  const double row_cost = static_cast<double>(unique.positions.size()) /
+                          std::max<int64>(num_unique, 1) * inner_dim;
+  const Eigen::TensorOpCost cost(
+      (params.size() + 1) * inner_dim * sizeof(T),
+      params.size() * inner_dim * sizeof(T), row_cost + 10 * inner_dim);
+  ctx->eigen_cpu_device().parallelFor(
+      num_unique, cost, [&](Eigen::Index first, Eigen::Index last) {
+        for (Eigen::Index k = first; k < last; ++k) {
+          if (k + 1 < last) {
+            const int64 next = unique.rows[k + 1];
+            for (const T* param : params) {
+              port::prefetch<port::PREFETCH_HINT_T0>(param + next * inner_dim);
+            }
+            port::prefetch<port::PREFETCH_HINT_T0>(
+                updates + unique.positions[unique.offsets[k + 1]] * inner_dim);
+          }
+          update(k);
+        }
+      });
+}
+
+// Runs `update(row, grad)` on each distinct row in parallel, with `grad` the
+// fp32 sum of the updates of the row.
+template <typename T, typename Update>
+void UpdateUniqueRows(OpKernelContext* ctx, const UniqueRows& unique,
+                      const T* updates, int64 inner_dim,
+                      const std::vector<const T*>& params,
+                      const Update& update) {
+  ForEachUniqueRow<T>(
+      ctx, unique, updates, inner_dim, params, [&](int64 k) {
+        // Per thread, as rows are updated in parallel.
+        thread_local std::vector<float> grad;
+        grad.assign(inner_dim, 0.0f);
+        for (int64 j = unique.offsets[k]; j < unique.offsets[k + 1]; ++j) {
+          const T* src = updates + unique.positions[j] * inner_dim;
+          for (int64 i = 0; i < inner_dim; ++i) {
+            grad[i] += static_cast<float>(src[i]);
+          }
+        }
+        update(unique.rows[k], grad.data());
+      });
+}
+
+// Checks `grad` is [N, var.shape[1:]] with `indices` a vector of size N, and
+// returns the size of a row in `inner_dim`.
+Status CheckSparseUpdate(const Tensor& var, const Tensor& grad,
+                         const Tensor& indices, int64* inner_dim) {
+  if (!TensorShapeUtils::IsVectorOrHigher(var.shape())) {
+    return errors::InvalidArgument("var must be at least 1 dimensional");
+  }
+  if (!TensorShapeUtils::IsVector(indices.shape())) {
+    return errors::InvalidArgument("indices must be one-dimensional");
+  }
+  if (grad.dims() != var.dims() || grad.dim_size(0) != indices.dim_size(0)) {
+    return errors::InvalidArgument(
+        "grad must be the same size as indices in the first dimension and "
+        "match var in the others, got grad ",
+        grad.shape().DebugString(), ", var ", var.shape().DebugString());
+  }
+  *inner_dim = 1;
+  for (int d = 1; d < var.dims(); ++d) {
+    if (var.dim_size(d) != grad.dim_size(d)) {
+      return errors::InvalidArgument("var and grad must match in dimension ",
+                                     d);
+    }
+    *inner_dim *= var.dim_size(d);
+  }
+  return Status::OK();
+}
+
+Status CheckScalar(const Tensor& tensor, const char* name) {
+  if (!TensorShapeUtils::IsScalar(tensor.shape())) {
+    return errors::InvalidArgument(name, " is not a scalar: ",
+                                   tensor.shape().DebugString());
+  }
+  return Status::OK();
+}
+
+}  // namespace
+
+// ResourceSparseApplyAdagrad(V2) on CPU. As in TF, duplicate indices are
+// applied one after another, in input order, by the thread of their row.
+template <typename Device, typename T, typename Tindex, bool has_epsilon>
+class SparseApplyAdagradOp : public OpKernel {
+ public:
+  explicit SparseApplyAdagradOp(OpKernelConstruction* ctx) : OpKernel(ctx) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("use_locking", &use_exclusive_lock_));
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("update_slots", &update_slots_));
+  }
+
+  void Compute(OpKernelContext* ctx) override {
+    const bool sparse = true;
+    auto locks = MaybeLockVariableInputMutexesInOrder<Device, T>(
+        ctx, use_exclusive_lock_, sparse, {0, 1});
+    Tensor var;
+    OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<Device, T>(
+                            ctx, 0, use_exclusive_lock_, sparse, &var));
+    Tensor accum;
+    OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<Device, T>(
+                            ctx, 1, use_exclusive_lock_, sparse, &accum));
+    OP_REQUIRES(ctx, var.IsInitialized(),
+                errors::FailedPrecondition(
+                    "Attempting to use uninitialized first variable"));
+    OP_REQUIRES(ctx, accum.IsInitialized(),
+                errors::FailedPrecondition(
+                    "Attempting to use uninitialized second variable"));
+    OP_REQUIRES(
+        ctx, var.shape().IsSameSize(accum.shape()),
+        errors::InvalidArgument("var and accum do not have the same shape",
+                                var.shape().DebugString(), " ",
+                                accum.shape().DebugString()));
+
+    const Tensor& lr = ctx->input(2);
+    OP_REQUIRES_OK(ctx, CheckScalar(lr, "lr"));
+    const int grad_input = has_epsilon ? 4 : 3;
+    float epsilon = 0.0f;
+    if (has_epsilon) {
+      OP_REQUIRES_OK(ctx, CheckScalar(ctx->input(3), "epsilon"));
+      epsilon = static_cast<float>(ctx->input(3).scalar<T>()());
+    }
+    const Tensor& grad = ctx->input(grad_input);
+    const Tensor& indices = ctx->input(grad_input + 1);
+    int64 inner_dim = 1;
+    OP_REQUIRES_OK(ctx, CheckSparseUpdate(var, grad, indices, &inner_dim));
+    if (indices.NumElements() == 0 || inner_dim == 0) return;
+
+    UniqueRows unique;
+    OP_REQUIRES_OK(ctx,
+                   GroupByRow<Tindex>(indices, var.dim_size(0), &unique));
+
+    const float lr_value = static_cast<float>(lr.scalar<T>()());
+    T* var_ptr = var.flat<T>().data();
+    T* accum_ptr = accum.flat<T>().data();
+    const T* grad_ptr = grad.flat<T>().data();
+    const bool update_slots = update_slots_;
+    ForEachUniqueRow<T>(
+        ctx, unique, grad_ptr, inner_dim, {var_ptr, accum_ptr}, [&](int64 k) {
+          T* v = var_ptr + unique.rows[k] * inner_dim;
+          T* a = accum_ptr + unique.rows[k] * inner_dim;
+          for (int64 j = unique.offsets[k]; j < unique.offsets[k + 1]; ++j) {
+            const T* g = grad_ptr + unique.positions[j] * inner_dim;
+            for (int64 i = 0; i < inner_dim; ++i) {
+              const float g_i = static_cast<float>(g[i]);
+              float acc = static_cast<float>(a[i]);
+              if (update_slots) {
+                acc += g_i * g_i;
+                a[i] = static_cast<T>(acc);
+              }
+              const float denom =
+                  has_epsilon ? std::sqrt(acc) + epsilon : std::sqrt(acc);
+              v[i] = static_cast<T>(static_cast<float>(v[i]) -
+                                    lr_value * g_i / denom);
+            }
+          }
+        });
+  }
+
+ private:
+  bool use_exclusive_lock_;
+  bool update_slots_;
+};
+
+// Lazy Adam with decoupled weight decay on the rows of a sparse gradient:
+// only the rows in `indices` of var, m and v are updated, with the same
+// formula as ResourceApplyAdamWithWeightDecay. Duplicate indices are summed.
+template <typename Device, typename T, typename Tindex>
+class SparseApplyAdamWithWeightDecayOp : public OpKernel {
+ public:
+  explicit SparseApplyAdamWithWeightDecayOp(OpKernelConstruction* ctx)
+      : OpKernel(ctx) {
+    OP_REQUIRES_OK(ctx, ctx->GetAttr("use_locking", &use_exclusive_lock_));
+  }
+
+  void Compute(OpKernelContext* ctx) override {
+    const bool sparse = true;
+    auto locks = MaybeLockVariableInputMutexesInOrder<Device, T>(
+        ctx, use_exclusive_lock_, sparse, {0, 1, 2});
+    Tensor var, m, v;
+    OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<Device, T>(
+                            ctx, 0, use_exclusive_lock_, sparse, &var));
+    OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<Device, T>(
+                            ctx, 1, use_exclusive_lock_, sparse, &m));
+    OP_REQUIRES_OK(ctx, GetInputTensorFromVariable<Device, T>(
+                            ctx, 2, use_exclusive_lock_, sparse, &v));
+    OP_REQUIRES(ctx,
+                var.IsInitialized() && m.IsInitialized() && v.IsInitialized(),
+                errors::FailedPrecondition(
+                    "Attempting to use uninitialized variables"));
+    OP_REQUIRES(
+        ctx,
+        var.shape().IsSameSize(m.shape()) && var.shape().IsSameSize(v.shape()),
+        errors::InvalidArgument("var, m and v do not have the same shape",
+                                var.shape().DebugString(), " ",
+                                m.shape().DebugString(), " ",
+                                v.shape().DebugString()));
+
+    static const char* const kScalars[] = {"beta1_power", "beta2_power", "lr",
+                                           "beta1",       "beta2",
+                                           "epsilon",     "weight_decay"};
+    float scalars[7];
+    for (int i = 0; i < 7; ++i) {
+      OP_REQUIRES_OK(ctx, CheckScalar(ctx->input(3 + i), kScalars[i]));
+      scalars[i] = static_cast<float>(ctx->input(3 + i).scalar<T>()());
+    }
+    const float beta1_power = scalars[0], beta2_power = scalars[1];
+    const float lr = scalars[2], beta1 = scalars[3], beta2 = scalars[4];
+    const float epsilon = scalars[5], weight_decay = scalars[6];
+
+    const Tensor& grad = ctx->input(10);
+    const Tensor& indices = ctx->input(11);
+    int64 inner_dim = 1;
+    OP_REQUIRES_OK(ctx, CheckSparseUpdate(var, grad, indices, &inner_dim));
+    if (indices.NumElements() == 0 || inner_dim == 0) return;
+
+    UniqueRows unique;
+    OP_REQUIRES_OK(ctx,
+                   GroupByRow<Tindex>(indices, var.dim_size(0), &unique));
+
+    const float alpha =
+        lr * std::sqrt(1.0f - beta2_power) / (1.0f - beta1_power);
+    const float decay = 1.0f - weight_decay * lr;
+    T* var_ptr = var.flat<T>().data();
+    T* m_ptr = m.flat<T>().data();
+    T* v_ptr = v.flat<T>().data();
+    UpdateUniqueRows<T>(
+        ctx, unique, grad.flat<T>().data(), inner_dim, {var_ptr, m_ptr, v_ptr},
+        [&](int64 row, const float* g) {
+          const int64 offset = row * inner_dim;
+          for (int64 i = offset; i < offset + inner_dim; ++i) {
+            const float gi = g[i - offset];
+            float mi = static_cast<float>(m_ptr[i]);
+            float vi = static_cast<float>(v_ptr[i]);
+            mi += (gi - mi) * (1.0f - beta1);
+            vi += (gi * gi - vi) * (1.0f - beta2);
+            m_ptr[i] = static_cast<T>(mi);
+            v_ptr[i] = static_cast<T>(vi);
+            var_ptr[i] = static_cast<T>(decay * static_cast<float>(var_ptr[i]) -
+                                        mi * alpha / (std::sqrt(vi) + epsilon));
+          }
+        });
+  }
+
+ private:
+  bool use_exclusive_lock_;
+};
+
+// ResourceScatterAdd on CPU, summing duplicate indices first so each row is
+// written by one thread.
+template <typename Device, typename T, typename Tindex>
+class ResourceScatterAddOp : public OpKernel {
+ public:
+  explicit ResourceScatterAddOp(OpKernelConstruction* ctx) : OpKernel(ctx) {}
+
+  void Compute(OpKernelContext* ctx) override {
+    auto locks = MaybeLockVariableInputMutexesInOrder<Device, T>(
+        ctx, /* do_lock */ true, /* sparse */ true, {0});
+    Tensor params;
+    OP_REQUIRES_OK(
+        ctx, GetInputTensorFromVariable<Device, T>(
+                 ctx, 0, /* lock_held unused */ true, /* sparse */ true,
+                 &params));
+    OP_REQUIRES(ctx, TensorShapeUtils::IsVectorOrHigher(params.shape()),
+                errors::InvalidArgument("params must be at least 1-D, got ",
+                                        params.shape().DebugString()));
+
+    const Tensor& indices = ctx->input(1);
+    const Tensor& updates = ctx->input(2);
+    const int64 n = indices.NumElements();
+    if (n == 0) return;
+    // From dims 1..n, as params may have no rows.
+    int64 inner_dim = 1;
+    for (int d = 1; d < params.dims(); ++d) inner_dim *= params.dim_size(d);
+    const bool is_scalar = TensorShapeUtils::IsScalar(updates.shape());
+    OP_REQUIRES(
+        ctx, is_scalar || updates.NumElements() == n * inner_dim,
+        errors::InvalidArgument(
+            "shape of indices (", indices.shape().DebugString(),
+            ") is not compatible with the shape of updates (",
+            updates.shape().DebugString(), ")"));
+    if (inner_dim == 0) return;
+
+    // Indices of any shape are flattened.
+    Tensor flat_indices;
+    OP_REQUIRES(ctx, flat_indices.CopyFrom(indices, TensorShape({n})),
+                errors::Internal("Failed to flatten indices"));
+    UniqueRows unique;
+    OP_REQUIRES_OK(
+        ctx, GroupByRow<Tindex>(flat_indices, params.dim_size(0), &unique));
+
+    T* params_ptr = params.flat<T>().data();
+    if (is_scalar) {
+      const float update = static_cast<float>(updates.scalar<T>()());
+      const int64 num_unique = unique.rows.size();
+      ctx->eigen_cpu_device().parallelFor(
+          num_unique, Eigen::TensorOpCost(inner_dim * sizeof(T),
+                                          inner_dim * sizeof(T), inner_dim),
+          [&](Eigen::Index first, Eigen::Index last) {
+            for (Eigen::Index k = first; k < last; ++k) {
+              const float count = unique.offsets[k + 1] - unique.offsets[k];
+              T* dst = params_ptr + unique.rows[k] * inner_dim;
+              for (int64 i = 0; i < inner_dim; ++i) {
+                dst[i] = static_cast<T>(static_cast<float>(dst[i]) +
+                                        update * count);
+              }
+            }
+          });
+      return;
+    }
+
+    UpdateUniqueRows<T>(ctx, unique, updates.flat<T>().data(), inner_dim,
+                        {params_ptr}, [&](int64 row, const float* sum) {
+                          T* dst = params_ptr + row * inner_dim;
+                          for (int64 i = 0; i < inner_dim; ++i) {
+                            dst[i] = static_cast<T>(static_cast<float>(dst[i]) +
+                                                    sum[i]);
+                          }
+                        });
+  }
+};
+
+#define REGISTER_CPU_SPARSE_TRAINING(T, Tindex)                             \
+  REGISTER_KERNEL_BUILDER(                                                  \
+      Name("_ITEXResourceSparseApplyAdagrad")                               \
+          .Device(DEVICE_CPU)                                               \
+          .TypeConstraint<T>("T")                                           \
+          .TypeConstraint<Tindex>("Tindices"),                              \
+      SparseApplyAdagradOp<CPUDevice, T, Tindex, /*has_epsilon=*/false>);   \
+  REGISTER_KERNEL_BUILDER(                                                  \
+      Name("_ITEXResourceSparseApplyAdagradV2")                             \
+          .Device(DEVICE_CPU)                                               \
+          .TypeConstraint<T>("T")                                           \
+          .TypeConstraint<Tindex>("Tindices"),                              \
+      SparseApplyAdagradOp<CPUDevice, T, Tindex, /*has_epsilon=*/true>);    \
+  REGISTER_KERNEL_BUILDER(                                                  \
+      Name("ResourceSparseApplyAdamWithWeightDecay")                        \
+          .Device(DEVICE_CPU)                                               \
+          .TypeConstraint<T>("T")                                           \
+          .TypeConstraint<Tindex>("Tindices"),                              \
+      SparseApplyAdamWithWeightDecayOp<CPUDevice, T, Tindex>);              \
+  REGISTER_KERNEL_BUILDER(Name("_ITEXResourceScatterAdd")                   \
+                              .Device(DEVICE_CPU)                           \
+                              .TypeConstraint<T>("dtype")                   \
+                              .TypeConstraint<Tindex>("Tindices"),          \
+                          ResourceScatterAddOp<CPUDevice, T, Tindex>);
+
+#define REGISTER_CPU_SPARSE_TRAINING_ALL(T) \
+  REGISTER_CPU_SPARSE_TRAINING(T, int32);   \
+  REGISTER_CPU_SPARSE_TRAINING(T, int64);
+
+TF_CALL_CPU_NUMBER_TYPES(REGISTER_CPU_SPARSE_TRAINING_ALL);
+#undef REGISTER_CPU_SPARSE_TRAINING_ALL
+#undef REGISTER_CPU_SPARSE_TRAINING
+
+}  // namespace itex
@@ -59,6 +59,15 @@ using dnnl::memory;
 TF_CALL_GPU_NUMBER_TYPES(REGISTER_MATMUL_GPU);
 #undef REGISTER_MATMUL_GPU
 
+#define REGISTER_MATMUL_LAYERNORM_GPU(TYPE)                                 \
+  REGISTER_KERNEL_BUILDER(Name("_ITEXFusedMatMulWithSumAndLayerNorm")       \
+                              .Device(DEVICE_GPU)                           \
+                              .TypeConstraint<TYPE>("T")                    \
+                              .TypeConstraint<float>("U"),                  \
+                          FusedMatMulWithSumAndLayerNormOp<GPUDevice, TYPE>);
+TF_CALL_GPU_NUMBER_TYPES(REGISTER_MATMUL_LAYERNORM_GPU);
+#undef REGISTER_MATMUL_LAYERNORM_GPU
+
 #define REGISTER_MATMUL_GRAD_GPU(TYPE)                                       \
   REGISTER_KERNEL_BUILDER(                                                   \
       Name("_FusedMatMulGrad").Device(DEVICE_GPU).TypeConstraint<TYPE>("T"), \
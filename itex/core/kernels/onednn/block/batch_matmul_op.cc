@@ -14,6 +14,7 @@ limitations under the License.
 ==============================================================================*/
 
 #include <algorithm>
+#include <atomic>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -374,9 +375,8 @@ class OneDnnBatchMatMulV2Op : public OneDnnMatMulBaseOp<Device, Trhs> {
  private:
 #ifndef INTEL_CPU_ONLY
   // TODO(itex): Wrap all cache related code to a module, reuse this module
-  inline bool IsMulCacheEmpty() TF_LOCKS_EXCLUDED(mul_cache_mu_) {
-    tf_shared_lock lock(&mul_cache_mu_);
-    return (!mul_cached_tensor_.IsInitialized());
+  inline bool IsMulCacheEmpty() const {
+    return mul_cached_data_.load(std::memory_order_acquire) == nullptr;
   }
 
   void AllocatePersistentTensor(OpKernelContext* context, Tensor** mul_tensor) {
@@ -411,19 +411,18 @@ class OneDnnBatchMatMulV2Op : public OneDnnMatMulBaseOp<Device, Trhs> {
     auto event = dpcpp_stream->memcpy(mul_host_data, mul_device_data,
                                       1 * sizeof(Toutput));
     event.wait();
+    mul_cached_data_.store(mul_host_data, std::memory_order_release);
   }
 
-  Toutput* GetCachedMul(OpKernelContext* context)
-      TF_LOCKS_EXCLUDED(mul_cache_mu_) {
-    tf_shared_lock lock(&mul_cache_mu_);
-    const Tensor& mul_cached_data = *mul_cached_tensor_.AccessTensor(context);
-
-    return static_cast<Toutput*>(
-        const_cast<Toutput*>(mul_cached_data.flat<Toutput>().data()));
+  // Lock free, the value never changes once cached.
+  Toutput* GetCachedMul(OpKernelContext* context) {
+    return mul_cached_data_.load(std::memory_order_acquire);
   }
 
   mutex mul_cache_mu_;
   PersistentTensor mul_cached_tensor_ TF_GUARDED_BY(mul_cache_mu_);
+  // Host data of `mul_cached_tensor_`, published once the copy is done.
+  std::atomic<Toutput*> mul_cached_data_{nullptr};
 #endif  // INTEL_CPU_ONLY
 };
 
@@ -17,8 +17,10 @@ limitations under the License.
 #define ITEX_CORE_KERNELS_ONEDNN_BLOCK_CONV_OPS_IMPL_H_
 
 #include <algorithm>
+#include <memory>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "itex/core/kernels/common/conv_ops.h"
@@ -27,6 +29,7 @@ limitations under the License.
 #include "itex/core/utils/errors.h"
 #include "itex/core/utils/onednn/onednn_layout_util.h"
 #include "itex/core/utils/onednn/onednn_post_op_util.h"
+#include "itex/core/utils/onednn/onednn_primitive_log.h"
 #include "itex/core/utils/onednn/onednn_util.h"
 #include "itex/core/utils/op_kernel.h"
 #include "itex/core/utils/op_requires.h"
@@ -123,95 +126,96 @@ class OneDnnConvOp : public OpKernel {
       OP_REQUIRES_OK(context, context->GetAttr("inplace_sum", &inplace_sum_));
     }
 
-    ITEX_CHECK_OK(
-        ReadBoolFromEnvVar("ITEX_CACHE_ONEDNN_OBJECT", false, &enable_cache_));
+    enable_cache_ = IsOneDnnObjectCacheEnabled();
 
     fp32_math_mode_ = GetFP32MathMode<Device>();
   }
 
-  void InitOrSetMemory(OpKernelContext* context) {
-    if (!(enable_cache_ && is_init_ &&
-          IsInputSame(context, 0, input_dims_, src_onednn_shape_) &&
-          IsInputSame(context, 1, filter_dims_, filter_onednn_shape_))) {
-      Init(context);
-      return;
-    }
-
-    if (is_input_zero_) {
-      AllocateOutputSetOneDnnShape(context, this->kDstIndex_,
-                                   &this->dst_tensor_, this->dst_tf_shape_,
-                                   this->dst_onednn_shape_);
-      return;
-    }
+  // Everything derived from the input signature. A plan is immutable once
+  // created, so concurrent Compute() calls on the same node share it and only
+  // bind their own memories and temporaries.
+  struct ConvPlan {
+    std::vector<int64> input_dims, filter_dims;
+    OneDnnShape src_onednn_shape, filter_onednn_shape;
+    bool is_input_zero = false;
+    bool is_src_reordered = false, is_filter_reordered = false;
+    TensorShape dst_tf_shape;
+    OneDnnShape dst_onednn_shape;
+    memory::dims dst_dims_onednn;
+    OneDnnTensorFormat data_fmt_onednn;
+    TensorShape dst_shape;
+    memory::desc src_md, filter_md, bias_md;
+    ConvFwdPd fwd_pd;
+    primitive fwd_primitive;
+    dnnl::reorder src_reorder, weight_reorder;
+  };
 
-    if (is_src_reordered_) {
-      src_mem_input_.set_data_handle(context->tensor_data(kSrcIndex_));
-      src_mem_.set_data_handle(GetTensorBuffer<Tinput>(&src_data_output_));
-      src_reorder_.execute(onednn_stream_, src_reorder_args_);
-    } else {
-      src_mem_.set_data_handle(context->tensor_data(kSrcIndex_));
+  void Compute(OpKernelContext* context) override {
+    bool is_init = false;
+    std::shared_ptr<const ConvPlan> plan = LookupPlan(context, &is_init);
+    if (plan == nullptr) {
+      std::shared_ptr<ConvPlan> new_plan;
+      CreatePlan(context,
+                 is_init ? PrimitiveCreateReason::kShapeChange
+                         : PrimitiveCreateReason::kCold,
+                 &new_plan);
+      if (!context->status().ok()) return;
+      plan = new_plan;
+      InsertPlan(std::move(new_plan));
     }
+    Execute(context, *plan);
+  }
 
-    if (is_filter_reordered_) {
-      if (!is_filter_const_) {
-        filter_mem_input_.set_data_handle(context->tensor_data(kFilterIndex_));
-        filter_mem_.set_data_handle(GetTensorBuffer<Tfilter>(&tmp_weight_));
-        weight_reorder_.execute(onednn_stream_, weight_reorder_args_);
-      }
-    } else {
-      filter_mem_.set_data_handle(context->tensor_data(kFilterIndex_));
+  // Returns the cached plan if it matches current inputs, otherwise nullptr.
+  // `is_init` tells whether any plan was created before.
+  std::shared_ptr<const ConvPlan> LookupPlan(OpKernelContext* context,
+                                             bool* is_init)
+      TF_LOCKS_EXCLUDED(mu_compute_) {
+    std::shared_ptr<const ConvPlan> plan;
+    {
+      mutex_lock lock(&mu_compute_);
+      *is_init = is_init_;
+      plan = plan_;
     }
-
-    if (post_op_util_.HasBias()) {
-      const Tensor& bias_tensor = context->input(kBiasIndex_);
-      Tbias* bias_data = this->GetBiasHandle(context, bias_tensor);
-      bias_mem_.set_data_handle(bias_data);
+    if (plan != nullptr &&
+        IsInputSame(context, 0, plan->input_dims, plan->src_onednn_shape) &&
+        IsInputSame(context, 1, plan->filter_dims, plan->filter_onednn_shape)) {
+      return plan;
     }
-    AllocateOutputTensor(context, fwd_pd_, dst_dims_onednn_, data_fmt_onednn_,
-                         &dst_onednn_shape_, dst_shape_, &dst_tensor_);
-    dst_mem_.set_data_handle(
-        reinterpret_cast<Tsummand*>(GetTensorBuffer<Toutput>(dst_tensor_)));
+    return nullptr;
   }
 
-  void Compute(OpKernelContext* context) override {
+  void InsertPlan(std::shared_ptr<const ConvPlan> plan)
+      TF_LOCKS_EXCLUDED(mu_compute_) {
     mutex_lock lock(&mu_compute_);
-    dst_tensor_ = nullptr;
-    onednn_engine_ = CreateDnnlEngine<Device>(*context);
-    // onednn_stream has thread safety issue, need create a new one in
-    // every compute.
-    onednn_stream_ = CreateDnnlStream(*context, onednn_engine_);
-    InitOrSetMemory(context);
-
-    // Skip primitive execution if the calculation is meaningless.
-    if (is_input_zero_) return;
-
-    fwd_primitive_.execute(onednn_stream_, fwd_primitives_args_);
+    is_init_ = true;
+    if (enable_cache_) plan_ = std::move(plan);
   }
 
-  void Init(OpKernelContext* context) {
+  void CreatePlan(OpKernelContext* context, PrimitiveCreateReason reason,
+                  std::shared_ptr<ConvPlan>* plan_ptr) {
     try {
-      fwd_primitives_args_.clear();
+      auto plan = std::make_shared<ConvPlan>();
 
       // Input tensors
       const Tensor& src_tensor = context->input(kSrcIndex_);
       const Tensor& filter_tensor = context->input(kFilterIndex_);
 
       auto input_shape = src_tensor.shape();
-      input_dims_.clear();
       for (int i = 0; i < input_shape.dims(); ++i) {
-        input_dims_.push_back(input_shape.dim_size(i));
+        plan->input_dims.push_back(input_shape.dim_size(i));
       }
       auto filter_tensor_shape = filter_tensor.shape();
-      filter_dims_.clear();
       for (int i = 0; i < filter_tensor_shape.dims(); ++i) {
-        filter_dims_.push_back(filter_tensor_shape.dim_size(i));
+        plan->filter_dims.push_back(filter_tensor_shape.dim_size(i));
       }
 
       // Get shapes of input & filter tensors
-      GetOneDnnShape(context, kSrcIndex_, &src_onednn_shape_);
-      GetOneDnnShape(context, kFilterIndex_, &filter_onednn_shape_);
-      TensorShape src_tf_shape = src_onednn_shape_.IsOneDnnTensor()
-                                     ? src_onednn_shape_.GetTfShape()
+      GetOneDnnShape(context, kSrcIndex_, &plan->src_onednn_shape);
+      GetOneDnnShape(context, kFilterIndex_, &plan->filter_onednn_shape);
+      const OneDnnShape& src_onednn_shape = plan->src_onednn_shape;
+      TensorShape src_tf_shape = src_onednn_shape.IsOneDnnTensor()
+                                     ? src_onednn_shape.GetTfShape()
                                      : src_tensor.shape();
       TensorShape filter_tf_shape = filter_tensor.shape();
 
@@ -233,7 +237,7 @@ class OneDnnConvOp : public OpKernel {
 
       conv_util.InitFwdDimensions(src_tf_shape, filter_tf_shape, &src_dims,
                                   &filter_dims, &stride_dims, &dilation_dims,
-                                  &dst_dims_tf, &dst_dims_onednn_,
+                                  &dst_dims_tf, &plan->dst_dims_onednn,
                                   &pad_left_dims, &pad_right_dims);
 
       // OneDNN dilations start from 0.
@@ -241,14 +245,11 @@ class OneDnnConvOp : public OpKernel {
         --dilation_dims[i];
       }
 
-      dst_tf_shape_ = OneDnnDimsToTFShape(dst_dims_tf);
+      plan->dst_tf_shape = OneDnnDimsToTFShape(dst_dims_tf);
       // Corner cases: output with 0 elements and 0 batch size.
-      if (dst_tf_shape_.num_elements() == 0 || dst_dims_tf[0] == 0) {
-        is_input_zero_ = true;
-        AllocateOutputSetOneDnnShape(context, this->kDstIndex_,
-                                     &this->dst_tensor_, this->dst_tf_shape_,
-                                     this->dst_onednn_shape_);
-        is_init_ = true;
+      if (plan->dst_tf_shape.num_elements() == 0 || dst_dims_tf[0] == 0) {
+        plan->is_input_zero = true;
+        *plan_ptr = std::move(plan);
         return;
       }
 
@@ -258,11 +259,13 @@ class OneDnnConvOp : public OpKernel {
                         "Only 2D convolution is supported for depthwise."));
       }
 
+      auto onednn_engine = CreateDnnlEngine<Device>(*context);
+
       // Get OneDnn layout for data
-      data_fmt_onednn_ =
+      plan->data_fmt_onednn =
           TFDataFormatToOneDnnDataFormat(data_format_, is_conv2d_);
       memory::format_tag data_layout =
-          OneDnnTensorFormatToTag(data_fmt_onednn_);
+          OneDnnTensorFormatToTag(plan->data_fmt_onednn);
       OP_REQUIRES(context, data_layout != memory::format_tag::undef,
                   errors::InvalidArgument("Invalid data format"));
 
@@ -273,17 +276,17 @@ class OneDnnConvOp : public OpKernel {
                                ? (is_depthwise ? memory::format_tag::hwigo
                                                : memory::format_tag::hwio)
                                : memory::format_tag::dhwio;
-      memory::desc src_md =
-          src_onednn_shape_.IsOneDnnTensor()
-              ? src_onednn_shape_.GetOneDnnLayout()
+      plan->src_md =
+          src_onednn_shape.IsOneDnnTensor()
+              ? src_onednn_shape.GetOneDnnLayout()
               : memory::desc(src_dims, OneDnnType<Tinput>(), data_layout);
       memory::desc src_md_prefer =
           memory::desc(src_dims, OneDnnType<Tinput>(), memory::format_tag::any);
       if (src_dims[1] == 3 && std::is_same<Device, GPUDevice>::value) {
-        src_md_prefer = src_md;
+        src_md_prefer = plan->src_md;
       }
 
-      memory::desc filter_md =
+      plan->filter_md =
           memory::desc(filter_dims, OneDnnType<Tfilter>(), filter_layout);
       // block format filter is allowed with plain src. preferred for both
       // layout disabled or enabled
@@ -296,10 +299,10 @@ class OneDnnConvOp : public OpKernel {
       // respectively quint8 and qint8.
       memory::desc dst_md;
       if (std::is_same<Toutput, Tsummand>::value) {
-        dst_md = memory::desc({dst_dims_onednn_}, OneDnnType<Toutput>(),
+        dst_md = memory::desc({plan->dst_dims_onednn}, OneDnnType<Toutput>(),
                               memory::format_tag::any);
       } else {
-        dst_md = memory::desc({dst_dims_onednn_}, OneDnnType<Tsummand>(),
+        dst_md = memory::desc({plan->dst_dims_onednn}, OneDnnType<Tsummand>(),
                               memory::format_tag::any);
       }
 
@@ -309,8 +312,9 @@ class OneDnnConvOp : public OpKernel {
       // construction. We use "post_op_util_.AddOps" in this situation
       // 2. For int8 ops, set post op information during op compute, since there
       // is no "fused_ops" attr for these ops. We use "ExtendInt8PostOps" in
-      // this situation
-      this->ExtendInt8PostOps(context);
+      // this situation. It works on a copy so the kernel stays read-only.
+      PostOpUtil post_op_util = post_op_util_;
+      this->ExtendInt8PostOps(context, &post_op_util);
 
       // Create a convolution descriptor
       ConvFwdDesc fwd_desc =
@@ -318,125 +322,175 @@ class OneDnnConvOp : public OpKernel {
                       src_md_prefer, filter_md_prefer, dst_md, stride_dims,
                       dilation_dims, pad_left_dims, pad_right_dims);
 
-      if (post_op_util_.HasBias()) {
+      if (post_op_util.HasBias()) {
         const Tensor& bias_tensor = context->input(kBiasIndex_);
         TensorShape bias_tensor_shape = bias_tensor.shape();
         conv_util.GetBiasDimension(bias_tensor_shape, &bias_dims);
 
         // TODO(itex): use format_tag::any for bias
-        auto bias_md =
+        plan->bias_md =
             memory::desc(bias_dims, OneDnnType<Tbias>(), memory::format_tag::x);
 
         fwd_desc = ConvFwdDesc(
             prop_kind::forward, dnnl::algorithm::convolution_direct,
-            src_md_prefer, filter_md_prefer, bias_md, dst_md, stride_dims,
+            src_md_prefer, filter_md_prefer, plan->bias_md, dst_md, stride_dims,
             dilation_dims, pad_left_dims, pad_right_dims);
-
-        Tbias* bias_data = this->GetBiasHandle(context, bias_tensor);
-        bias_mem_ = CreateDnnlMemory(bias_md, onednn_engine_, bias_data);
-        fwd_primitives_args_.insert({DNNL_ARG_BIAS, bias_mem_});
       }
 
       // Set post op attribution.
       dnnl::primitive_attr post_ops_attr;
-      post_op_util_.SetPostOpAttr(&post_ops_attr);
+      post_op_util.SetPostOpAttr(&post_ops_attr);
       post_ops_attr.set_scratchpad_mode(dnnl::scratchpad_mode::user);
       if (std::is_same<Tinput, float>::value) {
         post_ops_attr.set_fpmath_mode(fp32_math_mode_);
       }
-      fwd_pd_ = ConvFwdPd(fwd_desc, post_ops_attr, onednn_engine_);
+      {
+        ScopedPrimitiveCreation primitive_record(this, "convolution", reason);
+        plan->fwd_pd = ConvFwdPd(fwd_desc, post_ops_attr, onednn_engine);
+        plan->fwd_primitive = dnnl::convolution_forward(plan->fwd_pd);
+        primitive_record.SetPrimitiveDesc(plan->fwd_pd);
+      }
 
-      fwd_primitive_ = dnnl::convolution_forward(fwd_pd_);
+      int64 dst_data_size =
+          plan->fwd_pd.dst_desc().get_size() / sizeof(Toutput);
+      plan->dst_shape = TensorShape({dst_data_size});
 
-      int64 dst_data_size = fwd_pd_.dst_desc().get_size() / sizeof(Toutput);
-      dst_shape_ = TensorShape({dst_data_size});
+      // Check whether src and filter need to be reordered.
+      plan->is_src_reordered = (plan->src_md != plan->fwd_pd.src_desc());
+      if (plan->is_src_reordered) {
+        plan->src_reorder = dnnl::reorder(dnnl::reorder::primitive_desc(
+            onednn_engine, plan->src_md, onednn_engine,
+            plan->fwd_pd.src_desc()));
+      }
+      plan->is_filter_reordered =
+          (plan->filter_md != plan->fwd_pd.weights_desc());
+      if (plan->is_filter_reordered) {
+        plan->weight_reorder = dnnl::reorder(dnnl::reorder::primitive_desc(
+            onednn_engine, plan->filter_md, onednn_engine,
+            plan->fwd_pd.weights_desc()));
+      }
+      *plan_ptr = std::move(plan);
+    } catch (dnnl::error& e) {
+      string error_msg = "Status: " + std::to_string(e.status) +
+                         ", message: " + string(e.message) + ", in file " +
+                         string(__FILE__) + ":" + std::to_string(__LINE__);
+      OP_REQUIRES_OK(
+          context,
+          errors::Aborted("Operation received an exception:", error_msg));
+    }
+  }
 
-      AllocateOutputTensor(context, fwd_pd_, dst_dims_onednn_, data_fmt_onednn_,
-                           &dst_onednn_shape_, dst_shape_, &dst_tensor_);
+  // Binds current inputs and outputs to the plan and runs it. Nothing in the
+  // kernel is written here, except the thread-safe weight/bias caches.
+  void Execute(OpKernelContext* context, const ConvPlan& plan) {
+    Tensor* dst_tensor = nullptr;
+    if (plan.is_input_zero) {
+      AllocateOutputSetOneDnnShape(context, kDstIndex_, &dst_tensor,
+                                   plan.dst_tf_shape, plan.dst_onednn_shape);
+      return;
+    }
 
-      // Check whether src and filter need to be reordered.
-      is_src_reordered_ = (src_md != fwd_pd_.src_desc());
-      src_mem_input_ = CreateDnnlMemory(src_md, onednn_engine_,
-                                        GetTensorBuffer<Tinput>(&src_tensor));
+    try {
+      auto onednn_engine = CreateDnnlEngine<Device>(*context);
+      // onednn_stream has thread safety issue, need create a new one in
+      // every compute.
+      auto onednn_stream = CreateDnnlStream(*context, onednn_engine);
+      const Tensor& src_tensor = context->input(kSrcIndex_);
+      const Tensor& filter_tensor = context->input(kFilterIndex_);
 
-      if (is_src_reordered_) {
-        int64 src_out_size = fwd_pd_.src_desc().get_size() / sizeof(Tinput);
+      memory src_mem = CreateDnnlMemory(plan.src_md, onednn_engine,
+                                        GetTensorBuffer<Tinput>(&src_tensor));
+      // This one for dnnl primitive input when input need reorder.
+      Tensor src_data_output;
+      if (plan.is_src_reordered) {
+        int64 src_out_size =
+            plan.fwd_pd.src_desc().get_size() / sizeof(Tinput);
         OP_REQUIRES_OK(context,
                        context->allocate_temp(DataTypeToEnum<Tinput>::v(),
                                               TensorShape({src_out_size}),
-                                              &src_data_output_));
-        src_mem_ = CreateDnnlMemory(fwd_pd_.src_desc(), onednn_engine_,
-                                    GetTensorBuffer<Tinput>(&src_data_output_));
-        src_reorder_args_.clear();
-        src_reorder_args_.insert({DNNL_ARG_SRC, src_mem_input_});
-        src_reorder_args_.insert({DNNL_ARG_DST, src_mem_});
-        src_reorder_ = dnnl::reorder(src_mem_input_, src_mem_);
-        src_reorder_.execute(onednn_stream_, src_reorder_args_);
-      } else {
-        src_mem_ = src_mem_input_;
+                                              &src_data_output));
+        memory src_reorder_mem =
+            CreateDnnlMemory(plan.fwd_pd.src_desc(), onednn_engine,
+                             GetTensorBuffer<Tinput>(&src_data_output));
+        std::unordered_map<int, memory> src_reorder_args = {
+            {DNNL_ARG_SRC, src_mem}, {DNNL_ARG_DST, src_reorder_mem}};
+        plan.src_reorder.execute(onednn_stream, src_reorder_args);
+        src_mem = src_reorder_mem;
       }
 
-      is_filter_reordered_ = (filter_md != fwd_pd_.weights_desc());
-      filter_mem_input_ = CreateDnnlMemory(
-          filter_md, onednn_engine_, GetTensorBuffer<Tfilter>(&filter_tensor));
-
-      if (is_filter_reordered_) {
+      memory filter_mem =
+          CreateDnnlMemory(plan.filter_md, onednn_engine,
+                           GetTensorBuffer<Tfilter>(&filter_tensor));
+      // This one for dnnl primitive weight when weight need reorder.
+      Tensor tmp_weight;
+      if (plan.is_filter_reordered) {
+        memory::desc expected_md = plan.fwd_pd.weights_desc();
         Tfilter* filter_cached_data = nullptr;
         if (is_filter_const_) {
           if (weight_cache_manager_.IsEmpty()) {
             // Cache weight
             weight_cache_manager_.SetCache(
-                context, filter_md, fwd_pd_.weights_desc(),
-                GetTensorBuffer<Tfilter>(&filter_tensor), onednn_engine_);
+                context, plan.filter_md, expected_md,
+                GetTensorBuffer<Tfilter>(&filter_tensor), onednn_engine);
           }
           filter_cached_data =
-              weight_cache_manager_.GetCache(context, fwd_pd_.weights_desc());
-          if (filter_cached_data != nullptr) {
-            filter_mem_ = CreateDnnlMemory(fwd_pd_.weights_desc(),
-                                           onednn_engine_, filter_cached_data);
-          }
+              weight_cache_manager_.GetCache(context, expected_md);
+        }
+        if (filter_cached_data != nullptr) {
+          filter_mem =
+              CreateDnnlMemory(expected_md, onednn_engine, filter_cached_data);
         } else {
           int64 reorder_filter_data_size =
-              fwd_pd_.weights_desc().get_size() / sizeof(Tfilter);
+              expected_md.get_size() / sizeof(Tfilter);
           OP_REQUIRES_OK(context, context->allocate_temp(
                                       DataTypeToEnum<Tfilter>::v(),
                                       TensorShape({reorder_filter_data_size}),
-                                      &tmp_weight_));
-          void* filter_data_handle = GetTensorBuffer<Tfilter>(&tmp_weight_);
-          filter_mem_ = CreateDnnlMemory(fwd_pd_.weights_desc(), onednn_engine_,
-                                         filter_data_handle);
-          weight_reorder_args_.clear();
-          weight_reorder_args_.insert({DNNL_ARG_SRC, filter_mem_input_});
-          weight_reorder_args_.insert({DNNL_ARG_DST, filter_mem_});
-          weight_reorder_ = dnnl::reorder(filter_mem_input_, filter_mem_);
-          weight_reorder_.execute(onednn_stream_, weight_reorder_args_);
+                                      &tmp_weight));
+          memory filter_reorder_mem =
+              CreateDnnlMemory(expected_md, onednn_engine,
+                               GetTensorBuffer<Tfilter>(&tmp_weight));
+          std::unordered_map<int, memory> weight_reorder_args = {
+              {DNNL_ARG_SRC, filter_mem}, {DNNL_ARG_DST, filter_reorder_mem}};
+          plan.weight_reorder.execute(onednn_stream, weight_reorder_args);
+          filter_mem = filter_reorder_mem;
         }
-      } else {
-        filter_mem_ = filter_mem_input_;
       }
 
-      // TODO(itex): redesign the code for Tsummand
-      dst_mem_ = CreateDnnlMemory(
-          fwd_pd_.dst_desc(), onednn_engine_,
-          reinterpret_cast<Tsummand*>(GetTensorBuffer<Toutput>(dst_tensor_)));
+      OneDnnShape dst_onednn_shape;
+      AllocateOutputTensor(context, onednn_engine, plan.fwd_pd,
+                           plan.dst_dims_onednn, plan.data_fmt_onednn,
+                           &dst_onednn_shape, plan.dst_shape, &dst_tensor);
+      if (!context->status().ok()) return;
 
+      Tensor scratchpad_tensor;
       int64 scratchpad_size =
-          fwd_pd_.scratchpad_desc().get_size() / sizeof(Tinput);
+          plan.fwd_pd.scratchpad_desc().get_size() / sizeof(Tinput);
       OP_REQUIRES_OK(context,
                      context->allocate_temp(DataTypeToEnum<Tinput>::v(),
                                             TensorShape({scratchpad_size}),
-                                            &scratchpad_tensor_));
-      scratchpad_mem_ =
-          dnnl::memory(fwd_pd_.scratchpad_desc(), onednn_engine_,
-                       GetTensorBuffer<Tinput>(&scratchpad_tensor_));
+                                            &scratchpad_tensor));
 
-      // Execute convolution
-      fwd_primitives_args_.insert({DNNL_ARG_SRC, src_mem_});
-      fwd_primitives_args_.insert({DNNL_ARG_WEIGHTS, filter_mem_});
-      fwd_primitives_args_.insert({DNNL_ARG_DST, dst_mem_});
-      fwd_primitives_args_.insert({DNNL_ARG_SCRATCHPAD, scratchpad_mem_});
+      // TODO(itex): redesign the code for Tsummand
+      std::unordered_map<int, memory> fwd_primitives_args = {
+          {DNNL_ARG_SRC, src_mem},
+          {DNNL_ARG_WEIGHTS, filter_mem},
+          {DNNL_ARG_DST,
+           CreateDnnlMemory(plan.fwd_pd.dst_desc(), onednn_engine,
+                            reinterpret_cast<Tsummand*>(
+                                GetTensorBuffer<Toutput>(dst_tensor)))},
+          {DNNL_ARG_SCRATCHPAD,
+           dnnl::memory(plan.fwd_pd.scratchpad_desc(), onednn_engine,
+                        GetTensorBuffer<Tinput>(&scratchpad_tensor))}};
+      if (post_op_util_.HasBias()) {
+        const Tensor& bias_tensor = context->input(kBiasIndex_);
+        Tbias* bias_data =
+            this->GetBiasHandle(context, onednn_engine, bias_tensor);
+        fwd_primitives_args.insert(
+            {DNNL_ARG_BIAS,
+             CreateDnnlMemory(plan.bias_md, onednn_engine, bias_data)});
+      }
 
-      is_init_ = true;
+      plan.fwd_primitive.execute(onednn_stream, fwd_primitives_args);
     } catch (dnnl::error& e) {
       string error_msg = "Status: " + std::to_string(e.status) +
                          ", message: " + string(e.message) + ", in file " +
@@ -455,51 +509,6 @@ class OneDnnConvOp : public OpKernel {
   /* Fused Conv */
   PostOpUtil post_op_util_;
 
-  // Cache oneDNN object and TF memory
-  bool is_init_ = false;
-  bool is_input_zero_ = false;
-  bool is_src_reordered_ = false;
-  bool is_filter_reordered_ = false;
-
-  // This one for dnnl primitive input
-  dnnl::memory src_mem_;
-  // This one for TF input when input need reorder.
-  dnnl::memory src_mem_input_;
-  // This one for dnnl primitive weight
-  dnnl::memory filter_mem_;
-  // This one for TF weight when weight need reorder.
-  dnnl::memory filter_mem_input_;
-  dnnl::memory dst_mem_;
-  dnnl::memory scratchpad_mem_;
-  dnnl::memory bias_mem_;
-  dnnl::memory::dims dst_dims_onednn_;
-
-  dnnl::stream onednn_stream_;
-  dnnl::engine onednn_engine_;
-
-  dnnl::reorder src_reorder_;
-  dnnl::reorder weight_reorder_;
-  primitive fwd_primitive_;
-  ConvFwdPd fwd_pd_;
-
-  std::unordered_map<int, memory> fwd_primitives_args_;
-  std::unordered_map<int, memory> src_reorder_args_;
-  std::unordered_map<int, memory> weight_reorder_args_;
-
-  OneDnnShape dst_onednn_shape_;
-  TensorShape dst_tf_shape_;
-  OneDnnTensorFormat data_fmt_onednn_;
-  TensorShape dst_shape_;
-  std::vector<int64> input_dims_, filter_dims_;
-  OneDnnShape src_onednn_shape_, filter_onednn_shape_;
-
-  Tensor* dst_tensor_ = nullptr;
-  // This one for dnnl primitive input when input need reorder.
-  Tensor src_data_output_;
-  // This one for dnnl primitive weight when weight need reorder.
-  Tensor tmp_weight_;
-  Tensor scratchpad_tensor_;
-
   bool enable_cache_ = false;
   dnnl::fpmath_mode fp32_math_mode_ = dnnl::fpmath_mode::strict;
 
@@ -515,14 +524,19 @@ class OneDnnConvOp : public OpKernel {
   // Weight cache manager
   WeightCacheManager<Tfilter> weight_cache_manager_;
 
+  // Only guards lookup and insert of the plan, never the execution.
   mutex mu_compute_;
+  std::shared_ptr<const ConvPlan> plan_ TF_GUARDED_BY(mu_compute_);
+  bool is_init_ TF_GUARDED_BY(mu_compute_) = false;
 
  protected:
-  // ExtendInt8PostOps is only used in Int8 ops.
-  virtual void ExtendInt8PostOps(OpKernelContext* context) {}
+  // ExtendInt8PostOps is only used in Int8 ops. Hooks below may be called by
+  // concurrent Compute(), they must only write to their arguments.
+  virtual void ExtendInt8PostOps(OpKernelContext* context,
+                                 PostOpUtil* post_op_util) {}
 
   virtual void AllocateOutputTensor(
-      OpKernelContext* context,
+      OpKernelContext* context, const dnnl::engine& onednn_engine,
       const dnnl::convolution_forward::primitive_desc& conv_pd,
       const memory::dims& dst_dims_onednn, OneDnnTensorFormat dst_tf_format,
       OneDnnShape* dst_onednn_shape, TensorShape tensor_shape,
@@ -585,12 +599,11 @@ class OneDnnConvOp : public OpKernel {
                         ? add_onednn_shape.GetOneDnnLayout()
                         : memory::desc(dst_dims_onednn, OneDnnType<Toutput>(),
                                        dst_layout);
-      memory fuse_add_src = memory(add_md, this->onednn_engine_,
+      memory fuse_add_src = memory(add_md, onednn_engine,
                                    GetTensorBuffer<Toutput>(&add_tensor));
-      memory fuse_add_dst = memory(dst_md, this->onednn_engine_,
+      memory fuse_add_dst = memory(dst_md, onednn_engine,
                                    GetTensorBuffer<Toutput>(*dst_tensor));
-      ReorderMemory(*context, &fuse_add_src, &fuse_add_dst,
-                    this->onednn_engine_);
+      ReorderMemory(*context, &fuse_add_src, &fuse_add_dst, onednn_engine);
     } else {
       OP_REQUIRES(
           context,
@@ -607,6 +620,7 @@ class OneDnnConvOp : public OpKernel {
   }
 
   virtual Tbias* GetBiasHandle(OpKernelContext* context,
+                               const dnnl::engine& onednn_engine,
                                const Tensor& bias_tensor) {
     return static_cast<Tbias*>(
         const_cast<Tbias*>(bias_tensor.flat<Tbias>().data()));
@@ -715,7 +729,8 @@ class OneDnnQuantizedConvOp
   }
 
  protected:
-  void ExtendInt8PostOps(OpKernelContext* context) override {
+  void ExtendInt8PostOps(OpKernelContext* context,
+                         PostOpUtil* post_op_util) override {
     // When the output type is quint8, the output data is requantized
     // into quint8. A post_op "output_scale" is added to do the conversion.
     // Otherwise the output_scale will be 1.f
@@ -759,10 +774,11 @@ class OneDnnQuantizedConvOp
                     (int_const_scale_limit * float_output_range);
       }
     }
-    this->post_op_util_.SetOutputScale(scales);
+    post_op_util->SetOutputScale(scales);
   }
 
   Tbias* GetBiasHandle(OpKernelContext* context,
+                       const dnnl::engine& onednn_engine,
                        const Tensor& bias_tensor) override {
     if (std::is_same<Tbias, qint32>::value) {
       return static_cast<Tbias*>(
@@ -784,7 +800,7 @@ class OneDnnQuantizedConvOp
 
     // TODO(itex): avoid to use new memory
     size_t depth = min_filter_vector.NumElements();
-    scales_.resize(depth);
+    std::vector<float> scales(depth);
     for (size_t i = 0; i < depth; ++i) {
       float tmp_scale =
           int_const_scale_limit /
@@ -792,15 +808,15 @@ class OneDnnQuantizedConvOp
            std::max(std::abs(max_filter[i]), std::abs(min_filter[i])));
       // TODO(itex): Check whether delete some instuctions about
       // scales_are_valid is correct
-      scales_[i] = tmp_scale;
+      scales[i] = tmp_scale;
     }
     // TODO(itex): is_bias_const_ is useless, delete it
     if (!is_bias_const_ || bias_cache_manager.IsEmpty()) {
       dnnl::primitive_attr bias_attr;
       if (depth == 1) {
-        bias_attr.set_output_scales(0, scales_);
+        bias_attr.set_output_scales(0, scales);
       } else {
-        bias_attr.set_output_scales(1, scales_);
+        bias_attr.set_output_scales(1, scales);
       }
 
       auto bias_md = memory::desc({static_cast<int>(bias_tensor.NumElements())},
@@ -811,7 +827,7 @@ class OneDnnQuantizedConvOp
       // TODO(itex): Check whether the bias_md is always equals to
       // conv_pd.bias_desc()
       bias_cache_manager.SetCache(context, bias_md, bias_attr, bias_data,
-                                  this->onednn_engine_);
+                                  onednn_engine);
     }
     return bias_cache_manager.GetCache(context);
   }
@@ -830,7 +846,6 @@ class OneDnnQuantizedConvOp
   const int kDstMaxRangeIndex = 2;
 
  private:
-  std::vector<float> scales_;
   // Bias cache manager
   BiasCacheManager<Tbias> bias_cache_manager;
 };
@@ -852,11 +867,13 @@ class OneDnnQuantizedConvReluOp
   }
 
  protected:
-  void ExtendInt8PostOps(OpKernelContext* context) override {
+  void ExtendInt8PostOps(OpKernelContext* context,
+                         PostOpUtil* post_op_util) override {
     OneDnnQuantizedConvOp<Device, Tinput, Tbias, Toutput, Tsummand,
                           quantized_bias_enabled,
-                          is_depthwise>::ExtendInt8PostOps(context);
-    this->post_op_util_.SetPostOpScale("Relu", 1.0);
+                          is_depthwise>::ExtendInt8PostOps(context,
+                                                           post_op_util);
+    post_op_util->SetPostOpScale("Relu", 1.0);
   }
 };
 
@@ -887,10 +904,12 @@ class OneDnnQuantizedConvSumReluOp
   }
 
  protected:
-  void ExtendInt8PostOps(OpKernelContext* context) override {
+  void ExtendInt8PostOps(OpKernelContext* context,
+                         PostOpUtil* post_op_util) override {
     OneDnnQuantizedConvOp<Device, Tinput, Tbias, Toutput, Tsummand,
                           quantized_bias_enabled,
-                          is_depthwise>::ExtendInt8PostOps(context);
+                          is_depthwise>::ExtendInt8PostOps(context,
+                                                           post_op_util);
     // Calculate the scale (beta in OneDnn api term) for sum
     float sum_post_op_scale;
     if (std::is_same<Toutput, quint8>::value) {
@@ -925,11 +944,12 @@ class OneDnnQuantizedConvSumReluOp
       sum_post_op_scale = 1.0;
     }
 
-    this->post_op_util_.SetPostOpScale("Add", sum_post_op_scale);
-    this->post_op_util_.SetPostOpScale("Relu", 1.0);
+    post_op_util->SetPostOpScale("Add", sum_post_op_scale);
+    post_op_util->SetPostOpScale("Relu", 1.0);
   }
 
   void AllocateOutputTensor(OpKernelContext* context,
+                            const dnnl::engine& onednn_engine,
                             const ConvFwdPd& conv_prim_desc,
                             const memory::dims& output_dims_onednn_order,
                             OneDnnTensorFormat output_tf_format,
@@ -971,7 +991,8 @@ class OneDnnQuantizedConvSumReluOp
     // TODO(itex): investigate the influence of additional attr tensor_shape
     OneDnnConvOp<Device, Tinput, qint8, Tbias, Toutput, Tsummand, false,
                  quantized_bias_enabled,
-                 is_depthwise>::AllocateOutputTensor(context, conv_prim_desc,
+                 is_depthwise>::AllocateOutputTensor(context, onednn_engine,
+                                                     conv_prim_desc,
                                                      output_dims_onednn_order,
                                                      output_tf_format,
                                                      output_onednn_shape,
@@ -1029,15 +1050,15 @@ class OneDnnQuantizedConvSumReluOp
     void* dst_buf = static_cast<void*>((*dst_tensor)->flat<Tsummand>().data());
 
     memory summand_mem =
-        CreateDnnlMemory(summand_md, this->onednn_engine_, summand_buf);
-    memory dst_mem = CreateDnnlMemory(conv_prim_desc.dst_desc(),
-                                      this->onednn_engine_, dst_buf);
+        CreateDnnlMemory(summand_md, onednn_engine, summand_buf);
+    memory dst_mem =
+        CreateDnnlMemory(conv_prim_desc.dst_desc(), onednn_engine, dst_buf);
 
     dnnl::reorder summand_scaled_primitive =
         dnnl::reorder(summand_mem, dst_mem, reorder_attr);
     std::unordered_map<int, dnnl::memory> reorder_args = {
         {DNNL_ARG_SRC, summand_mem}, {DNNL_ARG_DST, dst_mem}};
-    auto onednn_stream = CreateDnnlStream(*context, this->onednn_engine_);
+    auto onednn_stream = CreateDnnlStream(*context, onednn_engine);
     summand_scaled_primitive.execute(onednn_stream, reorder_args);
   }
 
@@ -1199,6 +1220,14 @@ class OneDnnQuantizeV2WithQuantizedConv2DOp
       return;
     }
 
+    // `filter_mem_` points to the weight cache, which may be evicted since
+    // the last run. Init() fills it again.
+    if (this->is_filter_reordered_ && is_filter_const_ &&
+        weight_cache_manager_.IsEmpty()) {
+      Init(context, /*is_weight_evicted=*/true);
+      return;
+    }
+
     if (this->is_src_reordered_) {
       this->src_mem_input_.set_data_handle(
           context->tensor_data(this->kSrcIndex_));
@@ -1225,17 +1254,21 @@ class OneDnnQuantizeV2WithQuantizedConv2DOp
 
     if (this->post_op_util_.HasBias()) {
       const Tensor& bias_tensor = context->input(this->kBiasIndex_);
-      Tbias* bias_data = this->GetBiasHandle(context, bias_tensor);
+      Tbias* bias_data =
+          this->GetBiasHandle(context, this->onednn_engine_, bias_tensor);
       this->bias_mem_.set_data_handle(bias_data);
     }
-    AllocateOutputTensor(context, this->fwd_pd_, this->dst_dims_onednn_,
+    AllocateOutputTensor(context, this->onednn_engine_, this->fwd_pd_,
+                         this->dst_dims_onednn_,
                          this->data_fmt_onednn_, &this->dst_onednn_shape_,
                          this->dst_shape_, &this->dst_tensor_);
     this->dst_mem_.set_data_handle(reinterpret_cast<Tsummand*>(
         GetTensorBuffer<Toutput>(this->dst_tensor_)));
   }
 
-  void Init(OpKernelContext* context) {
+  // `is_weight_evicted` is set when the cached objects are recreated only to
+  // fill the evicted weight cache again.
+  void Init(OpKernelContext* context, bool is_weight_evicted = false) {
     try {
       this->fwd_primitives_args_.clear();
 
@@ -1358,7 +1391,7 @@ class OneDnnQuantizeV2WithQuantizedConv2DOp
       // 2. For int8 ops, set post op information during op compute, since there
       // is no "fused_ops" attr for these ops. We use "ExtendInt8PostOps" in
       // this situation
-      this->ExtendInt8PostOps(context);
+      this->ExtendInt8PostOps(context, &this->post_op_util_);
 
       // Create a convolution descriptor
       ConvFwdDesc fwd_desc =
@@ -1380,7 +1413,8 @@ class OneDnnQuantizeV2WithQuantizedConv2DOp
             src_md_prefer, filter_md_prefer, bias_md, dst_md, stride_dims,
             dilation_dims, pad_left_dims, pad_right_dims);
 
-        Tbias* bias_data = this->GetBiasHandle(context, bias_tensor);
+        Tbias* bias_data =
+            this->GetBiasHandle(context, this->onednn_engine_, bias_tensor);
         this->bias_mem_ =
             CreateDnnlMemory(bias_md, this->onednn_engine_, bias_data);
         this->fwd_primitives_args_.insert({DNNL_ARG_BIAS, this->bias_mem_});
@@ -1390,17 +1424,26 @@ class OneDnnQuantizeV2WithQuantizedConv2DOp
       dnnl::primitive_attr post_ops_attr;
       this->post_op_util_.SetPostOpAttr(&post_ops_attr);
       post_ops_attr.set_scratchpad_mode(dnnl::scratchpad_mode::user);
-      this->fwd_pd_ = ConvFwdPd(fwd_desc, post_ops_attr, this->onednn_engine_);
-
-      this->fwd_primitive_ = dnnl::convolution_forward(this->fwd_pd_);
+      {
+        ScopedPrimitiveCreation primitive_record(
+            this, "convolution",
+            is_weight_evicted ? PrimitiveCreateReason::kEviction
+            : this->is_init_  ? PrimitiveCreateReason::kShapeChange
+                              : PrimitiveCreateReason::kCold);
+        this->fwd_pd_ =
+            ConvFwdPd(fwd_desc, post_ops_attr, this->onednn_engine_);
+        this->fwd_primitive_ = dnnl::convolution_forward(this->fwd_pd_);
+        primitive_record.SetPrimitiveDesc(this->fwd_pd_);
+      }
 
       int64 dst_data_size =
           this->fwd_pd_.dst_desc().get_size() / sizeof(Toutput);
       this->dst_shape_ = TensorShape({dst_data_size});
 
-      AllocateOutputTensor(context, this->fwd_pd_, this->dst_dims_onednn_,
-                           this->data_fmt_onednn_, &this->dst_onednn_shape_,
-                           this->dst_shape_, &this->dst_tensor_);
+      AllocateOutputTensor(context, this->onednn_engine_, this->fwd_pd_,
+                           this->dst_dims_onednn_, this->data_fmt_onednn_,
+                           &this->dst_onednn_shape_, this->dst_shape_,
+                           &this->dst_tensor_);
 
       // add quantizeV2 logic
       int num_slices = 1;
@@ -1498,12 +1541,13 @@ class OneDnnQuantizeV2WithQuantizedConv2DOp
           }
           filter_cached_data = weight_cache_manager_.GetCache(
               context, this->fwd_pd_.weights_desc());
-          if (filter_cached_data != nullptr) {
-            this->filter_mem_ =
-                CreateDnnlMemory(this->fwd_pd_.weights_desc(),
-                                 this->onednn_engine_, filter_cached_data);
-          }
+        }
+        if (filter_cached_data != nullptr) {
+          this->filter_mem_ =
+              CreateDnnlMemory(this->fwd_pd_.weights_desc(),
+                               this->onednn_engine_, filter_cached_data);
         } else {
+          // Not const, or the cache was evicted.
           int64 reorder_filter_data_size =
               this->fwd_pd_.weights_desc().get_size() / sizeof(qint8);
           OP_REQUIRES_OK(context, context->allocate_temp(
@@ -1587,11 +1631,13 @@ class OneDnnQuantizeV2WithQuantizedConv2DOp
   }
 
  protected:
-  void ExtendInt8PostOps(OpKernelContext* context) override {
+  void ExtendInt8PostOps(OpKernelContext* context,
+                         PostOpUtil* post_op_util) override {
     OneDnnQuantizedConvOp<Device, Tinput, Tbias, Toutput, Tsummand,
                           quantized_bias_enabled,
-                          is_depthwise>::ExtendInt8PostOps(context);
-    this->post_op_util_.SetPostOpScale("Relu", 1.0);
+                          is_depthwise>::ExtendInt8PostOps(context,
+                                                           post_op_util);
+    post_op_util->SetPostOpScale("Relu", 1.0);
   }
 
   void AdjustInputMinMaxRange(OpKernelContext* context, float input_min_range,
@@ -1619,7 +1665,7 @@ class OneDnnQuantizeV2WithQuantizedConv2DOp
   }
 
   void AllocateOutputTensor(
-      OpKernelContext* context,
+      OpKernelContext* context, const dnnl::engine& onednn_engine,
       const dnnl::convolution_forward::primitive_desc& conv_pd,
       const memory::dims& dst_dims_onednn, OneDnnTensorFormat dst_tf_format,
       OneDnnShape* dst_onednn_shape, TensorShape tensor_shape,
@@ -1664,7 +1710,41 @@ class OneDnnQuantizeV2WithQuantizedConv2DOp
   // Weight cache manager
   WeightCacheManager<qint8> weight_cache_manager_;
 
+  // QuantizeV2 is fused into the src reorder, whose scale depends on the
+  // runtime input range, so this op keeps its memories in members and
+  // serializes Compute.
   mutex mu_compute_;
+  bool is_init_ = false;
+  bool is_input_zero_ = false;
+  bool is_src_reordered_ = false;
+  bool is_filter_reordered_ = false;
+  dnnl::memory src_mem_;
+  dnnl::memory src_mem_input_;
+  dnnl::memory filter_mem_;
+  dnnl::memory filter_mem_input_;
+  dnnl::memory dst_mem_;
+  dnnl::memory scratchpad_mem_;
+  dnnl::memory bias_mem_;
+  dnnl::memory::dims dst_dims_onednn_;
+  dnnl::stream onednn_stream_;
+  dnnl::engine onednn_engine_;
+  dnnl::reorder src_reorder_;
+  dnnl::reorder weight_reorder_;
+  primitive fwd_primitive_;
+  ConvFwdPd fwd_pd_;
+  std::unordered_map<int, memory> fwd_primitives_args_;
+  std::unordered_map<int, memory> src_reorder_args_;
+  std::unordered_map<int, memory> weight_reorder_args_;
+  OneDnnShape dst_onednn_shape_;
+  TensorShape dst_tf_shape_;
+  OneDnnTensorFormat data_fmt_onednn_;
+  TensorShape dst_shape_;
+  std::vector<int64> input_dims_;
+  OneDnnShape src_onednn_shape_;
+  Tensor* dst_tensor_ = nullptr;
+  Tensor src_data_output_;
+  Tensor tmp_weight_;
+  Tensor scratchpad_tensor_;
 
  private:
   bool pad_enabled = false;
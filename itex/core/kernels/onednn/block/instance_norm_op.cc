@@ -14,8 +14,11 @@ limitations under the License.
 ==============================================================================*/
 
 #include "itex/core/devices/xpu_device_util.h"
+#include "itex/core/kernels/common/instance_norm_op.h"
 #include "itex/core/utils/errors.h"
+#include "itex/core/utils/mutex.h"
 #include "itex/core/utils/onednn/onednn_layout_util.h"
+#include "itex/core/utils/onednn/onednn_primitive_log.h"
 #include "itex/core/utils/onednn/onednn_util.h"
 #include "itex/core/utils/op_kernel.h"
 #include "itex/core/utils/op_requires.h"
@@ -61,6 +64,8 @@ class OneDnnInstanceNormOp : public OpKernel {
                                   "only support Relu and LeakyRelu"));
       }
     }
+
+    enable_cache_ = IsOneDnnObjectCacheEnabled();
   }
 
   void Compute(OpKernelContext* context) override {
@@ -142,6 +147,33 @@ class OneDnnInstanceNormOp : public OpKernel {
       int batch_size = src_tf_shape.dim_size(0);
       const int64_t elems_per_batch = src_tf_shape.num_elements() / batch_size;
 
+      // Plain channels-last input doesn't need oneDNN at all.
+      if (!src_onednn_shape.IsOneDnnTensor() &&
+          !scale_onednn_shape.IsOneDnnTensor() &&
+          !shift_onednn_shape.IsOneDnnTensor() &&
+          CanUseInstanceNormChannelsLast<Device>(tensor_format_, src_tf_shape,
+                                                 scale_tensor, shift_tensor)) {
+        dst_onednn_shape.SetOneDnnTensor(false);
+        AllocateOutputSetOneDnnShape(context, kDstIndex, &dst_tensor,
+                                     src_tf_shape, dst_onednn_shape);
+        const int64 channels = src_tf_shape.dim_size(src_tf_shape.dims() - 1);
+        InstanceNormChannelsLast instance_norm(
+            batch_size, elems_per_batch / channels, channels);
+        Tensor workspace_tensor;
+        OP_REQUIRES_OK(
+            context,
+            context->allocate_temp(DT_FLOAT,
+                                   TensorShape({instance_norm.WorkspaceSize()}),
+                                   &workspace_tensor));
+        instance_norm.Compute<T, U>(
+            context->eigen_cpu_device(), src_tensor.flat<T>().data(),
+            scale_tensor.flat<U>().data(), shift_tensor.flat<U>().data(),
+            epsilon_, fuse_activation, leakyrelu_alpha_,
+            workspace_tensor.flat<float>().data(),
+            dst_tensor->flat<T>().data());
+        return;
+      }
+
       dnnl::memory::dims src_dims;
       bool use_3d_format = src_tf_shape.dims() == 5;
 
@@ -211,31 +243,43 @@ class OneDnnInstanceNormOp : public OpKernel {
                       onednn_engine);
       }
 
-      // Create fwd primitive.
-      auto propagation = dnnl::prop_kind::forward_inference;
-      auto flags = dnnl::normalization_flags::use_scale |
-                   dnnl::normalization_flags::use_shift;
-
-      dnnl::batch_normalization_forward::desc bn_fwd_desc(propagation, src_md,
-                                                          epsilon_, flags);
-      dnnl::primitive_attr attr;
-      attr.set_scratchpad_mode(dnnl::scratchpad_mode::user);
+      // The primitive only depends on the per-instance shape, so it is shared
+      // by all batches and reused across steps when caching is enabled.
       dnnl::batch_normalization_forward::primitive_desc bn_fwd_pd;
-
-      if (fuse_activation) {
-        dnnl::post_ops post_ops;
-        post_ops.append_eltwise(1.0, dnnl::algorithm::eltwise_relu,
-                                leakyrelu_alpha_, 0.0);
-        attr.set_post_ops(post_ops);
-        bn_fwd_pd = dnnl::batch_normalization_forward::primitive_desc(
-            bn_fwd_desc, attr, onednn_engine);
-      } else {
-        bn_fwd_pd = dnnl::batch_normalization_forward::primitive_desc(
-            bn_fwd_desc, onednn_engine);
+      dnnl::batch_normalization_forward bn_fwd_primitive;
+      {
+        mutex_lock lock(&mu_compute_);
+        if (!(enable_cache_ && is_init_ && src_dims == cached_src_dims_)) {
+          ScopedPrimitiveCreation record(
+              this, "batch_normalization",
+              is_init_ ? PrimitiveCreateReason::kShapeChange
+                       : PrimitiveCreateReason::kCold);
+          // Create fwd primitive.
+          auto propagation = dnnl::prop_kind::forward_inference;
+          auto flags = dnnl::normalization_flags::use_scale |
+                       dnnl::normalization_flags::use_shift;
+
+          dnnl::batch_normalization_forward::desc bn_fwd_desc(
+              propagation, src_md, epsilon_, flags);
+          dnnl::primitive_attr attr;
+          attr.set_scratchpad_mode(dnnl::scratchpad_mode::user);
+          if (fuse_activation) {
+            dnnl::post_ops post_ops;
+            post_ops.append_eltwise(1.0, dnnl::algorithm::eltwise_relu,
+                                    leakyrelu_alpha_, 0.0);
+            attr.set_post_ops(post_ops);
+          }
+          bn_fwd_pd_ = dnnl::batch_normalization_forward::primitive_desc(
+              bn_fwd_desc, attr, onednn_engine);
+          bn_fwd_primitive_ = dnnl::batch_normalization_forward(bn_fwd_pd_);
+          record.SetPrimitiveDesc(bn_fwd_pd_);
+          cached_src_dims_ = src_dims;
+          is_init_ = true;
+        }
+        bn_fwd_pd = bn_fwd_pd_;
+        bn_fwd_primitive = bn_fwd_primitive_;
       }
 
-      dnnl::batch_normalization_forward bn_fwd_primitive(bn_fwd_pd);
-
       // Allocate output dst tensor.
       TensorShape dst_tf_shape = src_tf_shape;
       SetOutputTensorShape(src_md_order, onednn_tensor_fmt, &dst_tf_shape,
@@ -300,9 +344,18 @@ class OneDnnInstanceNormOp : public OpKernel {
 
  private:
   float epsilon_;
-  float leakyrelu_alpha_;
+  float leakyrelu_alpha_ = 0.0f;
   TensorFormat tensor_format_;
   string data_format;
+
+  bool enable_cache_ = false;
+  bool is_init_ = false;
+  mutex mu_compute_;
+  dnnl::memory::dims cached_src_dims_ TF_GUARDED_BY(mu_compute_);
+  dnnl::batch_normalization_forward::primitive_desc bn_fwd_pd_
+      TF_GUARDED_BY(mu_compute_);
+  dnnl::batch_normalization_forward bn_fwd_primitive_
+      TF_GUARDED_BY(mu_compute_);
 };
 
 #ifndef INTEL_CPU_ONLY
@@ -203,6 +203,7 @@ class OneDnnLayerNormOp : public OpKernel {
       auto shift_mem = CreateDnnlMemory(shift_md, onednn_engine, shift_data);
 
       dnnl::memory scale_cached_mem, shift_cached_mem;
+      Tensor scale_fp32_tensor, shift_fp32_tensor;
 
       if (IsScaleShiftBF16()) {
         const dnnl::memory::desc scale_fp32_md = dnnl::memory::desc(
@@ -222,7 +223,14 @@ class OneDnnLayerNormOp : public OpKernel {
               CreateDnnlMemory(scale_fp32_md, onednn_engine, scale_cached_data);
 
         } else {
-          ITEX_LOG(FATAL) << "Wrong cache for _OneDnnMklLayerNorm scale tensor";
+          // Not cached, convert into a temporary buffer.
+          OP_REQUIRES_OK(context, context->allocate_temp(
+                                      DT_FLOAT, TensorShape({depth_}),
+                                      &scale_fp32_tensor));
+          scale_cached_mem = CreateDnnlMemory(
+              scale_fp32_md, onednn_engine,
+              GetTensorBuffer<float>(&scale_fp32_tensor));
+          ReorderMemory(*context, &scale_mem, &scale_cached_mem, onednn_engine);
         }
 
         const dnnl::memory::desc shift_fp32_md = dnnl::memory::desc(
@@ -239,7 +247,14 @@ class OneDnnLayerNormOp : public OpKernel {
           shift_cached_mem =
               CreateDnnlMemory(shift_fp32_md, onednn_engine, shift_cached_data);
         } else {
-          ITEX_LOG(FATAL) << "Wrong cache for _OneDnnMklLayerNorm shift tensor";
+          // Not cached, convert into a temporary buffer.
+          OP_REQUIRES_OK(context, context->allocate_temp(
+                                      DT_FLOAT, TensorShape({depth_}),
+                                      &shift_fp32_tensor));
+          shift_cached_mem = CreateDnnlMemory(
+              shift_fp32_md, onednn_engine,
+              GetTensorBuffer<float>(&shift_fp32_tensor));
+          ReorderMemory(*context, &shift_mem, &shift_cached_mem, onednn_engine);
         }
       }
 
@@ -15,12 +15,15 @@ limitations under the License.
 
 #include "itex/core/kernels/onednn/block/matmul_op.h"
 
+#include <memory>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "itex/core/utils/errors.h"
 #include "itex/core/utils/onednn/onednn_layout_util.h"
+#include "itex/core/utils/onednn/onednn_primitive_log.h"
 #include "itex/core/utils/onednn/onednn_util.h"
 #include "itex/core/utils/op_kernel.h"
 #include "itex/core/utils/op_requires.h"
@@ -64,8 +67,7 @@ class OneDnnMatMulOp : public OneDnnMatMulBaseOp<Device, T> {
     }
     this->fp32_math_mode_ = GetFP32MathMode<Device>();
 
-    ITEX_CHECK_OK(
-        ReadBoolFromEnvVar("ITEX_CACHE_ONEDNN_OBJECT", false, &enable_cache_));
+    enable_cache_ = IsOneDnnObjectCacheEnabled();
   }
 
   memory::desc CreateMatMulMemoryDesc(memory::dims md, bool is_adjoint) {
@@ -74,131 +76,88 @@ class OneDnnMatMulOp : public OneDnnMatMulBaseOp<Device, T> {
     return memory::desc(md, OneDnnType<T>(), memory::format_tag::ab);
   }
 
-  void InitOrSetMemory(OpKernelContext* context) {
-    if (!(enable_cache_ && is_init_ &&
-          IsInputSame(context, 0, input_dims_, src_onednn_shape_) &&
-          IsInputSame(context, 1, weight_dims_, weight_onednn_shape_))) {
-      Init(context);
-      return;
-    }
-
-    if (is_input_zero_) {
-      OneDnnShape dst_onednn_shape;
-      dst_onednn_shape.SetOneDnnTensor(false);
-      AllocateOutputSetOneDnnShape(context, kDstIndex_, &dst_tensor_,
-                                   dst_tf_shape_, dst_onednn_shape_);
-      return;
-    }
-
-    if (is_src_reordered_) {
-      src_mem_.set_data_handle(context->tensor_data(kSrcIndex_));
-      src_reorder_mem_.set_data_handle(
-          GetTensorBuffer<T>(&src_reorder_tensor_));
-      ReorderMemory(*context, &src_mem_, &src_reorder_mem_, onednn_engine_);
-    } else {
-      src_mem_.set_data_handle(context->tensor_data(kSrcIndex_));
-    }
-
-    if (is_weight_reordered_) {
-      if (!this->is_filter_const_) {
-        weight_mem_.set_data_handle(context->tensor_data(kWeightIndex_));
-        weight_reorder_mem_.set_data_handle(
-            GetTensorBuffer<T>(&weight_reorder_tensor_));
-        ReorderMemory(*context, &weight_mem_, &weight_reorder_mem_,
-                      onednn_engine_);
-      }
-    } else {
-      // No reorder needed
-      weight_mem_.set_data_handle(context->tensor_data(kWeightIndex_));
+  // Everything derived from the input signature. A plan is immutable once
+  // created, so concurrent Compute() calls on the same node share it and only
+  // bind their own memories and temporaries.
+  struct MatMulPlan {
+    std::vector<int64> input_dims, weight_dims;
+    OneDnnShape src_onednn_shape, weight_onednn_shape;
+    bool is_input_zero = false;
+    bool is_src_reordered = false, is_weight_reordered = false;
+    TensorShape dst_tf_shape;
+    OneDnnShape dst_onednn_shape;
+    memory::dims dst_dims;
+    memory::desc src_md, weight_md;
+    matmul::primitive_desc fwd_pd;
+    matmul fwd_primitive;
+  };
+
+  // Returns the cached plan if it matches current inputs, otherwise nullptr.
+  // `is_init` tells whether any plan was created before.
+  std::shared_ptr<const MatMulPlan> LookupPlan(OpKernelContext* context,
+                                               bool* is_init)
+      TF_LOCKS_EXCLUDED(mu_compute_) {
+    std::shared_ptr<const MatMulPlan> plan;
+    {
+      mutex_lock lock(&mu_compute_);
+      *is_init = is_init_;
+      plan = plan_;
     }
-
-    // Allocate output data tensor, whether the output layout is blocked or
-    // not relies on the result of IsBlockedMd
-    SetOutputTensorShape(fwd_pd_.dst_desc(), OneDnnTensorFormat::FORMAT_NC,
-                         &dst_tf_shape_, &dst_onednn_shape_,
-                         IsBlockedMd(fwd_pd_.dst_desc()));
-
-    // Handle Add fusion.
-    if (this->post_op_util_.HasAdd()) {
-      int is_forward_success = kUnsuccess_;
-      add_tensor_ = &context->input(kAddIndex_);
-
-      if (add_onednn_shape_ == dst_onednn_shape_) {
-        // Try to do in-place.
-        if (this->inplace_sum_) {
-          context->set_output(kDstIndex_, *add_tensor_);
-          ForwardMetaData(context, kAddIndex_, kDstIndex_, dst_onednn_shape_);
-          dst_tensor_ = context->mutable_output(kDstIndex_);
-          is_forward_success = kAddIndex_;
-        } else {
-          ForwardOrAllocateOutputSetOneDnnShape(
-              context, kAddIndex_, kDstIndex_, &dst_tensor_, dst_tf_shape_,
-              dst_onednn_shape_, &is_forward_success);
-        }
-      }
-      // Reorder is needed. Check `dst_tensor_` first:
-      //   1) nullptr, add shape is different with dst shape;
-      //   2) not nullptr, forward is failed but dst has been allocated;
-      if (dst_tensor_ == nullptr) {
-        AllocateOutputSetOneDnnShape(context, kDstIndex_, &dst_tensor_,
-                                     dst_tf_shape_, dst_onednn_shape_);
-      }
-      if (is_forward_success == kUnsuccess_) {
-        fuse_add_src_mem_.set_data_handle(GetTensorBuffer<T>(add_tensor_));
-        fuse_add_dst_mem_.set_data_handle(GetTensorBuffer<T>(dst_tensor_));
-        ReorderMemory(*context, &fuse_add_src_mem_, &fuse_add_dst_mem_,
-                      onednn_engine_);
-      }
-    } else {
-      AllocateOutputSetOneDnnShape(context, kDstIndex_, &dst_tensor_,
-                                   dst_tf_shape_, dst_onednn_shape_);
+    if (plan != nullptr &&
+        IsInputSame(context, 0, plan->input_dims, plan->src_onednn_shape) &&
+        IsInputSame(context, 1, plan->weight_dims, plan->weight_onednn_shape)) {
+      return plan;
     }
+    return nullptr;
+  }
 
-    if (this->post_op_util_.HasBias()) {
-      bias_mem_.set_data_handle(context->tensor_data(kBiasIndex_));
-    }
-    dst_mem_.set_data_handle(GetTensorBuffer<T>(dst_tensor_));
+  void InsertPlan(std::shared_ptr<const MatMulPlan> plan)
+      TF_LOCKS_EXCLUDED(mu_compute_) {
+    mutex_lock lock(&mu_compute_);
+    is_init_ = true;
+    if (enable_cache_) plan_ = std::move(plan);
   }
 
-  void Init(OpKernelContext* context) {
+  void CreatePlan(OpKernelContext* context, PrimitiveCreateReason reason,
+                  std::shared_ptr<MatMulPlan>* plan_ptr) {
     try {
       const Tensor& src_tensor = context->input(kSrcIndex_);
       const Tensor& weight_tensor = context->input(kWeightIndex_);
+      auto plan = std::make_shared<MatMulPlan>();
 
-      GetOneDnnShape(context, kSrcIndex_, &src_onednn_shape_);
-      GetOneDnnShape(context, kWeightIndex_, &weight_onednn_shape_);
-      fwd_primitive_args_.clear();
+      GetOneDnnShape(context, kSrcIndex_, &plan->src_onednn_shape);
+      GetOneDnnShape(context, kWeightIndex_, &plan->weight_onednn_shape);
+      const OneDnnShape& src_onednn_shape = plan->src_onednn_shape;
+      const OneDnnShape& weight_onednn_shape = plan->weight_onednn_shape;
 
       auto input_shape = src_tensor.shape();
-      input_dims_.clear();
       for (int i = 0; i < input_shape.dims(); ++i) {
-        input_dims_.push_back(input_shape.dim_size(i));
+        plan->input_dims.push_back(input_shape.dim_size(i));
       }
       auto weight_tensor_shape = weight_tensor.shape();
-      weight_dims_.clear();
       for (int i = 0; i < weight_tensor_shape.dims(); ++i) {
-        weight_dims_.push_back(weight_tensor_shape.dim_size(i));
+        plan->weight_dims.push_back(weight_tensor_shape.dim_size(i));
       }
 
       OP_REQUIRES(context,
                   (Eigen::internal::is_same<Device, CPUDevice>::value ||
-                   !(this->transpose_a_ && src_onednn_shape_.IsOneDnnTensor())),
+                   !(this->transpose_a_ && src_onednn_shape.IsOneDnnTensor())),
                   errors::InvalidArgument(
                       "OneDnnMatMul with block layout input and "
                       "transpose_a = true is only supported on CPU"));
       OP_REQUIRES(
           context,
           (Eigen::internal::is_same<Device, CPUDevice>::value ||
-           !(this->transpose_b_ && weight_onednn_shape_.IsOneDnnTensor())),
+           !(this->transpose_b_ && weight_onednn_shape.IsOneDnnTensor())),
           errors::InvalidArgument(
               "OneDnnMatMul with block layout weight and transpose_b = true "
               "is only supported on CPU"));
 
-      TensorShape src_tf_shape = src_onednn_shape_.IsOneDnnTensor()
-                                     ? src_onednn_shape_.GetTfShape()
+      TensorShape src_tf_shape = src_onednn_shape.IsOneDnnTensor()
+                                     ? src_onednn_shape.GetTfShape()
                                      : src_tensor.shape();
-      TensorShape weight_tf_shape = weight_onednn_shape_.IsOneDnnTensor()
-                                        ? weight_onednn_shape_.GetTfShape()
+      TensorShape weight_tf_shape = weight_onednn_shape.IsOneDnnTensor()
+                                        ? weight_onednn_shape.GetTfShape()
                                         : weight_tensor.shape();
       const int batch = this->transpose_a_ ? src_tf_shape.dim_size(1)
                                            : src_tf_shape.dim_size(0);
@@ -209,41 +168,38 @@ class OneDnnMatMulOp : public OneDnnMatMulBaseOp<Device, T> {
 
       memory::dims src_dims = {batch, k};
       memory::dims weight_dims = {k, channel};
+      plan->dst_dims = {src_dims[0], weight_dims[1]};
+      plan->dst_tf_shape = {src_dims[0], weight_dims[1]};
 
-      dst_tf_shape_ = {src_dims[0], weight_dims[1]};
-
-      if (dst_tf_shape_.num_elements() == 0) {
-        is_input_zero_ = true;
-        OneDnnShape dst_onednn_shape;
-        dst_onednn_shape.SetOneDnnTensor(false);
-        AllocateOutputSetOneDnnShape(context, kDstIndex_, &dst_tensor_,
-                                     dst_tf_shape_, dst_onednn_shape_);
-        is_init_ = true;
+      if (plan->dst_tf_shape.num_elements() == 0) {
+        plan->is_input_zero = true;
+        plan->dst_onednn_shape.SetOneDnnTensor(false);
+        *plan_ptr = std::move(plan);
         return;
       }
 
-      auto src_md =
-          src_onednn_shape_.IsOneDnnTensor()
-              ? src_onednn_shape_.GetOneDnnLayout()
+      auto onednn_engine = CreateDnnlEngine<Device>(*context);
+      plan->src_md =
+          src_onednn_shape.IsOneDnnTensor()
+              ? src_onednn_shape.GetOneDnnLayout()
               : memory::desc(src_dims, OneDnnType<T>(),
                              this->transpose_a_ ? memory::format_tag::ba
                                                 : memory::format_tag::ab);
-      auto weight_md =
-          weight_onednn_shape_.IsOneDnnTensor()
-              ? weight_onednn_shape_.GetOneDnnLayout()
+      plan->weight_md =
+          weight_onednn_shape.IsOneDnnTensor()
+              ? weight_onednn_shape.GetOneDnnLayout()
               : memory::desc(weight_dims, OneDnnType<T>(),
                              this->transpose_b_ ? memory::format_tag::ba
                                                 : memory::format_tag::ab);
-      memory::dims dst_dims = {src_dims[0], weight_dims[1]};
 
       // Use any format if:
       // 1. Input tensor is not oneDNN tensor, then it can be reordered to
       //    blocked format anyway
       // 2. Input tensor is oneDNN tensor, and it's not transposed
       bool is_src_any =
-          !(src_onednn_shape_.IsOneDnnTensor() && this->transpose_a_);
+          !(src_onednn_shape.IsOneDnnTensor() && this->transpose_a_);
       bool is_wei_any =
-          !(weight_onednn_shape_.IsOneDnnTensor() && this->transpose_b_);
+          !(weight_onednn_shape.IsOneDnnTensor() && this->transpose_b_);
 
       auto src_exec_md =
           is_src_any
@@ -253,7 +209,7 @@ class OneDnnMatMulOp : public OneDnnMatMulBaseOp<Device, T> {
           is_wei_any ? memory::desc(weight_dims, OneDnnType<T>(),
                                     memory::format_tag::any)
                      : CreateMatMulMemoryDesc(weight_dims, this->transpose_b_);
-      auto dst_exec_md = this->CreateMemoryDescWithStrides(dst_dims);
+      auto dst_exec_md = this->CreateMemoryDescWithStrides(plan->dst_dims);
 
       // Check post ops.
       dnnl::primitive_attr post_op_attr;
@@ -263,163 +219,193 @@ class OneDnnMatMulOp : public OneDnnMatMulBaseOp<Device, T> {
         post_op_attr.set_fpmath_mode(this->fp32_math_mode_);
       }
 
-      if (this->post_op_util_.HasBias()) {
-        memory::desc bias_any_md = memory::desc(
-            {1, weight_dims[1]}, OneDnnType<T>(), memory::format_tag::ab);
-        matmul::desc matmul_d =
-            matmul::desc(src_exec_md, weight_exec_md, bias_any_md, dst_exec_md);
-        fwd_pd_ =
-            matmul::primitive_desc(matmul_d, post_op_attr, onednn_engine_);
-      } else {
-        matmul::desc matmul_d =
-            matmul::desc(src_exec_md, weight_exec_md, dst_exec_md);
-        fwd_pd_ =
-            matmul::primitive_desc(matmul_d, post_op_attr, onednn_engine_);
+      {
+        ScopedPrimitiveCreation primitive_record(this, "matmul", reason);
+        if (this->post_op_util_.HasBias()) {
+          memory::desc bias_any_md = memory::desc(
+              {1, weight_dims[1]}, OneDnnType<T>(), memory::format_tag::ab);
+          matmul::desc matmul_d = matmul::desc(src_exec_md, weight_exec_md,
+                                               bias_any_md, dst_exec_md);
+          plan->fwd_pd =
+              matmul::primitive_desc(matmul_d, post_op_attr, onednn_engine);
+        } else {
+          matmul::desc matmul_d =
+              matmul::desc(src_exec_md, weight_exec_md, dst_exec_md);
+          plan->fwd_pd =
+              matmul::primitive_desc(matmul_d, post_op_attr, onednn_engine);
+        }
+        plan->fwd_primitive = matmul(plan->fwd_pd);
+        primitive_record.SetPrimitiveDesc(plan->fwd_pd);
       }
-      fwd_primitive_ = matmul(fwd_pd_);
-      // Create src memory, check if src needs to be reordered
-      src_mem_ = CreateDnnlMemory(src_md, onednn_engine_,
-                                  GetTensorBuffer<T>(&src_tensor));
-
-      is_src_reordered_ = (src_md != fwd_pd_.src_desc());
-      if (is_src_reordered_) {
-        int64 src_reorder_size = fwd_pd_.src_desc().get_size() / sizeof(T);
+      plan->is_src_reordered = (plan->src_md != plan->fwd_pd.src_desc());
+      plan->is_weight_reordered =
+          (plan->weight_md != plan->fwd_pd.weights_desc());
+
+      // Whether the output layout is blocked or not relies on the result of
+      // IsBlockedMd
+      SetOutputTensorShape(plan->fwd_pd.dst_desc(),
+                           OneDnnTensorFormat::FORMAT_NC, &plan->dst_tf_shape,
+                           &plan->dst_onednn_shape,
+                           IsBlockedMd(plan->fwd_pd.dst_desc()));
+      *plan_ptr = std::move(plan);
+    } catch (dnnl::error& e) {
+      string error_msg = "Status: " + std::to_string(e.status) +
+                         ", message: " + string(e.message) + ", in file " +
+                         string(__FILE__) + ":" + std::to_string(__LINE__);
+      OP_REQUIRES_OK(
+          context,
+          errors::Aborted("Operation received an exception:", error_msg));
+    }
+  }
+
+  // Binds current inputs and outputs to the plan and runs it. Nothing in the
+  // kernel is written here, except the thread-safe weight cache.
+  void Execute(OpKernelContext* context, const MatMulPlan& plan) {
+    Tensor* dst_tensor = nullptr;
+    if (plan.is_input_zero) {
+      AllocateOutputSetOneDnnShape(context, kDstIndex_, &dst_tensor,
+                                   plan.dst_tf_shape, plan.dst_onednn_shape);
+      return;
+    }
+
+    try {
+      auto onednn_engine = CreateDnnlEngine<Device>(*context);
+      // onednn_stream has thread safety issue, need create a new one in
+      // every compute.
+      auto onednn_stream = CreateDnnlStream(*context, onednn_engine);
+      const Tensor& src_tensor = context->input(kSrcIndex_);
+      const Tensor& weight_tensor = context->input(kWeightIndex_);
+
+      // Reorder src if needed.
+      memory src_mem = CreateDnnlMemory(plan.src_md, onednn_engine,
+                                        GetTensorBuffer<T>(&src_tensor));
+      Tensor src_reorder_tensor;
+      if (plan.is_src_reordered) {
+        int64 src_reorder_size = plan.fwd_pd.src_desc().get_size() / sizeof(T);
         OP_REQUIRES_OK(context,
                        context->allocate_temp(DataTypeToEnum<T>::v(),
                                               TensorShape({src_reorder_size}),
-                                              &src_reorder_tensor_));
-        src_reorder_mem_ =
-            CreateDnnlMemory(fwd_pd_.src_desc(), onednn_engine_,
-                             GetTensorBuffer<T>(&src_reorder_tensor_));
-        ReorderMemory(*context, &src_mem_, &src_reorder_mem_, onednn_engine_);
+                                              &src_reorder_tensor));
+        memory src_reorder_mem =
+            CreateDnnlMemory(plan.fwd_pd.src_desc(), onednn_engine,
+                             GetTensorBuffer<T>(&src_reorder_tensor));
+        ReorderMemory(*context, &src_mem, &src_reorder_mem, onednn_engine);
+        src_mem = src_reorder_mem;
       }
 
-      memory::desc expected_md = fwd_pd_.weights_desc();
-
-      is_weight_reordered_ = (weight_md != expected_md);
-      if (is_weight_reordered_) {
+      // Reorder weight if needed, const weight is reordered only once.
+      memory weight_mem = CreateDnnlMemory(plan.weight_md, onednn_engine,
+                                           GetTensorBuffer<T>(&weight_tensor));
+      Tensor weight_reorder_tensor;
+      if (plan.is_weight_reordered) {
+        memory::desc expected_md = plan.fwd_pd.weights_desc();
         T* weight_cached_data = nullptr;
         if (this->is_filter_const_) {
           if (this->weight_cache_manager_.IsEmpty()) {
             // Cache weight in first time executing this node
             this->weight_cache_manager_.SetCache(
-                context, weight_md, expected_md,
-                GetTensorBuffer<T>(&weight_tensor), onednn_engine_);
+                context, plan.weight_md, expected_md,
+                GetTensorBuffer<T>(&weight_tensor), onednn_engine);
           }
 
           weight_cached_data =
               this->weight_cache_manager_.GetCache(context, expected_md);
         }
         if (weight_cached_data != nullptr) {
-          weight_reorder_mem_ =
-              CreateDnnlMemory(expected_md, onednn_engine_, weight_cached_data);
+          weight_mem =
+              CreateDnnlMemory(expected_md, onednn_engine, weight_cached_data);
         } else {
           // During training, reorder weight in each iteration
-          weight_mem_ = CreateDnnlMemory(weight_md, onednn_engine_,
-                                         GetTensorBuffer<T>(&weight_tensor));
-
-          int64 weight_reorder_size =
-              fwd_pd_.weights_desc().get_size() / sizeof(T);
+          int64 weight_reorder_size = expected_md.get_size() / sizeof(T);
           OP_REQUIRES_OK(context, context->allocate_temp(
                                       DataTypeToEnum<T>::v(),
                                       TensorShape({weight_reorder_size}),
-                                      &weight_reorder_tensor_));
-          weight_reorder_mem_ =
-              CreateDnnlMemory(expected_md, onednn_engine_,
-                               GetTensorBuffer<T>(&weight_reorder_tensor_));
-          ReorderMemory(*context, &weight_mem_, &weight_reorder_mem_,
-                        onednn_engine_);
+                                      &weight_reorder_tensor));
+          memory weight_reorder_mem =
+              CreateDnnlMemory(expected_md, onednn_engine,
+                               GetTensorBuffer<T>(&weight_reorder_tensor));
+          ReorderMemory(*context, &weight_mem, &weight_reorder_mem,
+                        onednn_engine);
+          weight_mem = weight_reorder_mem;
         }
-      } else {
-        // No reorder needed
-        weight_mem_ = CreateDnnlMemory(weight_md, onednn_engine_,
-                                       GetTensorBuffer<T>(&weight_tensor));
       }
 
-      // Allocate output data tensor, whether the output layout is blocked or
-      // not relies on the result of IsBlockedMd
-      SetOutputTensorShape(fwd_pd_.dst_desc(), OneDnnTensorFormat::FORMAT_NC,
-                           &dst_tf_shape_, &dst_onednn_shape_,
-                           IsBlockedMd(fwd_pd_.dst_desc()));
-
       // Handle Add fusion.
       if (this->post_op_util_.HasAdd()) {
-        add_tensor_ = &context->input(kAddIndex_);
-        GetOneDnnShape(context, kAddIndex_, &add_onednn_shape_);
+        const Tensor* add_tensor = &context->input(kAddIndex_);
+        OneDnnShape add_onednn_shape;
+        GetOneDnnShape(context, kAddIndex_, &add_onednn_shape);
         int is_forward_success = kUnsuccess_;
         // Try to do in-place.
-        if (add_onednn_shape_ == dst_onednn_shape_) {
+        if (add_onednn_shape == plan.dst_onednn_shape) {
           // TODO(itex): Remove this workaround when inplace works.
           if (this->inplace_sum_) {
-            context->set_output(kDstIndex_, *add_tensor_);
-            ForwardMetaData(context, kAddIndex_, kDstIndex_, dst_onednn_shape_);
-            dst_tensor_ = context->mutable_output(kDstIndex_);
+            context->set_output(kDstIndex_, *add_tensor);
+            ForwardMetaData(context, kAddIndex_, kDstIndex_,
+                            plan.dst_onednn_shape);
+            dst_tensor = context->mutable_output(kDstIndex_);
             is_forward_success = kAddIndex_;
           } else {
             ForwardOrAllocateOutputSetOneDnnShape(
-                context, kAddIndex_, kDstIndex_, &dst_tensor_, dst_tf_shape_,
-                dst_onednn_shape_, &is_forward_success);
+                context, kAddIndex_, kDstIndex_, &dst_tensor,
+                plan.dst_tf_shape, plan.dst_onednn_shape, &is_forward_success);
           }
         }
 
-        // Reorder is needed. Check `dst_tensor_` first:
+        // Reorder is needed. Check `dst_tensor` first:
         //   1) nullptr, add shape is different with dst shape;
         //   2) not nullptr, forward is failed but dst has been allocated;
-        if (dst_tensor_ == nullptr) {
-          AllocateOutputSetOneDnnShape(context, kDstIndex_, &dst_tensor_,
-                                       dst_tf_shape_, dst_onednn_shape_);
+        if (dst_tensor == nullptr) {
+          AllocateOutputSetOneDnnShape(context, kDstIndex_, &dst_tensor,
+                                       plan.dst_tf_shape,
+                                       plan.dst_onednn_shape);
         }
 
         if (is_forward_success == kUnsuccess_) {
           // In-place do not success, need reorder.
-          auto add_md = add_onednn_shape_.IsOneDnnTensor()
-                            ? add_onednn_shape_.GetOneDnnLayout()
-                            : memory::desc(dst_dims, OneDnnType<T>(),
+          auto add_md = add_onednn_shape.IsOneDnnTensor()
+                            ? add_onednn_shape.GetOneDnnLayout()
+                            : memory::desc(plan.dst_dims, OneDnnType<T>(),
                                            memory::format_tag::ab);
-          fuse_add_src_mem_ = CreateDnnlMemory(add_md, onednn_engine_,
-                                               GetTensorBuffer<T>(add_tensor_));
-          fuse_add_dst_mem_ =
-              CreateDnnlMemory(fwd_pd_.dst_desc(), onednn_engine_,
-                               GetTensorBuffer<T>(dst_tensor_));
-          ReorderMemory(*context, &fuse_add_src_mem_, &fuse_add_dst_mem_,
-                        onednn_engine_);
+          memory fuse_add_src_mem = CreateDnnlMemory(
+              add_md, onednn_engine, GetTensorBuffer<T>(add_tensor));
+          memory fuse_add_dst_mem =
+              CreateDnnlMemory(plan.fwd_pd.dst_desc(), onednn_engine,
+                               GetTensorBuffer<T>(dst_tensor));
+          ReorderMemory(*context, &fuse_add_src_mem, &fuse_add_dst_mem,
+                        onednn_engine);
         }
       } else {
-        AllocateOutputSetOneDnnShape(context, kDstIndex_, &dst_tensor_,
-                                     dst_tf_shape_, dst_onednn_shape_);
+        AllocateOutputSetOneDnnShape(context, kDstIndex_, &dst_tensor,
+                                     plan.dst_tf_shape, plan.dst_onednn_shape);
       }
 
-      // Create dst memory
-      T* dst_data = dst_tensor_->flat<T>().data();
-      dst_mem_ = CreateDnnlMemory(fwd_pd_.dst_desc(), onednn_engine_,
-                                  static_cast<void*>(dst_data));
-
-      int64 scratchpad_size = fwd_pd_.scratchpad_desc().get_size() / sizeof(T);
+      Tensor scratchpad_tensor;
+      int64 scratchpad_size =
+          plan.fwd_pd.scratchpad_desc().get_size() / sizeof(T);
       OP_REQUIRES_OK(context,
                      context->allocate_temp(DataTypeToEnum<T>::v(),
                                             TensorShape({scratchpad_size}),
-                                            &scratchpad_tensor_));
-      scratchpad_mem_ = dnnl::memory(fwd_pd_.scratchpad_desc(), onednn_engine_,
-                                     GetTensorBuffer<T>(&scratchpad_tensor_));
-
-      // Execute MatMul
-      onednn_stream_ = CreateDnnlStream(*context, onednn_engine_);
-      fwd_primitive_args_ = {
-          {DNNL_ARG_SRC, is_src_reordered_ ? src_reorder_mem_ : src_mem_},
-          {DNNL_ARG_WEIGHTS,
-           is_weight_reordered_ ? weight_reorder_mem_ : weight_mem_},
-          {DNNL_ARG_DST, dst_mem_},
-          {DNNL_ARG_SCRATCHPAD, scratchpad_mem_}};
+                                            &scratchpad_tensor));
 
+      std::unordered_map<int, memory> fwd_primitive_args = {
+          {DNNL_ARG_SRC, src_mem},
+          {DNNL_ARG_WEIGHTS, weight_mem},
+          {DNNL_ARG_DST, CreateDnnlMemory(plan.fwd_pd.dst_desc(), onednn_engine,
+                                          GetTensorBuffer<T>(dst_tensor))},
+          {DNNL_ARG_SCRATCHPAD,
+           dnnl::memory(plan.fwd_pd.scratchpad_desc(), onednn_engine,
+                        GetTensorBuffer<T>(&scratchpad_tensor))}};
       if (this->post_op_util_.HasBias()) {
+        // Bias is 1-dimension, no reorder needed
         const Tensor& bias_tensor = context->input(kBiasIndex_);
-        // Create bias memory, since it is 1-dimension, no reordered needed
-        bias_mem_ = CreateDnnlMemory(fwd_pd_.bias_desc(), onednn_engine_,
-                                     GetTensorBuffer<T>(&bias_tensor));
-
-        fwd_primitive_args_.emplace(DNNL_ARG_BIAS, bias_mem_);
+        fwd_primitive_args.emplace(
+            DNNL_ARG_BIAS,
+            CreateDnnlMemory(plan.fwd_pd.bias_desc(), onednn_engine,
+                             GetTensorBuffer<T>(&bias_tensor)));
       }
-      is_init_ = true;
+
+      plan.fwd_primitive.execute(onednn_stream, fwd_primitive_args);
     } catch (dnnl::error& e) {
       string error_msg = "Status: " + std::to_string(e.status) +
                          ", message: " + string(e.message) + ", in file " +
@@ -431,18 +417,19 @@ class OneDnnMatMulOp : public OneDnnMatMulBaseOp<Device, T> {
   }
 
   void Compute(OpKernelContext* context) override {
-    mutex_lock lock(&mu_compute_);
-    dst_tensor_ = nullptr;
-    onednn_engine_ = CreateDnnlEngine<Device>(*context);
-    // onednn_stream has thread safety issue, need create a new one in
-    // every compute.
-    onednn_stream_ = CreateDnnlStream(*context, onednn_engine_);
-    InitOrSetMemory(context);
-
-    // Skip primitive execution if the calculation is meaningless.
-    if (is_input_zero_) return;
-
-    fwd_primitive_.execute(onednn_stream_, fwd_primitive_args_);
+    bool is_init = false;
+    std::shared_ptr<const MatMulPlan> plan = LookupPlan(context, &is_init);
+    if (plan == nullptr) {
+      std::shared_ptr<MatMulPlan> new_plan;
+      CreatePlan(context,
+                 is_init ? PrimitiveCreateReason::kShapeChange
+                         : PrimitiveCreateReason::kCold,
+                 &new_plan);
+      if (!context->status().ok()) return;
+      plan = new_plan;
+      InsertPlan(std::move(new_plan));
+    }
+    Execute(context, *plan);
   }
 
  private:
@@ -450,25 +437,11 @@ class OneDnnMatMulOp : public OneDnnMatMulBaseOp<Device, T> {
   // For Handling Add fusion.
   const int kAddIndex_ = 3, kUnsuccess_ = -1, kBiasIndex_ = 2;
 
-  OneDnnShape src_onednn_shape_, weight_onednn_shape_, dst_onednn_shape_;
-  std::vector<int64> input_dims_, weight_dims_;
-  memory src_mem_, dst_mem_, src_reorder_mem_, weight_mem_, weight_reorder_mem_,
-      scratchpad_mem_, bias_mem_, fuse_add_src_mem_, fuse_add_dst_mem_;
-  OneDnnShape add_onednn_shape_;
-  TensorShape dst_tf_shape_;
-  dnnl::stream onednn_stream_;
-  dnnl::engine onednn_engine_;
-  matmul::primitive_desc fwd_pd_;
-  matmul fwd_primitive_;
-  std::unordered_map<int, memory> fwd_primitive_args_;
-  Tensor* dst_tensor_;
-  Tensor src_reorder_tensor_, weight_reorder_tensor_, scratchpad_tensor_;
-  const Tensor* add_tensor_;
-  bool is_input_zero_ = false;
-  bool is_init_ = false;
-  bool is_src_reordered_ = false, is_weight_reordered_ = false;
   bool enable_cache_ = false;
+  // Only guards lookup and insert of the plan, never the execution.
   mutex mu_compute_;
+  std::shared_ptr<const MatMulPlan> plan_ TF_GUARDED_BY(mu_compute_);
+  bool is_init_ TF_GUARDED_BY(mu_compute_) = false;
 };
 
 template <typename Device, typename T>
@@ -110,9 +110,12 @@ class OneDnnReshapeOp : public OpKernel {
         // 1. For plain layout (src_onednn_md == dst_tf_md), we don't need to
         // actually change the Tensor physical layout. Just copy the input
         // tensor with new shape.
-        // 2. For block layout (src_onednn_md != dst_tf_md), which is different
-        // layout compared to normal Tensorflow tensor. We need to reorder
-        // tensor and then put it in the shape expected by Tensorflow.
+        // 2. For block layout whose blocked dims are untouched by reshape,
+        // e.g. [N*S, C] <-> [N, S, C] with blocking on C, the buffer is also
+        // valid for the new shape. Just forward it with new memory desc.
+        // 3. Otherwise, the block layout is different layout compared to
+        // normal Tensorflow tensor. We need to reorder tensor and then put it
+        // in the shape expected by Tensorflow.
 
         // Get OneDnn layout of input tensor.
         auto src_onednn_md = src_onednn_shape.GetOneDnnLayout();
@@ -126,9 +129,18 @@ class OneDnnReshapeOp : public OpKernel {
               << "Reshape: Input tensor is plain layout, but "
                  "IsOneDnnTensor() = True. The implementation of the op "
                  "before _OneDnnTotf may be improved";
-          Tensor dst_tensor;
-          ITEX_CHECK(dst_tensor.CopyFrom(src_tensor, shape));
-          context->set_output(kDstIndex, dst_tensor);
+          SetPlainOutput(context, src_tensor, shape);
+          return;
+        }
+
+        OneDnnShape dst_onednn_shape;
+        if (has_meta_output_ &&
+            GetReshapedOneDnnShape(src_onednn_shape, shape,
+                                   &dst_onednn_shape)) {
+          ITEX_VLOG(3) << "Reshape: Forward block layout tensor to "
+                       << shape.DebugString() << " without reorder.";
+          context->set_output(kDstIndex, src_tensor);
+          AllocateMetaData(context, kDstIndex, dst_onednn_shape);
           return;
         }
 
@@ -137,6 +149,9 @@ class OneDnnReshapeOp : public OpKernel {
         // Allocate new buffer for output tensor
         OP_REQUIRES_OK(context,
                        context->allocate_output(kDstIndex, shape, &dst_tensor));
+        if (has_meta_output_) {
+          AllocateMetaData(context, kDstIndex, OneDnnShape());
+        }
 
         auto onednn_engine = CreateDnnlEngine<Device>(*context);
         auto onednn_stream = CreateDnnlStream(*context, onednn_engine);
@@ -157,13 +172,85 @@ class OneDnnReshapeOp : public OpKernel {
     } else {
       // If input tensor is not in OneDnn layout, then just copy input tensor
       // to output with specified shape.
-      Tensor dst_tensor;
-      ITEX_CHECK(dst_tensor.CopyFrom(src_tensor, shape));
-      context->set_output(kDstIndex, dst_tensor);
+      SetPlainOutput(context, src_tensor, shape);
     }
   }
 
+ protected:
+  // INT8 Reshape has plain layout output only, there is no meta output.
+  bool has_meta_output_ = true;
+
  private:
+  void SetPlainOutput(OpKernelContext* context, const Tensor& src_tensor,
+                      const TensorShape& shape) {
+    Tensor dst_tensor;
+    ITEX_CHECK(dst_tensor.CopyFrom(src_tensor, shape));
+    context->set_output(kDstIndex, dst_tensor);
+    if (has_meta_output_) {
+      AllocateMetaData(context, kDstIndex, OneDnnShape());
+    }
+  }
+
+  // Returns true if the block layout of input is also a valid layout of the
+  // new shape, that is, reshape only splits or merges dims which are neither
+  // blocked nor padded. `dst_onednn_shape` describes the input buffer in the
+  // new shape then.
+  //
+  // The md dims stay in TF order, so a 4-D or 5-D output labelled NCHW or
+  // NCDHW is only right if the input was NCHW or NCDHW of the same rank.
+  // Otherwise, e.g. NC to 4-D, an NHWC consumer would misread it.
+  bool GetReshapedOneDnnShape(const OneDnnShape& src_onednn_shape,
+                              const TensorShape& shape,
+                              OneDnnShape* dst_onednn_shape) {
+    // The dims of memory desc must be in TF order, which isn't true for
+    // channels-last tensors.
+    OneDnnTensorFormat src_format = src_onednn_shape.GetTfDataFormat();
+    if (src_format != OneDnnTensorFormat::FORMAT_X &&
+        src_format != OneDnnTensorFormat::FORMAT_NC &&
+        src_format != OneDnnTensorFormat::FORMAT_TNC &&
+        src_format != OneDnnTensorFormat::FORMAT_NCHW &&
+        src_format != OneDnnTensorFormat::FORMAT_NCDHW) {
+      return false;
+    }
+
+    OneDnnTensorFormat dst_format;
+    switch (shape.dims()) {
+      case 1:
+        dst_format = OneDnnTensorFormat::FORMAT_X;
+        break;
+      case 2:
+        dst_format = OneDnnTensorFormat::FORMAT_NC;
+        break;
+      case 3:
+        dst_format = OneDnnTensorFormat::FORMAT_TNC;
+        break;
+      case 4:
+        dst_format = OneDnnTensorFormat::FORMAT_NCHW;
+        break;
+      case 5:
+        dst_format = OneDnnTensorFormat::FORMAT_NCDHW;
+        break;
+      default:
+        return false;
+    }
+    if (shape.num_elements() == 0) return false;
+    if (shape.dims() > 3 &&
+        (src_onednn_shape.GetTfShape().dims() != shape.dims() ||
+         src_format != dst_format)) {
+      return false;
+    }
+
+    // oneDNN returns zero memory desc if the blocked dims are affected.
+    auto dst_md = src_onednn_shape.GetOneDnnLayout().reshape(
+        TFShapeToOneDnnDims(shape), /*allow_empty=*/true);
+    if (dst_md.is_zero()) return false;
+
+    dst_onednn_shape->SetOneDnnTensor(true);
+    dst_onednn_shape->SetOneDnnLayout(dst_md);
+    dst_onednn_shape->SetTfDataFormat(dst_format);
+    return true;
+  }
+
   template <typename Tshape>
   Status ValidateSizes(const Tensor& sizes, int64* product, int* unknown_index,
                        TensorShape* shape, bool* has_zero_dim) {
@@ -209,7 +296,9 @@ template <typename Device, typename T>
 class OneDnnQuantizedReshapeOp : public OneDnnReshapeOp<Device, T> {
  public:
   explicit OneDnnQuantizedReshapeOp(OpKernelConstruction* context)
-      : OneDnnReshapeOp<Device, T>(context) {}
+      : OneDnnReshapeOp<Device, T>(context) {
+    this->has_meta_output_ = false;
+  }
 
   void Compute(OpKernelContext* context) override {
     // This call processes inputs 1 and 2 to write output 0.
@@ -248,13 +337,14 @@ class OneDnnQuantizedReshapeOp : public OneDnnReshapeOp<Device, T> {
 
 // FP32 kernel registration
 #ifndef INTEL_CPU_ONLY
-#define REGISTER_KERNEL(TYPE)                            \
-  REGISTER_KERNEL_BUILDER(Name("_OneDnnReshape")         \
-                              .Device(DEVICE_GPU)        \
-                              .TypeConstraint<TYPE>("T") \
-                              .HostMemory("shape")       \
-                              .HostMemory("tensor_meta") \
-                              .HostMemory("shape_meta"), \
+#define REGISTER_KERNEL(TYPE)                             \
+  REGISTER_KERNEL_BUILDER(Name("_OneDnnReshape")          \
+                              .Device(DEVICE_GPU)         \
+                              .TypeConstraint<TYPE>("T")  \
+                              .HostMemory("shape")        \
+                              .HostMemory("tensor_meta")  \
+                              .HostMemory("shape_meta")   \
+                              .HostMemory("output_meta"), \
                           OneDnnReshapeOp<GPUDevice, TYPE>)
 TF_CALL_GPU_NUMBER_TYPES(REGISTER_KERNEL);
 #undef REGISTER_KERNEL
@@ -13,6 +13,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <chrono>  // NOLINT(build/c++11)
 #include <string>
 
 #include "itex/core/devices/xpu_device_util.h"
@@ -25,17 +26,44 @@ limitations under the License.
 #include "itex/core/kernels/cpu/cpu_kernel_init.h"
 #endif  // INTEL_CPU_ONLY
 
+namespace {
+// Logs the elapsed time of a plugin initialization phase with ITEX_VERBOSE=1.
+class ScopedInitPhaseTimer {
+ public:
+  explicit ScopedInitPhaseTimer(const char* phase)
+      : phase_(phase), start_(std::chrono::steady_clock::now()) {}
+  ~ScopedInitPhaseTimer() {
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+                       std::chrono::steady_clock::now() - start_)
+                       .count();
+    ITEX_VLOG(1) << "TF_InitKernel phase " << phase_ << " took " << elapsed
+                 << " us";
+  }
+
+ private:
+  const char* phase_;
+  std::chrono::steady_clock::time_point start_;
+};
+}  // namespace
+
 void TF_InitKernel() {
+  ScopedInitPhaseTimer total_timer("total");
+  ITEX_BACKEND backend;
+  {
+    ScopedInitPhaseTimer timer("get_backend");
+    backend = itex::itex_get_backend();
+  }
   // Register generic GPU kernels.
-  ITEX_BACKEND backend = itex::itex_get_backend();
   switch (backend) {
-    case ITEX_BACKEND_GPU:
+    case ITEX_BACKEND_GPU: {
 #ifndef INTEL_CPU_ONLY
+      ScopedInitPhaseTimer timer("register_gpu_kernels");
       RegisterGPUKernels(itex::DEVICE_XPU);
 #else
       ITEX_LOG(ERROR) << "XPU-GPU kernel not supported.";
 #endif  // INTEL_CPU_ONLY
       break;
+    }
     case ITEX_BACKEND_AUTO:
       ITEX_LOG(ERROR) << "XPU-AUTO kernel not supported.";
       break;
@@ -45,10 +73,16 @@ void TF_InitKernel() {
   }
 
   // Register op definitions.
-  CallOnce_RegisterOps();
+  {
+    ScopedInitPhaseTimer timer("register_ops");
+    CallOnce_RegisterOps();
+  }
 
 #ifdef INTEL_CPU_ONLY
   // Register generic CPU kernels.
-  RegisterCPUKernels(itex::DEVICE_CPU);
+  {
+    ScopedInitPhaseTimer timer("register_cpu_kernels");
+    RegisterCPUKernels(itex::DEVICE_CPU);
+  }
 #endif
 }
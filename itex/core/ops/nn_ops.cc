@@ -137,6 +137,197 @@ void Register_FusedMatMulGradOp() {
   }
 }
 
+void Register_CausalConv1DOp() {
+  itex::StatusUniquePtr status(TF_NewStatus());
+  {
+    TF_OpDefinitionBuilder* op_builder =
+        TF_NewOpDefinitionBuilder("ItexCausalConv1D");
+    TF_OpDefinitionBuilderAddInput(op_builder, "input: T");
+    TF_OpDefinitionBuilderAddInput(op_builder, "filter: T");
+    TF_OpDefinitionBuilderAddInput(op_builder, "reset: bool");
+    TF_OpDefinitionBuilderAddOutput(op_builder, "output: T");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "T: {bfloat16, float}");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "dilation: int = 1");
+    // The kernel keeps the input history between calls.
+    TF_OpDefinitionBuilderSetIsStateful(op_builder, true);
+    TF_OpDefinitionBuilderSetShapeInferenceFunction(op_builder,
+                                                    &unknown_shape_fn);
+
+    TF_RegisterOpDefinition(op_builder, status.get());
+    ITEX_CHECK_EQ(TF_OK, TF_GetCode(status.get()))
+        << "ItexCausalConv1D op registration failed: ";
+  }
+}
+
+void Register_StepTagOp() {
+  itex::StatusUniquePtr status(TF_NewStatus());
+  {
+    TF_OpDefinitionBuilder* op_builder =
+        TF_NewOpDefinitionBuilder("ItexStepTag");
+    TF_OpDefinitionBuilderAddInput(op_builder, "x: T");
+    TF_OpDefinitionBuilderAddInput(op_builder, "tag: int64");
+    TF_OpDefinitionBuilderAddOutput(op_builder, "y: T");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "T: type");
+    // Runs in every step, it must not be folded or deduplicated.
+    TF_OpDefinitionBuilderSetIsStateful(op_builder, true);
+    TF_OpDefinitionBuilderSetShapeInferenceFunction(op_builder,
+                                                    &unchanged_shape_fn);
+
+    TF_RegisterOpDefinition(op_builder, status.get());
+    ITEX_CHECK_EQ(TF_OK, TF_GetCode(status.get()))
+        << "ItexStepTag op registration failed: ";
+  }
+}
+
+void Register_PackedSequenceOps() {
+  itex::StatusUniquePtr status(TF_NewStatus());
+  {
+    TF_OpDefinitionBuilder* op_builder =
+        TF_NewOpDefinitionBuilder("ItexPackSequences");
+    TF_OpDefinitionBuilderAddInput(op_builder, "padded: T");
+    TF_OpDefinitionBuilderAddInput(op_builder, "lengths: int32");
+    TF_OpDefinitionBuilderAddOutput(op_builder, "packed: T");
+    TF_OpDefinitionBuilderAddOutput(op_builder, "cu_seqlens: int32");
+    TF_OpDefinitionBuilderAddAttr(op_builder,
+                                  "T: {bfloat16, half, float, int32, int64}");
+    TF_OpDefinitionBuilderSetShapeInferenceFunction(op_builder,
+                                                    &unknown_shape_fn);
+
+    TF_RegisterOpDefinition(op_builder, status.get());
+    ITEX_CHECK_EQ(TF_OK, TF_GetCode(status.get()))
+        << "ItexPackSequences op registration failed: ";
+  }
+
+  {
+    TF_OpDefinitionBuilder* op_builder =
+        TF_NewOpDefinitionBuilder("ItexUnpackSequences");
+    TF_OpDefinitionBuilderAddInput(op_builder, "packed: T");
+    TF_OpDefinitionBuilderAddInput(op_builder, "cu_seqlens: int32");
+    TF_OpDefinitionBuilderAddInput(op_builder, "max_seq_len: int32");
+    TF_OpDefinitionBuilderAddOutput(op_builder, "padded: T");
+    TF_OpDefinitionBuilderAddAttr(op_builder,
+                                  "T: {bfloat16, half, float, int32, int64}");
+    TF_OpDefinitionBuilderSetShapeInferenceFunction(op_builder,
+                                                    &unknown_shape_fn);
+
+    TF_RegisterOpDefinition(op_builder, status.get());
+    ITEX_CHECK_EQ(TF_OK, TF_GetCode(status.get()))
+        << "ItexUnpackSequences op registration failed: ";
+  }
+
+  {
+    TF_OpDefinitionBuilder* op_builder =
+        TF_NewOpDefinitionBuilder("ItexVarlenAttention");
+    TF_OpDefinitionBuilderAddInput(op_builder, "query: T");
+    TF_OpDefinitionBuilderAddInput(op_builder, "key: T");
+    TF_OpDefinitionBuilderAddInput(op_builder, "value: T");
+    TF_OpDefinitionBuilderAddInput(op_builder, "cu_seqlens: int32");
+    TF_OpDefinitionBuilderAddOutput(op_builder, "output: T");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "T: {bfloat16, float}");
+    // 0 means 1 / sqrt(head_size).
+    TF_OpDefinitionBuilderAddAttr(op_builder, "scale: float = 0.0");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "causal: bool = false");
+    TF_OpDefinitionBuilderSetShapeInferenceFunction(op_builder,
+                                                    &unchanged_shape_fn);
+
+    TF_RegisterOpDefinition(op_builder, status.get());
+    ITEX_CHECK_EQ(TF_OK, TF_GetCode(status.get()))
+        << "ItexVarlenAttention op registration failed: ";
+  }
+}
+
+void Register_ITEXLocalAttentionOp() {
+  itex::StatusUniquePtr status(TF_NewStatus());
+  {
+    TF_OpDefinitionBuilder* op_builder =
+        TF_NewOpDefinitionBuilder("_ITEXLocalAttention");
+    TF_OpDefinitionBuilderAddInput(op_builder, "query: T");
+    TF_OpDefinitionBuilderAddInput(op_builder, "key: T");
+    TF_OpDefinitionBuilderAddInput(op_builder, "value: T");
+    // [seq_len] or [batch, seq_len], global tokens attend to and are attended
+    // by all the tokens.
+    TF_OpDefinitionBuilderAddInput(op_builder, "global_mask: bool");
+    TF_OpDefinitionBuilderAddOutput(op_builder, "output: T");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "T: {bfloat16, float}");
+    // A token attends to the tokens at most `window_size` positions away.
+    TF_OpDefinitionBuilderAddAttr(op_builder, "window_size: int >= 0");
+    // 0 means 1 / sqrt(head_size).
+    TF_OpDefinitionBuilderAddAttr(op_builder, "scale: float = 0.0");
+    TF_OpDefinitionBuilderSetShapeInferenceFunction(op_builder,
+                                                    &unchanged_shape_fn);
+
+    TF_RegisterOpDefinition(op_builder, status.get());
+    ITEX_CHECK_EQ(TF_OK, TF_GetCode(status.get()))
+        << "_ITEXLocalAttention op registration failed: ";
+  }
+}
+
+void Register_ITEXRotaryEmbeddingOp() {
+  itex::StatusUniquePtr status(TF_NewStatus());
+  {
+    TF_OpDefinitionBuilder* op_builder =
+        TF_NewOpDefinitionBuilder("_ITEXRotaryEmbedding");
+    TF_OpDefinitionBuilderAddInput(op_builder, "x: T");
+    // Broadcast to x.
+    TF_OpDefinitionBuilderAddInput(op_builder, "cos: T");
+    TF_OpDefinitionBuilderAddInput(op_builder, "sin: T");
+    TF_OpDefinitionBuilderAddOutput(op_builder, "y: T");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "T: {bfloat16, float}");
+    // Rotate the pairs of adjacent channels instead of the two halves of the
+    // last dim.
+    TF_OpDefinitionBuilderAddAttr(op_builder, "interleaved: bool = false");
+    TF_OpDefinitionBuilderSetShapeInferenceFunction(op_builder,
+                                                    &unchanged_shape_fn);
+
+    TF_RegisterOpDefinition(op_builder, status.get());
+    ITEX_CHECK_EQ(TF_OK, TF_GetCode(status.get()))
+        << "_ITEXRotaryEmbedding op registration failed: ";
+  }
+}
+
+void Register_CompressedEmbeddingOps() {
+  itex::StatusUniquePtr status(TF_NewStatus());
+  {
+    TF_OpDefinitionBuilder* op_builder =
+        TF_NewOpDefinitionBuilder("_ITEXCompressedGather");
+    TF_OpDefinitionBuilderAddInput(op_builder, "params: Tparams");
+    TF_OpDefinitionBuilderAddInput(op_builder, "indices: Tindices");
+    TF_OpDefinitionBuilderAddInput(op_builder, "scale_bias: float");
+    TF_OpDefinitionBuilderAddOutput(op_builder, "output: float");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "Tparams: {bfloat16, int8}");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "Tindices: {int32, int64}");
+    TF_OpDefinitionBuilderSetShapeInferenceFunction(op_builder,
+                                                    &unknown_shape_fn);
+
+    TF_RegisterOpDefinition(op_builder, status.get());
+    ITEX_CHECK_EQ(TF_OK, TF_GetCode(status.get()))
+        << "_ITEXCompressedGather op registration failed: ";
+  }
+
+  {
+    TF_OpDefinitionBuilder* op_builder =
+        TF_NewOpDefinitionBuilder("_ITEXCompressedSparseSegmentReduction");
+    TF_OpDefinitionBuilderAddInput(op_builder, "data: Tparams");
+    TF_OpDefinitionBuilderAddInput(op_builder, "indices: Tidx");
+    TF_OpDefinitionBuilderAddInput(op_builder, "segment_ids: Tsegmentids");
+    TF_OpDefinitionBuilderAddInput(op_builder, "scale_bias: float");
+    TF_OpDefinitionBuilderAddOutput(op_builder, "output: float");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "Tparams: {bfloat16, int8}");
+    TF_OpDefinitionBuilderAddAttr(op_builder,
+                                  "Tidx: {int32, int64} = DT_INT32");
+    TF_OpDefinitionBuilderAddAttr(op_builder,
+                                  "Tsegmentids: {int32, int64} = DT_INT32");
+    TF_OpDefinitionBuilderAddAttr(op_builder,
+                                  "combiner: {'sum', 'mean', 'sqrtn'}");
+    TF_OpDefinitionBuilderSetShapeInferenceFunction(op_builder,
+                                                    &unknown_shape_fn);
+
+    TF_RegisterOpDefinition(op_builder, status.get());
+    ITEX_CHECK_EQ(TF_OK, TF_GetCode(status.get()))
+        << "_ITEXCompressedSparseSegmentReduction op registration failed: ";
+  }
+}
+
 void Register_GeluOp() {
   itex::StatusUniquePtr status(TF_NewStatus());
   {
@@ -666,6 +857,53 @@ void Register_ITEXFusedMatMulOp() {
   }
 }
 
+// fp32 `_ITEXFusedMatMul` run in INT8 with per-call activation scales, see
+// `ITEX_DYNAMIC_INT8`. Only BiasAdd and activation fusions are supported.
+void Register_ITEXDynamicQuantizedMatMulOp() {
+  itex::StatusUniquePtr status(TF_NewStatus());
+  {
+    TF_OpDefinitionBuilder* op_builder =
+        TF_NewOpDefinitionBuilder("_ITEXDynamicQuantizedMatMul");
+    TF_OpDefinitionBuilderAddInput(op_builder, "a: T");
+    TF_OpDefinitionBuilderAddInput(op_builder, "b: T");
+    TF_OpDefinitionBuilderAddInput(op_builder, "args: num_args * T");
+    TF_OpDefinitionBuilderAddOutput(op_builder, "product: T");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "T: {float} = DT_FLOAT");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "transpose_a: bool = false");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "transpose_b: bool = false");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "num_args: int >= 0");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "fused_ops: list(string) = []");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "leakyrelu_alpha: float = 0.2");
+    // Unused, copied from `_ITEXFusedMatMul` by the rewrite.
+    TF_OpDefinitionBuilderAddAttr(op_builder, "epsilon: float = 0.0001");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "is_filter_const: bool = false");
+    TF_OpDefinitionBuilderSetShapeInferenceFunction(op_builder,
+                                                    &unknown_shape_fn);
+    TF_RegisterOpDefinition(op_builder, status.get());
+    ITEX_CHECK_EQ(TF_OK, TF_GetCode(status.get()))
+        << "_ITEXDynamicQuantizedMatMul op registration failed: ";
+  }
+}
+
+void Register_ITEXMinMaxCollectorOp() {
+  itex::StatusUniquePtr status(TF_NewStatus());
+  {
+    TF_OpDefinitionBuilder* op_builder =
+        TF_NewOpDefinitionBuilder("_ITEXMinMaxCollector");
+    TF_OpDefinitionBuilderAddInput(op_builder, "x: T");
+    TF_OpDefinitionBuilderAddOutput(op_builder, "y: T");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "T: {float} = DT_FLOAT");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "key: string");
+    // Keep it from being folded or deduplicated by later passes.
+    TF_OpDefinitionBuilderSetIsStateful(op_builder, true);
+    TF_OpDefinitionBuilderSetShapeInferenceFunction(op_builder,
+                                                    &unchanged_shape_fn);
+    TF_RegisterOpDefinition(op_builder, status.get());
+    ITEX_CHECK_EQ(TF_OK, TF_GetCode(status.get()))
+        << "_ITEXMinMaxCollector op registration failed: ";
+  }
+}
+
 void Register_QuantizedFusedMatMulOp() {
   itex::StatusUniquePtr status(TF_NewStatus());
   {
@@ -1515,6 +1753,65 @@ void Register_ITEXFusedMatMulWithSumOp() {
   }
 }
 
+// MatMul + BiasAdd + residual Add + LayerNorm over the last dim. Outputs keep
+// the order of LayerNorm, so its consumers are unchanged, and the pre-norm sum
+// is the last output for consumers of the residual Add, e.g. LayerNormGrad.
+void Register_ITEXFusedMatMulWithSumAndLayerNormOp() {
+  itex::StatusUniquePtr status(TF_NewStatus());
+  {
+    TF_OpDefinitionBuilder* op_builder =
+        TF_NewOpDefinitionBuilder("_ITEXFusedMatMulWithSumAndLayerNorm");
+    TF_OpDefinitionBuilderAddInput(op_builder, "a: T");
+    TF_OpDefinitionBuilderAddInput(op_builder, "b: T");
+    TF_OpDefinitionBuilderAddInput(op_builder, "bias: T");
+    TF_OpDefinitionBuilderAddInput(op_builder, "add: T");
+    TF_OpDefinitionBuilderAddInput(op_builder, "scale: U");
+    TF_OpDefinitionBuilderAddInput(op_builder, "offset: U");
+    TF_OpDefinitionBuilderAddOutput(op_builder, "y: T");
+    TF_OpDefinitionBuilderAddOutput(op_builder, "layer_mean: U");
+    TF_OpDefinitionBuilderAddOutput(op_builder, "layer_variance: U");
+    TF_OpDefinitionBuilderAddOutput(op_builder, "sum: T");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "transpose_a: bool = false");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "transpose_b: bool = false");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "T: {bfloat16, float, half}");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "U: {float}");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "is_filter_const: bool = false");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "epsilon: float = 0.0001");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "is_training: bool = true");
+
+    TF_OpDefinitionBuilderSetShapeInferenceFunction(op_builder,
+                                                    &unknown_shape_fn);
+    TF_RegisterOpDefinition(op_builder, status.get());
+    ITEX_CHECK_EQ(TF_OK, TF_GetCode(status.get()))
+        << "_ITEXFusedMatMulWithSumAndLayerNorm op registration failed: ";
+  }
+}
+
+void Register_ITEXConv1DOp() {
+  itex::StatusUniquePtr status(TF_NewStatus());
+  {
+    TF_OpDefinitionBuilder* op_builder =
+        TF_NewOpDefinitionBuilder("_ITEXConv1D");
+    TF_OpDefinitionBuilderAddInput(op_builder, "input: T");
+    TF_OpDefinitionBuilderAddInput(op_builder, "filter: T");
+    TF_OpDefinitionBuilderAddOutput(op_builder, "output: T");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "T: {bfloat16, float}");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "stride: int = 1");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "dilation: int = 1");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "is_filter_const: bool = false");
+    TF_OpDefinitionBuilderAddAttr(op_builder, GetPaddingAttrString());
+    TF_OpDefinitionBuilderAddAttr(op_builder,
+                                  "data_format: {'NWC', 'NCW'} = 'NWC'");
+
+    TF_OpDefinitionBuilderSetShapeInferenceFunction(op_builder,
+                                                    &unknown_shape_fn);
+
+    TF_RegisterOpDefinition(op_builder, status.get());
+    ITEX_CHECK_EQ(TF_OK, TF_GetCode(status.get()))
+        << "_ITEXConv1D op registration failed: ";
+  }
+}
+
 void Register_ITEXConv2DOp() {
   itex::StatusUniquePtr status(TF_NewStatus());
   {
@@ -1543,6 +1840,36 @@ void Register_ITEXConv2DOp() {
   }
 }
 
+void Register_ITEXConv2DWithReorderedFilterOp() {
+  itex::StatusUniquePtr status(TF_NewStatus());
+  {
+    TF_OpDefinitionBuilder* op_builder =
+        TF_NewOpDefinitionBuilder("_ITEXConv2DWithReorderedFilter");
+    TF_OpDefinitionBuilderAddInput(op_builder, "input: T");
+    TF_OpDefinitionBuilderAddInput(op_builder, "filter: T");
+    TF_OpDefinitionBuilderAddOutput(op_builder, "output: T");
+    TF_OpDefinitionBuilderAddOutput(op_builder, "reordered_filter: T");
+    TF_OpDefinitionBuilderAddOutput(op_builder, "reordered_filter_desc: uint8");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "T: {bfloat16, float}");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "strides: list(int)");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "use_cudnn_on_gpu: bool = true");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "is_filter_const: bool = false");
+    TF_OpDefinitionBuilderAddAttr(op_builder,
+                                  GetPaddingAttrStringWithExplicit());
+    TF_OpDefinitionBuilderAddAttr(op_builder, GetExplicitPaddingsAttrString());
+    TF_OpDefinitionBuilderAddAttr(op_builder, GetConvnetDataFormatAttrString());
+    TF_OpDefinitionBuilderAddAttr(op_builder,
+                                  "dilations: list(int) = [1, 1, 1, 1]");
+
+    TF_OpDefinitionBuilderSetShapeInferenceFunction(op_builder,
+                                                    &unknown_shape_fn);
+
+    TF_RegisterOpDefinition(op_builder, status.get());
+    ITEX_CHECK_EQ(TF_OK, TF_GetCode(status.get()))
+        << "_ITEXConv2DWithReorderedFilter op registration failed: ";
+  }
+}
+
 void Register_ITEXConv2DBackpropInputOp() {
   itex::StatusUniquePtr status(TF_NewStatus());
   {
@@ -1572,6 +1899,38 @@ void Register_ITEXConv2DBackpropInputOp() {
   }
 }
 
+void Register_ITEXConv2DBackpropInputWithReorderedFilterOp() {
+  itex::StatusUniquePtr status(TF_NewStatus());
+  {
+    TF_OpDefinitionBuilder* op_builder = TF_NewOpDefinitionBuilder(
+        "_ITEXConv2DBackpropInputWithReorderedFilter");
+    TF_OpDefinitionBuilderAddInput(op_builder, "input_sizes: int32");
+    TF_OpDefinitionBuilderAddInput(op_builder, "filter: T");
+    TF_OpDefinitionBuilderAddInput(op_builder, "out_backprop: T");
+    TF_OpDefinitionBuilderAddInput(op_builder, "reordered_filter: T");
+    TF_OpDefinitionBuilderAddInput(op_builder, "reordered_filter_desc: uint8");
+    TF_OpDefinitionBuilderAddOutput(op_builder, "output: T");
+
+    TF_OpDefinitionBuilderAddAttr(op_builder, "T: {bfloat16, float}");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "strides: list(int)");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "use_cudnn_on_gpu: bool = true");
+    TF_OpDefinitionBuilderAddAttr(op_builder,
+                                  GetPaddingAttrStringWithExplicit());
+    TF_OpDefinitionBuilderAddAttr(op_builder, GetExplicitPaddingsAttrString());
+    TF_OpDefinitionBuilderAddAttr(op_builder, GetConvnetDataFormatAttrString());
+    TF_OpDefinitionBuilderAddAttr(op_builder,
+                                  "dilations: list(int) = [1, 1, 1, 1]");
+
+    TF_OpDefinitionBuilderSetShapeInferenceFunction(op_builder,
+                                                    &unknown_shape_fn);
+
+    TF_RegisterOpDefinition(op_builder, status.get());
+    ITEX_CHECK_EQ(TF_OK, TF_GetCode(status.get()))
+        << "_ITEXConv2DBackpropInputWithReorderedFilter op registration "
+           "failed: ";
+  }
+}
+
 void Register_ITEXConv2DBackpropInputWithSliceOp() {
   itex::StatusUniquePtr status(TF_NewStatus());
   {
@@ -2776,6 +3135,51 @@ void Register_ITEXFusedBatchNormExGradOp() {
   }
 }
 
+void Register_ITEXFusedBatchNormGradWithConv2DBackpropOp() {
+  itex::StatusUniquePtr status(TF_NewStatus());
+  {
+    TF_OpDefinitionBuilder* op_builder = TF_NewOpDefinitionBuilder(
+        "_ITEXFusedBatchNormGradWithConv2DBackprop");
+
+    TF_OpDefinitionBuilderAddInput(op_builder, "y_backprop: T");
+    TF_OpDefinitionBuilderAddInput(op_builder, "x: T");
+    TF_OpDefinitionBuilderAddInput(op_builder, "scale: float");
+    TF_OpDefinitionBuilderAddInput(op_builder, "reserve_space_1: U");
+    TF_OpDefinitionBuilderAddInput(op_builder, "reserve_space_2: U");
+    TF_OpDefinitionBuilderAddInput(op_builder, "reserve_space_3: U");
+    TF_OpDefinitionBuilderAddInput(op_builder, "offset: float");
+    TF_OpDefinitionBuilderAddInput(op_builder, "y: T");
+    TF_OpDefinitionBuilderAddInput(op_builder, "conv_input: T");
+    TF_OpDefinitionBuilderAddInput(op_builder, "filter: T");
+    TF_OpDefinitionBuilderAddInput(op_builder, "input_sizes: int32");
+    TF_OpDefinitionBuilderAddOutput(op_builder, "x_backprop: T");
+    TF_OpDefinitionBuilderAddOutput(op_builder, "scale_backprop: U");
+    TF_OpDefinitionBuilderAddOutput(op_builder, "offset_backprop: U");
+    TF_OpDefinitionBuilderAddOutput(op_builder, "reserve_space_4: U");
+    TF_OpDefinitionBuilderAddOutput(op_builder, "reserve_space_5: U");
+    TF_OpDefinitionBuilderAddOutput(op_builder, "input_backprop: T");
+    TF_OpDefinitionBuilderAddOutput(op_builder, "filter_backprop: T");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "T: {bfloat16, float}");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "U: {float}");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "epsilon: float = 0.0001");
+    TF_OpDefinitionBuilderAddAttr(op_builder, GetConvnetDataFormatAttrString());
+    TF_OpDefinitionBuilderAddAttr(op_builder,
+                                  "activation_mode: string = \"ReluGrad\"");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "is_training: bool = true");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "strides: list(int)");
+    TF_OpDefinitionBuilderAddAttr(op_builder,
+                                  GetPaddingAttrStringWithExplicit());
+    TF_OpDefinitionBuilderAddAttr(op_builder, GetExplicitPaddingsAttrString());
+    TF_OpDefinitionBuilderAddAttr(op_builder,
+                                  "dilations: list(int) = [1, 1, 1, 1]");
+    TF_OpDefinitionBuilderSetShapeInferenceFunction(op_builder,
+                                                    &unknown_shape_fn);
+    TF_RegisterOpDefinition(op_builder, status.get());
+    ITEX_CHECK_EQ(TF_OK, TF_GetCode(status.get()))
+        << "_ITEXFusedBatchNormGradWithConv2DBackprop op registration failed: ";
+  }
+}
+
 void Register_ITEXReluOp() {
   itex::StatusUniquePtr status(TF_NewStatus());
   {
@@ -3297,6 +3701,63 @@ void Register_ITEXQuantizedReshapeOp() {
   }
 }
 
+void Register_ITEXQuantizedLayerNormOp() {
+  itex::StatusUniquePtr status(TF_NewStatus());
+  {
+    TF_OpDefinitionBuilder* op_builder =
+        TF_NewOpDefinitionBuilder("_ITEXQuantizedLayerNorm");
+
+    TF_OpDefinitionBuilderAddInput(op_builder, "x: T");
+    TF_OpDefinitionBuilderAddInput(op_builder, "scale: float");
+    TF_OpDefinitionBuilderAddInput(op_builder, "offset: float");
+    TF_OpDefinitionBuilderAddInput(op_builder, "min_x: float");
+    TF_OpDefinitionBuilderAddInput(op_builder, "max_x: float");
+    TF_OpDefinitionBuilderAddInput(op_builder, "min_y: float");
+    TF_OpDefinitionBuilderAddInput(op_builder, "max_y: float");
+    TF_OpDefinitionBuilderAddOutput(op_builder, "y: out_type");
+    TF_OpDefinitionBuilderAddOutput(op_builder, "y_min: float");
+    TF_OpDefinitionBuilderAddOutput(op_builder, "y_max: float");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "T: {qint8, quint8}");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "out_type: {qint8, quint8}");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "epsilon: float = 0.001");
+    TF_OpDefinitionBuilderAddAttr(op_builder,
+                                  "ensure_minimum_range: float = 0.01");
+    TF_OpDefinitionBuilderSetShapeInferenceFunction(op_builder,
+                                                    &unknown_shape_fn);
+
+    TF_RegisterOpDefinition(op_builder, status.get());
+    ITEX_CHECK_EQ(TF_OK, TF_GetCode(status.get()))
+        << "_ITEXQuantizedLayerNorm op registration failed: ";
+  }
+}
+
+void Register_ITEXQuantizedSoftmaxOp() {
+  itex::StatusUniquePtr status(TF_NewStatus());
+  {
+    TF_OpDefinitionBuilder* op_builder =
+        TF_NewOpDefinitionBuilder("_ITEXQuantizedSoftmax");
+
+    TF_OpDefinitionBuilderAddInput(op_builder, "logits: T");
+    TF_OpDefinitionBuilderAddInput(op_builder, "min_logits: float");
+    TF_OpDefinitionBuilderAddInput(op_builder, "max_logits: float");
+    TF_OpDefinitionBuilderAddInput(op_builder, "min_softmax: float");
+    TF_OpDefinitionBuilderAddInput(op_builder, "max_softmax: float");
+    TF_OpDefinitionBuilderAddOutput(op_builder, "softmax: out_type");
+    TF_OpDefinitionBuilderAddOutput(op_builder, "softmax_min: float");
+    TF_OpDefinitionBuilderAddOutput(op_builder, "softmax_max: float");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "T: {qint8, quint8}");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "out_type: {qint8, quint8}");
+    TF_OpDefinitionBuilderAddAttr(op_builder,
+                                  "ensure_minimum_range: float = 0.01");
+    TF_OpDefinitionBuilderSetShapeInferenceFunction(op_builder,
+                                                    &unknown_shape_fn);
+
+    TF_RegisterOpDefinition(op_builder, status.get());
+    ITEX_CHECK_EQ(TF_OK, TF_GetCode(status.get()))
+        << "_ITEXQuantizedSoftmax op registration failed: ";
+  }
+}
+
 void Register_ITEXQuantizedTransposeOp() {
   itex::StatusUniquePtr status(TF_NewStatus());
   {
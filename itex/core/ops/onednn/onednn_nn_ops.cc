@@ -3196,8 +3196,10 @@ void Register_OneDnnReshapeOp() {
     TF_OpDefinitionBuilderAddInput(op_builder, "shape: Tshape");
     TF_OpDefinitionBuilderAddInput(op_builder, "tensor_meta: uint8");
     TF_OpDefinitionBuilderAddInput(op_builder, "shape_meta: uint8");
-    // OneDnn always has plain format output, so there is no meta tensor
+    // Output keeps block layout if the blocked dims are not affected by
+    // reshape, otherwise it's plain layout.
     TF_OpDefinitionBuilderAddOutput(op_builder, "output: T");
+    TF_OpDefinitionBuilderAddOutput(op_builder, "output_meta: uint8");
     TF_OpDefinitionBuilderAddAttr(op_builder,
                                   "T: {bfloat16, half, float} = DT_FLOAT");
     TF_OpDefinitionBuilderAddAttr(op_builder,
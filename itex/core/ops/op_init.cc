@@ -15,21 +15,68 @@ limitations under the License.
 
 #include "itex/core/ops/op_init.h"
 
+#include <climits>
 #include <map>
 #include <string>
+#include <unordered_set>
+#include <utility>
 
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/wire_format_lite.h"
 #include "itex/core/ops/utils/logging.h"
 #include "itex/core/utils/tf_version.h"
 #include "protos/op_def.pb.h"
 
+namespace {
+
+// Returns the names of the ops in a serialized OpList. Only the name field of
+// each OpDef is read, the rest is skipped without being parsed, as parsing
+// every OpDef of TF is the bulk of the legacy op detection.
+std::unordered_set<std::string> GetOpNames(const TF_Buffer* op_list_buffer) {
+  using google::protobuf::internal::WireFormatLite;
+  const uint32_t kOpTag = WireFormatLite::MakeTag(
+      itex::OpList::kOpFieldNumber, WireFormatLite::WIRETYPE_LENGTH_DELIMITED);
+  const uint32_t kNameTag = WireFormatLite::MakeTag(
+      itex::OpDef::kNameFieldNumber, WireFormatLite::WIRETYPE_LENGTH_DELIMITED);
+
+  std::unordered_set<std::string> names;
+  google::protobuf::io::CodedInputStream input(
+      static_cast<const uint8_t*>(op_list_buffer->data),
+      op_list_buffer->length);
+  input.SetTotalBytesLimit(INT_MAX);
+  while (uint32_t tag = input.ReadTag()) {
+    if (tag != kOpTag) {
+      if (!WireFormatLite::SkipField(&input, tag)) break;
+      continue;
+    }
+    uint32_t length;
+    if (!input.ReadVarint32(&length)) break;
+    auto limit = input.PushLimit(length);
+    while (uint32_t op_tag = input.ReadTag()) {
+      if (op_tag == kNameTag) {
+        std::string name;
+        if (!WireFormatLite::ReadString(&input, &name)) break;
+        names.insert(std::move(name));
+      } else if (!WireFormatLite::SkipField(&input, op_tag)) {
+        break;
+      }
+    }
+    input.PopLimit(limit);
+  }
+  return names;
+}
+
+}  // namespace
+
 // Some ops currently are available only in spr-base branch, not in TF master
 // branch. We will register those ops in ITEX, before they are upstreamed to TF
 // public.
 void Register_TFLegacyOp() {
   // Get all ops registered in TF Proper, before ITEX op registration
   TF_Buffer* op_list_buffer = TF_GetAllOpList();
-  itex::OpList op_list;
-  op_list.ParseFromArray(op_list_buffer->data, op_list_buffer->length);
+  const std::unordered_set<std::string> registered_ops =
+      GetOpNames(op_list_buffer);
+  TF_DeleteBuffer(op_list_buffer);
 
   std::map<std::string, std::function<void()>> op_register_map = {
       {"_QuantizedBatchMatMul", Register_QuantizedBatchMatMulOp},
@@ -46,10 +93,8 @@ void Register_TFLegacyOp() {
       {"_QuantizedMatMul", Register_QuantizedMatMulOp},
       {"_QuantizedTranspose", Register_QuantizedTransposeOp}};
 
-  for (auto register_pair : op_register_map) {
-    if (std::find_if(op_list.op().begin(), op_list.op().end(), [=](auto op) {
-          return op.name() == register_pair.first;
-        }) == op_list.op().end()) {
+  for (const auto& register_pair : op_register_map) {
+    if (registered_ops.count(register_pair.first) == 0) {
       auto register_func = register_pair.second;
       register_func();
     } else {
@@ -57,8 +102,6 @@ void Register_TFLegacyOp() {
                       << " is already registered in Tensorflow";
     }
   }
-
-  TF_DeleteBuffer(op_list_buffer);
 }
 
 void RegisterOps() {
@@ -78,12 +121,22 @@ void RegisterOps() {
   Register_FusedResourceApplyAdamOp();
   Register_FusedApplyAdamWithWeightDecayOp();
   Register_FusedResourceApplyAdamWithWeightDecayOp();
+  Register_ResourceSparseApplyAdamWithWeightDecayOp();
+  Register_ITEXResourceSparseApplyAdagradOp();
+  Register_ITEXResourceSparseApplyAdagradV2Op();
+  Register_ITEXResourceScatterAddOp();
 
   Register_QuantizedConv2DV2Op();
   Register_QuantizedConv3DV2Op();
   Register_QuantizedDepthwiseConv2DV2Op();
 
   // Custom kernels
+  Register_CausalConv1DOp();
+  Register_PackedSequenceOps();
+  Register_StepTagOp();
+  Register_ITEXLocalAttentionOp();
+  Register_ITEXRotaryEmbeddingOp();
+  Register_CompressedEmbeddingOps();
   Register_Conv2DBackpropFilterWithBiasOp();
   Register_Conv2DBackpropInputWithSliceOp();
   Register_Conv3DBackpropFilterWithBiasOp();
@@ -103,6 +156,8 @@ void RegisterOps() {
   Register_ITEXFusedConv3DOp();
   Register_ITEXFusedDepthwiseConv2dNativeOp();
   Register_ITEXFusedMatMulOp();
+  Register_ITEXDynamicQuantizedMatMulOp();
+  Register_ITEXMinMaxCollectorOp();
   Register_ITEXFusedQuantizeV2WithQuantizedConv2DOp();
   Register_ITEXFusedBinaryOp();
   Register_ITEXRandomUniformOp();
@@ -129,11 +184,14 @@ void RegisterOps() {
   Register_ITEXBatchMatMulOp();
   Register_ITEXBatchMatMulV2Op();
   Register_ITEXCastOp();
+  Register_ITEXConv1DOp();
   Register_ITEXConv2DBackpropFilterOp();
   Register_ITEXConv2DBackpropFilterWithBiasOp();
   Register_ITEXConv2DBackpropInputOp();
+  Register_ITEXConv2DBackpropInputWithReorderedFilterOp();
   Register_ITEXConv2DBackpropInputWithSliceOp();
   Register_ITEXConv2DOp();
+  Register_ITEXConv2DWithReorderedFilterOp();
   Register_ITEXConv3DBackpropFilterV2Op();
   Register_ITEXConv3DBackpropFilterWithBiasOp();
   Register_ITEXConv3DBackpropInputOp();
@@ -154,11 +212,13 @@ void RegisterOps() {
   Register_ITEXFusedBatchNormGradOp();
   Register_ITEXFusedBatchNormGradV2Op();
   Register_ITEXFusedBatchNormGradV3Op();
+  Register_ITEXFusedBatchNormGradWithConv2DBackpropOp();
   Register_ITEXFusedBatchNormOp();
   Register_ITEXFusedBatchNormV2Op();
   Register_ITEXFusedBatchNormV3Op();
   Register_ITEXFusedConv2DWithSumOp();
   Register_ITEXFusedMatMulWithSumOp();
+  Register_ITEXFusedMatMulWithSumAndLayerNormOp();
   Register_ITEXFusedInstanceNormOp();
   Register_ITEXGeluGradOp();
   Register_ITEXGeluOp();
@@ -190,12 +250,14 @@ void RegisterOps() {
   Register_ITEXQuantizedFusedMatMulOp();
   Register_ITEXQuantizedFusedMatMulAndDequantizeOp();
   Register_ITEXQuantizedFusedMatMulAndRequantizeOp();
+  Register_ITEXQuantizedLayerNormOp();
   Register_ITEXQuantizedMatMulWithBiasOp();
   Register_ITEXQuantizedMatMulWithBiasAndReluOp();
   Register_ITEXQuantizedMatMulWithBiasAndReluAndRequantizeOp();
   Register_ITEXQuantizedMatMulWithBiasAndRequantizeOp();
   Register_ITEXQuantizedMaxPoolOp();
   Register_ITEXQuantizedReshapeOp();
+  Register_ITEXQuantizedSoftmaxOp();
   Register_ITEXQuantizedTransposeOp();
   Register_ITEXQuantizedConv2DOp();
   Register_ITEXQuantizedConv2DAndRequantizeOp();
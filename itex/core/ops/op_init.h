@@ -28,7 +28,11 @@ void Register_FusedApplyMomentumOp();
 void Register_FusedResourceApplyAdamOp();
 void Register_FusedResourceApplyAdamWithWeightDecayOp();
 void Register_FusedResourceApplyMomentumOp();
+void Register_ITEXResourceScatterAddOp();
+void Register_ITEXResourceSparseApplyAdagradOp();
+void Register_ITEXResourceSparseApplyAdagradV2Op();
 void Register_ResourceApplyAdamWithWeightDecayOp();
+void Register_ResourceSparseApplyAdamWithWeightDecayOp();
 
 // Unupstreamed ops. These ops are only available in spr-base branch, not in
 // TF master.
@@ -50,6 +54,12 @@ void Register_QuantizedMatMulOp();
 void Register_QuantizedFusedBatchNormOp();
 
 // Custom kernels
+void Register_CausalConv1DOp();
+void Register_PackedSequenceOps();
+void Register_StepTagOp();
+void Register_ITEXLocalAttentionOp();
+void Register_ITEXRotaryEmbeddingOp();
+void Register_CompressedEmbeddingOps();
 void Register_Conv2DBackpropFilterWithBiasOp();
 void Register_Conv2DBackpropInputWithSliceOp();
 void Register_Conv3DBackpropFilterWithBiasOp();
@@ -70,6 +80,8 @@ void Register_ITEXFusedConv2DOp();
 void Register_ITEXFusedConv3DOp();
 void Register_ITEXFusedDepthwiseConv2dNativeOp();
 void Register_ITEXFusedMatMulOp();
+void Register_ITEXDynamicQuantizedMatMulOp();
+void Register_ITEXMinMaxCollectorOp();
 void Register_ITEXFusedQuantizeV2WithQuantizedConv2DOp();
 void Register_ITEXFusedBinaryOp();
 void Register_ITEXRandomUniformOp();
@@ -97,11 +109,14 @@ void Register_ITEXAvgPool3DGradOp();
 void Register_ITEXBatchMatMulOp();
 void Register_ITEXBatchMatMulV2Op();
 void Register_ITEXCastOp();
+void Register_ITEXConv1DOp();
 void Register_ITEXConv2DBackpropFilterOp();
 void Register_ITEXConv2DBackpropFilterWithBiasOp();
 void Register_ITEXConv2DBackpropInputOp();
+void Register_ITEXConv2DBackpropInputWithReorderedFilterOp();
 void Register_ITEXConv2DBackpropInputWithSliceOp();
 void Register_ITEXConv2DOp();
+void Register_ITEXConv2DWithReorderedFilterOp();
 void Register_ITEXConv3DBackpropFilterV2Op();
 void Register_ITEXConv3DBackpropFilterWithBiasOp();
 void Register_ITEXConv3DBackpropInputOp();
@@ -122,11 +137,13 @@ void Register_ITEXFusedBatchNormExGradOp();
 void Register_ITEXFusedBatchNormGradOp();
 void Register_ITEXFusedBatchNormGradV2Op();
 void Register_ITEXFusedBatchNormGradV3Op();
+void Register_ITEXFusedBatchNormGradWithConv2DBackpropOp();
 void Register_ITEXFusedBatchNormOp();
 void Register_ITEXFusedBatchNormV2Op();
 void Register_ITEXFusedBatchNormV3Op();
 void Register_ITEXFusedConv2DWithSumOp();
 void Register_ITEXFusedMatMulWithSumOp();
+void Register_ITEXFusedMatMulWithSumAndLayerNormOp();
 void Register_ITEXFusedInstanceNormOp();
 void Register_ITEXGeluGradOp();
 void Register_ITEXGeluOp();
@@ -158,12 +175,14 @@ void Register_ITEXQuantizedFusedBatchNormOp();
 void Register_ITEXQuantizedFusedMatMulOp();
 void Register_ITEXQuantizedFusedMatMulAndDequantizeOp();
 void Register_ITEXQuantizedFusedMatMulAndRequantizeOp();
+void Register_ITEXQuantizedLayerNormOp();
 void Register_ITEXQuantizedMatMulWithBiasOp();
 void Register_ITEXQuantizedMatMulWithBiasAndReluOp();
 void Register_ITEXQuantizedMatMulWithBiasAndReluAndRequantizeOp();
 void Register_ITEXQuantizedMatMulWithBiasAndRequantizeOp();
 void Register_ITEXQuantizedMaxPoolOp();
 void Register_ITEXQuantizedReshapeOp();
+void Register_ITEXQuantizedSoftmaxOp();
 void Register_ITEXQuantizedTransposeOp();
 void Register_ITEXQuantizedConv2DOp();
 void Register_ITEXQuantizedConv2DAndRequantizeOp();
@@ -205,6 +205,106 @@ void Register_ResourceApplyAdamWithWeightDecayOp() {
   }
 }
 
+// Lazy Adam with weight decay, only the rows in `indices` are updated.
+void Register_ResourceSparseApplyAdamWithWeightDecayOp() {
+  itex::StatusUniquePtr status(TF_NewStatus());
+  {
+    TF_OpDefinitionBuilder* op_builder =
+        TF_NewOpDefinitionBuilder("ResourceSparseApplyAdamWithWeightDecay");
+
+    TF_OpDefinitionBuilderAddInput(op_builder, "var: resource");
+    TF_OpDefinitionBuilderAddInput(op_builder, "m: resource");
+    TF_OpDefinitionBuilderAddInput(op_builder, "v: resource");
+    TF_OpDefinitionBuilderAddInput(op_builder, "beta1_power: T");
+    TF_OpDefinitionBuilderAddInput(op_builder, "beta2_power: T");
+    TF_OpDefinitionBuilderAddInput(op_builder, "lr: T");
+    TF_OpDefinitionBuilderAddInput(op_builder, "beta1: T");
+    TF_OpDefinitionBuilderAddInput(op_builder, "beta2: T");
+    TF_OpDefinitionBuilderAddInput(op_builder, "epsilon: T");
+    TF_OpDefinitionBuilderAddInput(op_builder, "weight_decay: T");
+    TF_OpDefinitionBuilderAddInput(op_builder, "grad: T");
+    TF_OpDefinitionBuilderAddInput(op_builder, "indices: Tindices");
+
+    TF_OpDefinitionBuilderAddAttr(op_builder, "T: numbertype");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "Tindices: {int32, int64}");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "use_locking: bool = false");
+    TF_OpDefinitionBuilderSetShapeInferenceFunction(op_builder,
+                                                    &unknown_shape_fn);
+    TF_RegisterOpDefinition(op_builder, status.get());
+    ITEX_CHECK_EQ(TF_OK, TF_GetCode(status.get()))
+        << "ResourceSparseApplyAdamWithWeightDecay op registration failed: ";
+  }
+}
+
+void Register_ITEXResourceSparseApplyAdagradOp() {
+  itex::StatusUniquePtr status(TF_NewStatus());
+  {
+    TF_OpDefinitionBuilder* op_builder =
+        TF_NewOpDefinitionBuilder("_ITEXResourceSparseApplyAdagrad");
+
+    TF_OpDefinitionBuilderAddInput(op_builder, "var: resource");
+    TF_OpDefinitionBuilderAddInput(op_builder, "accum: resource");
+    TF_OpDefinitionBuilderAddInput(op_builder, "lr: T");
+    TF_OpDefinitionBuilderAddInput(op_builder, "grad: T");
+    TF_OpDefinitionBuilderAddInput(op_builder, "indices: Tindices");
+
+    TF_OpDefinitionBuilderAddAttr(op_builder, "T: numbertype");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "Tindices: {int32, int64}");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "use_locking: bool = false");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "update_slots: bool = true");
+    TF_OpDefinitionBuilderSetShapeInferenceFunction(op_builder,
+                                                    &unknown_shape_fn);
+    TF_RegisterOpDefinition(op_builder, status.get());
+    ITEX_CHECK_EQ(TF_OK, TF_GetCode(status.get()))
+        << "_ITEXResourceSparseApplyAdagrad op registration failed: ";
+  }
+}
+
+void Register_ITEXResourceSparseApplyAdagradV2Op() {
+  itex::StatusUniquePtr status(TF_NewStatus());
+  {
+    TF_OpDefinitionBuilder* op_builder =
+        TF_NewOpDefinitionBuilder("_ITEXResourceSparseApplyAdagradV2");
+
+    TF_OpDefinitionBuilderAddInput(op_builder, "var: resource");
+    TF_OpDefinitionBuilderAddInput(op_builder, "accum: resource");
+    TF_OpDefinitionBuilderAddInput(op_builder, "lr: T");
+    TF_OpDefinitionBuilderAddInput(op_builder, "epsilon: T");
+    TF_OpDefinitionBuilderAddInput(op_builder, "grad: T");
+    TF_OpDefinitionBuilderAddInput(op_builder, "indices: Tindices");
+
+    TF_OpDefinitionBuilderAddAttr(op_builder, "T: numbertype");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "Tindices: {int32, int64}");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "use_locking: bool = false");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "update_slots: bool = true");
+    TF_OpDefinitionBuilderSetShapeInferenceFunction(op_builder,
+                                                    &unknown_shape_fn);
+    TF_RegisterOpDefinition(op_builder, status.get());
+    ITEX_CHECK_EQ(TF_OK, TF_GetCode(status.get()))
+        << "_ITEXResourceSparseApplyAdagradV2 op registration failed: ";
+  }
+}
+
+void Register_ITEXResourceScatterAddOp() {
+  itex::StatusUniquePtr status(TF_NewStatus());
+  {
+    TF_OpDefinitionBuilder* op_builder =
+        TF_NewOpDefinitionBuilder("_ITEXResourceScatterAdd");
+
+    TF_OpDefinitionBuilderAddInput(op_builder, "resource: resource");
+    TF_OpDefinitionBuilderAddInput(op_builder, "indices: Tindices");
+    TF_OpDefinitionBuilderAddInput(op_builder, "updates: dtype");
+
+    TF_OpDefinitionBuilderAddAttr(op_builder, "dtype: numbertype");
+    TF_OpDefinitionBuilderAddAttr(op_builder, "Tindices: {int32, int64}");
+    TF_OpDefinitionBuilderSetShapeInferenceFunction(op_builder,
+                                                    &unknown_shape_fn);
+    TF_RegisterOpDefinition(op_builder, status.get());
+    ITEX_CHECK_EQ(TF_OK, TF_GetCode(status.get()))
+        << "_ITEXResourceScatterAdd op registration failed: ";
+  }
+}
+
 void Register_FusedApplyAdamWithWeightDecayOp() {
   itex::StatusUniquePtr status(TF_NewStatus());
   {
@@ -0,0 +1,197 @@
+/* Copyright (c) 2022 Intel Corporation
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "itex/core/utils/cache_governor.h"
+
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "itex/core/utils/env_var.h"
+#include "itex/core/utils/logging.h"
+
+namespace itex {
+
+namespace {
+// Kernel running on this thread, see CacheGovernor::ScopedKernelRun.
+thread_local absl::string_view current_node;
+thread_local std::atomic<int32>* current_running = nullptr;
+
+constexpr int64 kBytesPerMB = 1024 * 1024;
+
+int64 ReadCacheBudgetBytes() {
+  int64 budget_mb = 0;
+  ITEX_CHECK_OK(ReadInt64FromEnvVar("ITEX_CACHE_BUDGET_MB", 0, &budget_mb));
+  if (budget_mb > 0) {
+    ITEX_LOG(INFO) << "Kernel caches are limited to " << budget_mb << " MB.";
+  }
+  return budget_mb > 0 ? budget_mb * kBytesPerMB : 0;
+}
+
+uint64 ReadCacheLogIntervalUs() {
+  int64 interval_s = 0;
+  ITEX_CHECK_OK(
+      ReadInt64FromEnvVar("ITEX_CACHE_LOG_INTERVAL_S", 0, &interval_s));
+  return interval_s > 0 ? interval_s * 1000000 : 0;
+}
+}  // namespace
+
+const char* CacheCategoryName(CacheCategory category) {
+  switch (category) {
+    case CacheCategory::kWeight:
+      return "weight";
+    case CacheCategory::kBias:
+      return "bias";
+    case CacheCategory::kLlgaPartition:
+      return "llga_partition";
+    default:
+      return "unknown";
+  }
+}
+
+CacheGovernor::ScopedKernelRun::ScopedKernelRun(absl::string_view node,
+                                                std::atomic<int32>* running)
+    : prev_node_(current_node),
+      prev_running_(current_running),
+      counted_(nullptr) {
+  current_node = node;
+  current_running = running;
+  if (CacheGovernor::Global()->HasBudget()) {
+    // Sequentially consistent, pairs with the check in eviction: either the
+    // evicting thread sees this run, or this run sees the cache unpublished.
+    running->fetch_add(1, std::memory_order_seq_cst);
+    counted_ = running;
+  }
+}
+
+CacheGovernor::ScopedKernelRun::~ScopedKernelRun() {
+  if (counted_ != nullptr) counted_->fetch_sub(1, std::memory_order_seq_cst);
+  current_node = prev_node_;
+  current_running = prev_running_;
+}
+
+CacheGovernor* CacheGovernor::Global() {
+  static CacheGovernor* instance = new CacheGovernor();
+  return instance;
+}
+
+CacheGovernor::CacheGovernor()
+    : budget_bytes_(ReadCacheBudgetBytes()),
+      log_interval_us_(ReadCacheLogIntervalUs()) {}
+
+CacheGovernor::Entry* CacheGovernor::Register(CacheCategory category,
+                                              int64 bytes, EvictFn evict) {
+  std::unique_ptr<Entry> entry(new Entry());
+  entry->category = category;
+  entry->node = std::string(current_node);
+  entry->bytes = bytes;
+  entry->running = current_running;
+  // Without the owner, there's no way to know the buffer is not in use.
+  if (entry->running != nullptr) entry->evict = std::move(evict);
+  entry->last_use_us.store(EnvTime::NowMicros(), std::memory_order_relaxed);
+
+  mutex_lock lock(&mu_);
+  Entry* result = entry.get();
+  entries_.push_back(std::move(entry));
+  total_bytes_ += bytes;
+  if (HasBudget() && total_bytes_ > budget_bytes_) EvictOverBudget(result);
+  log_pending_ = true;
+  MaybeLog();
+  return result;
+}
+
+void CacheGovernor::Unregister(Entry* entry) {
+  mutex_lock lock(&mu_);
+  auto it = std::find_if(
+      entries_.begin(), entries_.end(),
+      [entry](const std::unique_ptr<Entry>& e) { return e.get() == entry; });
+  if (it == entries_.end()) return;
+  total_bytes_ -= entry->bytes;
+  entries_.erase(it);
+  log_pending_ = true;
+  MaybeLog();
+}
+
+void CacheGovernor::EvictOverBudget(const Entry* keep) {
+  // Candidates in LRU order. Entries in use are skipped by their evict
+  // function, so it keeps going with the next one.
+  std::vector<std::list<std::unique_ptr<Entry>>::iterator> candidates;
+  for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+    if (it->get() != keep && (*it)->evict) candidates.push_back(it);
+  }
+  std::sort(candidates.begin(), candidates.end(), [](auto a, auto b) {
+    return (*a)->last_use_us.load(std::memory_order_relaxed) <
+           (*b)->last_use_us.load(std::memory_order_relaxed);
+  });
+
+  for (auto it : candidates) {
+    if (total_bytes_ <= budget_bytes_) break;
+    Entry* entry = it->get();
+    if (entry->running->load(std::memory_order_seq_cst) != 0) continue;
+    if (!entry->evict()) continue;
+    ITEX_VLOG(1) << "Evicted " << entry->bytes << " bytes of "
+                 << CacheCategoryName(entry->category) << " cache of "
+                 << entry->node;
+    total_bytes_ -= entry->bytes;
+    ++num_evictions_;
+    entries_.erase(it);
+  }
+  if (total_bytes_ > budget_bytes_) {
+    ITEX_VLOG(1) << "Kernel caches use " << total_bytes_
+                 << " bytes, over budget " << budget_bytes_
+                 << " bytes, as the rest is in use or can't be evicted.";
+  }
+}
+
+void CacheGovernor::MaybeLog() {
+  if (log_interval_us_ == 0 || !log_pending_) return;
+  const uint64 now_us = EnvTime::NowMicros();
+  if (now_us - last_log_us_ < log_interval_us_) return;
+  last_log_us_ = now_us;
+  log_pending_ = false;
+
+  int64 category_bytes[static_cast<int>(CacheCategory::kNumCategories)] = {};
+  for (const auto& entry : entries_) {
+    category_bytes[static_cast<int>(entry->category)] += entry->bytes;
+  }
+  std::string summary;
+  for (int i = 0; i < static_cast<int>(CacheCategory::kNumCategories); ++i) {
+    summary += std::string(", ") +
+               CacheCategoryName(static_cast<CacheCategory>(i)) + " " +
+               std::to_string(category_bytes[i]);
+  }
+  ITEX_LOG(INFO) << "Kernel caches hold " << total_bytes_ << " bytes in "
+                 << entries_.size() << " entries" << summary
+                 << ", evictions " << num_evictions_;
+}
+
+CacheGovernor::Stats CacheGovernor::GetStats() {
+  Stats stats;
+  mutex_lock lock(&mu_);
+  stats.budget_bytes = budget_bytes_;
+  stats.total_bytes = total_bytes_;
+  stats.num_entries = entries_.size();
+  stats.num_evictions = num_evictions_;
+  for (const auto& entry : entries_) {
+    const char* category = CacheCategoryName(entry->category);
+    stats.category_bytes[category] += entry->bytes;
+    stats.category_entries[category] += 1;
+    stats.node_bytes[entry->node] += entry->bytes;
+  }
+  return stats;
+}
+
+}  // namespace itex
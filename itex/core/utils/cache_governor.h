@@ -0,0 +1,136 @@
+/* Copyright (c) 2022 Intel Corporation
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef ITEX_CORE_UTILS_CACHE_GOVERNOR_H_
+#define ITEX_CORE_UTILS_CACHE_GOVERNOR_H_
+
+#include <atomic>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <string>
+
+#include "absl/strings/string_view.h"
+#include "itex/core/utils/env_time.h"
+#include "itex/core/utils/mutex.h"
+#include "itex/core/utils/types.h"
+
+namespace itex {
+
+enum class CacheCategory {
+  kWeight = 0,
+  kBias,
+  kLlgaPartition,
+  kNumCategories,
+};
+
+const char* CacheCategoryName(CacheCategory category);
+
+// Process-wide accounting of the persistent memory held by kernel caches,
+// such as reordered weights and scaled biases, which otherwise grows
+// unbounded in servers hosting or reloading many models.
+//
+// Each cache registers its buffer once it's filled and unregisters it before
+// freeing it. `ITEX_CACHE_BUDGET_MB` sets a budget of all the cached bytes:
+// once a new buffer goes over it, buffers of other kernels are evicted in
+// least recently used order. An evicted cache is refilled by its next run.
+// `ITEX_CACHE_LOG_INTERVAL_S` logs the usage when it changes, at most once
+// per interval.
+class CacheGovernor {
+ public:
+  // Releases the cached buffer if it can be done without blocking, and
+  // returns whether it did. It's called with the governor lock held, so it
+  // must not call back into the governor.
+  using EvictFn = std::function<bool()>;
+
+  // One registered buffer, owned by the governor.
+  struct Entry {
+    CacheCategory category;
+    std::string node;
+    int64 bytes;
+    // Null if the buffer can't be evicted.
+    EvictFn evict;
+    // Runs in flight of the owner kernel, eviction is only tried while it's
+    // zero. Null if the owner is unknown, then the buffer can't be evicted.
+    std::atomic<int32>* running;
+    std::atomic<uint64> last_use_us;
+  };
+
+  struct Stats {
+    int64 budget_bytes = 0;
+    int64 total_bytes = 0;
+    int64 num_entries = 0;
+    int64 num_evictions = 0;
+    std::map<std::string, int64> category_bytes;
+    std::map<std::string, int64> category_entries;
+    std::map<std::string, int64> node_bytes;
+  };
+
+  // Sets the kernel running on this thread, which owns the caches filled
+  // during the run. Run counting is only done with a budget, as it's only
+  // needed by eviction.
+  class ScopedKernelRun {
+   public:
+    ScopedKernelRun(absl::string_view node, std::atomic<int32>* running);
+    ~ScopedKernelRun();
+
+   private:
+    absl::string_view prev_node_;
+    std::atomic<int32>* prev_running_;
+    std::atomic<int32>* counted_;
+  };
+
+  static CacheGovernor* Global();
+
+  bool HasBudget() const { return budget_bytes_ > 0; }
+
+  // Starts tracking `bytes` of the kernel running on this thread. Evicts
+  // other entries if it goes over budget. The returned entry stays valid
+  // until it's unregistered or evicted.
+  Entry* Register(CacheCategory category, int64 bytes, EvictFn evict)
+      TF_LOCKS_EXCLUDED(mu_);
+
+  void Unregister(Entry* entry) TF_LOCKS_EXCLUDED(mu_);
+
+  // Records a cache hit for LRU order, no-op without budget.
+  void Touch(Entry* entry) {
+    if (HasBudget()) {
+      entry->last_use_us.store(EnvTime::NowMicros(), std::memory_order_relaxed);
+    }
+  }
+
+  Stats GetStats() TF_LOCKS_EXCLUDED(mu_);
+
+ private:
+  CacheGovernor();
+
+  void EvictOverBudget(const Entry* keep) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  void MaybeLog() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  const int64 budget_bytes_;
+  const uint64 log_interval_us_;
+
+  mutex mu_;
+  std::list<std::unique_ptr<Entry>> entries_ TF_GUARDED_BY(mu_);
+  int64 total_bytes_ TF_GUARDED_BY(mu_) = 0;
+  int64 num_evictions_ TF_GUARDED_BY(mu_) = 0;
+  uint64 last_log_us_ TF_GUARDED_BY(mu_) = 0;
+  bool log_pending_ TF_GUARDED_BY(mu_) = false;
+};
+
+}  // namespace itex
+
+#endif  // ITEX_CORE_UTILS_CACHE_GOVERNOR_H_
@@ -0,0 +1,56 @@
+/* Copyright (c) 2022 Intel Corporation
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "itex/core/utils/calibration_stats.h"
+
+#include <algorithm>
+
+namespace itex {
+
+CalibrationStats* CalibrationStats::Global() {
+  static CalibrationStats* instance = new CalibrationStats();
+  return instance;
+}
+
+void CalibrationStats::Update(const std::string& key, float min, float max) {
+  mutex_lock lock(&mu_);
+  auto it = ranges_.find(key);
+  if (it == ranges_.end()) {
+    ranges_.emplace(key, Range{min, max});
+    return;
+  }
+  it->second.min = std::min(it->second.min, min);
+  it->second.max = std::max(it->second.max, max);
+}
+
+bool CalibrationStats::Lookup(const std::string& key, Range* range) {
+  mutex_lock lock(&mu_);
+  auto it = ranges_.find(key);
+  if (it == ranges_.end()) return false;
+  *range = it->second;
+  return true;
+}
+
+std::map<std::string, CalibrationStats::Range> CalibrationStats::GetAll() {
+  mutex_lock lock(&mu_);
+  return ranges_;
+}
+
+void CalibrationStats::SetAll(const std::map<std::string, Range>& ranges) {
+  mutex_lock lock(&mu_);
+  ranges_ = ranges;
+}
+
+}  // namespace itex
@@ -0,0 +1,64 @@
+/* Copyright (c) 2022 Intel Corporation
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef ITEX_CORE_UTILS_CALIBRATION_STATS_H_
+#define ITEX_CORE_UTILS_CALIBRATION_STATS_H_
+
+#include <map>
+#include <string>
+
+#include "itex/core/utils/mutex.h"
+
+namespace itex {
+
+// Process-wide activation ranges of INT8 calibration. With
+// `ITEX_INT8_CALIBRATION=COLLECT`, collector ops inserted by the graph pass
+// widen the range of their tensor on every run. With
+// `ITEX_INT8_CALIBRATION=QUANTIZE`, the graph pass reads them back to emit
+// the quantized graph. Ranges are keyed by "<graph>/<node name>:input" or
+// "<graph>/<node name>:output" of the calibrated Conv/MatMul node, where
+// <graph> is a fingerprint of the calibrated nodes of the graph.
+class CalibrationStats {
+ public:
+  struct Range {
+    float min;
+    float max;
+  };
+
+  static CalibrationStats* Global();
+
+  // Widens the range of `key` to include [min, max].
+  void Update(const std::string& key, float min, float max)
+      TF_LOCKS_EXCLUDED(mu_);
+
+  // Returns false if no range has been collected for `key`.
+  bool Lookup(const std::string& key, Range* range) TF_LOCKS_EXCLUDED(mu_);
+
+  std::map<std::string, Range> GetAll() TF_LOCKS_EXCLUDED(mu_);
+
+  // Replaces all the ranges, e.g. with ones saved by a previous process.
+  void SetAll(const std::map<std::string, Range>& ranges)
+      TF_LOCKS_EXCLUDED(mu_);
+
+ private:
+  CalibrationStats() = default;
+
+  mutex mu_;
+  std::map<std::string, Range> ranges_ TF_GUARDED_BY(mu_);
+};
+
+}  // namespace itex
+
+#endif  // ITEX_CORE_UTILS_CALIBRATION_STATS_H_
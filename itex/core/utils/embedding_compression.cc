@@ -0,0 +1,107 @@
+/* Copyright (c) 2022 Intel Corporation
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "itex/core/utils/embedding_compression.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "itex/core/utils/errors.h"
+
+namespace itex {
+
+Status CompressEmbeddingTable(const Tensor& table, DataType dtype,
+                              Tensor* compressed, Tensor* scale_bias) {
+  if (table.dtype() != DT_FLOAT || table.dims() != 2) {
+    return errors::InvalidArgument(
+        "Only 2-D fp32 embedding tables can be compressed, got ",
+        DataTypeString(table.dtype()), " ", table.shape().DebugString());
+  }
+  const int64 num_rows = table.dim_size(0);
+  const int64 dim = table.dim_size(1);
+  auto src = table.flat<float>();
+
+  if (dtype == DT_BFLOAT16) {
+    *compressed = Tensor(DT_BFLOAT16, table.shape());
+    *scale_bias = Tensor(DT_FLOAT, TensorShape({0}));
+    auto dst = compressed->flat<Eigen::bfloat16>();
+    for (int64 i = 0; i < src.size(); ++i) {
+      dst(i) = static_cast<Eigen::bfloat16>(src(i));
+    }
+    return Status::OK();
+  }
+  if (dtype != DT_INT8) {
+    return errors::InvalidArgument(
+        "Embedding tables can only be compressed to bfloat16 or int8, got ",
+        DataTypeString(dtype));
+  }
+
+  // [min, max] of each row is mapped to [-128, 127].
+  *compressed = Tensor(DT_INT8, table.shape());
+  *scale_bias = Tensor(DT_FLOAT, TensorShape({num_rows, 2}));
+  auto dst = compressed->flat<int8>();
+  auto params = scale_bias->flat<float>();
+  for (int64 row = 0; row < num_rows; ++row) {
+    const float* row_src = src.data() + row * dim;
+    float min_value = 0.0f, max_value = 0.0f;
+    if (dim > 0) {
+      min_value = *std::min_element(row_src, row_src + dim);
+      max_value = *std::max_element(row_src, row_src + dim);
+    }
+    const float scale = (max_value - min_value) / 255.0f;
+    const float bias = min_value + 128.0f * scale;
+    params(2 * row) = scale;
+    params(2 * row + 1) = scale > 0.0f ? bias : min_value;
+    for (int64 i = 0; i < dim; ++i) {
+      const float q =
+          scale > 0.0f ? std::round((row_src[i] - bias) / scale) : 0.0f;
+      dst(row * dim + i) =
+          static_cast<int8>(std::min(127.0f, std::max(-128.0f, q)));
+    }
+  }
+  return Status::OK();
+}
+
+float EmbeddingCompressionError(const Tensor& table, const Tensor& compressed,
+                                const Tensor& scale_bias) {
+  const int64 num_rows = table.dim_size(0);
+  const int64 dim = table.dim_size(1);
+  auto src = table.flat<float>();
+  const float* params = scale_bias.flat<float>().data();
+  std::vector<float> row(dim);
+  float max_abs = 0.0f, max_error = 0.0f;
+  for (int64 r = 0; r < num_rows; ++r) {
+    std::fill(row.begin(), row.end(), 0.0f);
+    if (compressed.dtype() == DT_BFLOAT16) {
+      AccumulateEmbeddingRow(compressed.flat<Eigen::bfloat16>().data(), params,
+                             r, dim, 1.0f, row.data());
+    } else {
+      AccumulateEmbeddingRow(compressed.flat<int8>().data(), params, r, dim,
+                             1.0f, row.data());
+    }
+    for (int64 i = 0; i < dim; ++i) {
+      const float value = src(r * dim + i);
+      max_abs = std::max(max_abs, std::abs(value));
+      const float error = std::abs(row[i] - value);
+      if (std::isnan(error)) return std::numeric_limits<float>::infinity();
+      max_error = std::max(max_error, error);
+    }
+  }
+  return max_abs > 0.0f ? max_error / max_abs : max_error;
+}
+
+}  // namespace itex
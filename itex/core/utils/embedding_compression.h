@@ -0,0 +1,61 @@
+/* Copyright (c) 2022 Intel Corporation
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef ITEX_CORE_UTILS_EMBEDDING_COMPRESSION_H_
+#define ITEX_CORE_UTILS_EMBEDDING_COMPRESSION_H_
+
+#include "itex/core/utils/plugin_tensor.h"
+#include "itex/core/utils/types.h"
+
+namespace itex {
+
+// Compressed embedding tables, see ITEX_EMBEDDING_COMPRESSION.
+//
+// A [num_rows, dim] fp32 table is stored as bf16, or as int8 with a scale and
+// a bias per row, row[i] = q[i] * scale + bias, kept in a [num_rows, 2] fp32
+// `scale_bias` tensor. Lookups only dequantize the gathered rows.
+
+// Compresses the fp32 `table` to `dtype`, DT_BFLOAT16 or DT_INT8.
+// `scale_bias` is empty for bf16.
+Status CompressEmbeddingTable(const Tensor& table, DataType dtype,
+                              Tensor* compressed, Tensor* scale_bias);
+
+// Returns the max abs difference between `table` and its compressed version,
+// relative to the max abs value of `table`.
+float EmbeddingCompressionError(const Tensor& table, const Tensor& compressed,
+                                const Tensor& scale_bias);
+
+// Adds `weight` * row `row` of a compressed table to `acc` of size `dim`.
+inline void AccumulateEmbeddingRow(const Eigen::bfloat16* table,
+                                   const float* scale_bias, int64 row,
+                                   int64 dim, float weight, float* acc) {
+  const Eigen::bfloat16* src = table + row * dim;
+  for (int64 i = 0; i < dim; ++i) {
+    acc[i] += weight * static_cast<float>(src[i]);
+  }
+}
+
+inline void AccumulateEmbeddingRow(const int8* table, const float* scale_bias,
+                                   int64 row, int64 dim, float weight,
+                                   float* acc) {
+  const int8* src = table + row * dim;
+  const float scale = scale_bias[2 * row] * weight;
+  const float bias = scale_bias[2 * row + 1] * weight;
+  for (int64 i = 0; i < dim; ++i) acc[i] += src[i] * scale + bias;
+}
+
+}  // namespace itex
+
+#endif  // ITEX_CORE_UTILS_EMBEDDING_COMPRESSION_H_
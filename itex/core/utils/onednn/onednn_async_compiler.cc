@@ -0,0 +1,77 @@
+/* Copyright (c) 2022 Intel Corporation
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "itex/core/utils/onednn/onednn_async_compiler.h"
+
+#include <algorithm>
+#include <mutex>   // NOLINT(build/c++11)
+#include <thread>  // NOLINT(build/c++11)
+#include <utility>
+
+#include "itex/core/utils/env_var.h"
+#include "itex/core/utils/logging.h"
+
+namespace itex {
+
+AsyncPrimitiveCompiler* AsyncPrimitiveCompiler::Global() {
+  static AsyncPrimitiveCompiler* instance = [] {
+    int64_t num_threads = 1;
+    ITEX_CHECK_OK(
+        ReadInt64FromEnvVar("ITEX_ASYNC_COMPILE_THREADS", 1, &num_threads));
+    return new AsyncPrimitiveCompiler(
+        static_cast<int>(std::max<int64_t>(num_threads, 1)));
+  }();
+  return instance;
+}
+
+bool AsyncPrimitiveCompiler::IsEnabled() {
+  static std::once_flag enable_flag;
+  static bool enabled = false;
+  std::call_once(enable_flag, [&]() {
+    ITEX_CHECK_OK(
+        ReadBoolFromEnvVar("ITEX_ASYNC_PRIMITIVE_COMPILE", false, &enabled));
+  });
+  return enabled;
+}
+
+AsyncPrimitiveCompiler::AsyncPrimitiveCompiler(int num_threads) {
+  // The pool lives as long as the process, so the workers are never joined.
+  for (int i = 0; i < num_threads; ++i) {
+    std::thread(&AsyncPrimitiveCompiler::WorkerLoop, this).detach();
+  }
+}
+
+void AsyncPrimitiveCompiler::Schedule(std::function<void()> task) {
+  {
+    mutex_lock lock(&mu_);
+    tasks_.push_back(std::move(task));
+  }
+  cv_.notify_one();
+}
+
+void AsyncPrimitiveCompiler::WorkerLoop() {
+  while (true) {
+    std::function<void()> task;
+    {
+      mutex_lock lock(&mu_);
+      while (tasks_.empty()) cv_.wait(&lock);
+      task = std::move(tasks_.front());
+      tasks_.pop_front();
+    }
+    task();
+  }
+}
+
+}  // namespace itex
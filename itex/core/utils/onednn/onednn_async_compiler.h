@@ -0,0 +1,55 @@
+/* Copyright (c) 2022 Intel Corporation
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef ITEX_CORE_UTILS_ONEDNN_ONEDNN_ASYNC_COMPILER_H_
+#define ITEX_CORE_UTILS_ONEDNN_ONEDNN_ASYNC_COMPILER_H_
+
+#include <deque>
+#include <functional>
+
+#include "itex/core/utils/macros.h"
+#include "itex/core/utils/mutex.h"
+
+namespace itex {
+
+// Process-wide pool which creates oneDNN primitives off the compute threads.
+// It is enabled by `ITEX_ASYNC_PRIMITIVE_COMPILE`, with
+// `ITEX_ASYNC_COMPILE_THREADS` threads (1 by default). A kernel which misses
+// its primitive cache schedules the creation here and runs the current call
+// through a generic primitive, then swaps the created one in when it's ready.
+// Tasks must not outlive what they capture, kernels wait for their pending
+// tasks on destruction.
+class AsyncPrimitiveCompiler {
+ public:
+  static AsyncPrimitiveCompiler* Global();
+  static bool IsEnabled();
+
+  void Schedule(std::function<void()> task) TF_LOCKS_EXCLUDED(mu_);
+
+ private:
+  explicit AsyncPrimitiveCompiler(int num_threads);
+
+  void WorkerLoop() TF_LOCKS_EXCLUDED(mu_);
+
+  mutex mu_;
+  condition_variable cv_;
+  std::deque<std::function<void()>> tasks_ TF_GUARDED_BY(mu_);
+
+  TF_DISALLOW_COPY_AND_ASSIGN(AsyncPrimitiveCompiler);
+};
+
+}  // namespace itex
+
+#endif  // ITEX_CORE_UTILS_ONEDNN_ONEDNN_ASYNC_COMPILER_H_
@@ -18,6 +18,7 @@ limitations under the License.
 #include <unordered_map>
 #include <utility>
 
+#include "itex/core/utils/cache_governor.h"
 #include "itex/core/utils/mutex.h"
 
 namespace itex {
@@ -48,7 +49,13 @@ void SetOneDnnGraphPartition(dnnl::graph::partition partition) {
   // TODO(itex): Check do we need to keep this mutex to handle multi graphs
   // are optimized parallel
   mutex_lock mu(&partition_map_mutex);
-  GetPartitionMap()->insert({partition.get_id(), std::move(partition)});
+  // The size of a compiled partition is not exposed, so only the number of
+  // partitions is accounted.
+  if (GetPartitionMap()->insert({partition.get_id(), std::move(partition)})
+          .second) {
+    CacheGovernor::Global()->Register(CacheCategory::kLlgaPartition, 0,
+                                      nullptr);
+  }
 }
 
 void ExtractSpatialDims(bool is_channel_last, const std::vector<int32_t>& src,
@@ -0,0 +1,223 @@
+/* Copyright (c) 2022 Intel Corporation
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "itex/core/utils/onednn/onednn_primitive_log.h"
+
+#include <algorithm>
+#include <mutex>  // NOLINT(build/c++11)
+#include <sstream>
+
+#include "itex/core/utils/env_time.h"
+#include "itex/core/utils/env_var.h"
+#include "itex/core/utils/logging.h"
+
+namespace itex {
+
+namespace {
+
+std::string& PrimitiveLogPath() {
+  static std::string* path = new std::string();
+  return *path;
+}
+
+const char* DataTypeToString(dnnl_data_type_t data_type) {
+  switch (data_type) {
+    case dnnl_f32:
+      return "f32";
+    case dnnl_f16:
+      return "f16";
+    case dnnl_bf16:
+      return "bf16";
+    case dnnl_s32:
+      return "s32";
+    case dnnl_s8:
+      return "s8";
+    case dnnl_u8:
+      return "u8";
+    default:
+      return "undef";
+  }
+}
+
+// Escape the characters which are not allowed in JSON string.
+std::string JsonEscape(const std::string& str) {
+  std::string escaped;
+  escaped.reserve(str.size());
+  for (char c : str) {
+    switch (c) {
+      case '"':
+        escaped += "\\\"";
+        break;
+      case '\\':
+        escaped += "\\\\";
+        break;
+      case '\n':
+        escaped += "\\n";
+        break;
+      default:
+        escaped += c;
+    }
+  }
+  return escaped;
+}
+
+}  // namespace
+
+const char* PrimitiveCreateReasonToString(PrimitiveCreateReason reason) {
+  switch (reason) {
+    case PrimitiveCreateReason::kCold:
+      return "cold";
+    case PrimitiveCreateReason::kShapeChange:
+      return "shape_change";
+    case PrimitiveCreateReason::kEviction:
+      return "eviction";
+    case PrimitiveCreateReason::kGeneric:
+      return "generic";
+  }
+  return "unknown";
+}
+
+std::string OneDnnMemoryDescToString(const dnnl::memory::desc& md) {
+  const dnnl_memory_desc_t& data = md.data;
+  std::stringstream ss;
+  for (int i = 0; i < data.ndims; ++i) {
+    if (i != 0) ss << "x";
+    ss << data.dims[i];
+  }
+  ss << ":" << DataTypeToString(data.data_type) << ":";
+
+  if (data.format_kind == dnnl_format_kind_any) {
+    ss << "any";
+  } else if (data.format_kind != dnnl_blocked) {
+    ss << "opaque";
+  } else {
+    const dnnl_blocking_desc_t& blk = data.format_desc.blocking;
+    bool is_blocked[DNNL_MAX_NDIMS] = {false};
+    for (int i = 0; i < blk.inner_nblks; ++i) {
+      is_blocked[blk.inner_idxs[i]] = true;
+    }
+
+    // Outer dims are ordered from the largest stride to the smallest one.
+    std::vector<int> order(data.ndims);
+    for (int i = 0; i < data.ndims; ++i) order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&blk](int a, int b) {
+      return blk.strides[a] > blk.strides[b];
+    });
+    for (int dim : order) {
+      ss << static_cast<char>((is_blocked[dim] ? 'A' : 'a') + dim);
+    }
+    for (int i = 0; i < blk.inner_nblks; ++i) {
+      ss << blk.inner_blks[i] << static_cast<char>('a' + blk.inner_idxs[i]);
+    }
+  }
+  return ss.str();
+}
+
+PrimitiveCreationLog::PrimitiveCreationLog() {
+  const std::string& path = PrimitiveLogPath();
+  if (path.empty()) return;
+  file_ = fopen(path.c_str(), "a");
+  if (file_ == nullptr) {
+    ITEX_LOG(WARNING) << "Failed to open oneDNN primitive log file: " << path;
+  }
+}
+
+PrimitiveCreationLog::~PrimitiveCreationLog() {
+  mutex_lock lock(&mu_);
+  if (file_ != nullptr) fclose(file_);
+}
+
+PrimitiveCreationLog* PrimitiveCreationLog::Global() {
+  static PrimitiveCreationLog* log = new PrimitiveCreationLog();
+  return log;
+}
+
+bool PrimitiveCreationLog::IsEnabled() {
+  static std::once_flag log_flag;
+  static bool log_enabled = false;
+  std::call_once(log_flag, [&]() {
+    std::string path;
+    ITEX_CHECK_OK(ReadStringFromEnvVar("ITEX_ONEDNN_PRIMITIVE_LOG", "", &path));
+    PrimitiveLogPath() = path;
+    log_enabled = !path.empty();
+  });
+  return log_enabled;
+}
+
+void PrimitiveCreationLog::Record(PrimitiveCreationRecord&& record) {
+  mutex_lock lock(&mu_);
+  int64 node_total_ns =
+      (node_total_ns_[record.node_name] += record.create_time_ns);
+  if (file_ == nullptr) return;
+
+  std::stringstream ss;
+  ss << "{\"timestamp_us\":" << record.timestamp_us << ",\"node\":\""
+     << JsonEscape(record.node_name) << "\",\"op\":\""
+     << JsonEscape(record.op_type) << "\",\"primitive\":\""
+     << record.primitive_kind << "\",\"impl\":\""
+     << JsonEscape(record.impl_info) << "\",\"reason\":\""
+     << PrimitiveCreateReasonToString(record.reason) << "\",\"mds\":{";
+  for (size_t i = 0; i < record.mds.size(); ++i) {
+    if (i != 0) ss << ",";
+    ss << "\"" << record.mds[i].first << "\":\"" << record.mds[i].second
+       << "\"";
+  }
+  ss << "},\"create_time_ns\":" << record.create_time_ns
+     << ",\"node_total_ns\":" << node_total_ns << "}\n";
+
+  const std::string line = ss.str();
+  fwrite(line.data(), 1, line.size(), file_);
+  fflush(file_);
+}
+
+ScopedPrimitiveCreation::ScopedPrimitiveCreation(const OpKernel* op,
+                                                 const char* primitive_kind,
+                                                 PrimitiveCreateReason reason)
+    : enabled_(PrimitiveCreationLog::IsEnabled()) {
+  if (!enabled_) return;
+  record_.node_name = std::string(op->name());
+  record_.op_type = std::string(op->type());
+  record_.primitive_kind = primitive_kind;
+  record_.reason = reason;
+  record_.timestamp_us = EnvTime::NowMicros();
+  start_ = std::chrono::steady_clock::now();
+}
+
+void ScopedPrimitiveCreation::SetPrimitiveDesc(
+    const dnnl::primitive_desc_base& pd) {
+  if (!enabled_) return;
+  record_.impl_info = pd.impl_info_str();
+
+  // Primitives without weights return a zero memory desc, skip them.
+  auto add_md = [this](const char* name, const dnnl::memory::desc& md) {
+    if (md.data.ndims != 0) {
+      record_.mds.emplace_back(name, OneDnnMemoryDescToString(md));
+    }
+  };
+  add_md("src", pd.src_desc(0));
+  add_md("weights", pd.weights_desc(0));
+  add_md("dst", pd.dst_desc(0));
+}
+
+ScopedPrimitiveCreation::~ScopedPrimitiveCreation() {
+  if (!enabled_) return;
+  record_.create_time_ns =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now() - start_)
+          .count();
+  PrimitiveCreationLog::Global()->Record(std::move(record_));
+}
+
+}  // namespace itex
@@ -0,0 +1,105 @@
+/* Copyright (c) 2022 Intel Corporation
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef ITEX_CORE_UTILS_ONEDNN_ONEDNN_PRIMITIVE_LOG_H_
+#define ITEX_CORE_UTILS_ONEDNN_ONEDNN_PRIMITIVE_LOG_H_
+
+#include <chrono>  // NOLINT(build/c++11)
+#include <cstdio>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "dnnl.hpp"  // NOLINT(build/include_subdir)
+#include "itex/core/utils/macros.h"
+#include "itex/core/utils/mutex.h"
+#include "itex/core/utils/op_kernel.h"
+#include "itex/core/utils/types.h"
+
+namespace itex {
+
+// Why a kernel had to (re)create its oneDNN primitive.
+enum class PrimitiveCreateReason {
+  kCold,         // First execution of the node.
+  kShapeChange,  // Input shape or layout differs from the cached primitive.
+  kEviction,     // Recreated to fill an evicted weight cache again.
+  kGeneric,      // Shape-agnostic primitive run while the new shape compiles.
+};
+
+const char* PrimitiveCreateReasonToString(PrimitiveCreateReason reason);
+
+// Describe memory desc as "<dims>:<data type>:<format>", e.g.
+// "1x64x56x56:f32:aBcd8b". The format string follows oneDNN's tag naming:
+// outer dims ordered by stride, followed by inner blocks.
+std::string OneDnnMemoryDescToString(const dnnl::memory::desc& md);
+
+struct PrimitiveCreationRecord {
+  std::string node_name;
+  std::string op_type;
+  std::string primitive_kind;
+  std::string impl_info;
+  std::vector<std::pair<std::string, std::string>> mds;
+  PrimitiveCreateReason reason;
+  int64 timestamp_us;
+  int64 create_time_ns;
+};
+
+// Process-wide log of oneDNN primitive creations. It is enabled by setting
+// `ITEX_ONEDNN_PRIMITIVE_LOG` to an output file path, each creation is
+// appended as one JSON line. Every line also carries the accumulated creation
+// time of its node, so the last line of a node is the per-node total.
+class PrimitiveCreationLog {
+ public:
+  static PrimitiveCreationLog* Global();
+  static bool IsEnabled();
+
+  void Record(PrimitiveCreationRecord&& record) TF_LOCKS_EXCLUDED(mu_);
+
+ private:
+  PrimitiveCreationLog();
+  ~PrimitiveCreationLog();
+
+  mutex mu_;
+  FILE* file_ TF_GUARDED_BY(mu_) = nullptr;
+  std::unordered_map<std::string, int64> node_total_ns_ TF_GUARDED_BY(mu_);
+};
+
+// Measures primitive creation in current scope and records it into
+// PrimitiveCreationLog at the end of the scope. It is almost free when the log
+// is disabled. Usage:
+//   ScopedPrimitiveCreation record(this, "matmul", reason);
+//   fwd_pd_ = matmul::primitive_desc(...);
+//   fwd_primitive_ = matmul(fwd_pd_);
+//   record.SetPrimitiveDesc(fwd_pd_);
+class ScopedPrimitiveCreation {
+ public:
+  ScopedPrimitiveCreation(const OpKernel* op, const char* primitive_kind,
+                          PrimitiveCreateReason reason);
+  ~ScopedPrimitiveCreation();
+
+  void SetPrimitiveDesc(const dnnl::primitive_desc_base& pd);
+
+ private:
+  bool enabled_;
+  PrimitiveCreationRecord record_;
+  std::chrono::steady_clock::time_point start_;
+
+  TF_DISALLOW_COPY_AND_ASSIGN(ScopedPrimitiveCreation);
+};
+
+}  // namespace itex
+
+#endif  // ITEX_CORE_UTILS_ONEDNN_ONEDNN_PRIMITIVE_LOG_H_
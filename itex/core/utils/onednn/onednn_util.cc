@@ -15,9 +15,15 @@ limitations under the License.
 
 #include "itex/core/utils/onednn/onednn_util.h"
 
+#include <iterator>
+#include <mutex>  // NOLINT(build/c++11)
+#include <string>
 #include <unordered_map>
 
+#include "itex/core/utils/env_var.h"
+#include "itex/core/utils/hash.h"
 #include "itex/core/utils/register_types.h"
+#include "itex/core/utils/str_util.h"
 
 namespace itex {
 
@@ -31,18 +37,122 @@ void ReorderMemory(const OpKernelContext& context,
   reorder_primitive.execute(onednn_stream, reorder_args);
 }
 
-// TF datatype and shape is meaningless for some tensors, such as scratchpad
-// tensor and memory desc tensor in weight cache. These tensors are only used
-// in OneDnn primitive, not related to Tensorflow. We only need to choose a
-// short length datatype, ensure the it is divisible by allocated buffer.
-using ShortDT = uint8;
+bool IsOneDnnObjectCacheEnabled() {
+  static std::once_flag cache_flag;
+  static bool cache_enabled = false;
+  std::call_once(cache_flag, [&]() {
+    ITEX_CHECK_OK(ReadBoolFromEnvVar("ITEX_CACHE_ONEDNN_OBJECT", false,
+                                     &cache_enabled));
+  });
+  return cache_enabled;
+}
+
+const std::string& GetFP32MathModeString() {
+  static std::once_flag math_mode_flag;
+  static std::string* fp32_math_mode = new std::string("fp32");
+  std::call_once(math_mode_flag, [&]() {
+    ITEX_CHECK_OK(
+        ReadStringFromEnvVar("ITEX_FP32_MATH_MODE", "fp32", fp32_math_mode));
+    *fp32_math_mode = str_util::Lowercase(*fp32_math_mode);
+  });
+  return *fp32_math_mode;
+}
+
+bool CanUseConvFilterLayout(
+    const dnnl::memory::desc& filter_md,
+    const dnnl::convolution_backward_data::desc& any_desc,
+    const dnnl::convolution_backward_data::desc& shared_desc,
+    const dnnl::primitive_attr& attr, const dnnl::engine& onednn_engine,
+    const dnnl::convolution_forward::primitive_desc& fwd_pd) {
+  dnnl::convolution_backward_data::primitive_desc any_pd(
+      any_desc, attr, onednn_engine, fwd_pd);
+  if (any_pd.weights_desc() == filter_md) return true;
+  dnnl::convolution_backward_data::primitive_desc shared_pd(
+      shared_desc, attr, onednn_engine, fwd_pd, /*allow_empty=*/true);
+  return shared_pd && shared_pd.impl_info_str() == any_pd.impl_info_str();
+}
+
+SharedWeightCache::Buffer::~Buffer() {
+  CacheGovernor::Global()->Unregister(entry);
+}
+
+SharedWeightCache* SharedWeightCache::Global() {
+  static SharedWeightCache* instance = new SharedWeightCache();
+  return instance;
+}
+
+bool SharedWeightCache::IsEnabled(const dnnl::engine& onednn_engine) {
+  static std::once_flag share_flag;
+  static bool share_enabled = true;
+  std::call_once(share_flag, [&]() {
+    ITEX_CHECK_OK(
+        ReadBoolFromEnvVar("ITEX_SHARE_WEIGHT_CACHE", true, &share_enabled));
+  });
+  return share_enabled && !CacheGovernor::Global()->HasBudget() &&
+         onednn_engine.get_kind() == dnnl::engine::kind::cpu;
+}
+
+SharedWeightCache::Key SharedWeightCache::MakeKey(const void* data,
+                                                  size_t size) {
+  // Seeds of the two fingerprints, any two different values.
+  constexpr uint64 kFingerprintSeed = 0x9ae16a3b2f90404fULL;
+  constexpr uint64 kCheckSeed = 0xc3a5c85c97cb3127ULL;
+  const char* bytes = static_cast<const char*>(data);
+  return {Hash64Combine(Hash64(bytes, size, kFingerprintSeed), size),
+          Hash64(bytes, size, kCheckSeed)};
+}
+
+std::shared_ptr<const SharedWeightCache::Buffer>
+SharedWeightCache::LookupLocked(const Key& key,
+                                const dnnl::memory::desc& original_md,
+                                const dnnl::memory::desc& expected_md) {
+  auto range = slots_.equal_range(key.fingerprint);
+  for (auto it = range.first; it != range.second; ++it) {
+    const Slot& slot = it->second;
+    if (slot.check != key.check || slot.original_md != original_md ||
+        slot.expected_md != expected_md)
+      continue;
+    // Null if the last owner is gone, then it's refilled.
+    std::shared_ptr<const Buffer> buffer = slot.buffer.lock();
+    if (buffer != nullptr) return buffer;
+  }
+  return nullptr;
+}
+
+std::shared_ptr<const SharedWeightCache::Buffer> SharedWeightCache::Lookup(
+    const Key& key, const dnnl::memory::desc& original_md,
+    const dnnl::memory::desc& expected_md) {
+  mutex_lock lock(&mu_);
+  return LookupLocked(key, original_md, expected_md);
+}
+
+std::shared_ptr<const SharedWeightCache::Buffer> SharedWeightCache::Insert(
+    const Key& key, const dnnl::memory::desc& original_md,
+    const dnnl::memory::desc& expected_md, const PersistentTensor& tensor,
+    void* data) {
+  mutex_lock lock(&mu_);
+  std::shared_ptr<const Buffer> buffer =
+      LookupLocked(key, original_md, expected_md);
+  if (buffer != nullptr) return buffer;
+
+  // Drop the slots of freed buffers, this one included.
+  for (auto it = slots_.begin(); it != slots_.end();) {
+    it = it->second.buffer.expired() ? slots_.erase(it) : std::next(it);
+  }
+  CacheGovernor::Entry* entry = CacheGovernor::Global()->Register(
+      CacheCategory::kWeight, expected_md.get_size(), nullptr);
+  buffer.reset(new Buffer{tensor, data, entry});
+  slots_.emplace(key.fingerprint,
+                 Slot{key.check, original_md, expected_md, buffer});
+  return buffer;
+}
 
 template <typename T>
-bool WeightCacheManager<T>::IsEmpty() TF_LOCKS_EXCLUDED(mu_) {
-  tf_shared_lock lock(&mu_);
-  // TODO(itex): investigate why weight_cached_data_.NumElements() == 1
-  // instead of 0,  while weight_cached_data_.IsInitialized() == True
-  return (!weight_cached_data_.IsInitialized());
+WeightCacheManager<T>::~WeightCacheManager() {
+  mutex_lock lock(&mu_);
+  if (cached_weight_ != nullptr && cached_weight_->entry != nullptr) {
+    CacheGovernor::Global()->Unregister(cached_weight_->entry);
+  }
 }
 
 template <typename T>
@@ -52,10 +162,27 @@ void WeightCacheManager<T>::SetCache(
     const dnnl::engine& onednn_engine) TF_LOCKS_EXCLUDED(mu_) {
   mutex_lock lock(&mu_);
 
-  if (weight_cached_data_.IsInitialized()) {
+  if (cached_weight_ != nullptr) {
     return;
   }
 
+  // Reuse the buffer of another node with the same weight if there's one,
+  // without reordering it again.
+  const bool is_shared = SharedWeightCache::IsEnabled(onednn_engine);
+  SharedWeightCache::Key key{0, 0};
+  if (is_shared) {
+    key = SharedWeightCache::MakeKey(weight_data,
+                                     weight_original_md.get_size());
+    shared_weight_ = SharedWeightCache::Global()->Lookup(
+        key, weight_original_md, weight_expected_md);
+    if (shared_weight_ != nullptr) {
+      cached_weight_.reset(new CachedWeight{
+          static_cast<T*>(shared_weight_->data), weight_expected_md, nullptr});
+      published_.store(cached_weight_.get(), std::memory_order_seq_cst);
+      return;
+    }
+  }
+
   // Create original memory
   dnnl::memory weight_mem =
       CreateDnnlMemory(weight_original_md, onednn_engine, weight_data);
@@ -78,52 +205,56 @@ void WeightCacheManager<T>::SetCache(
   // Execute reorder
   ReorderMemory(*context, &weight_mem, &weight_reorder_mem, onednn_engine);
 
-  // Cache the memory descriptor
-  Tensor* weight_md_cached_tensor = nullptr;
-  TensorShape weight_md_tf_shape;
-  weight_md_tf_shape.AddDim(sizeof(weight_expected_md) / sizeof(ShortDT));
+  // Publish the buffer with its md, readers no longer need the lock.
+  CacheGovernor::Entry* entry = nullptr;
+  if (is_shared) {
+    shared_weight_ = SharedWeightCache::Global()->Insert(
+        key, weight_original_md, weight_expected_md, weight_cached_data_,
+        weight_cached_data);
+    // Only the shared buffer is kept, which may be another thread's.
+    weight_cached_data_ = PersistentTensor();
+    weight_cached_data = shared_weight_->data;
+  } else {
+    entry = CacheGovernor::Global()->Register(
+        CacheCategory::kWeight, weight_size, [this]() { return Evict(); });
+  }
+  cached_weight_.reset(new CachedWeight{static_cast<T*>(weight_cached_data),
+                                        weight_expected_md, entry});
+  published_.store(cached_weight_.get(), std::memory_order_seq_cst);
+}
 
-  AllocatorAttributes alloc_attr;
-  alloc_attr.set_on_host(true);
-  OP_REQUIRES_OK(context,
-                 context->allocate_persistent(
-                     DataTypeToEnum<ShortDT>::value, weight_md_tf_shape,
-                     &weight_cached_md_, &weight_md_cached_tensor, alloc_attr));
-  *reinterpret_cast<dnnl::memory::desc*>(
-      weight_md_cached_tensor->flat<ShortDT>().data()) = weight_expected_md;
+template <typename T>
+bool WeightCacheManager<T>::Evict() {
+  mutex_lock lock(&mu_, std::try_to_lock);
+  if (!lock || cached_weight_ == nullptr) return false;
+
+  // Unpublish first, then check no run of the owner kernel is in flight.
+  // Both sides are sequentially consistent: a run counted after the check
+  // sees the cache empty, a run counted before keeps the buffer alive.
+  published_.store(nullptr, std::memory_order_seq_cst);
+  if (cached_weight_->entry->running->load(std::memory_order_seq_cst) != 0) {
+    published_.store(cached_weight_.get(), std::memory_order_seq_cst);
+    return false;
+  }
+  cached_weight_.reset();
+  weight_cached_data_ = PersistentTensor();
+  return true;
 }
 
 template <typename T>
 T* WeightCacheManager<T>::GetCache(OpKernelContext* context,
-                                   const dnnl::memory::desc& expected_md)
-    TF_LOCKS_EXCLUDED(mu_) {
-  tf_shared_lock lock(&mu_);
-  const Tensor* weight_cached_data = weight_cached_data_.AccessTensor(context);
-  const Tensor* weight_cached_md = weight_cached_md_.AccessTensor(context);
+                                   const dnnl::memory::desc& expected_md) {
+  const CachedWeight* cached = published_.load(std::memory_order_seq_cst);
+  // The cache may be evicted between IsEmpty() and here.
+  if (cached == nullptr) return nullptr;
+  if (cached->entry != nullptr) CacheGovernor::Global()->Touch(cached->entry);
 
   // Check if the memory descriptor of the cached weight is same as
   // expected_md. if so use the cached memory, else return nullptr
-  if (weight_cached_md->flat<ShortDT>().size()) {
-    dnnl::memory::desc* cached_md = reinterpret_cast<dnnl::memory::desc*>(
-        const_cast<ShortDT*>(weight_cached_md->flat<ShortDT>().data()));
-    if (*cached_md == expected_md) {
-      return reinterpret_cast<T*>(
-          const_cast<T*>(weight_cached_data->flat<T>().data()));
-    } else {
-      return nullptr;
-      // TODO(itex): Weight cache format can change in the case that matmul
-      // src has dymanic shape. Is it possible to cache weights with different
-      // format? OP_REQUIRES_PTR(
-      //     context, false,
-      //     errors::Aborted("Unexpected memory descriptor from cached
-      //     tensor!"));
-    }
-  } else {
-    OP_REQUIRES_PTR(
-        context, false,
-        errors::Aborted(
-            "Size of cached filter memory descriptor must not be zero!"));
-  }
+  // TODO(itex): Weight cache format can change in the case that matmul
+  // src has dymanic shape. Is it possible to cache weights with different
+  // format?
+  return cached->md == expected_md ? cached->data : nullptr;
 }
 
 #define DEFINE_WEIGHT_CACHE(T) template class WeightCacheManager<T>;
@@ -133,11 +264,9 @@ TF_CALL_double(DEFINE_WEIGHT_CACHE);
 #undef DEFINE_WEIGHT_CACHE
 
 template <typename T>
-bool BiasCacheManager<T>::IsEmpty() TF_LOCKS_EXCLUDED(mu_) {
-  tf_shared_lock lock(&mu_);
-  // TODO(itex): investigate why bias_cached_data_.NumElements() == 1
-  // instead of 0,  when bias_cached_data_.IsInitialized() == True
-  return (!bias_cached_data_.IsInitialized());
+BiasCacheManager<T>::~BiasCacheManager() {
+  mutex_lock lock(&mu_);
+  if (entry_ != nullptr) CacheGovernor::Global()->Unregister(entry_);
 }
 
 template <typename T>
@@ -180,15 +309,19 @@ void BiasCacheManager<T>::SetCache(OpKernelContext* context,
   // Execute reorder
   auto onednn_stream = CreateDnnlStream(*context, onednn_engine);
   reorder_primitive.execute(onednn_stream, reorder_args);
+
+  entry_ = CacheGovernor::Global()->Register(CacheCategory::kBias, bias_size,
+                                             nullptr);
+  published_.store(static_cast<T*>(bias_cached_data),
+                   std::memory_order_release);
 }
 
 template <typename T>
-T* BiasCacheManager<T>::GetCache(OpKernelContext* context)
-    TF_LOCKS_EXCLUDED(mu_) {
-  tf_shared_lock lock(&mu_);
-  const Tensor* bias_cached_data = bias_cached_data_.AccessTensor(context);
-  return reinterpret_cast<T*>(
-      const_cast<T*>(bias_cached_data->flat<T>().data()));
+T* BiasCacheManager<T>::GetCache(OpKernelContext* context) {
+  T* bias_cached_data = published_.load(std::memory_order_acquire);
+  OP_REQUIRES_PTR(context, bias_cached_data != nullptr,
+                  errors::Aborted("Bias cache must be set before use!"));
+  return bias_cached_data;
 }
 
 #define DEFINE_BIAS_CACHE(T) template class BiasCacheManager<T>;
@@ -16,8 +16,11 @@ limitations under the License.
 #ifndef ITEX_CORE_UTILS_ONEDNN_ONEDNN_UTIL_H_
 #define ITEX_CORE_UTILS_ONEDNN_ONEDNN_UTIL_H_
 
+#include <atomic>
 #include <map>
+#include <memory>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -27,6 +30,7 @@ limitations under the License.
 #include "dnnl_sycl.hpp"  // NOLINT(build/include_subdir)
 #endif                    // INTEL_CPU_ONLY
 
+#include "itex/core/utils/cache_governor.h"
 #include "itex/core/utils/logging.h"
 #include "itex/core/utils/op_kernel.h"
 #include "itex/core/utils/op_requires.h"
@@ -503,43 +507,144 @@ void ReorderMemory(const OpKernelContext& context,
                    const dnnl::memory* src_memory, dnnl::memory* reorder_memory,
                    const dnnl::engine& onednn_engine);
 
+// Process-wide pool of reordered weights on CPU, keyed by a fingerprint of the
+// original weight data and both memory descs. Nodes using the same constant
+// weight, e.g. a tied embedding and output projection, or several sessions
+// and signatures of one model, share one reference-counted buffer instead of
+// each keeping its own copy, and only the first one reorders it. A buffer is
+// freed with its last owner.
+//
+// The key is checked on a hit with a second fingerprint of the original data,
+// computed with another seed, so a collision of the first one can't mix
+// weights.
+//
+// `ITEX_SHARE_WEIGHT_CACHE=0` disables sharing. It's also disabled under
+// `ITEX_CACHE_BUDGET_MB`, as a buffer with several owners can't be evicted by
+// one of them.
+class SharedWeightCache {
+ public:
+  struct Buffer {
+    ~Buffer();
+
+    PersistentTensor tensor;
+    void* data;
+    // Registered once for all the owners, never evicted.
+    CacheGovernor::Entry* entry;
+  };
+
+  // Fingerprints of the original weight data.
+  struct Key {
+    uint64 fingerprint;
+    // Checked on a hit, as the fingerprint may collide.
+    uint64 check;
+  };
+
+  static SharedWeightCache* Global();
+
+  // Only CPU weights are shared, as they can be fingerprinted from the host.
+  static bool IsEnabled(const dnnl::engine& onednn_engine);
+
+  static Key MakeKey(const void* data, size_t size);
+
+  // Returns the live buffer of this key and mds, or nullptr, then the caller
+  // reorders the weight and inserts it.
+  std::shared_ptr<const Buffer> Lookup(const Key& key,
+                                       const dnnl::memory::desc& original_md,
+                                       const dnnl::memory::desc& expected_md)
+      TF_LOCKS_EXCLUDED(mu_);
+
+  // Adds a buffer reordered by the caller and registers it to
+  // CacheGovernor. If another thread added one with this key and mds since
+  // the lookup, that one is returned and `tensor` is dropped.
+  std::shared_ptr<const Buffer> Insert(const Key& key,
+                                       const dnnl::memory::desc& original_md,
+                                       const dnnl::memory::desc& expected_md,
+                                       const PersistentTensor& tensor,
+                                       void* data) TF_LOCKS_EXCLUDED(mu_);
+
+ private:
+  struct Slot {
+    uint64 check;
+    dnnl::memory::desc original_md;
+    dnnl::memory::desc expected_md;
+    std::weak_ptr<const Buffer> buffer;
+  };
+
+  std::shared_ptr<const Buffer> LookupLocked(
+      const Key& key, const dnnl::memory::desc& original_md,
+      const dnnl::memory::desc& expected_md) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  mutex mu_;
+  std::unordered_multimap<uint64, Slot> slots_ TF_GUARDED_BY(mu_);
+};
+
 // Weight cache is used to avoid weight reorder repetitively when target weight
 // block md is different frome original weight plain md.
+//
+// The cache is filled once and never changes afterwards, so it is published
+// through an atomic pointer: readers only do a load, and `mu_` is only taken
+// by the thread filling the cache. The buffer is registered to
+// CacheGovernor, which may evict it under a cache budget when no run of the
+// owner kernel is in flight; the next run then fills it again. When
+// SharedWeightCache is enabled, the buffer is taken from it instead and
+// accounted there.
 template <typename T>
 class WeightCacheManager {
  public:
   WeightCacheManager() = default;
-  ~WeightCacheManager() = default;
+  ~WeightCacheManager() TF_LOCKS_EXCLUDED(mu_);
 
-  bool IsEmpty() TF_LOCKS_EXCLUDED(mu_);
+  // Sequentially consistent load, see Evict().
+  bool IsEmpty() const {
+    return published_.load(std::memory_order_seq_cst) == nullptr;
+  }
 
-  // Cache the reordered weight buffer & weight md as persistent tensors.
-  // Only one thread can execute this method at any given time.
+  // Cache the reordered weight buffer as persistent tensor, then publish it
+  // with its md. Only one thread can execute this method at any given time.
   void SetCache(OpKernelContext* context,
                 const dnnl::memory::desc& weight_original_md,
                 const dnnl::memory::desc& weight_expected_md, void* weight_data,
                 const dnnl::engine& onednn_engine) TF_LOCKS_EXCLUDED(mu_);
 
-  // Get the cached weight buffer
-  T* GetCache(OpKernelContext* context, const dnnl::memory::desc& expected_md)
-      TF_LOCKS_EXCLUDED(mu_);
+  // Get the cached weight buffer, lock free. Returns nullptr if the cache is
+  // empty or has another md, then the caller reorders the weight itself.
+  T* GetCache(OpKernelContext* context, const dnnl::memory::desc& expected_md);
 
  private:
   TF_DISALLOW_COPY_AND_ASSIGN(WeightCacheManager);
 
+  struct CachedWeight {
+    T* data;
+    dnnl::memory::desc md;
+    // Null for a shared buffer.
+    CacheGovernor::Entry* entry;
+  };
+
+  // Frees the cache if it can be done without waiting, called by
+  // CacheGovernor.
+  bool Evict() TF_LOCKS_EXCLUDED(mu_);
+
   mutex mu_;
   PersistentTensor weight_cached_data_ TF_GUARDED_BY(mu_);
-  PersistentTensor weight_cached_md_ TF_GUARDED_BY(mu_);
+  std::shared_ptr<const SharedWeightCache::Buffer> shared_weight_
+      TF_GUARDED_BY(mu_);
+  std::unique_ptr<const CachedWeight> cached_weight_ TF_GUARDED_BY(mu_);
+  // Points to `cached_weight_` once the reorder is done.
+  std::atomic<const CachedWeight*> published_{nullptr};
 };
 
 // Bias cache is used to avoid scale the bias tensor repetitively in INT8 kernel
+// and is published the same way as WeightCacheManager. It's accounted by
+// CacheGovernor but never evicted, as callers use it without a fallback.
 template <typename T>
 class BiasCacheManager {
  public:
   BiasCacheManager() = default;
-  ~BiasCacheManager() = default;
+  ~BiasCacheManager() TF_LOCKS_EXCLUDED(mu_);
 
-  bool IsEmpty() TF_LOCKS_EXCLUDED(mu_);
+  bool IsEmpty() const {
+    return published_.load(std::memory_order_acquire) == nullptr;
+  }
 
   // Cache the scaled bias buffer as persistent tensors.
   // Only one thread can execute this method at any given time.
@@ -547,22 +652,29 @@ class BiasCacheManager {
                 const dnnl::primitive_attr& bias_attr, void* bias_data,
                 const dnnl::engine& onednn_engine) TF_LOCKS_EXCLUDED(mu_);
 
-  // Get the cached bias buffer
-  T* GetCache(OpKernelContext* context) TF_LOCKS_EXCLUDED(mu_);
+  // Get the cached bias buffer, lock free.
+  T* GetCache(OpKernelContext* context);
 
  private:
   TF_DISALLOW_COPY_AND_ASSIGN(BiasCacheManager);
 
   mutex mu_;
   PersistentTensor bias_cached_data_ TF_GUARDED_BY(mu_);
+  CacheGovernor::Entry* entry_ TF_GUARDED_BY(mu_) = nullptr;
+  // Data of `bias_cached_data_` once the scaling is done.
+  std::atomic<T*> published_{nullptr};
 };
 
+// Returns whether `ITEX_CACHE_ONEDNN_OBJECT` is enabled. The env var is read
+// only once, instead of in every kernel constructor.
+bool IsOneDnnObjectCacheEnabled();
+
+// Returns the lowercase value of `ITEX_FP32_MATH_MODE`, read only once.
+const std::string& GetFP32MathModeString();
+
 template <typename Device>
 inline dnnl::fpmath_mode GetFP32MathMode() {
-  std::string fp32_math_mode = "fp32";
-  ITEX_CHECK_OK(
-      ReadStringFromEnvVar("ITEX_FP32_MATH_MODE", "fp32", &fp32_math_mode));
-  fp32_math_mode = str_util::Lowercase(fp32_math_mode);
+  const std::string& fp32_math_mode = GetFP32MathModeString();
   if (fp32_math_mode == "fp32") {
     return dnnl::fpmath_mode::strict;
   }
@@ -583,5 +695,17 @@ inline dnnl::fpmath_mode GetFP32MathMode() {
       << fp32_math_mode;
 }
 
+// Returns whether the backward data convolution of `any_desc`, whose filter
+// format is `any`, can read its filter in `filter_md`, the layout reordered
+// by the forward convolution `fwd_pd`. It can if it picks that layout, or if
+// the implementation it picks also accepts it through `shared_desc`, the same
+// descriptor with `filter_md` as filter.
+bool CanUseConvFilterLayout(
+    const dnnl::memory::desc& filter_md,
+    const dnnl::convolution_backward_data::desc& any_desc,
+    const dnnl::convolution_backward_data::desc& shared_desc,
+    const dnnl::primitive_attr& attr, const dnnl::engine& onednn_engine,
+    const dnnl::convolution_forward::primitive_desc& fwd_pd);
+
 }  // namespace itex
 #endif  // ITEX_CORE_UTILS_ONEDNN_ONEDNN_UTIL_H_
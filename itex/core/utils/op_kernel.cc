@@ -17,8 +17,12 @@ limitations under the License.
 
 #include "itex/core/utils/op_kernel.h"
 
+#include <algorithm>
+#include <chrono>  // NOLINT(build/c++11)
 #include <iostream>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "itex/core/devices/xpu_device_util.h"
 #include "itex/core/utils/kernel_def_util.h"
@@ -709,25 +713,59 @@ KernelRegistry* GlobalKernelRegistry() {
   return &global_kernel_registry;
 }
 
-void RegisterCPUKernels(const char* device_name) {
+namespace {
+// Calls all register functions of `backend`. When ITEX_VERBOSE >= 2, the time
+// of every register function is measured and the slowest ones are reported, to
+// find out kernels which do heavy work during plugin initialization.
+void RegisterKernelsForBackend(const char* device_name, const char* backend) {
+  const bool profile_each = ITEX_VLOG_IS_ON(2);
+  std::vector<std::pair<int64, const std::string*>> elapsed_list;
+  auto start = std::chrono::steady_clock::now();
   for (auto const& x : GlobalKernelRegistry()->registry) {
     KernelRegisterFunc func = x.second;
-    func(device_name, DEVICE_CPU);
+    if (!profile_each) {
+      func(device_name, backend);
+      continue;
+    }
+    auto func_start = std::chrono::steady_clock::now();
+    func(device_name, backend);
+    elapsed_list.emplace_back(
+        std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - func_start)
+            .count(),
+        &x.first);
   }
+  auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+                     std::chrono::steady_clock::now() - start)
+                     .count();
+  ITEX_VLOG(1) << "Registered " << GlobalKernelRegistry()->registry.size()
+               << " kernel entries for " << backend << " backend in "
+               << elapsed << " us";
+
+  if (profile_each) {
+    constexpr size_t kTopN = 10;
+    size_t top_n = std::min(kTopN, elapsed_list.size());
+    std::partial_sort(
+        elapsed_list.begin(), elapsed_list.begin() + top_n, elapsed_list.end(),
+        [](const auto& a, const auto& b) { return a.first > b.first; });
+    for (size_t i = 0; i < top_n; ++i) {
+      ITEX_VLOG(2) << "Kernel registration " << *elapsed_list[i].second
+                   << " took " << elapsed_list[i].first << " us";
+    }
+  }
+}
+}  // namespace
+
+void RegisterCPUKernels(const char* device_name) {
+  RegisterKernelsForBackend(device_name, DEVICE_CPU);
 }
 
 void RegisterGPUKernels(const char* device_name) {
-  for (auto const& x : GlobalKernelRegistry()->registry) {
-    KernelRegisterFunc func = x.second;
-    func(device_name, DEVICE_GPU);
-  }
+  RegisterKernelsForBackend(device_name, DEVICE_GPU);
 }
 
 void RegisterDefaultKernels() {
-  for (auto const& x : GlobalKernelRegistry()->registry) {
-    KernelRegisterFunc func = x.second;
-    func(DEVICE_DEFAULT, DEVICE_DEFAULT);
-  }
+  RegisterKernelsForBackend(DEVICE_DEFAULT, DEVICE_DEFAULT);
 }
 }  // namespace register_kernel
 
@@ -18,6 +18,7 @@ limitations under the License.
 #ifndef ITEX_CORE_UTILS_OP_KERNEL_H_
 #define ITEX_CORE_UTILS_OP_KERNEL_H_
 
+#include <atomic>
 #include <functional>
 #include <map>
 #include <memory>
@@ -28,12 +29,14 @@ limitations under the License.
 #include "absl/synchronization/mutex.h"
 #include "itex/core/utils/allocator.h"
 #include "itex/core/utils/annotated_traceme.h"
+#include "itex/core/utils/cache_governor.h"
 #include "itex/core/utils/cpu_info.h"
 #include "itex/core/utils/env_var.h"
 #include "itex/core/utils/kernel_def_util.h"
 #include "itex/core/utils/logging.h"
 #include "itex/core/utils/mutex.h"
 #include "itex/core/utils/plugin_tensor.h"
+#include "itex/core/utils/step_cancellation.h"
 #include "itex/core/utils/types.h"
 #include "protos/node_def.pb.h"
 #include "tensorflow/c/c_api.h"
@@ -185,6 +188,7 @@ class OpKernelContext {
   }
 
   int num_inputs() const;  // { return inputs->size(); }
+  int64 step_id() const { return TF_GetStepId(ctx_); }
 
   // TODO(itex): Add TF_InputIsRef C-API to distinguish whether the input is
   // ref tensor or not. Currently, input_dtype is not fully funtional at all !!
@@ -563,9 +567,14 @@ class OpKernel {
 
   std::string TraceString(const OpKernelContext& ctx) const;
 
+  // Runs of this kernel in flight, only counted with a cache budget. See
+  // CacheGovernor.
+  std::atomic<int32>* num_running() { return &num_running_; }
+
  private:
   absl::string_view op_name;
   absl::string_view op_type;
+  std::atomic<int32> num_running_{0};
 };
 
 class KernelDefBuilder {
@@ -696,6 +705,14 @@ class Registrar {
 bool IsSyncExecEnabled();
 bool IsVerboseEnabled();
 inline void RunOrWaitUntilFinish(OpKernelContext* context, OpKernel* op) {
+  // Skip kernels of a cancelled or timed out step.
+  Status s = StepCancellation::Global()->CheckStep(context->step_id());
+  if (ITEX_PREDICT_FALSE(!s.ok())) {
+    context->CtxFailure(__FILE__, __LINE__, s);
+    return;
+  }
+  // Caches filled by this run are accounted to `op`.
+  CacheGovernor::ScopedKernelRun kernel_run(op->name(), op->num_running());
 #ifndef INTEL_CPU_ONLY
   if (IsSyncExecEnabled()) {
     auto start = std::chrono::steady_clock::now();
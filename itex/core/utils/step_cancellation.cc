@@ -0,0 +1,179 @@
+/* Copyright (c) 2022 Intel Corporation
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "itex/core/utils/step_cancellation.h"
+
+#include <thread>  // NOLINT(build/c++11)
+
+#include "itex/core/utils/env_time.h"
+#include "itex/core/utils/env_var.h"
+#include "itex/core/utils/errors.h"
+#include "itex/core/utils/logging.h"
+#include "itex/core/utils/macros.h"
+
+namespace itex {
+
+namespace {
+int64 ReadStepTimeoutUs() {
+  int64 timeout_ms = 0;
+  ITEX_CHECK_OK(ReadInt64FromEnvVar("ITEX_STEP_TIMEOUT_MS", 0, &timeout_ms));
+  if (timeout_ms > 0) {
+    ITEX_LOG(INFO) << "Kernels of a step will be skipped after "
+                   << timeout_ms << " ms.";
+  }
+  return timeout_ms > 0 ? timeout_ms * 1000 : 0;
+}
+}  // namespace
+
+StepCancellation* StepCancellation::Global() {
+  static StepCancellation* instance = new StepCancellation();
+  return instance;
+}
+
+StepCancellation::StepCancellation() : timeout_us_(ReadStepTimeoutUs()) {}
+
+int64 StepCancellation::NewTag() {
+  return next_tag_.fetch_add(1, std::memory_order_relaxed);
+}
+
+StepCancellation::StepSlot* StepCancellation::FindSlot(int64 step_id,
+                                                       bool create,
+                                                       uint64 now_us) {
+  const uint64 home = static_cast<uint64>(step_id) % kNumSlots;
+  while (true) {
+    StepSlot* reusable = nullptr;
+    int64 reusable_id = kNoStep;
+    for (int64 i = 0; i < kMaxProbes; ++i) {
+      StepSlot& slot = steps_[(home + i) % kNumSlots];
+      int64 slot_step = slot.step_id.load(std::memory_order_acquire);
+      while (ITEX_PREDICT_FALSE(slot_step == kClaimingStep)) {
+        std::this_thread::yield();
+        slot_step = slot.step_id.load(std::memory_order_acquire);
+      }
+      if (slot_step == step_id) return &slot;
+      if (!create || reusable != nullptr) {
+        // Slots are never emptied, so a step is always before the first
+        // empty slot of its probe sequence.
+        if (slot_step == kNoStep) break;
+        continue;
+      }
+      const bool is_idle =
+          slot_step == kNoStep ||
+          (now_us > slot.last_use_us.load(std::memory_order_relaxed) +
+                        kIdleMicros &&
+           now_us > slot.start_us.load(std::memory_order_relaxed) +
+                        static_cast<uint64>(timeout_us_));
+      if (is_idle) {
+        reusable = &slot;
+        reusable_id = slot_step;
+      }
+      if (slot_step == kNoStep) break;
+    }
+    if (reusable == nullptr) return nullptr;
+
+    // Another first kernel of this step, or of another one, may take the
+    // slot first, then look again.
+    if (!reusable->step_id.compare_exchange_strong(
+            reusable_id, kClaimingStep, std::memory_order_acq_rel,
+            std::memory_order_relaxed)) {
+      continue;
+    }
+    reusable->start_us.store(now_us, std::memory_order_relaxed);
+    reusable->last_use_us.store(now_us, std::memory_order_relaxed);
+    reusable->tag.store(kNoTag, std::memory_order_relaxed);
+    reusable->cancelled.store(false, std::memory_order_relaxed);
+    reusable->step_id.store(step_id, std::memory_order_release);
+    return reusable;
+  }
+}
+
+bool StepCancellation::IsTagCancelled(int64 tag) {
+  mutex_lock lock(&mu_);
+  return cancelled_tags_.count(tag) > 0;
+}
+
+Status StepCancellation::TagStep(int64 step_id, int64 tag) {
+  has_tags_.store(true, std::memory_order_relaxed);
+  StepSlot* slot = FindSlot(step_id, true, EnvTime::NowMicros());
+  if (slot == nullptr) {
+    ITEX_LOG_FIRST_N(WARNING, 1)
+        << "Too many running steps, step " << step_id
+        << " can't be cancelled by its tag.";
+    return Status::OK();
+  }
+  // Paired with CancelTag: either the tag is found cancelled here, or the
+  // slot is found by its tag there.
+  slot->tag.store(tag);
+  if (IsTagCancelled(tag)) {
+    slot->cancelled.store(true, std::memory_order_relaxed);
+    return errors::Cancelled("Step ", step_id, " was cancelled.");
+  }
+  return Status::OK();
+}
+
+void StepCancellation::CancelTag(int64 tag) {
+  {
+    mutex_lock lock(&mu_);
+    cancelled_tags_.insert(tag);
+  }
+  for (auto& slot : steps_) {
+    if (slot.tag.load() == tag) {
+      slot.cancelled.store(true, std::memory_order_relaxed);
+    }
+  }
+}
+
+void StepCancellation::ReleaseTag(int64 tag) {
+  mutex_lock lock(&mu_);
+  cancelled_tags_.erase(tag);
+}
+
+Status StepCancellation::CheckStep(int64 step_id) {
+  const bool has_timeout = timeout_us_ > 0;
+  if (ITEX_PREDICT_TRUE(!has_timeout &&
+                        !has_tags_.load(std::memory_order_relaxed))) {
+    return Status::OK();
+  }
+
+  // Without timeout, only tagged steps need a slot, taken by TagStep.
+  const uint64 now_us = EnvTime::NowMicros();
+  StepSlot* slot = FindSlot(step_id, has_timeout, now_us);
+  if (slot == nullptr) return Status::OK();
+
+  const uint64 start_us = slot->start_us.load(std::memory_order_relaxed);
+  const bool cancelled = slot->cancelled.load(std::memory_order_relaxed);
+  // Written rarely, to keep the slot's cache line shared between kernels.
+  if (now_us > slot->last_use_us.load(std::memory_order_relaxed) +
+                   kIdleMicros / 16) {
+    slot->last_use_us.store(now_us, std::memory_order_relaxed);
+  }
+  // The slot may have been taken by another step meanwhile.
+  if (ITEX_PREDICT_FALSE(slot->step_id.load(std::memory_order_acquire) !=
+                         step_id)) {
+    return Status::OK();
+  }
+
+  if (ITEX_PREDICT_FALSE(cancelled)) {
+    return errors::Cancelled("Step ", step_id, " was cancelled.");
+  }
+  if (has_timeout && now_us > start_us + static_cast<uint64>(timeout_us_)) {
+    return errors::DeadlineExceeded("Step ", step_id, " exceeded ",
+                                    timeout_us_ / 1000,
+                                    " ms set by ITEX_STEP_TIMEOUT_MS.");
+  }
+  return Status::OK();
+}
+
+}  // namespace itex
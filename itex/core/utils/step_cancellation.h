@@ -0,0 +1,103 @@
+/* Copyright (c) 2022 Intel Corporation
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef ITEX_CORE_UTILS_STEP_CANCELLATION_H_
+#define ITEX_CORE_UTILS_STEP_CANCELLATION_H_
+
+#include <atomic>
+#include <unordered_set>
+
+#include "itex/core/utils/mutex.h"
+#include "itex/core/utils/status.h"
+#include "itex/core/utils/types.h"
+
+namespace itex {
+
+// Cancellation state of steps seen by ITEX kernels. The cancellation manager
+// of a step is not visible through TF C API, so ITEX keeps its own state and
+// checks it before each kernel runs. Once a step is cancelled or exceeds
+// `ITEX_STEP_TIMEOUT_MS`, its remaining kernels fail fast instead of burning
+// cores for a result nobody waits for. A running oneDNN primitive can't be
+// interrupted, so the granularity is one kernel.
+//
+// TF step ids are not visible to users either. A caller gets a tag from
+// `NewTag`, and runs an `ItexStepTag` op fed with it in its steps, which
+// binds the step to the tag. `CancelTag` then cancels the steps of that tag
+// only.
+//
+// Kernels of many steps run concurrently, so steps are kept in a fixed-size
+// open-addressing table of atomics keyed by the full step id, instead of a
+// map behind a mutex. A slot is only reused once its step has run no kernel
+// for `kIdleMicros` and is past its deadline. A step which finds no slot is
+// unknown: its kernels run without timeout and it can't be cancelled.
+class StepCancellation {
+ public:
+  static StepCancellation* Global();
+
+  // Returns a new tag, unique in the process.
+  int64 NewTag();
+
+  // Binds `step_id` to `tag`. Returns Cancelled if `tag` is cancelled.
+  Status TagStep(int64 step_id, int64 tag);
+
+  // Kernels of the steps bound to `tag`, now or later, which haven't started
+  // will fail with Cancelled.
+  void CancelTag(int64 tag) TF_LOCKS_EXCLUDED(mu_);
+
+  // Forgets `tag` once its steps are done.
+  void ReleaseTag(int64 tag) TF_LOCKS_EXCLUDED(mu_);
+
+  // Returns Cancelled or DeadlineExceeded if kernels of `step_id` shouldn't
+  // run anymore. The first call for a step records its start time.
+  Status CheckStep(int64 step_id);
+
+ private:
+  StepCancellation();
+
+  static constexpr int64 kNumSlots = 16384;
+  static constexpr int64 kMaxProbes = 32;
+  static constexpr int64 kNoStep = -1;
+  // Set while a slot is being filled for a new step.
+  static constexpr int64 kClaimingStep = -2;
+  static constexpr int64 kNoTag = 0;
+  static constexpr uint64 kIdleMicros = 10 * 1000 * 1000;
+
+  struct StepSlot {
+    std::atomic<int64> step_id{kNoStep};
+    std::atomic<uint64> start_us{0};
+    std::atomic<uint64> last_use_us{0};
+    std::atomic<int64> tag{kNoTag};
+    std::atomic<bool> cancelled{false};
+  };
+
+  // Returns the slot of `step_id`, or null if it has none. If `create`, a
+  // slot is taken for a new step, null if none is free.
+  StepSlot* FindSlot(int64 step_id, bool create, uint64 now_us);
+  bool IsTagCancelled(int64 tag) TF_LOCKS_EXCLUDED(mu_);
+
+  const int64 timeout_us_;
+  std::atomic<int64> next_tag_{kNoTag + 1};
+  // Whether a step was ever tagged. Without timeout, untagged steps don't
+  // need a slot.
+  std::atomic<bool> has_tags_{false};
+  StepSlot steps_[kNumSlots];
+
+  mutex mu_;
+  std::unordered_set<int64> cancelled_tags_ TF_GUARDED_BY(mu_);
+};
+
+}  // namespace itex
+
+#endif  // ITEX_CORE_UTILS_STEP_CANCELLATION_H_
@@ -0,0 +1,220 @@
+# Copyright (c) 2022 Intel Corporation
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+
+"""Tune Advanced AMP lists by profiling accuracy and speed of op types."""
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+import collections
+import time
+
+import numpy as np
+import tensorflow as tf
+
+from google.protobuf import text_format
+from intel_extension_for_tensorflow.core.utils.protobuf import config_pb2
+from intel_extension_for_tensorflow.python.device import get_backend
+from intel_extension_for_tensorflow.python.device import get_config
+from intel_extension_for_tensorflow.python.device import set_backend
+
+_LISTS = ("allowlist", "inferlist", "clearlist", "denylist")
+
+# Op types which never compute on floating-point data by themselves.
+_SKIPPED_OPS = frozenset({
+    "Placeholder", "Const", "Identity", "IdentityN", "NoOp",
+    "ReadVariableOp", "VarHandleOp", "VariableV2", "_Arg", "_Retval",
+    "Shape", "ShapeN", "Size", "Rank", "StopGradient", "Cast",
+})
+
+AmpOpProfile = collections.namedtuple(
+    "AmpOpProfile", ["op_type", "relative_error", "speedup"])
+
+
+def _float_op_types(concrete_fn):
+  """Returns op types of `concrete_fn` which produce float32 tensors."""
+  op_types = set()
+  for op in concrete_fn.graph.get_operations():
+    if op.type in _SKIPPED_OPS:
+      continue
+    if any(out.dtype == tf.float32 for out in op.outputs):
+      op_types.add(op.type)
+  return sorted(op_types)
+
+
+def _amp_options(data_type, lists):
+  """Builds options which move each op type to the given list.
+
+  `lists` maps list name to op types. An op type is removed from all the
+  other lists so that it only lands in the requested one.
+  """
+  options = config_pb2.AutoMixedPrecisionOptions()
+  options.data_type = data_type
+  for name in _LISTS:
+    added = sorted(lists.get(name, ()))
+    removed = sorted(op_type for other in _LISTS if other != name
+                     for op_type in lists.get(other, ()))
+    if added:
+      setattr(options, name + "_add", ",".join(added))
+    if removed:
+      setattr(options, name + "_remove", ",".join(removed))
+  return options
+
+
+def _config(options):
+  graph_options = config_pb2.GraphOptions()
+  if options is None:
+    graph_options.auto_mixed_precision = config_pb2.OFF
+  else:
+    graph_options.auto_mixed_precision = config_pb2.ON
+    graph_options.auto_mixed_precision_options.CopyFrom(options)
+  return config_pb2.ConfigProto(graph_options=graph_options)
+
+
+def _sync(outputs):
+  """Waits for `outputs`, which may still be computed asynchronously."""
+  for t in tf.nest.flatten(outputs):
+    t.numpy()
+
+
+def _run(model_fn, inputs, backend, options, warmup, iterations):
+  """Returns outputs and average latency of `model_fn` under `options`.
+
+  The config of `backend` is restored afterwards.
+  """
+  previous_config = get_config()
+  set_backend(backend, _config(options))
+  try:
+    # A new tf.function is traced and optimized with the config just set.
+    fn = tf.function(model_fn)
+    outputs = ()
+    for _ in range(warmup):
+      outputs = fn(*inputs)
+    _sync(outputs)
+    start = time.perf_counter()
+    for _ in range(iterations):
+      outputs = fn(*inputs)
+    _sync(outputs)
+    latency = (time.perf_counter() - start) / iterations
+  finally:
+    set_backend(backend, previous_config)
+  outputs = tf.nest.map_structure(
+      lambda t: np.asarray(tf.cast(t, tf.float32)), outputs)
+  return tf.nest.flatten(outputs), latency
+
+
+def _relative_error(outputs, references):
+  """Max relative L2 error of float outputs against fp32 references."""
+  error = 0.0
+  for out, ref in zip(outputs, references):
+    if not np.issubdtype(ref.dtype, np.floating):
+      continue
+    norm = np.linalg.norm(ref)
+    diff = np.linalg.norm(out.astype(np.float64) - ref)
+    error = max(error, diff / norm if norm > 0 else diff)
+  return float(error)
+
+
+def profile_amp_lists(model_fn, inputs, error_budget=1e-2,
+                      data_type=config_pb2.BFLOAT16, op_types=None,
+                      backend=None, warmup=3, iterations=10):
+  """Recommends Advanced AMP lists for `model_fn` under an error budget.
+
+  Each op type is first profiled alone in low precision, with the other op
+  types kept in fp32, to get its relative error against the fp32 outputs of
+  the calibration batch and its speedup. Then op types are greedily moved to
+  ALLOWLIST in order of speedup as long as the error of the whole model stays
+  within `error_budget`. An op type which breaks the budget is tried in
+  INFERLIST, and goes to DENYLIST if that still breaks it. Op types without
+  speedup go to CLEARLIST so that they follow their neighbors without extra
+  Cast. The recommendation is left active on `backend` when it returns.
+
+  Args:
+    model_fn: Python callable which takes `inputs` and returns tensors.
+    inputs: list of tensors, the calibration batch.
+    error_budget: max relative L2 error of outputs against fp32.
+    data_type: `itex.BFLOAT16` or `itex.FLOAT16`.
+    op_types: op types to tune, default is all the float op types of the
+      model.
+    backend: backend to profile on, default is the current backend.
+    warmup: runs before timing each configuration.
+    iterations: timed runs of each configuration.
+
+  Returns:
+    A tuple of the recommended `itex.AutoMixedPrecisionOptions` and a list of
+    `AmpOpProfile` of each op type.
+  """
+  if backend is None:
+    backend = get_backend()
+    backend = backend.decode() if isinstance(backend, bytes) else backend
+  inputs = list(inputs)
+  if op_types is None:
+    op_types = _float_op_types(
+        tf.function(model_fn).get_concrete_function(*inputs))
+
+  references, fp32_latency = _run(model_fn, inputs, backend, None, warmup,
+                                  iterations)
+
+  profiles = []
+  for op_type in op_types:
+    others = [t for t in op_types if t != op_type]
+    options = _amp_options(data_type, {"allowlist": [op_type],
+                                       "denylist": others})
+    outputs, latency = _run(model_fn, inputs, backend, options, warmup,
+                            iterations)
+    profiles.append(AmpOpProfile(op_type, _relative_error(outputs, references),
+                                 fp32_latency / max(latency, 1e-12)))
+    tf.compat.v1.logging.info("AMP profile %s: relative error %.3e, "
+                              "speedup %.3f", *profiles[-1])
+
+  lists = {name: [] for name in _LISTS}
+  pending = {p.op_type for p in profiles}
+  for profile in sorted(profiles, key=lambda p: -p.speedup):
+    pending.discard(profile.op_type)
+    candidates = ("allowlist", "inferlist")
+    if profile.speedup <= 1.0:
+      candidates = ("clearlist",)
+    placed = False
+    if profile.relative_error <= error_budget:
+      for name in candidates:
+        trial = {k: list(v) for k, v in lists.items()}
+        trial[name].append(profile.op_type)
+        trial["denylist"].extend(pending)
+        outputs, _ = _run(model_fn, inputs, backend,
+                          _amp_options(data_type, trial), warmup, 1)
+        if _relative_error(outputs, references) <= error_budget:
+          lists[name].append(profile.op_type)
+          placed = True
+          break
+    if not placed:
+      lists["denylist"].append(profile.op_type)
+
+  recommended = _amp_options(data_type, lists)
+  set_backend(backend, _config(recommended))
+  return recommended, profiles
+
+
+def save_amp_config(options, path):
+  """Writes `options` as a text format `itex.ConfigProto` file."""
+  with open(path, "w") as f:
+    f.write(text_format.MessageToString(_config(options)))
+
+
+def load_amp_config(path):
+  """Loads a file written by `save_amp_config` for `itex.set_backend`."""
+  config = config_pb2.ConfigProto()
+  with open(path) as f:
+    text_format.Parse(f.read(), config)
+  return config
@@ -18,6 +18,14 @@ import tensorflow  # pylint: disable=unused-import
 import intel_extension_for_tensorflow_lib  # pylint: disable=unused-import
 from intel_extension_for_tensorflow.python.device import set_backend  # pylint: disable=unused-import
 from intel_extension_for_tensorflow.python.device import get_backend  # pylint: disable=unused-import
+from intel_extension_for_tensorflow.python.device import get_cache_stats  # pylint: disable=unused-import
+from intel_extension_for_tensorflow.python.device import get_calibration_ranges  # pylint: disable=unused-import
+from intel_extension_for_tensorflow.python.device import set_calibration_ranges  # pylint: disable=unused-import
+from intel_extension_for_tensorflow.python.device import cancellable_step  # pylint: disable=unused-import
+from intel_extension_for_tensorflow.python.device import StepHandle  # pylint: disable=unused-import
+from intel_extension_for_tensorflow.python.amp_tune import profile_amp_lists  # pylint: disable=unused-import
+from intel_extension_for_tensorflow.python.amp_tune import save_amp_config  # pylint: disable=unused-import
+from intel_extension_for_tensorflow.python.amp_tune import load_amp_config  # pylint: disable=unused-import
 from intel_extension_for_tensorflow.python import ops  # pylint: disable=unused-import,line-too-long
 from intel_extension_for_tensorflow.python.version import __version__  # pylint: disable=unused-import
 from intel_extension_for_tensorflow.python import version  # pylint: disable=unused-import
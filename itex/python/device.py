@@ -18,6 +18,8 @@ from __future__ import absolute_import
 from __future__ import division
 from __future__ import print_function
 
+import contextlib
+
 from intel_extension_for_tensorflow.python._pywrap_itex import *
 from intel_extension_for_tensorflow.core.utils.protobuf import config_pb2
 
@@ -41,3 +43,102 @@ def set_backend(backend, config=None):
 
 def get_backend():
   return ITEX_GetBackend()
+
+
+def get_config():
+  """Returns the config last set by `set_backend`."""
+  config = config_pb2.ConfigProto()
+  config.ParseFromString(ITEX_GetConfig())
+  return config
+
+
+def get_cache_stats():
+  """Returns memory held by kernel caches, such as reordered weights.
+
+  The dict has `budget_bytes` set by `ITEX_CACHE_BUDGET_MB` (0 means no
+  budget), `total_bytes`, `num_entries`, `num_evictions`, and bytes by cache
+  category in `category_bytes`, entries by category in `category_entries`
+  and bytes by node in `node_bytes`.
+  """
+  return ITEX_GetCacheStats()
+
+
+def get_calibration_ranges():
+  """Returns activation ranges recorded by INT8 calibration.
+
+  With `ITEX_INT8_CALIBRATION=COLLECT`, running the graph records the range
+  of the input of each calibrated Conv2D/MatMul and the output of Conv2D. The
+  dict maps "<graph>/<node name>:input" or "<graph>/<node name>:output" to a
+  (min, max) tuple, where <graph> is a fingerprint of the names and weights
+  of the calibrated nodes of the graph.
+  """
+  return ITEX_GetCalibrationRanges()
+
+
+def set_calibration_ranges(ranges):
+  """Replaces the activation ranges used by INT8 calibration.
+
+  `ranges` is a dict as returned by `get_calibration_ranges`, e.g. saved by a
+  previous process, to run with `ITEX_INT8_CALIBRATION=QUANTIZE` without
+  collecting again.
+  """
+  ITEX_SetCalibrationRanges(
+      {key: (float(r[0]), float(r[1])) for key, r in ranges.items()})
+
+
+class StepHandle(object):
+  """Handle to cancel the steps tagged with it by `itex.ops.tag_step`.
+
+  Use `cancellable_step` to get one.
+  """
+
+  def __init__(self):
+    self._tag = ITEX_NewStepTag()
+    self._released = False
+
+  @property
+  def tag(self):
+    """The int64 tag to feed to `itex.ops.tag_step`."""
+    return self._tag
+
+  def cancel(self):
+    """Cancels the steps tagged with this handle, including later ones.
+
+    Their ITEX kernels which haven't started fail with
+    `tf.errors.CancelledError`. A kernel which is already running is not
+    interrupted. Other steps are not affected. Does nothing once the
+    handle is released.
+    """
+    if not self._released:
+      ITEX_CancelStepTag(self._tag)
+
+  def _release(self):
+    self._released = True
+    ITEX_ReleaseStepTag(self._tag)
+
+
+@contextlib.contextmanager
+def cancellable_step():
+  """Returns a `StepHandle` for the steps run in the context.
+
+  TF step ids are not visible to Python, so a step is bound to the handle by
+  an `itex.ops.tag_step` op fed with `handle.tag`. The handle can be
+  cancelled from another thread, e.g. when the client of a request goes
+  away:
+
+    @tf.function
+    def serve(x, tag):
+      return model(itex.ops.tag_step(x, tag))
+
+    with itex.cancellable_step() as step:
+      pending[request_id] = step
+      y = serve(x, tf.constant(step.tag, tf.int64))
+
+  With `tf.compat.v1.Session`, feed `step.tag` to a placeholder instead.
+  The handle is released at the end of the context.
+  """
+  handle = StepHandle()
+  try:
+    yield handle
+  finally:
+    handle._release()  # pylint: disable=protected-access
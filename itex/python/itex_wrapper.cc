@@ -14,10 +14,17 @@ limitations under the License.
 ==============================================================================*/
 
 #include <iostream>
+#include <map>
+#include <string>
+#include <utility>
 
 #include "Python.h"
 #include "itex/core/devices/xpu_device_util.h"
+#include "itex/core/utils/cache_governor.h"
+#include "itex/core/utils/calibration_stats.h"
+#include "itex/core/utils/step_cancellation.h"
 #include "pybind11/pybind11.h"
+#include "pybind11/stl.h"
 
 namespace py = pybind11;
 
@@ -32,6 +39,36 @@ static py::object ITEX_GetBackend() {
   return py::reinterpret_steal<py::object>(result);
 }
 
+static py::dict ITEX_GetCacheStats() {
+  CacheGovernor::Stats stats = CacheGovernor::Global()->GetStats();
+  py::dict result;
+  result["budget_bytes"] = stats.budget_bytes;
+  result["total_bytes"] = stats.total_bytes;
+  result["num_entries"] = stats.num_entries;
+  result["num_evictions"] = stats.num_evictions;
+  result["category_bytes"] = stats.category_bytes;
+  result["category_entries"] = stats.category_entries;
+  result["node_bytes"] = stats.node_bytes;
+  return result;
+}
+
+static py::dict ITEX_GetCalibrationRanges() {
+  py::dict result;
+  for (const auto& it : CalibrationStats::Global()->GetAll()) {
+    result[py::str(it.first)] = py::make_tuple(it.second.min, it.second.max);
+  }
+  return result;
+}
+
+static void ITEX_SetCalibrationRanges(
+    const std::map<std::string, std::pair<float, float>>& ranges) {
+  std::map<std::string, CalibrationStats::Range> stats;
+  for (const auto& it : ranges) {
+    stats[it.first] = {it.second.first, it.second.second};
+  }
+  CalibrationStats::Global()->SetAll(stats);
+}
+
 PYBIND11_MODULE(_pywrap_itex, m) {
   m.doc() = "pybind11 front-end api for Intel ® Extension for TensorFlow*";
   m.def("ITEX_SetBackend", [](const char* backend, py::bytes proto) {
@@ -46,6 +83,17 @@ PYBIND11_MODULE(_pywrap_itex, m) {
     itex_set_backend(backend, config);
   });
   m.def("ITEX_GetBackend", &itex::ITEX_GetBackend);
+  m.def("ITEX_GetConfig",
+        []() { return py::bytes(itex_get_config().SerializeAsString()); });
+  m.def("ITEX_GetCacheStats", &itex::ITEX_GetCacheStats);
+  m.def("ITEX_GetCalibrationRanges", &itex::ITEX_GetCalibrationRanges);
+  m.def("ITEX_SetCalibrationRanges", &itex::ITEX_SetCalibrationRanges);
+  m.def("ITEX_NewStepTag",
+        []() { return StepCancellation::Global()->NewTag(); });
+  m.def("ITEX_CancelStepTag",
+        [](int64_t tag) { StepCancellation::Global()->CancelTag(tag); });
+  m.def("ITEX_ReleaseStepTag",
+        [](int64_t tag) { StepCancellation::Global()->ReleaseTag(tag); });
 }
 
 }  // namespace itex
@@ -15,7 +15,12 @@
 
 # pylint: disable=g-bad-import-order,unused-import,missing-module-docstring,unused-import,line-too-long
 from intel_extension_for_tensorflow.python.ops.activations import gelu
+from intel_extension_for_tensorflow.python.ops.causal_conv1d import causal_conv1d
 from intel_extension_for_tensorflow.python.ops import ops_grad as _ops_grad
 from intel_extension_for_tensorflow.python.ops.optimizers import AdamWithWeightDecayOptimizer
 from intel_extension_for_tensorflow.python.ops.layer_norm import LayerNormalization
+from intel_extension_for_tensorflow.python.ops.packed_sequences import pack_sequences
+from intel_extension_for_tensorflow.python.ops.packed_sequences import unpack_sequences
+from intel_extension_for_tensorflow.python.ops.packed_sequences import varlen_attention
 from intel_extension_for_tensorflow.python.ops.recurrent import ItexLSTM
+from intel_extension_for_tensorflow.python.ops.step_tag import tag_step
@@ -0,0 +1,57 @@
+# Copyright (c) 2022 Intel Corporation
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Streaming causal 1-D convolution."""
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+from intel_extension_for_tensorflow.python.ops.load_ops_library import load_ops_library
+from tensorflow.python.framework import ops
+
+
+def causal_conv1d(inputs, filters, reset=False, dilation=1, name=None):
+  """Causal 1-D convolution over a stream of frames.
+
+  The op keeps the last `(kernel_size - 1) * dilation` input frames of the
+  previous call, so each call only convolves the new frames and returns one
+  output frame per input frame. Feeding a sequence chunk by chunk gives the
+  same result as convolving the whole sequence at once with causal padding.
+
+  >>> import intel_extension_for_tensorflow as itex
+  >>> filters = tf.ones([3, 1, 1])
+  >>> x = tf.constant([[[1.], [2.]]])
+  >>> itex.ops.causal_conv1d(x, filters, reset=True).numpy().ravel()
+  array([1., 3.], dtype=float32)
+  >>> itex.ops.causal_conv1d(x, filters).numpy().ravel()
+  array([4., 5.], dtype=float32)
+
+  Args:
+    inputs: A 3-D `Tensor` of shape `[batch, new_frames, in_channels]`.
+    filters: A 3-D `Tensor` of shape `[kernel_size, in_channels,
+      out_channels]`.
+    reset: A scalar bool, whether to drop the kept frames before this call,
+      e.g. at the start of a new stream.
+    dilation: An int, the dilation rate of the convolution.
+    name: A name for the operation (optional).
+
+  Returns:
+    A `Tensor` of shape `[batch, new_frames, out_channels]`.
+  """
+  with ops.name_scope(name, "CausalConv1D", [inputs, filters, reset]):
+    inputs = ops.convert_to_tensor(inputs, name="inputs")
+    filters = ops.convert_to_tensor(filters, name="filters")
+    reset = ops.convert_to_tensor(reset, name="reset")
+    return load_ops_library.itex_causal_conv1d(
+        inputs, filters, reset, dilation=dilation)
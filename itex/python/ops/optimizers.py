@@ -38,8 +38,14 @@ class AdamWithWeightDecayOptimizer(optimizer.Optimizer): # pylint: disable=missi
                epsilon=1e-8,
                use_locking=False,
                name="Adam",
-               exclude_from_weight_decay=["LayerNorm", "layer_norm", "bias"]):
+               exclude_from_weight_decay=["LayerNorm", "layer_norm", "bias"],
+               lazy_sparse_update=False):
     r"""Construct a new Adam optimizer with weight decay
+
+    With `lazy_sparse_update`, sparse gradients of resource variables only
+    update the moments and values of the rows they touch, in one CPU kernel
+    summing duplicate indices. Otherwise, all rows of the moments decay at
+    each step, as with a dense gradient.
     """
     super(AdamWithWeightDecayOptimizer, self).__init__(use_locking, name)
     self._lr = learning_rate
@@ -48,6 +54,7 @@ class AdamWithWeightDecayOptimizer(optimizer.Optimizer): # pylint: disable=missi
     self._epsilon = epsilon
     self.exclude_from_weight_decay = exclude_from_weight_decay
     self.weight_decay_rate = weight_decay_rate
+    self._lazy_sparse_update = lazy_sparse_update
 
     # Tensor versions of the constructor arguments, created in _prepare().
     self._lr_t = None
@@ -221,8 +228,29 @@ class AdamWithWeightDecayOptimizer(optimizer.Optimizer): # pylint: disable=missi
       return x.value()
 
   def _resource_apply_sparse(self, grad, var, indices): # pylint: disable=arguments-differ
-    return self._apply_sparse_shared(grad, var, indices,
-                                     self._resource_scatter_add)
+    if not self._lazy_sparse_update:
+      return self._apply_sparse_shared(grad, var, indices,
+                                       self._resource_scatter_add)
+    m = self.get_slot(var, "m")
+    v = self.get_slot(var, "v")
+    beta_1_power, beta_2_power = self._get_beta_accumulators()
+    param_name = self._get_variable_name(var.name)
+    weight_decay_rate = (self.weight_decay_rate
+                         if self._do_use_weight_decay(param_name) else 0.0)
+    return load_ops_library.resource_sparse_apply_adam_with_weight_decay(
+        var.handle,
+        m.handle,
+        v.handle,
+        math_ops.cast(beta_1_power, grad.dtype.base_dtype),
+        math_ops.cast(beta_2_power, grad.dtype.base_dtype),
+        math_ops.cast(self._lr_t, grad.dtype.base_dtype),
+        math_ops.cast(self._beta_1_t, grad.dtype.base_dtype),
+        math_ops.cast(self._beta_2_t, grad.dtype.base_dtype),
+        math_ops.cast(self._epsilon_t, grad.dtype.base_dtype),
+        math_ops.cast(weight_decay_rate, grad.dtype.base_dtype),
+        grad,
+        indices,
+        use_locking=self._use_locking)
 
   def _finish(self, update_ops, name_scope):
     # Update the power accumulators.
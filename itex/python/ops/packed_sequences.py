@@ -0,0 +1,110 @@
+# Copyright (c) 2022 Intel Corporation
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Packed variable-length sequences."""
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+from intel_extension_for_tensorflow.python.ops.load_ops_library import load_ops_library
+from tensorflow.python.framework import dtypes
+from tensorflow.python.framework import ops
+from tensorflow.python.ops import math_ops
+
+
+def pack_sequences(padded, lengths, name=None):
+  """Drops the padding of a batch of variable-length sequences.
+
+  The valid tokens of all the sequences are stored back to back, so that
+  token-wise layers such as `Dense`, `LayerNormalization` and activations run
+  on the packed tensor without computing on padding. Use `varlen_attention`
+  for attention and `unpack_sequences` to get the padded layout back.
+
+  >>> import intel_extension_for_tensorflow as itex
+  >>> x = tf.constant([[1., 2., 0.], [3., 0., 0.]])
+  >>> packed, cu_seqlens = itex.ops.pack_sequences(x, [2, 1])
+  >>> packed.numpy(), cu_seqlens.numpy()
+  (array([1., 2., 3.], dtype=float32), array([0, 2, 3], dtype=int32))
+
+  Args:
+    padded: A `Tensor` of shape `[batch, max_len, ...]`.
+    lengths: An int `Tensor` of shape `[batch]`, the valid length of each
+      sequence.
+    name: A name for the operation (optional).
+
+  Returns:
+    A tuple of the packed `Tensor` of shape `[total_tokens, ...]` and the
+    int32 cumulative lengths `cu_seqlens` of shape `[batch + 1]`.
+  """
+  with ops.name_scope(name, "PackSequences", [padded, lengths]):
+    padded = ops.convert_to_tensor(padded, name="padded")
+    lengths = math_ops.cast(lengths, dtypes.int32)
+    return load_ops_library.itex_pack_sequences(padded, lengths)
+
+
+def unpack_sequences(packed, cu_seqlens, max_seq_len, name=None):
+  """Scatters packed sequences back to a zero-padded batch.
+
+  Args:
+    packed: A `Tensor` of shape `[total_tokens, ...]`.
+    cu_seqlens: An int32 `Tensor` of shape `[batch + 1]` returned by
+      `pack_sequences`.
+    max_seq_len: A scalar int, the padded length of the output.
+    name: A name for the operation (optional).
+
+  Returns:
+    A `Tensor` of shape `[batch, max_seq_len, ...]`.
+  """
+  with ops.name_scope(name, "UnpackSequences",
+                      [packed, cu_seqlens, max_seq_len]):
+    packed = ops.convert_to_tensor(packed, name="packed")
+    cu_seqlens = ops.convert_to_tensor(cu_seqlens, dtype=dtypes.int32,
+                                       name="cu_seqlens")
+    max_seq_len = math_ops.cast(max_seq_len, dtypes.int32)
+    return load_ops_library.itex_unpack_sequences(packed, cu_seqlens,
+                                                  max_seq_len)
+
+
+def varlen_attention(query, key, value, cu_seqlens, scale=None, causal=False,
+                     name=None):
+  """Scaled dot-product attention over packed sequences.
+
+  Each token only attends to the tokens of its own sequence, which gives the
+  same result as masked attention on the padded batch without spending
+  compute on padding.
+
+  Args:
+    query: A `Tensor` of shape `[total_tokens, num_heads, head_size]`.
+    key: A `Tensor` of the same shape as `query`.
+    value: A `Tensor` of the same shape as `query`.
+    cu_seqlens: An int32 `Tensor` of shape `[batch + 1]` returned by
+      `pack_sequences`.
+    scale: A float multiplied to the scores, default is
+      `1 / sqrt(head_size)`.
+    causal: A bool, whether a token only attends to itself and the tokens
+      before it.
+    name: A name for the operation (optional).
+
+  Returns:
+    A `Tensor` of the same shape as `query`.
+  """
+  with ops.name_scope(name, "VarlenAttention",
+                      [query, key, value, cu_seqlens]):
+    query = ops.convert_to_tensor(query, name="query")
+    key = ops.convert_to_tensor(key, name="key")
+    value = ops.convert_to_tensor(value, name="value")
+    cu_seqlens = ops.convert_to_tensor(cu_seqlens, dtype=dtypes.int32,
+                                       name="cu_seqlens")
+    return load_ops_library.itex_varlen_attention(
+        query, key, value, cu_seqlens, scale=scale or 0.0, causal=causal)
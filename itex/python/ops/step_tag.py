@@ -0,0 +1,45 @@
+# Copyright (c) 2022 Intel Corporation
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Binding steps to a cancellation handle."""
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+
+from intel_extension_for_tensorflow.python.ops.load_ops_library import load_ops_library
+from tensorflow.python.framework import dtypes
+from tensorflow.python.framework import ops
+from tensorflow.python.ops import math_ops
+
+
+def tag_step(x, tag, name=None):
+  """Binds the running step to `tag` and returns `x`.
+
+  Once the `itex.StepHandle` of `tag` is cancelled, the ITEX kernels of the
+  step which haven't started fail with `tf.errors.CancelledError`. Tag an
+  input of the model so that the step is bound before most of its kernels
+  run, see `itex.cancellable_step`.
+
+  Args:
+    x: A `Tensor`, forwarded as is.
+    tag: A scalar int64 `Tensor`, `itex.StepHandle.tag`.
+    name: A name for the operation (optional).
+
+  Returns:
+    `x`.
+  """
+  with ops.name_scope(name, "StepTag", [x, tag]):
+    x = ops.convert_to_tensor(x, name="x")
+    tag = math_ops.cast(tag, dtypes.int64)
+    return load_ops_library.itex_step_tag(x, tag)
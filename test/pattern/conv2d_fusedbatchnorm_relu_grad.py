@@ -0,0 +1,90 @@
+# Copyright (c) 2022 Intel Corporation
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+
+
+import numpy as np
+import tensorflow as tf
+from tensorflow.python.framework import config
+from tensorflow.python.framework import test_util
+from tensorflow.python.platform import test
+from tensorflow.core.protobuf import config_pb2
+from tensorflow.python.ops import array_ops
+
+tf.compat.v1.disable_eager_execution()
+class FusedBatchNormGradConv2DTest(test_util.TensorFlowTestCase):
+    """test Conv2D + FusedBatchNorm + Relu backward fusion"""
+
+    def _run(self, strides, padding):
+        if test.is_gpu_available():
+            self.skipTest("The fusion is only done on CPU.")
+        config.set_optimizer_experimental_options({'constant_folding': False})
+        x_arr = np.random.normal(size=(2, 9, 9, 8)).astype(np.float32)
+        w_arr = np.random.normal(size=(3, 3, 8, 16)).astype(np.float32)
+        scale = np.random.normal(size=(16,)).astype(np.float32)
+        offset = np.random.normal(size=(16,)).astype(np.float32)
+        conv_strides = [1, strides, strides, 1]
+
+        # Fused graph.
+        x = tf.compat.v1.placeholder(tf.float32, shape=x_arr.shape)
+        w = tf.compat.v1.placeholder(tf.float32, shape=w_arr.shape)
+        conv = tf.nn.conv2d(x, w, strides=conv_strides, padding=padding)
+        bn, _, _ = tf.compat.v1.nn.fused_batch_norm(
+            conv, scale, offset, is_training=True)
+        y = tf.nn.relu(bn)
+        upstream = tf.compat.v1.placeholder(tf.float32, shape=y.shape)
+        grads = tf.gradients(y, [x, w], grad_ys=upstream)
+        fetches = [array_ops.identity(g) for g in grads]
+
+        run_options = config_pb2.RunOptions(output_partition_graphs=True)
+        metadata = config_pb2.RunMetadata()
+        with self.session(use_gpu=False) as sess:
+            conv_arr = sess.run(conv, feed_dict={x: x_arr, w: w_arr})
+            up_arr = np.random.normal(size=conv_arr.shape).astype(np.float32)
+            ret = sess.run(fetches,
+                           feed_dict={x: x_arr, w: w_arr, upstream: up_arr},
+                           options=run_options, run_metadata=metadata)
+            found_fused_op = False
+            for graph in metadata.partition_graphs:
+                for node in graph.node:
+                    if node.op == '_ITEXFusedBatchNormGradWithConv2DBackprop':
+                        found_fused_op = True
+            self.assertTrue(found_fused_op, "this pattern has fusion issue!!")
+
+        # Reference: batch norm and conv backward in separate graphs.
+        c = tf.compat.v1.placeholder(tf.float32, shape=conv_arr.shape)
+        bn_ref, _, _ = tf.compat.v1.nn.fused_batch_norm(
+            c, scale, offset, is_training=True)
+        dc = tf.gradients(tf.nn.relu(bn_ref), c, grad_ys=upstream)[0]
+        dy = tf.compat.v1.placeholder(tf.float32, shape=conv_arr.shape)
+        dx_ref = tf.compat.v1.nn.conv2d_backprop_input(
+            x_arr.shape, w, dy, strides=conv_strides, padding=padding)
+        dw_ref = tf.compat.v1.nn.conv2d_backprop_filter(
+            x, w_arr.shape, dy, strides=conv_strides, padding=padding)
+        with self.session(use_gpu=False) as sess:
+            dc_arr = sess.run(dc, feed_dict={c: conv_arr, upstream: up_arr})
+            expected = sess.run([dx_ref, dw_ref],
+                                feed_dict={x: x_arr, w: w_arr, dy: dc_arr})
+
+        self.assertAllClose(expected[0], ret[0], rtol=1e-3, atol=1e-3)
+        self.assertAllClose(expected[1], ret[1], rtol=1e-3, atol=1e-3)
+
+    def testStride1Same(self):
+        self._run(strides=1, padding='SAME')
+
+    def testStride2Valid(self):
+        self._run(strides=2, padding='VALID')
+
+if __name__ == '__main__':
+    test.main()
@@ -0,0 +1,99 @@
+# Copyright (c) 2022 Intel Corporation
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+import json
+import os
+import tempfile
+
+# Read once when ITEX is loaded.
+_LOG_PATH = os.path.join(tempfile.mkdtemp(), 'primitive_log.json')
+os.environ['ITEX_ONEDNN_PRIMITIVE_LOG'] = _LOG_PATH
+
+import numpy as np
+import tensorflow as tf
+from tensorflow.python.framework import test_util
+from tensorflow.python.platform import test
+from tensorflow.core.protobuf import config_pb2
+from tensorflow.python.ops import array_ops
+
+tf.compat.v1.disable_eager_execution()
+class Conv2DShareReorderedFilterTest(test_util.TensorFlowTestCase):
+    """test Conv2DBackpropInput reusing the filter reordered by Conv2D"""
+
+    def _run(self, strides, padding):
+        if test.is_gpu_available():
+            self.skipTest("The rewrite is only done on CPU.")
+        x_arr = np.random.normal(size=(2, 9, 9, 16)).astype(np.float32)
+        w_arr = np.random.normal(size=(3, 3, 16, 32)).astype(np.float32)
+        conv_strides = [1, strides, strides, 1]
+
+        x = tf.compat.v1.placeholder(tf.float32, shape=x_arr.shape)
+        w = tf.compat.v1.placeholder(tf.float32, shape=w_arr.shape)
+        conv = tf.nn.conv2d(x, w, strides=conv_strides, padding=padding)
+        upstream = tf.compat.v1.placeholder(tf.float32, shape=conv.shape)
+        dx = tf.gradients(conv, x, grad_ys=upstream)[0]
+        fetches = [array_ops.identity(conv), array_ops.identity(dx)]
+
+        up_arr = np.random.normal(
+            size=conv.shape.as_list()).astype(np.float32)
+        log_offset = (os.path.getsize(_LOG_PATH)
+                      if os.path.exists(_LOG_PATH) else 0)
+        run_options = config_pb2.RunOptions(output_partition_graphs=True)
+        metadata = config_pb2.RunMetadata()
+        with self.session(use_gpu=False) as sess:
+            ret = sess.run(fetches,
+                           feed_dict={x: x_arr, w: w_arr, upstream: up_arr},
+                           options=run_options, run_metadata=metadata)
+            ops = set()
+            for graph in metadata.partition_graphs:
+                for node in graph.node:
+                    ops.add(node.op)
+
+        # The pair is only rewritten if the backward kernel can use the
+        # filter layout of the forward kernel on this CPU, in which case it
+        # must run with that layout.
+        if '_ITEXConv2DBackpropInputWithReorderedFilter' in ops:
+            self.assertIn('_ITEXConv2DWithReorderedFilter', ops)
+            weights = {}
+            with open(_LOG_PATH) as log:
+                log.seek(log_offset)
+                for line in log:
+                    record = json.loads(line)
+                    weights.setdefault(record['op'], set()).add(
+                        record['mds'].get('weights'))
+            self.assertEqual(
+                weights['_ITEXConv2DWithReorderedFilter'],
+                weights['_ITEXConv2DBackpropInputWithReorderedFilter'])
+        else:
+            self.assertNotIn('_ITEXConv2DWithReorderedFilter', ops)
+
+        # Reference: forward and backward in separate graphs.
+        dy = tf.compat.v1.placeholder(tf.float32, shape=up_arr.shape)
+        dx_ref = tf.compat.v1.nn.conv2d_backprop_input(
+            x_arr.shape, w, dy, strides=conv_strides, padding=padding)
+        with self.session(use_gpu=False) as sess:
+            conv_arr = sess.run(conv, feed_dict={x: x_arr, w: w_arr})
+            dx_arr = sess.run(dx_ref, feed_dict={w: w_arr, dy: up_arr})
+
+        self.assertAllClose(conv_arr, ret[0], rtol=1e-3, atol=1e-3)
+        self.assertAllClose(dx_arr, ret[1], rtol=1e-3, atol=1e-3)
+
+    def testStride1Same(self):
+        self._run(strides=1, padding='SAME')
+
+    def testStride2Valid(self):
+        self._run(strides=2, padding='VALID')
+
+if __name__ == '__main__':
+    test.main()
@@ -0,0 +1,90 @@
+# Copyright (c) 2022 Intel Corporation
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+
+
+import tensorflow as tf
+from tensorflow.python.framework import dtypes
+from tensorflow.python.framework import constant_op
+from tensorflow.core.protobuf import config_pb2
+from tensorflow.python.ops import array_ops
+from intel_extension_for_tensorflow.python.ops.load_ops_library import load_ops_library
+from intel_extension_for_tensorflow.python.test_func import test_util
+from intel_extension_for_tensorflow.python.test_func import test
+try:
+    from intel_extension_for_tensorflow.python.test_func import test as test_lib
+except ImportError:
+    from tensorflow.python.platform import test as test_lib
+import numpy as np
+
+@test_util.run_all_in_graph_and_eager_modes
+class QuantizedLayerNormTest(test_lib.TestCase):
+  def _run(self, narrow_range):
+    x_np = np.random.uniform(-4, 4, size=(4, 32)).astype(np.float32)
+    scale_np = np.random.uniform(0.5, 1.5, size=(32,)).astype(np.float32)
+    offset_np = np.random.uniform(-0.5, 0.5, size=(32,)).astype(np.float32)
+    x = constant_op.constant(x_np, dtype=dtypes.float32)
+    x_int8, x_min, x_max = array_ops.quantize(
+      x, -4.0, 4.0, T=dtypes.qint8, mode="SCALED")
+    x_fp = array_ops.dequantize(x_int8, x_min, x_max, mode="SCALED")
+    norm, _, _ = load_ops_library.layer_norm(
+      x_fp, constant_op.constant(scale_np), constant_op.constant(offset_np),
+      epsilon=0.001, is_training=False)
+    y_int8, y_min, y_max = array_ops.quantize(
+      norm, -4.0, 4.0, T=dtypes.qint8, mode="SCALED",
+      narrow_range=narrow_range)
+    y = array_ops.dequantize(y_int8, y_min, y_max, mode="SCALED",
+                             narrow_range=narrow_range)
+    fused = array_ops.identity(y)
+
+    run_options = config_pb2.RunOptions(output_partition_graphs=True)
+    metadata = config_pb2.RunMetadata()
+
+    with self.session() as sess:
+      ret = sess.run(fused, options=run_options, run_metadata=metadata)
+
+    ops = set()
+    for graph in metadata.partition_graphs:
+      for node in graph.node:
+        ops.add(node.op)
+
+    # Reference: fp32 layer norm, one quantization step tolerance in total.
+    mean = np.mean(x_np, axis=-1, keepdims=True)
+    var = np.var(x_np, axis=-1, keepdims=True)
+    ret_ref = (x_np - mean) / np.sqrt(var + 0.001) * scale_np + offset_np
+    self.assertAllClose(ret_ref, ret, atol=2 * 8.0 / 255, rtol=0)
+    return ops
+
+  @test_util.run_deprecated_v1
+  def testFuseDequantizeLayerNormQuantize(self):
+    if test_lib.is_gpu_available():
+      self.skipTest("Skip on GPU due to the pattern not supported")
+    tf.compat.v1.disable_eager_execution()
+    ops = self._run(narrow_range=False)
+    self.assertIn('_ITEXQuantizedLayerNorm', ops)
+    self.assertNotIn('LayerNorm', ops)
+    self.assertNotIn('_ITEXLayerNorm', ops)
+
+  @test_util.run_deprecated_v1
+  def testNarrowRangeNotFused(self):
+    if test_lib.is_gpu_available():
+      self.skipTest("Skip on GPU due to the pattern not supported")
+    tf.compat.v1.disable_eager_execution()
+    # The fused kernel quantizes to the full range.
+    ops = self._run(narrow_range=True)
+    self.assertNotIn('_ITEXQuantizedLayerNorm', ops)
+
+
+if __name__ == '__main__':
+  test.main()
@@ -0,0 +1,59 @@
+import tensorflow as tf
+from tensorflow.python.framework import dtypes
+from tensorflow.python.framework import constant_op
+from tensorflow.python.ops import nn_ops
+from tensorflow.core.protobuf import config_pb2
+from tensorflow.python.ops import array_ops
+from intel_extension_for_tensorflow.python.test_func import test_util
+from intel_extension_for_tensorflow.python.test_func import test
+try:
+    from intel_extension_for_tensorflow.python.test_func import test as test_lib
+except ImportError:
+    from tensorflow.python.platform import test as test_lib
+import numpy as np
+
+
+@test_util.run_all_in_graph_and_eager_modes
+class QuantizedSoftmaxTest(test_lib.TestCase):
+  @test_util.run_deprecated_v1
+  def testFuseDequantizeSoftmaxQuantize(self):
+    if test_lib.is_gpu_available():
+      self.skipTest("Skip on GPU due to the pattern not supported")
+    tf.compat.v1.disable_eager_execution()
+    x_np = np.random.uniform(-4, 4, size=(4, 32)).astype(np.float32)
+    x = constant_op.constant(x_np, dtype=dtypes.float32)
+    x_int8, x_min, x_max = array_ops.quantize(
+      x, -4.0, 4.0, T=dtypes.qint8, mode="SCALED")
+    x_fp = array_ops.dequantize(x_int8, x_min, x_max, mode="SCALED")
+    softmax = nn_ops.softmax(x_fp)
+    y_int8, y_min, y_max = array_ops.quantize(
+      softmax, 0.0, 1.0, T=dtypes.quint8, mode="SCALED")
+    y = array_ops.dequantize(y_int8, y_min, y_max, mode="SCALED")
+    fused = array_ops.identity(y)
+
+    run_options = config_pb2.RunOptions(output_partition_graphs=True)
+    metadata = config_pb2.RunMetadata()
+
+    with self.session() as sess:
+      ret = sess.run(fused, options=run_options, run_metadata=metadata)
+
+      # Graph should contain fused op.
+      graph = metadata.partition_graphs[0]
+      found_fused_op = False
+      softmax_exist = False
+      for node in graph.node:
+        if node.op == '_ITEXQuantizedSoftmax':
+          found_fused_op = True
+        if node.op in ('Softmax', '_ITEXSoftmax'):
+          softmax_exist = True
+      self.assertTrue((found_fused_op and not softmax_exist),
+              "this pattern has fusion issue!!")
+
+    # Reference: fp32 softmax, one quantization step tolerance in total.
+    exp = np.exp(x_np - np.max(x_np, axis=-1, keepdims=True))
+    ret_ref = exp / np.sum(exp, axis=-1, keepdims=True)
+    self.assertAllClose(ret_ref, ret, atol=2.0 / 255, rtol=0)
+
+
+if __name__ == '__main__':
+  test.main()
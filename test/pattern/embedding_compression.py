@@ -0,0 +1,179 @@
+# Copyright (c) 2022 Intel Corporation
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+
+
+import os
+
+import numpy as np
+import tensorflow as tf
+from tensorflow.python.framework import constant_op
+from tensorflow.python.framework import test_util
+from tensorflow.python.platform import test
+from tensorflow.core.protobuf import config_pb2
+from tensorflow.python.ops import array_ops
+from tensorflow.python.ops import math_ops
+
+tf.compat.v1.disable_eager_execution()
+class EmbeddingCompressionTest(test_util.TensorFlowTestCase):
+    """test lookups of compressed bf16/int8 embedding tables"""
+
+    def _run(self, out, feed_dict, mode, tolerance=None):
+        run_options = config_pb2.RunOptions(output_partition_graphs=True)
+        metadata = config_pb2.RunMetadata()
+        os.environ['ITEX_EMBEDDING_COMPRESSION'] = mode
+        if tolerance is not None:
+            os.environ['ITEX_EMBEDDING_COMPRESSION_TOLERANCE'] = str(tolerance)
+        try:
+            with self.session(use_gpu=False) as sess:
+                ret = sess.run(out, feed_dict=feed_dict,
+                               options=run_options, run_metadata=metadata)
+        finally:
+            os.environ['ITEX_EMBEDDING_COMPRESSION'] = ''
+            os.environ.pop('ITEX_EMBEDDING_COMPRESSION_TOLERANCE', None)
+        ops = set()
+        for graph in metadata.partition_graphs:
+            for node in graph.node:
+                ops.add(node.op)
+        return ret, ops
+
+    def _testGather(self, mode):
+        if test.is_gpu_available():
+            self.skipTest("Embedding compression is only done on CPU.")
+        table_arr = np.random.normal(size=(100, 16)).astype(np.float32)
+        ids_arr = np.random.randint(0, 100, size=(4, 8)).astype(np.int32)
+        ids = tf.compat.v1.placeholder(tf.int32, shape=ids_arr.shape)
+        out = array_ops.identity(
+            array_ops.gather(constant_op.constant(table_arr), ids))
+
+        ret, ops = self._run(out, {ids: ids_arr}, mode)
+        self.assertIn('_ITEXCompressedGather', ops)
+        atol = 0.01 * np.max(np.abs(table_arr))
+        self.assertAllClose(table_arr[ids_arr], ret, rtol=0.0, atol=atol)
+
+    def testGatherBF16(self):
+        self._testGather('BF16')
+
+    def testGatherINT8(self):
+        self._testGather('INT8')
+
+    def _testSparseSegment(self, mode, reduction, combine):
+        if test.is_gpu_available():
+            self.skipTest("Embedding compression is only done on CPU.")
+        table_arr = np.random.normal(size=(100, 16)).astype(np.float32)
+        ids_arr = np.random.randint(0, 100, size=(10,)).astype(np.int64)
+        # Segment 2 is empty.
+        seg_arr = np.array([0, 0, 0, 1, 1, 3, 3, 3, 3, 4], dtype=np.int32)
+        ids = tf.compat.v1.placeholder(tf.int64, shape=ids_arr.shape)
+        seg = tf.compat.v1.placeholder(tf.int32, shape=seg_arr.shape)
+        out = array_ops.identity(
+            reduction(constant_op.constant(table_arr), ids, seg))
+
+        ret, ops = self._run(out, {ids: ids_arr, seg: seg_arr}, mode)
+        self.assertIn('_ITEXCompressedSparseSegmentReduction', ops)
+        expected = np.zeros((5, 16), dtype=np.float32)
+        for s in range(5):
+            rows = table_arr[ids_arr[seg_arr == s]]
+            if len(rows):
+                expected[s] = combine(rows)
+        atol = 0.05 * np.max(np.abs(table_arr))
+        self.assertAllClose(expected, ret, rtol=0.0, atol=atol)
+
+    def testSparseSegmentSumINT8(self):
+        self._testSparseSegment('INT8', math_ops.sparse_segment_sum,
+                                lambda rows: rows.sum(axis=0))
+
+    def testSparseSegmentMeanBF16(self):
+        self._testSparseSegment('BF16', math_ops.sparse_segment_mean,
+                                lambda rows: rows.mean(axis=0))
+
+    def testSparseSegmentSqrtNINT8(self):
+        self._testSparseSegment(
+            'INT8', math_ops.sparse_segment_sqrt_n,
+            lambda rows: rows.sum(axis=0) / np.sqrt(len(rows)))
+
+    def testAboveToleranceStaysFP32(self):
+        if test.is_gpu_available():
+            self.skipTest("Embedding compression is only done on CPU.")
+        table_arr = np.random.normal(size=(100, 16)).astype(np.float32)
+        ids_arr = np.random.randint(0, 100, size=(8,)).astype(np.int32)
+        ids = tf.compat.v1.placeholder(tf.int32, shape=ids_arr.shape)
+        out = array_ops.identity(
+            array_ops.gather(constant_op.constant(table_arr), ids))
+
+        ret, ops = self._run(out, {ids: ids_arr}, 'INT8', tolerance=0.0)
+        self.assertNotIn('_ITEXCompressedGather', ops)
+        self.assertAllEqual(table_arr[ids_arr], ret)
+
+    def testTableControlInputsAreKept(self):
+        if test.is_gpu_available():
+            self.skipTest("Embedding compression is only done on CPU.")
+        table_arr = np.random.normal(size=(100, 16)).astype(np.float32)
+        ids_arr = np.random.randint(0, 100, size=(8,)).astype(np.int32)
+        counter = tf.Variable(0)
+        ids = tf.compat.v1.placeholder(tf.int32, shape=ids_arr.shape)
+        # The table only runs after the increment.
+        with tf.control_dependencies([counter.assign_add(1)]):
+            table = constant_op.constant(table_arr)
+        out = array_ops.identity(array_ops.gather(table, ids))
+
+        run_options = config_pb2.RunOptions(output_partition_graphs=True)
+        metadata = config_pb2.RunMetadata()
+        os.environ['ITEX_EMBEDDING_COMPRESSION'] = 'INT8'
+        try:
+            with self.session(use_gpu=False) as sess:
+                sess.run(counter.initializer)
+                ret = sess.run(out, feed_dict={ids: ids_arr},
+                               options=run_options, run_metadata=metadata)
+                self.assertEqual(1, sess.run(counter))
+        finally:
+            os.environ['ITEX_EMBEDDING_COMPRESSION'] = ''
+        ops = {node.op for graph in metadata.partition_graphs
+               for node in graph.node}
+        self.assertIn('_ITEXCompressedGather', ops)
+        atol = 0.01 * np.max(np.abs(table_arr))
+        self.assertAllClose(table_arr[ids_arr], ret, rtol=0.0, atol=atol)
+
+    def testVariableTableSeesAssign(self):
+        if test.is_gpu_available():
+            self.skipTest("Embedding compression is only done on CPU.")
+        table_arr = np.random.normal(size=(100, 16)).astype(np.float32)
+        new_arr = np.random.normal(size=(100, 16)).astype(np.float32)
+        ids_arr = np.random.randint(0, 100, size=(8,)).astype(np.int32)
+        table = tf.Variable(table_arr)
+        ids = tf.compat.v1.placeholder(tf.int32, shape=ids_arr.shape)
+        out = array_ops.identity(array_ops.gather(table, ids))
+        assign = table.assign(new_arr)
+
+        run_options = config_pb2.RunOptions(output_partition_graphs=True)
+        metadata = config_pb2.RunMetadata()
+        os.environ['ITEX_EMBEDDING_COMPRESSION'] = 'INT8'
+        try:
+            with self.session(use_gpu=False) as sess:
+                sess.run(table.initializer)
+                ret = sess.run(out, feed_dict={ids: ids_arr},
+                               options=run_options, run_metadata=metadata)
+                self.assertAllEqual(table_arr[ids_arr], ret)
+                # The table is written in place, lookups must see it.
+                sess.run(assign)
+                ret = sess.run(out, feed_dict={ids: ids_arr})
+                self.assertAllEqual(new_arr[ids_arr], ret)
+        finally:
+            os.environ['ITEX_EMBEDDING_COMPRESSION'] = ''
+        for graph in metadata.partition_graphs:
+            for node in graph.node:
+                self.assertNotIn('Compress', node.op)
+
+if __name__ == '__main__':
+    test.main()
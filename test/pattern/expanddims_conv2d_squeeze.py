@@ -0,0 +1,74 @@
+import tensorflow as tf
+from tensorflow.python.framework import dtypes
+from tensorflow.python.framework import constant_op
+from tensorflow.python.ops import nn_ops
+from tensorflow.core.protobuf import config_pb2
+from tensorflow.python.ops import array_ops
+from intel_extension_for_tensorflow.python.test_func import test_util
+from intel_extension_for_tensorflow.python.test_func import test
+try:
+    from intel_extension_for_tensorflow.python.test_func import test as test_lib
+except ImportError:
+    from tensorflow.python.platform import test as test_lib
+import numpy as np
+
+
+@test_util.run_all_in_graph_and_eager_modes
+class Conv1DTest(test_lib.TestCase):
+  @test_util.run_deprecated_v1
+  def testLowerConv1D(self):
+    if test_lib.is_gpu_available():
+      self.skipTest("Skip on GPU due to the pattern not supported")
+    tf.compat.v1.disable_eager_execution()
+    x_np = np.random.uniform(-1, 1, size=(2, 50, 8)).astype(np.float32)
+    w_np = np.random.uniform(-1, 1, size=(5, 8, 16)).astype(np.float32)
+    # Feed input via placeholder, otherwise the conv is constant folded.
+    x = tf.compat.v1.placeholder(dtypes.float32, shape=x_np.shape)
+    w = constant_op.constant(w_np, dtype=dtypes.float32)
+
+    for padding in ("SAME", "VALID"):
+      for stride, dilation in ((1, 1), (2, 1), (1, 3)):
+        conv = nn_ops.conv1d(x, w, stride=stride, padding=padding,
+                             dilations=dilation)
+        fused = array_ops.identity(conv)
+
+        run_options = config_pb2.RunOptions(output_partition_graphs=True)
+        metadata = config_pb2.RunMetadata()
+
+        with self.session() as sess:
+          ret = sess.run(fused, feed_dict={x: x_np}, options=run_options,
+                         run_metadata=metadata)
+
+          # Graph should contain the 1-D conv instead of Conv2D.
+          graph = metadata.partition_graphs[0]
+          found_fused_op = False
+          conv2d_exist = False
+          for node in graph.node:
+            if node.op == '_ITEXConv1D':
+              found_fused_op = True
+            if node.op in ('Conv2D', '_ITEXConv2D'):
+              conv2d_exist = True
+          self.assertTrue((found_fused_op and not conv2d_exist),
+                  "this pattern has fusion issue!!")
+
+        # Reference: direct convolution in numpy.
+        k = w_np.shape[0]
+        eff_k = (k - 1) * dilation + 1
+        width = x_np.shape[1]
+        if padding == "SAME":
+          out_w = (width + stride - 1) // stride
+          pad = max((out_w - 1) * stride + eff_k - width, 0)
+          x_pad = np.pad(x_np, ((0, 0), (pad // 2, pad - pad // 2), (0, 0)))
+        else:
+          out_w = (width - eff_k) // stride + 1
+          x_pad = x_np
+        ret_ref = np.zeros((2, out_w, 16), dtype=np.float32)
+        for i in range(out_w):
+          for j in range(k):
+            ret_ref[:, i, :] += np.matmul(
+                x_pad[:, i * stride + j * dilation, :], w_np[j])
+        self.assertAllClose(ret_ref, ret, atol=1e-4, rtol=1e-4)
+
+
+if __name__ == '__main__':
+  test.main()
@@ -0,0 +1,163 @@
+# Copyright (c) 2022 Intel Corporation
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+
+
+import collections
+import os
+
+import intel_extension_for_tensorflow as itex
+import numpy as np
+import tensorflow as tf
+from tensorflow.python.framework import constant_op
+from tensorflow.python.framework import test_util
+from tensorflow.python.platform import test
+from tensorflow.core.protobuf import config_pb2
+from tensorflow.core.protobuf import rewriter_config_pb2
+from tensorflow.python.ops import array_ops
+
+tf.compat.v1.disable_eager_execution()
+class Int8CalibrationTest(test_util.TensorFlowTestCase):
+    """test collecting activation ranges and quantizing with them"""
+
+    def _run(self, fused, x, x_arr, mode, graph=None, config=None):
+        run_options = config_pb2.RunOptions(output_partition_graphs=True)
+        metadata = config_pb2.RunMetadata()
+        os.environ['ITEX_INT8_CALIBRATION'] = mode
+        try:
+            with self.session(graph=graph, config=config,
+                              use_gpu=False) as sess:
+                ret = sess.run(fused, feed_dict={x: x_arr},
+                               options=run_options, run_metadata=metadata)
+        finally:
+            os.environ['ITEX_INT8_CALIBRATION'] = ''
+        # Number of nodes by op.
+        ops = collections.Counter()
+        for graph in metadata.partition_graphs:
+            for node in graph.node:
+                ops[node.op] += 1
+        return ret, ops
+
+    def _calibrate(self, fused, x, x_arr, quantized_op):
+        itex.set_calibration_ranges({})
+        _, ops = self._run(fused, x, x_arr, 'COLLECT')
+        self.assertIn('_ITEXMinMaxCollector', ops)
+        self.assertTrue(itex.get_calibration_ranges())
+
+        ret, ops = self._run(fused, x, x_arr, 'QUANTIZE')
+        self.assertTrue(any(quantized_op in op for op in ops),
+                        "this pattern has quantization issue!!")
+        self.assertNotIn('_ITEXMinMaxCollector', ops)
+        return ret
+
+    def testMatMulBiasAddRelu(self):
+        if test.is_gpu_available():
+            self.skipTest("INT8 calibration is only done on CPU.")
+        x_arr = np.random.normal(size=(8, 32)).astype(np.float32)
+        w_arr = np.random.normal(size=(32, 16)).astype(np.float32)
+        b_arr = np.random.normal(size=(16,)).astype(np.float32)
+        x = tf.compat.v1.placeholder(tf.float32, shape=x_arr.shape)
+        fused = tf.nn.relu(tf.nn.bias_add(
+            tf.matmul(x, constant_op.constant(w_arr)), b_arr))
+        fused = array_ops.identity(fused)
+
+        ret = self._calibrate(fused, x, x_arr, 'QuantizedFusedMatMul')
+        expected = np.maximum(np.matmul(x_arr, w_arr) + b_arr, 0)
+        atol = 0.02 * np.max(np.abs(expected))
+        self.assertAllClose(expected, ret, rtol=0.0, atol=atol)
+
+    def _testConv2D(self, relu):
+        if test.is_gpu_available():
+            self.skipTest("INT8 calibration is only done on CPU.")
+        x_arr = np.random.uniform(size=(2, 8, 8, 4)).astype(np.float32)
+        w_arr = np.random.normal(size=(3, 3, 4, 8)).astype(np.float32)
+        b_arr = np.random.normal(size=(8,)).astype(np.float32)
+        x = tf.compat.v1.placeholder(tf.float32, shape=x_arr.shape)
+        conv = tf.nn.conv2d(x, constant_op.constant(w_arr),
+                            strides=[1, 1, 1, 1], padding='SAME')
+        fused = tf.nn.bias_add(conv, b_arr)
+        if relu:
+            fused = tf.nn.relu(fused)
+        fused = array_ops.identity(fused)
+
+        with self.session(use_gpu=False) as sess:
+            expected = sess.run(fused, feed_dict={x: x_arr})
+        ret = self._calibrate(fused, x, x_arr, 'QuantizedConv2D')
+        atol = 0.03 * np.max(np.abs(expected))
+        self.assertAllClose(expected, ret, rtol=0.0, atol=atol)
+
+    def testConv2DBiasAdd(self):
+        self._testConv2D(relu=False)
+
+    def testConv2DBiasAddRelu(self):
+        self._testConv2D(relu=True)
+
+    def testCollectOptimizedTwice(self):
+        if test.is_gpu_available():
+            self.skipTest("INT8 calibration is only done on CPU.")
+        x_arr = np.random.uniform(size=(2, 8, 8, 4)).astype(np.float32)
+        w_arr = np.random.normal(size=(3, 3, 4, 8)).astype(np.float32)
+        b_arr = np.random.normal(size=(8,)).astype(np.float32)
+        x = tf.compat.v1.placeholder(tf.float32, shape=x_arr.shape)
+        conv = tf.nn.conv2d(x, constant_op.constant(w_arr),
+                            strides=[1, 1, 1, 1], padding='SAME')
+        fused = array_ops.identity(tf.nn.relu(tf.nn.bias_add(conv, b_arr)))
+
+        # The graph optimizers, this one included, run twice on the graph.
+        config = config_pb2.ConfigProto()
+        config.graph_options.rewrite_options.meta_optimizer_iterations = (
+            rewriter_config_pb2.RewriterConfig.TWO)
+        itex.set_calibration_ranges({})
+        _, ops = self._run(fused, x, x_arr, 'COLLECT', config=config)
+        # One collector on the input and one on the output.
+        self.assertEqual(ops['_ITEXMinMaxCollector'], 2)
+        self.assertEqual(len(itex.get_calibration_ranges()), 2)
+
+    def testGraphsWithSameNodeNames(self):
+        if test.is_gpu_available():
+            self.skipTest("INT8 calibration is only done on CPU.")
+        itex.set_calibration_ranges({})
+        # Same node names, but inputs in very different ranges.
+        models = []
+        for scale in (1.0, 100.0):
+            x_arr = scale * np.random.normal(size=(8, 32)).astype(np.float32)
+            w_arr = np.random.normal(size=(32, 16)).astype(np.float32)
+            b_arr = np.random.normal(size=(16,)).astype(np.float32)
+            graph = tf.Graph()
+            with graph.as_default():
+                x = tf.compat.v1.placeholder(tf.float32, shape=x_arr.shape)
+                fused = array_ops.identity(tf.nn.relu(tf.nn.bias_add(
+                    tf.matmul(x, constant_op.constant(w_arr)), b_arr)))
+            expected = np.maximum(np.matmul(x_arr, w_arr) + b_arr, 0)
+            models.append((graph, x, x_arr, fused, expected))
+
+        keys = []
+        for graph, x, x_arr, fused, _ in models:
+            before = set(itex.get_calibration_ranges())
+            self._run(fused, x, x_arr, 'COLLECT', graph=graph)
+            keys.append(set(itex.get_calibration_ranges()) - before)
+        self.assertTrue(keys[0])
+        self.assertEqual(len(keys[0]), len(keys[1]))
+        strip_scope = lambda key: key.split('/', 1)[1]
+        self.assertEqual({strip_scope(k) for k in keys[0]},
+                         {strip_scope(k) for k in keys[1]})
+
+        for graph, x, x_arr, fused, expected in models:
+            ret, ops = self._run(fused, x, x_arr, 'QUANTIZE', graph=graph)
+            self.assertTrue(any('QuantizedFusedMatMul' in op for op in ops))
+            atol = 0.02 * np.max(np.abs(expected))
+            self.assertAllClose(expected, ret, rtol=0.0, atol=atol)
+
+if __name__ == '__main__':
+    test.main()
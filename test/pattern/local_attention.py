@@ -0,0 +1,95 @@
+import tensorflow as tf
+from tensorflow.python.framework import dtypes
+from tensorflow.python.framework import constant_op
+from tensorflow.python.ops import math_ops
+from tensorflow.python.ops import nn_ops
+from tensorflow.core.protobuf import config_pb2
+from tensorflow.python.ops import array_ops
+from intel_extension_for_tensorflow.python.test_func import test_util
+from intel_extension_for_tensorflow.python.test_func import test
+try:
+    from intel_extension_for_tensorflow.python.test_func import test as test_lib
+except ImportError:
+    from tensorflow.python.platform import test as test_lib
+import numpy as np
+
+
+@test_util.run_all_in_graph_and_eager_modes
+class LocalAttentionTest(test_lib.TestCase):
+  def _run(self, allowed):
+    """Runs masked dense attention, returns the output and the graph ops."""
+    tf.compat.v1.disable_eager_execution()
+    shape = (2, 2, allowed.shape[0], 16)
+    q_np = np.random.uniform(-1, 1, size=shape).astype(np.float32)
+    k_np = np.random.uniform(-1, 1, size=shape).astype(np.float32)
+    v_np = np.random.uniform(-1, 1, size=shape).astype(np.float32)
+    mask_np = np.where(allowed, 0, -1e9).astype(np.float32)
+    scale = 0.25
+
+    # Feed inputs via placeholder, otherwise the attention is constant folded.
+    q = tf.compat.v1.placeholder(dtypes.float32, shape=shape)
+    k = tf.compat.v1.placeholder(dtypes.float32, shape=shape)
+    v = tf.compat.v1.placeholder(dtypes.float32, shape=shape)
+    scores = math_ops.matmul(q, k, adjoint_b=True) * scale
+    probs = nn_ops.softmax(scores + constant_op.constant(mask_np))
+    fused = array_ops.identity(math_ops.matmul(probs, v))
+
+    run_options = config_pb2.RunOptions(output_partition_graphs=True)
+    metadata = config_pb2.RunMetadata()
+    with self.session() as sess:
+      ret = sess.run(fused, feed_dict={q: q_np, k: k_np, v: v_np},
+                     options=run_options, run_metadata=metadata)
+
+    ops = set()
+    for graph in metadata.partition_graphs:
+      for node in graph.node:
+        ops.add(node.op)
+
+    # Reference: dense masked attention in numpy.
+    s = np.matmul(q_np, np.swapaxes(k_np, -1, -2)) * scale + mask_np
+    p = np.exp(s - np.max(s, axis=-1, keepdims=True))
+    p /= np.sum(p, axis=-1, keepdims=True)
+    self.assertAllClose(np.matmul(p, v_np), ret, atol=1e-4, rtol=1e-4)
+    return ops
+
+  @test_util.run_deprecated_v1
+  def testSlidingWindowWithGlobalTokens(self):
+    if test_lib.is_gpu_available():
+      self.skipTest("Skip on GPU due to the pattern not supported")
+    seq_len, window = 64, 4
+    index = np.arange(seq_len)
+    allowed = np.abs(index[:, None] - index[None, :]) <= window
+    for g in (0, 37):
+      allowed[g, :] = True
+      allowed[:, g] = True
+
+    ops = self._run(allowed)
+    self.assertIn('_ITEXLocalAttention', ops,
+                  "this pattern has fusion issue!!")
+    self.assertNotIn('Softmax', ops)
+
+  @test_util.run_deprecated_v1
+  def testWideWindowNotFused(self):
+    if test_lib.is_gpu_available():
+      self.skipTest("Skip on GPU due to the pattern not supported")
+    # Each row attends to more than a quarter of the sequence.
+    seq_len, window = 64, 12
+    index = np.arange(seq_len)
+    allowed = np.abs(index[:, None] - index[None, :]) <= window
+
+    ops = self._run(allowed)
+    self.assertNotIn('_ITEXLocalAttention', ops)
+
+  @test_util.run_deprecated_v1
+  def testCausalMaskNotFused(self):
+    if test_lib.is_gpu_available():
+      self.skipTest("Skip on GPU due to the pattern not supported")
+    seq_len = 64
+    allowed = np.tril(np.ones((seq_len, seq_len), dtype=bool))
+
+    ops = self._run(allowed)
+    self.assertNotIn('_ITEXLocalAttention', ops)
+
+
+if __name__ == '__main__':
+  test.main()
@@ -0,0 +1,87 @@
+# Copyright (c) 2022 Intel Corporation
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+
+
+import numpy as np
+import tensorflow as tf
+from tensorflow import keras
+from tensorflow.python.framework import config
+from tensorflow.python.framework import test_util
+from tensorflow.python.platform import test
+from tensorflow.core.protobuf import config_pb2
+from tensorflow.python.ops import array_ops
+
+tf.compat.v1.disable_eager_execution()
+class FusedMatMulLayerNormTest(test_util.TensorFlowTestCase):
+    """test matmul + biasadd + add + layernorm fusion"""
+
+    def _expected(self, x, w, b, residual, gamma, beta, epsilon):
+        pre_norm = np.matmul(x, w) + b + residual
+        mean = np.mean(pre_norm, axis=-1, keepdims=True)
+        var = np.var(pre_norm, axis=-1, keepdims=True)
+        return pre_norm, (pre_norm - mean) / np.sqrt(var + epsilon) * gamma + beta
+
+    def _run(self, m, fetch_sum):
+        config.set_optimizer_experimental_options({'constant_folding': False})
+        k, n, epsilon = 32, 48, 1e-3
+        x_arr = np.random.normal(size=(m, k)).astype(np.float32)
+        w_arr = np.random.normal(size=(k, n)).astype(np.float32)
+        b_arr = np.random.normal(size=(n,)).astype(np.float32)
+        r_arr = np.random.normal(size=(m, n)).astype(np.float32)
+        gamma = np.random.normal(size=(n,)).astype(np.float32)
+        beta = np.random.normal(size=(n,)).astype(np.float32)
+
+        x = tf.compat.v1.placeholder(tf.float32, shape=(m, k))
+        residual = tf.compat.v1.placeholder(tf.float32, shape=(m, n))
+        pre_norm = tf.nn.bias_add(tf.matmul(x, w_arr), b_arr) + residual
+        norm = keras.layers.LayerNormalization(
+            axis=-1, epsilon=epsilon,
+            beta_initializer=keras.initializers.constant(beta),
+            gamma_initializer=keras.initializers.constant(gamma))
+        y = array_ops.identity(norm(pre_norm))
+        fetches = [y, array_ops.identity(pre_norm * 2.0)] if fetch_sum else [y]
+
+        run_options = config_pb2.RunOptions(output_partition_graphs=True)
+        metadata = config_pb2.RunMetadata()
+        with self.session(use_gpu=True) as sess:
+            sess.run(tf.compat.v1.global_variables_initializer())
+            ret = sess.run(fetches, feed_dict={x: x_arr, residual: r_arr},
+                           options=run_options, run_metadata=metadata)
+            found_fused_op = False
+            for graph in metadata.partition_graphs:
+                for node in graph.node:
+                    if node.op == '_ITEXFusedMatMulWithSumAndLayerNorm':
+                        found_fused_op = True
+            self.assertTrue(found_fused_op, "this pattern has fusion issue!!")
+
+        expected_sum, expected_y = self._expected(
+            x_arr, w_arr, b_arr, r_arr, gamma, beta, epsilon)
+        self.assertAllClose(expected_y, ret[0], rtol=1e-3, atol=1e-3)
+        if fetch_sum:
+            self.assertAllClose(expected_sum * 2.0, ret[1], rtol=1e-3,
+                                atol=1e-3)
+
+    def testMatMulBiasAddAddLayerNorm(self):
+        self._run(m=8, fetch_sum=False)
+
+    def testPreNormSumIsKept(self):
+        self._run(m=8, fetch_sum=True)
+
+    def testRowTilesWithTail(self):
+        # Enough rows for several row tiles and a tail tile on CPU.
+        self._run(m=6000, fetch_sum=False)
+
+if __name__ == '__main__':
+    test.main()
@@ -0,0 +1,87 @@
+# Copyright (c) 2022 Intel Corporation
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+
+
+import os
+
+import numpy as np
+import tensorflow as tf
+from tensorflow.python.framework import constant_op
+from tensorflow.python.framework import test_util
+from tensorflow.python.platform import test
+from tensorflow.core.protobuf import config_pb2
+from tensorflow.python.ops import array_ops
+from tensorflow.python.ops import nn_ops
+
+tf.compat.v1.disable_eager_execution()
+class DynamicInt8MatMulTest(test_util.TensorFlowTestCase):
+    """test fp32 MatMul rewritten to dynamic INT8 MatMul"""
+
+    def _run(self, x_arr, transpose_b, activation):
+        w_shape = (16, 32) if transpose_b else (32, 16)
+        w_arr = np.random.normal(size=w_shape).astype(np.float32)
+        b_arr = np.random.normal(size=(16,)).astype(np.float32)
+        x = tf.compat.v1.placeholder(tf.float32, shape=x_arr.shape)
+        w = constant_op.constant(w_arr)
+        fused = tf.nn.bias_add(tf.matmul(x, w, transpose_b=transpose_b), b_arr)
+        if activation is not None:
+            fused = activation(fused)
+        fused = array_ops.identity(fused)
+
+        run_options = config_pb2.RunOptions(output_partition_graphs=True)
+        metadata = config_pb2.RunMetadata()
+        os.environ['ITEX_DYNAMIC_INT8'] = '1'
+        try:
+            with self.session(use_gpu=False) as sess:
+                ret = sess.run(fused, feed_dict={x: x_arr},
+                               options=run_options, run_metadata=metadata)
+        finally:
+            os.environ['ITEX_DYNAMIC_INT8'] = '0'
+        found_fused_op = False
+        for graph in metadata.partition_graphs:
+            for node in graph.node:
+                if node.op == '_ITEXDynamicQuantizedMatMul':
+                    found_fused_op = True
+        self.assertTrue(found_fused_op, "this pattern has fusion issue!!")
+
+        expected = np.matmul(x_arr, w_arr.T if transpose_b else w_arr) + b_arr
+        if activation is not None:
+            with self.session(use_gpu=False) as sess:
+                expected = sess.run(activation(constant_op.constant(expected)))
+        # 8-bit quantization error of both inputs, relative to the range of
+        # the output.
+        atol = 0.02 * np.max(np.abs(expected))
+        self.assertAllClose(expected, ret, rtol=0.0, atol=atol)
+
+    def testSignedActivation(self):
+        if test.is_gpu_available():
+            self.skipTest("Dynamic INT8 is only done on CPU.")
+        x_arr = np.random.normal(size=(8, 32)).astype(np.float32)
+        self._run(x_arr, transpose_b=False, activation=None)
+
+    def testUnsignedActivationRelu(self):
+        if test.is_gpu_available():
+            self.skipTest("Dynamic INT8 is only done on CPU.")
+        x_arr = np.random.uniform(size=(8, 32)).astype(np.float32)
+        self._run(x_arr, transpose_b=False, activation=nn_ops.relu)
+
+    def testTransposeB(self):
+        if test.is_gpu_available():
+            self.skipTest("Dynamic INT8 is only done on CPU.")
+        x_arr = np.random.normal(size=(8, 32)).astype(np.float32)
+        self._run(x_arr, transpose_b=True, activation=nn_ops.tanh)
+
+if __name__ == '__main__':
+    test.main()
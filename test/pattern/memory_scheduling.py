@@ -0,0 +1,74 @@
+# Copyright (c) 2022 Intel Corporation
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+
+
+import os
+
+import numpy as np
+import tensorflow as tf
+from tensorflow.python.framework import constant_op
+from tensorflow.python.framework import test_util
+from tensorflow.python.platform import test
+from tensorflow.core.protobuf import config_pb2
+from tensorflow.python.ops import array_ops
+from tensorflow.python.ops import math_ops
+
+tf.compat.v1.disable_eager_execution()
+class MemorySchedulingTest(test_util.TensorFlowTestCase):
+    """test control dependencies added between independent branches"""
+
+    def _run(self, out, feed_dict, enable):
+        run_options = config_pb2.RunOptions(output_partition_graphs=True)
+        metadata = config_pb2.RunMetadata()
+        os.environ['ITEX_MEMORY_SCHEDULING'] = '1' if enable else '0'
+        try:
+            with self.session() as sess:
+                ret = sess.run(out, feed_dict=feed_dict,
+                               options=run_options, run_metadata=metadata)
+        finally:
+            os.environ.pop('ITEX_MEMORY_SCHEDULING', None)
+        controlled = set()
+        for graph in metadata.partition_graphs:
+            for node in graph.node:
+                if 'MatMul' in node.op and any(
+                        name.startswith('^') for name in node.input):
+                    controlled.add(node.name)
+        return ret, controlled
+
+    def testWideBranches(self):
+        x_arr = np.random.normal(size=(256, 256)).astype(np.float32)
+        w_arrs = [np.random.normal(size=(256, 256)).astype(np.float32)
+                  for _ in range(4)]
+        x = tf.compat.v1.placeholder(tf.float32, shape=x_arr.shape)
+        # Each branch makes a large intermediate and reduces it to a scalar.
+        # Run one by one, only one intermediate is alive at a time.
+        branches = [
+            math_ops.reduce_sum(
+                math_ops.matmul(x, constant_op.constant(w),
+                                name='matmul_%d' % i))
+            for i, w in enumerate(w_arrs)]
+        out = array_ops.identity(math_ops.add_n(branches))
+        expected = sum(np.sum(np.matmul(x_arr, w)) for w in w_arrs)
+
+        ret, controlled = self._run(out, {x: x_arr}, enable=False)
+        self.assertEmpty(controlled)
+        self.assertAllClose(expected, ret, rtol=1e-3, atol=1.0)
+
+        ret, controlled = self._run(out, {x: x_arr}, enable=True)
+        self.assertNotEmpty(controlled)
+        self.assertAllClose(expected, ret, rtol=1e-3, atol=1.0)
+
+if __name__ == '__main__':
+    test.main()
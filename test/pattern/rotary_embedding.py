@@ -0,0 +1,92 @@
+import tensorflow as tf
+from tensorflow.python.framework import dtypes
+from tensorflow.python.framework import constant_op
+from tensorflow.python.ops import array_ops
+from tensorflow.core.protobuf import config_pb2
+from intel_extension_for_tensorflow.python.test_func import test_util
+from intel_extension_for_tensorflow.python.test_func import test
+try:
+    from intel_extension_for_tensorflow.python.test_func import test as test_lib
+except ImportError:
+    from tensorflow.python.platform import test as test_lib
+import numpy as np
+
+
+def rotate_half_slice(x):
+  half = x.shape[-1] // 2
+  return array_ops.concat([-x[..., half:], x[..., :half]], axis=-1)
+
+
+def rotate_half_split(x):
+  x1, x2 = array_ops.split(x, 2, axis=-1)
+  return array_ops.concat([-x2, x1], axis=-1)
+
+
+def rotate_every_two(x):
+  rotated = array_ops.stack([-x[..., 1::2], x[..., ::2]], axis=-1)
+  return array_ops.reshape(rotated, array_ops.shape(x))
+
+
+@test_util.run_all_in_graph_and_eager_modes
+class RotaryEmbeddingTest(test_lib.TestCase):
+  def _testRotary(self, rotate, interleaved):
+    if test_lib.is_gpu_available():
+      self.skipTest("Skip on GPU due to the pattern not supported")
+    tf.compat.v1.disable_eager_execution()
+    batch, heads, seq_len, head_size = 2, 4, 8, 16
+    x_np = np.random.uniform(
+        -1, 1, size=(batch, heads, seq_len, head_size)).astype(np.float32)
+    inv_freq = 1.0 / (10000 ** (np.arange(0, head_size, 2) / head_size))
+    freqs = np.outer(np.arange(seq_len), inv_freq)
+    if interleaved:
+      emb = np.repeat(freqs, 2, axis=-1)
+    else:
+      emb = np.concatenate([freqs, freqs], axis=-1)
+    cos_np = np.cos(emb).astype(np.float32)
+    sin_np = np.sin(emb).astype(np.float32)
+
+    # Feed input via placeholder, otherwise the graph is constant folded.
+    x = tf.compat.v1.placeholder(dtypes.float32, shape=x_np.shape)
+    cos = constant_op.constant(cos_np)
+    sin = constant_op.constant(sin_np)
+    out = array_ops.identity(x * cos + rotate(x) * sin)
+
+    run_options = config_pb2.RunOptions(output_partition_graphs=True)
+    metadata = config_pb2.RunMetadata()
+    with self.session() as sess:
+      ret = sess.run(out, feed_dict={x: x_np}, options=run_options,
+                     run_metadata=metadata)
+
+    found_fused_op = False
+    for graph in metadata.partition_graphs:
+      for node in graph.node:
+        if node.op == '_ITEXRotaryEmbedding':
+          found_fused_op = True
+          self.assertEqual(node.attr['interleaved'].b, interleaved)
+    self.assertTrue(found_fused_op, "this pattern has fusion issue!!")
+
+    # Reference: rotation in numpy.
+    if interleaved:
+      rotated = np.stack([-x_np[..., 1::2], x_np[..., ::2]],
+                         axis=-1).reshape(x_np.shape)
+    else:
+      half = head_size // 2
+      rotated = np.concatenate([-x_np[..., half:], x_np[..., :half]], axis=-1)
+    self.assertAllClose(x_np * cos_np + rotated * sin_np, ret, atol=1e-5,
+                        rtol=1e-5)
+
+  @test_util.run_deprecated_v1
+  def testRotateHalfSlice(self):
+    self._testRotary(rotate_half_slice, interleaved=False)
+
+  @test_util.run_deprecated_v1
+  def testRotateHalfSplit(self):
+    self._testRotary(rotate_half_split, interleaved=False)
+
+  @test_util.run_deprecated_v1
+  def testRotateEveryTwo(self):
+    self._testRotary(rotate_every_two, interleaved=True)
+
+
+if __name__ == '__main__':
+  test.main()
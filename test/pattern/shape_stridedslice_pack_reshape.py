@@ -0,0 +1,83 @@
+import tensorflow as tf
+from tensorflow.python.framework import dtypes
+from tensorflow.core.protobuf import config_pb2
+from tensorflow.python.ops import array_ops
+from intel_extension_for_tensorflow.python.test_func import test_util
+from intel_extension_for_tensorflow.python.test_func import test
+try:
+    from intel_extension_for_tensorflow.python.test_func import test as test_lib
+except ImportError:
+    from tensorflow.python.platform import test as test_lib
+import numpy as np
+
+
+@test_util.run_all_in_graph_and_eager_modes
+class ShapeChainFoldingTest(test_lib.TestCase):
+  def _run_and_check(self, x, y, x_np):
+    run_options = config_pb2.RunOptions(output_partition_graphs=True)
+    metadata = config_pb2.RunMetadata()
+
+    with self.session() as sess:
+      ret = sess.run(y, feed_dict={x: x_np}, options=run_options,
+                     run_metadata=metadata)
+
+      # Target shape of Reshape should be folded into Const.
+      chain_exist = False
+      for graph in metadata.partition_graphs:
+        for node in graph.node:
+          if node.op in ('Pack', 'StridedSlice', 'Shape', '_OneDnnShape'):
+            chain_exist = True
+      self.assertFalse(chain_exist, "this pattern has fusion issue!!")
+    return ret
+
+  @test_util.run_deprecated_v1
+  def testFoldDynamicBatch(self):
+    tf.compat.v1.disable_eager_execution()
+    x_np = np.random.uniform(-1, 1, size=(3, 4, 6)).astype(np.float32)
+    x = tf.compat.v1.placeholder(dtypes.float32, shape=(None, 4, 6))
+    # Only batch dim is dynamic, it's folded into -1.
+    shape = array_ops.shape(x)
+    y = array_ops.identity(array_ops.reshape(x, [shape[0], 24]))
+
+    ret = self._run_and_check(x, y, x_np)
+    self.assertAllClose(np.reshape(x_np, (3, 24)), ret)
+
+  @test_util.run_deprecated_v1
+  def testFoldStaticShape(self):
+    tf.compat.v1.disable_eager_execution()
+    x_np = np.random.uniform(-1, 1, size=(3, 4, 6)).astype(np.float32)
+    x = tf.compat.v1.placeholder(dtypes.float32, shape=(None, 4, 6))
+    shape = array_ops.shape(x)
+    y = array_ops.identity(array_ops.reshape(x, [-1, shape[1], shape[2], 1]))
+
+    ret = self._run_and_check(x, y, x_np)
+    self.assertAllClose(np.reshape(x_np, (3, 4, 6, 1)), ret)
+
+  @test_util.run_deprecated_v1
+  def testFoldInWhileLoop(self):
+    tf.compat.v1.disable_eager_execution()
+    # A v1 while loop, whose body is in its own frame of the graph.
+    tf.compat.v1.disable_control_flow_v2()
+    x_np = np.random.uniform(-1, 1, size=(3, 4, 6)).astype(np.float32)
+    x = tf.compat.v1.placeholder(dtypes.float32, shape=(None, 4, 6))
+
+    # The folded shapes must run in the frame of the loop body.
+    def body(i, acc):
+      shape = array_ops.shape(acc)
+      flat = array_ops.reshape(acc, [shape[0], 24]) + 1.0
+      return i + 1, array_ops.reshape(flat, [-1, shape[1], shape[2]])
+
+    try:
+      _, y = tf.compat.v1.while_loop(lambda i, acc: i < 3, body,
+                                     [tf.constant(0), x])
+    finally:
+      tf.compat.v1.enable_control_flow_v2()
+    y = array_ops.identity(y)
+
+    with self.session() as sess:
+      ret = sess.run(y, feed_dict={x: x_np})
+    self.assertAllClose(x_np + 3.0, ret)
+
+
+if __name__ == '__main__':
+  test.main()
@@ -125,6 +125,35 @@ class AdamWeightDecayOptimizerTest(test_util.TensorFlowTestCase):
             self.skipTest("No GPU available")
         self.doTestBasic(do_sparse=True)
 
+    def testLazySparseAdamW(self):
+        if test.is_gpu_available():
+            self.skipTest("Lazy sparse update is only implemented on CPU")
+        var_np = np.arange(8, dtype=np.float32).reshape(4, 2)
+        # Row 0 appears twice, its gradients are summed.
+        indices_np = np.array([0, 2, 0], dtype=np.int32)
+        grads_np = np.array([[0.1, 0.2], [0.3, 0.4], [0.5, 0.6]], dtype=np.float32)
+        var = tf.Variable(var_np)
+        grads = tf.IndexedSlices(
+            tf.constant(grads_np), tf.constant(indices_np), tf.constant([4, 2])
+        )
+        opt = itex_AdamW(
+            weight_decay_rate=WEIGHT_DECAY, learning_rate=0.01, lazy_sparse_update=True
+        )
+
+        summed_np = np.zeros_like(var_np)
+        np.add.at(summed_np, indices_np, grads_np)
+        rows = np.unique(indices_np)
+        expected = var_np.copy()
+        slot_vars = {}
+        for _ in range(3):
+            opt.apply_gradients([(grads, var)])
+            expected[rows], slot_vars = adamw_update_numpy(
+                expected[rows], summed_np[rows], slot_vars, weight_decay=WEIGHT_DECAY,
+                learning_rate=0.01, beta_1=0.9, beta_2=0.999, epsilon=1e-8
+            )
+            # Rows without gradient are untouched.
+            self.assertAllCloseAccordingToType(var.numpy(), expected)
+
     def testExcludeWeightDecayAdamW(self):
         adamw_opt = itex_AdamW(
             weight_decay_rate=WEIGHT_DECAY, learning_rate=0.01, exclude_from_weight_decay=["var1"]
@@ -0,0 +1,76 @@
+# Copyright (c) 2022 Intel Corporation
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+
+
+import os
+import tempfile
+
+import intel_extension_for_tensorflow as itex
+import numpy as np
+import tensorflow as tf
+
+from intel_extension_for_tensorflow.python import amp_tune
+from intel_extension_for_tensorflow.python import device
+from intel_extension_for_tensorflow.python.test_func import test_util
+from intel_extension_for_tensorflow.python.test_func import test
+
+np.random.seed(1)
+
+
+class AmpTuneTest(test_util.TensorFlowTestCase):
+  """test AMP lists tuning python api"""
+
+  def testRecommendationWithinBudget(self):
+    x = tf.constant(np.random.normal(size=(4, 16)).astype(np.float32))
+    # Weight is created once, each tuning run traces the model again.
+    w = tf.constant(np.random.normal(size=(16, 8)).astype(np.float32))
+    model = lambda x: tf.math.exp(tf.nn.relu(tf.matmul(x, w)))
+    options, profiles = itex.profile_amp_lists(
+        model, [x], error_budget=1e-2, op_types=["MatMul", "Relu", "Exp"],
+        warmup=1, iterations=1)
+    self.assertEqual(sorted(p.op_type for p in profiles),
+                     ["Exp", "MatMul", "Relu"])
+
+    # Each op type lands in exactly one list.
+    added = []
+    for name in ("allowlist", "inferlist", "clearlist", "denylist"):
+      value = getattr(options, name + "_add")
+      added += value.split(",") if value else []
+    self.assertEqual(sorted(added), ["Exp", "MatMul", "Relu"])
+
+    path = os.path.join(tempfile.mkdtemp(), "amp_config.pbtxt")
+    itex.save_amp_config(options, path)
+    config = itex.load_amp_config(path)
+    self.assertEqual(config.graph_options.auto_mixed_precision, itex.ON)
+    self.assertEqual(config.graph_options.auto_mixed_precision_options,
+                     options)
+    itex.set_backend(itex.get_backend().decode(), config)
+
+  def testProfileRunRestoresConfig(self):
+    x = tf.constant(np.random.normal(size=(4, 16)).astype(np.float32))
+    backend = itex.get_backend()
+    backend = backend.decode() if isinstance(backend, bytes) else backend
+    before = device.get_config()
+    options = amp_tune._amp_options(itex.BFLOAT16, {"allowlist": ["MatMul"]})
+    model = lambda x: tf.matmul(x, x, transpose_b=True)
+    outputs, latency = amp_tune._run(model, [x], backend, options, warmup=1,
+                                     iterations=1)
+    self.assertEqual(len(outputs), 1)
+    self.assertGreater(latency, 0)
+    self.assertEqual(device.get_config(), before)
+
+
+if __name__ == "__main__":
+  test.main()
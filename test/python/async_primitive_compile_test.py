@@ -0,0 +1,54 @@
+# Copyright (c) 2022 Intel Corporation
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+
+
+import os
+
+# Both are read once by the plugin, set them before it's loaded.
+os.environ["ITEX_CACHE_ONEDNN_OBJECT"] = "1"
+os.environ["ITEX_ASYNC_PRIMITIVE_COMPILE"] = "1"
+
+import numpy as np
+import tensorflow as tf
+
+from intel_extension_for_tensorflow.python.test_func import test_util
+from intel_extension_for_tensorflow.python.test_func import test
+
+np.random.seed(1)
+
+
+class AsyncPrimitiveCompileTest(test_util.TensorFlowTestCase):
+  """test MatMul running new shapes while their primitives compile"""
+
+  def testShapeChanges(self):
+    if test.is_gpu_available():
+      self.skipTest("Async primitive compile is only on CPU.")
+    w_arr = np.random.normal(size=(64, 32)).astype(np.float32)
+    b_arr = np.random.normal(size=(32,)).astype(np.float32)
+    w = tf.constant(w_arr)
+    fn = tf.function(
+        lambda x: tf.nn.relu(tf.nn.bias_add(tf.matmul(x, w), b_arr)),
+        input_signature=[tf.TensorSpec([None, 64], tf.float32)])
+
+    # Revisit shapes, so both generic and compiled plans are run.
+    for rows in [4, 7, 128, 7, 33, 4, 128, 1]:
+      x_arr = np.random.normal(size=(rows, 64)).astype(np.float32)
+      expected = np.maximum(np.matmul(x_arr, w_arr) + b_arr, 0)
+      ret = fn(tf.constant(x_arr))
+      self.assertAllClose(expected, ret, rtol=1e-4, atol=1e-4)
+
+
+if __name__ == "__main__":
+  test.main()
@@ -0,0 +1,69 @@
+# Copyright (c) 2022 Intel Corporation
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+
+
+import os
+
+# Read once when ITEX is loaded.
+os.environ["ITEX_CACHE_BUDGET_MB"] = "2"
+
+import intel_extension_for_tensorflow as itex
+import numpy as np
+import tensorflow as tf
+
+from intel_extension_for_tensorflow.python.test_func import test_util
+from intel_extension_for_tensorflow.python.test_func import test
+
+np.random.seed(1)
+
+
+class CacheEvictionTest(test_util.TensorFlowTestCase):
+  """test eviction of kernel caches under a budget"""
+
+  def testEvictedWeightsAreRefilled(self):
+    # 1 MB weights, more than the budget all together.
+    w_arrs = [(np.random.normal(size=(512, 512)) / 512 ** 0.5).astype(
+        np.float32) for _ in range(6)]
+    x_arr = np.random.normal(size=(8, 512)).astype(np.float32)
+
+    def model(x):
+      for w_arr in w_arrs:
+        x = tf.nn.relu(tf.matmul(x, tf.constant(w_arr)))
+      return x
+
+    expected = x_arr
+    for w_arr in w_arrs:
+      expected = np.maximum(np.matmul(expected, w_arr), 0)
+
+    fn = tf.function(model)
+    self.assertAllClose(expected, fn(tf.constant(x_arr)), rtol=1e-4,
+                        atol=1e-4)
+    stats = itex.get_cache_stats()
+    self.assertEqual(stats["budget_bytes"], 2 * 1024 * 1024)
+    self.assertGreater(stats["num_evictions"], 0)
+    self.assertLessEqual(stats["total_bytes"], stats["budget_bytes"])
+
+    # Later runs refill the evicted caches and still get the same result.
+    num_evictions = stats["num_evictions"]
+    for _ in range(2):
+      self.assertAllClose(expected, fn(tf.constant(x_arr)), rtol=1e-4,
+                          atol=1e-4)
+    stats = itex.get_cache_stats()
+    self.assertGreater(stats["num_evictions"], num_evictions)
+    self.assertLessEqual(stats["total_bytes"], stats["budget_bytes"])
+
+
+if __name__ == "__main__":
+  test.main()
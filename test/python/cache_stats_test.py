@@ -0,0 +1,46 @@
+# Copyright (c) 2022 Intel Corporation
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+
+
+import intel_extension_for_tensorflow as itex
+import numpy as np
+import tensorflow as tf
+
+from intel_extension_for_tensorflow.python.test_func import test_util
+from intel_extension_for_tensorflow.python.test_func import test
+
+np.random.seed(1)
+
+
+class CacheStatsTest(test_util.TensorFlowTestCase):
+  """test kernel cache stats python api"""
+
+  def testStatsAreConsistent(self):
+    x = tf.constant(np.random.normal(size=(4, 16)).astype(np.float32))
+    w = tf.constant(np.random.normal(size=(16, 8)).astype(np.float32))
+    tf.function(lambda x: tf.nn.relu(tf.matmul(x, w)))(x)
+
+    stats = itex.get_cache_stats()
+    self.assertEqual(stats["budget_bytes"], 0)
+    self.assertEqual(stats["num_evictions"], 0)
+    self.assertEqual(sum(stats["category_bytes"].values()),
+                     stats["total_bytes"])
+    self.assertEqual(sum(stats["node_bytes"].values()), stats["total_bytes"])
+    self.assertEqual(sum(stats["category_entries"].values()),
+                     stats["num_entries"])
+
+
+if __name__ == "__main__":
+  test.main()
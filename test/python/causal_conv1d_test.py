@@ -0,0 +1,62 @@
+# Copyright (c) 2022 Intel Corporation
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+
+
+import intel_extension_for_tensorflow as itex
+import numpy as np
+import tensorflow as tf
+
+from intel_extension_for_tensorflow.python.test_func import test_util
+from intel_extension_for_tensorflow.python.test_func import test
+
+np.random.seed(1)
+tf.compat.v1.disable_eager_execution()
+class CausalConv1DTest(test_util.TensorFlowTestCase):
+  """test streaming causal conv1d op"""
+
+  @test_util.run_deprecated_v1
+  def testStreamingMatchesOffline(self):
+    if test.is_gpu_available():
+      self.skipTest("Skip on GPU due to the op not supported")
+    kernel_size, dilation = 3, 2
+    x_arr = np.random.normal(size=(2, 23, 4)).astype(np.float32)
+    w_arr = np.random.normal(size=(kernel_size, 4, 6)).astype(np.float32)
+
+    # Offline reference: causal padding then VALID conv over whole sequence.
+    history = (kernel_size - 1) * dilation
+    x_pad = np.pad(x_arr, ((0, 0), (history, 0), (0, 0)))
+    ref = np.zeros((2, 23, 6), dtype=np.float32)
+    for t in range(23):
+      for j in range(kernel_size):
+        ref[:, t, :] += np.matmul(x_pad[:, t + j * dilation, :], w_arr[j])
+
+    x = tf.compat.v1.placeholder(tf.float32, shape=(2, None, 4))
+    reset = tf.compat.v1.placeholder(tf.bool, shape=())
+    with self.session(use_gpu=False) as sess:
+      y = itex.ops.causal_conv1d(x, w_arr, reset=reset, dilation=dilation)
+      # Run twice to check `reset` starts a new stream. Chunks shorter and
+      # longer than the kept history wrap the ring buffer differently.
+      for _ in range(2):
+        outputs = []
+        begin = 0
+        for i, chunk in enumerate((1, 5, 2, 7, 3, 5)):
+          outputs.append(sess.run(y, feed_dict={
+              x: x_arr[:, begin:begin + chunk], reset: i == 0}))
+          begin += chunk
+        self.assertAllClose(np.concatenate(outputs, axis=1), ref,
+                            rtol=1e-4, atol=1e-4)
+
+if __name__ == "__main__":
+  test.main()
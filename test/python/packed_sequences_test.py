@@ -0,0 +1,88 @@
+# Copyright (c) 2022 Intel Corporation
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+
+
+import intel_extension_for_tensorflow as itex
+import numpy as np
+import tensorflow as tf
+
+from intel_extension_for_tensorflow.python.test_func import test_util
+from intel_extension_for_tensorflow.python.test_func import test
+
+np.random.seed(1)
+tf.compat.v1.disable_eager_execution()
+class PackedSequencesTest(test_util.TensorFlowTestCase):
+  """test packed sequence ops"""
+
+  def _masked_attention(self, q, k, v, lengths, causal):
+    # Reference on the padded batch [batch, max_len, heads, head_size].
+    scale = 1.0 / np.sqrt(q.shape[-1])
+    out = np.zeros_like(q)
+    for b, length in enumerate(lengths):
+      for h in range(q.shape[2]):
+        scores = np.matmul(q[b, :length, h], k[b, :length, h].T) * scale
+        if causal:
+          scores += np.triu(np.full((length, length), -np.inf), 1)
+        probs = np.exp(scores - scores.max(axis=-1, keepdims=True))
+        probs /= probs.sum(axis=-1, keepdims=True)
+        out[b, :length, h] = np.matmul(probs, v[b, :length, h])
+    return out
+
+  @test_util.run_deprecated_v1
+  def testPackUnpackRoundTrip(self):
+    if test.is_gpu_available():
+      self.skipTest("Skip on GPU due to the op not supported")
+    lengths = np.array([3, 0, 5, 1], dtype=np.int32)
+    x_arr = np.random.normal(size=(4, 5, 6)).astype(np.float32)
+    x = tf.compat.v1.placeholder(tf.float32, shape=(None, None, 6))
+    with self.session(use_gpu=False) as sess:
+      packed, cu_seqlens = itex.ops.pack_sequences(x, lengths)
+      padded = itex.ops.unpack_sequences(packed, cu_seqlens, 7)
+      packed_val, cu_val, padded_val = sess.run(
+          [packed, cu_seqlens, padded], feed_dict={x: x_arr})
+    self.assertAllEqual(cu_val, [0, 3, 3, 8, 9])
+    self.assertAllEqual(
+        packed_val, np.concatenate([x_arr[b, :n] for b, n in
+                                    enumerate(lengths)]))
+    mask = np.arange(7)[None, :] < lengths[:, None]
+    expected = np.zeros((4, 7, 6), dtype=np.float32)
+    expected[:, :5] = x_arr
+    self.assertAllEqual(padded_val, expected * mask[..., None])
+
+  @test_util.run_deprecated_v1
+  def testVarlenAttentionMatchesMasked(self):
+    if test.is_gpu_available():
+      self.skipTest("Skip on GPU due to the op not supported")
+    # Sequences longer than one query block of the kernel.
+    lengths = np.array([37, 4, 0, 21], dtype=np.int32)
+    shape = (4, 40, 3, 8)
+    q_arr, k_arr, v_arr = [np.random.normal(size=shape).astype(np.float32)
+                           for _ in range(3)]
+    with self.session(use_gpu=False) as sess:
+      for causal in (False, True):
+        packed = [itex.ops.pack_sequences(t, lengths)
+                  for t in (q_arr, k_arr, v_arr)]
+        cu_seqlens = packed[0][1]
+        y = itex.ops.varlen_attention(packed[0][0], packed[1][0],
+                                      packed[2][0], cu_seqlens,
+                                      causal=causal)
+        y = itex.ops.unpack_sequences(y, cu_seqlens, shape[1])
+        self.assertAllClose(
+            sess.run(y),
+            self._masked_attention(q_arr, k_arr, v_arr, lengths, causal),
+            rtol=1e-4, atol=1e-4)
+
+if __name__ == "__main__":
+  test.main()
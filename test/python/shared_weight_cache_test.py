@@ -0,0 +1,70 @@
+# Copyright (c) 2022 Intel Corporation
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+import intel_extension_for_tensorflow as itex
+import numpy as np
+import tensorflow as tf
+
+from intel_extension_for_tensorflow.python.test_func import test_util
+from intel_extension_for_tensorflow.python.test_func import test
+
+np.random.seed(1)
+
+
+class SharedWeightCacheTest(test_util.TensorFlowTestCase):
+  """test sharing of reordered weights between nodes"""
+
+  def testSameWeightIsCachedOnce(self):
+    if test.is_gpu_available():
+      self.skipTest("Weights are only shared on CPU.")
+    w_arr = np.random.normal(size=(64, 32)).astype(np.float32)
+    x_arr = np.random.normal(size=(8, 64)).astype(np.float32)
+
+    def model(x):
+      w = tf.constant(w_arr)
+      return tf.nn.relu(tf.matmul(x, w))
+
+    # Two graphs, each with its own MatMul kernel on the same weight data.
+    first = tf.function(model)
+    second = tf.function(model)
+    expected = np.maximum(np.matmul(x_arr, w_arr), 0)
+
+    self.assertAllClose(expected, first(tf.constant(x_arr)), rtol=1e-4,
+                        atol=1e-4)
+    weight_bytes = itex.get_cache_stats()["category_bytes"].get("weight", 0)
+    self.assertAllClose(expected, second(tf.constant(x_arr)), rtol=1e-4,
+                        atol=1e-4)
+    self.assertEqual(
+        itex.get_cache_stats()["category_bytes"].get("weight", 0),
+        weight_bytes)
+
+  def testDifferentWeightsAreNotShared(self):
+    if test.is_gpu_available():
+      self.skipTest("Weights are only shared on CPU.")
+    w_arr = np.random.normal(size=(64, 32)).astype(np.float32)
+    # Same shape, one element differs.
+    w2_arr = w_arr.copy()
+    w2_arr[3, 5] += 1.0
+    x_arr = np.random.normal(size=(8, 64)).astype(np.float32)
+
+    first = tf.function(lambda x: tf.matmul(x, tf.constant(w_arr)))
+    second = tf.function(lambda x: tf.matmul(x, tf.constant(w2_arr)))
+    self.assertAllClose(np.matmul(x_arr, w_arr), first(tf.constant(x_arr)),
+                        rtol=1e-4, atol=1e-4)
+    self.assertAllClose(np.matmul(x_arr, w2_arr), second(tf.constant(x_arr)),
+                        rtol=1e-4, atol=1e-4)
+
+
+if __name__ == "__main__":
+  test.main()
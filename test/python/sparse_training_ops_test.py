@@ -0,0 +1,129 @@
+# Copyright (c) 2022 Intel Corporation
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+
+
+"""Tests for sparse apply kernels with duplicate indices on CPU."""
+
+import numpy as np
+import tensorflow as tf
+from intel_extension_for_tensorflow.python.test_func import test
+from intel_extension_for_tensorflow.python.test_func import test_util
+
+# Row 1 appears twice.
+INDICES = np.array([1, 3, 1], dtype=np.int64)
+UPDATES = np.array([[0.1, 0.2], [0.3, 0.4], [0.5, 0.6]], dtype=np.float32)
+
+
+def summed_updates(num_rows):
+    summed = np.zeros((num_rows, UPDATES.shape[1]), dtype=np.float32)
+    np.add.at(summed, INDICES, UPDATES)
+    return summed
+
+
+class SparseTrainingOpsTest(test_util.TensorFlowTestCase):
+
+    def setUp(self):
+        super(SparseTrainingOpsTest, self).setUp()
+        if test.is_gpu_available():
+            self.skipTest("These kernels are only rewritten on CPU")
+
+    def testSparseApplyAdagradV2(self):
+        var_np = np.ones((4, 2), dtype=np.float32)
+        accum_np = np.full((4, 2), 0.1, dtype=np.float32)
+        var = tf.Variable(var_np)
+        accum = tf.Variable(accum_np)
+        lr, epsilon = 0.1, 1e-7
+
+        @tf.function
+        def step():
+            tf.raw_ops.ResourceSparseApplyAdagradV2(
+                var=var.handle, accum=accum.handle, lr=lr, epsilon=epsilon,
+                grad=tf.constant(UPDATES), indices=tf.constant(INDICES))
+
+        for _ in range(2):
+            step()
+            # Duplicate rows are applied one after another, as in TF.
+            for row, g in zip(INDICES, UPDATES):
+                accum_np[row] += g * g
+                var_np[row] -= lr * g / (np.sqrt(accum_np[row]) + epsilon)
+            self.assertAllClose(accum.numpy(), accum_np)
+            self.assertAllClose(var.numpy(), var_np)
+
+    def testResourceScatterAdd(self):
+        var_np = np.arange(8, dtype=np.float32).reshape(4, 2)
+        var = tf.Variable(var_np)
+
+        @tf.function
+        def step():
+            tf.raw_ops.ResourceScatterAdd(
+                resource=var.handle, indices=tf.constant(INDICES),
+                updates=tf.constant(UPDATES))
+
+        step()
+        self.assertAllClose(var.numpy(), var_np + summed_updates(4))
+
+    def testOutOfRangeIndex(self):
+        var = tf.Variable(np.zeros((4, 2), dtype=np.float32))
+
+        @tf.function
+        def step():
+            tf.raw_ops.ResourceScatterAdd(
+                resource=var.handle, indices=tf.constant([1, 4]),
+                updates=tf.ones((2, 2)))
+
+        with self.assertRaises(tf.errors.InvalidArgumentError):
+            step()
+
+    def testEmptyParams(self):
+        var = tf.Variable(np.zeros((0, 2), dtype=np.float32))
+
+        @tf.function
+        def step():
+            tf.raw_ops.ResourceScatterAdd(
+                resource=var.handle, indices=tf.constant([0]),
+                updates=tf.ones((1, 2)))
+
+        with self.assertRaises(tf.errors.InvalidArgumentError):
+            step()
+
+    def testOpsAreRewritten(self):
+        run_options = tf.compat.v1.RunOptions(output_partition_graphs=True)
+        metadata = tf.compat.v1.RunMetadata()
+        graph = tf.Graph()
+        with graph.as_default():
+            var = tf.compat.v1.get_variable(
+                "var", initializer=np.ones((4, 2), dtype=np.float32),
+                use_resource=True)
+            accum = tf.compat.v1.get_variable(
+                "accum", initializer=np.full((4, 2), 0.1, dtype=np.float32),
+                use_resource=True)
+            apply_adagrad = tf.raw_ops.ResourceSparseApplyAdagradV2(
+                var=var.handle, accum=accum.handle, lr=0.1, epsilon=1e-7,
+                grad=tf.constant(UPDATES), indices=tf.constant(INDICES))
+            scatter_add = tf.raw_ops.ResourceScatterAdd(
+                resource=var.handle, indices=tf.constant(INDICES),
+                updates=tf.constant(UPDATES))
+            with self.session(graph=graph) as sess:
+                sess.run(tf.compat.v1.global_variables_initializer())
+                sess.run([apply_adagrad, scatter_add], options=run_options,
+                         run_metadata=metadata)
+        ops = {node.op for partition in metadata.partition_graphs
+               for node in partition.node}
+        self.assertIn("_ITEXResourceScatterAdd", ops)
+        self.assertIn("_ITEXResourceSparseApplyAdagradV2", ops)
+
+
+if __name__ == "__main__":
+    test.main()
@@ -0,0 +1,111 @@
+# Copyright (c) 2022 Intel Corporation
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+
+
+import os
+import threading
+import time
+
+# Read once when ITEX is loaded.
+os.environ["ITEX_STEP_TIMEOUT_MS"] = "500"
+
+import intel_extension_for_tensorflow as itex
+import numpy as np
+import tensorflow as tf
+
+from intel_extension_for_tensorflow.python.test_func import test_util
+from intel_extension_for_tensorflow.python.test_func import test
+
+np.random.seed(1)
+
+
+class StepCancellationTest(test_util.TensorFlowTestCase):
+  """test step cancellation and timeout"""
+
+  def _step(self, x, w, tag, in_between):
+    """Runs a MatMul, `in_between` then another MatMul depending on it."""
+    y = tf.matmul(itex.ops.tag_step(x, tag), w)
+    y = tf.numpy_function(lambda y: (in_between(), y)[1], [y], tf.float32)
+    y.set_shape(x.shape)
+    return tf.matmul(y, w)
+
+  def _run(self, x, w, tag, in_between=lambda: None):
+    return tf.function(self._step)(x, w, tf.constant(tag, tf.int64),
+                                   in_between)
+
+  def _inputs(self):
+    x = tf.constant(np.random.normal(size=(4, 4)).astype(np.float32))
+    w = tf.constant(np.random.normal(size=(4, 4)).astype(np.float32))
+    expected = np.matmul(np.matmul(x.numpy(), w.numpy()), w.numpy())
+    return x, w, expected
+
+  def testTimeout(self):
+    x, w, expected = self._inputs()
+    with itex.cancellable_step() as step:
+      with self.assertRaises(tf.errors.DeadlineExceededError):
+        self._run(x, w, step.tag, lambda: time.sleep(1.0))
+
+      # New steps get their own deadline.
+      ret = self._run(x, w, step.tag)
+      self.assertAllClose(expected, ret, rtol=1e-5, atol=1e-5)
+
+  def testCancelStep(self):
+    x, w, expected = self._inputs()
+    with itex.cancellable_step() as step:
+      with self.assertRaises(tf.errors.CancelledError):
+        self._run(x, w, step.tag, step.cancel)
+      # Later steps of the handle are cancelled too.
+      with self.assertRaises(tf.errors.CancelledError):
+        self._run(x, w, step.tag)
+
+    # Other handles are not affected.
+    with itex.cancellable_step() as step:
+      ret = self._run(x, w, step.tag)
+      self.assertAllClose(expected, ret, rtol=1e-5, atol=1e-5)
+
+  def testCancelOnlyOwnStep(self):
+    x, w, expected = self._inputs()
+    started = threading.Event()
+    resume = threading.Event()
+    errors = []
+
+    def in_between():
+      started.set()
+      resume.wait()
+
+    def run_cancelled():
+      try:
+        self._run(x, w, cancelled.tag, in_between)
+      except tf.errors.CancelledError as e:
+        errors.append(e)
+
+    with itex.cancellable_step() as cancelled:
+      thread = threading.Thread(target=run_cancelled)
+      thread.start()
+      started.wait()
+      # A concurrent step of another handle runs while the first one is
+      # cancelled.
+      cancelled.cancel()
+      with itex.cancellable_step() as other:
+        ret = self._run(x, w, other.tag)
+      resume.set()
+      thread.join()
+
+    self.assertAllClose(expected, ret, rtol=1e-5, atol=1e-5)
+    self.assertEqual(1, len(errors))
+
+
+if __name__ == "__main__":
+  test.main()
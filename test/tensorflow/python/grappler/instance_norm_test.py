@@ -229,6 +229,51 @@ class InstanceNormTest(test.TestCase, parameterized.TestCase):
       tol = 1e-5 if precision == 'float32' else 1e-2
       self.assertAllClose(output_val_ref, output_val, atol=tol, rtol=tol)
 
+  @test_util.run_deprecated_v1
+  @test_util.disable_xla('This test does not pass with XLA')
+  def test_instance_norm_3d_ndhwc_large_volume(self):
+    """Test InstanceNorm on a volume which spans many spatial chunks."""
+    run_options = config_pb2.RunOptions(output_partition_graphs=True)
+    metadata = config_pb2.RunMetadata()
+
+    ops.reset_default_graph()
+
+    # Batch 1 volume with a large mean, so the statistics are accumulated
+    # over many chunks and are sensitive to cancellation.
+    x = _input((1, 32, 32, 32, 1))
+    f = _weight([3, 3, 3, 1, 6])
+    in_scale = constant_op.constant([0.1, 0.2, -0.1, 0.33, 0.15, 0.66])
+    in_shift = constant_op.constant([0.13, 0.12, -0.1, 0.23, 0.19, 0.6])
+
+    x_1 = _conv3d(x, f) + 100.0
+    reduction_axes = (1, 2, 3)
+
+    y = batch_normalization(x_1, in_scale, in_shift, reduction_axes)
+    out = array_ops.identity(y)
+
+    # Compute reference value.
+    config = _get_config(remapping_on=False)
+    with session.Session(config=config) as sess:
+      sess.run(variables.global_variables_initializer())
+      output_val_ref = sess.run(
+          out, options=run_options, run_metadata=metadata)
+    # Compute output with fusion.
+    config = _get_config(remapping_on=True)
+    with session.Session(config=config) as sess:
+      sess.run(variables.global_variables_initializer())
+      output_val = sess.run(out, options=run_options, run_metadata=metadata)
+      graph = metadata.partition_graphs[0]
+
+    # Graph should contain fused op.
+    found_fused_op = False
+    for node in graph.node:
+      if 'InstanceNorm' in node.op:
+        found_fused_op = 1
+    self.assertTrue(found_fused_op)
+
+    # Computed output value should be close to reference value.
+    self.assertAllClose(output_val_ref, output_val, atol=1e-4, rtol=1e-4)
+
   @test_util.run_deprecated_v1
   @test_util.disable_xla('This test does not pass with XLA')
   def test_fused_instance_norm_2d_nhwc(self):
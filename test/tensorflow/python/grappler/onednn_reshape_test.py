@@ -0,0 +1,132 @@
+# Copyright (c) 2022 Intel Corporation
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+
+
+from intel_extension_for_tensorflow.python.test_func import test_util
+from intel_extension_for_tensorflow.python.test_func import test
+
+import numpy as np
+import os
+
+from tensorflow.core.protobuf import config_pb2
+from tensorflow.python.framework import constant_op
+from tensorflow.python.framework import dtypes
+from tensorflow.python.ops import array_ops
+from tensorflow.python.ops import nn_ops
+import tensorflow as tf
+
+# Test block format.
+os.environ['ITEX_LAYOUT_OPT']="1"
+
+
+class OneDnnReshapeTest(test.TestCase):
+
+  def _conv_reshape(self, new_shape):
+    x_np = np.random.uniform(-1, 1, size=(2, 8, 6, 6)).astype(np.float32)
+    w_np = np.random.uniform(-1, 1, size=(3, 3, 8, 32)).astype(np.float32)
+    x = tf.compat.v1.placeholder(dtypes.float32, shape=x_np.shape)
+    w = constant_op.constant(w_np)
+
+    conv = nn_ops.conv2d(x, w, strides=[1, 1, 1, 1], padding="SAME",
+                         data_format="NCHW")
+    reshape = array_ops.reshape(conv, new_shape)
+    # Relu keeps the reshaped tensor in oneDNN layout.
+    y = array_ops.identity(nn_ops.relu(reshape))
+
+    run_options = config_pb2.RunOptions(output_partition_graphs=True)
+    metadata = config_pb2.RunMetadata()
+    with self.session() as sess:
+      ret = sess.run(y, feed_dict={x: x_np}, options=run_options,
+                     run_metadata=metadata)
+
+    found_reshape = False
+    for graph in metadata.partition_graphs:
+      for node in graph.node:
+        if node.op == '_OneDnnReshape':
+          found_reshape = True
+    self.assertTrue(found_reshape)
+
+    # Reference result in plain layout.
+    ref = np.zeros((2, 32, 6, 6), dtype=np.float32)
+    x_pad = np.pad(x_np, ((0, 0), (0, 0), (1, 1), (1, 1)))
+    for h in range(6):
+      for w in range(6):
+        patch = x_pad[:, :, h:h + 3, w:w + 3]
+        ref[:, :, h, w] = np.einsum("nchw,hwco->no", patch, w_np)
+    ref = np.maximum(np.reshape(ref, new_shape), 0)
+    self.assertAllClose(ref, ret, atol=1e-4, rtol=1e-4)
+
+  @test_util.run_deprecated_v1
+  def testMergeOuterDims(self):
+    if test.is_gpu_available():
+      self.skipTest("Block layout of NCHW Conv is only tested on CPU")
+    # Merge H and W, C is the blocked dim.
+    self._conv_reshape([2, 32, 36])
+
+  @test_util.run_deprecated_v1
+  def testSplitOuterDims(self):
+    if test.is_gpu_available():
+      self.skipTest("Block layout of NCHW Conv is only tested on CPU")
+    # Split W, C is the blocked dim. The rank changes, so it's reordered to
+    # plain layout.
+    self._conv_reshape([2, 32, 6, 2, 3])
+
+  @test_util.run_deprecated_v1
+  def testBlockedDimAffected(self):
+    if test.is_gpu_available():
+      self.skipTest("Block layout of NCHW Conv is only tested on CPU")
+    # Blocked C is merged, reorder to plain layout is required.
+    self._conv_reshape([2, 32 * 36])
+
+  @test_util.run_deprecated_v1
+  def testRankChangeToNHWCConsumer(self):
+    if test.is_gpu_available():
+      self.skipTest("Block layout of NCHW Conv is only tested on CPU")
+    x_np = np.random.uniform(-1, 1, size=(2, 8, 6, 6)).astype(np.float32)
+    w_np = np.random.uniform(-1, 1, size=(3, 3, 8, 32)).astype(np.float32)
+    w2_np = np.random.uniform(-1, 1, size=(3, 3, 6, 4)).astype(np.float32)
+    x = tf.compat.v1.placeholder(dtypes.float32, shape=x_np.shape)
+
+    conv = nn_ops.conv2d(x, constant_op.constant(w_np), strides=[1, 1, 1, 1],
+                         padding="SAME", data_format="NCHW")
+    # 4-D to 3-D keeps the block layout, back to 4-D must not be labelled
+    # NCHW, as the NHWC Conv reads it as [N, H, W, C].
+    reshape = array_ops.reshape(array_ops.reshape(conv, [2, 32, 36]),
+                                [2, 32, 6, 6])
+    conv2 = nn_ops.conv2d(reshape, constant_op.constant(w2_np),
+                          strides=[1, 1, 1, 1], padding="SAME",
+                          data_format="NHWC")
+    y = array_ops.identity(conv2)
+
+    with self.session() as sess:
+      ret = sess.run(y, feed_dict={x: x_np})
+
+    ref1 = np.zeros((2, 32, 6, 6), dtype=np.float32)
+    x_pad = np.pad(x_np, ((0, 0), (0, 0), (1, 1), (1, 1)))
+    for h in range(6):
+      for w in range(6):
+        patch = x_pad[:, :, h:h + 3, w:w + 3]
+        ref1[:, :, h, w] = np.einsum("nchw,hwco->no", patch, w_np)
+    ref = np.zeros((2, 32, 6, 4), dtype=np.float32)
+    ref1_pad = np.pad(ref1, ((0, 0), (1, 1), (1, 1), (0, 0)))
+    for h in range(32):
+      for w in range(6):
+        patch = ref1_pad[:, h:h + 3, w:w + 3, :]
+        ref[:, h, w, :] = np.einsum("nhwc,hwco->no", patch, w2_np)
+    self.assertAllClose(ref, ret, atol=1e-3, rtol=1e-3)
+
+
+if __name__ == "__main__":
+  test.main()